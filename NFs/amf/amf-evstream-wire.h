@@ -0,0 +1,119 @@
+/*
+ * amf-evstream-wire.h — records on the AMF event socket (amf-evstream.c).
+ *
+ * The AMF publishes typed state changes on a Unix stream socket:
+ *
+ *   /run/open5gs-amf-events.sock   (AMF_EVSTREAM_SOCK_PATH)
+ *
+ * Every subscriber gets, in order:
+ *
+ *   HELLO      once: the AMF's epoch (start time), next and oldest seq
+ *   snapshot   current gNBs, cnode and health state whose event is older
+ *              than the history (flag AMF_EVSTREAM_F_SNAPSHOT)
+ *   history    the last AMF_EVSTREAM_HISTORY events, oldest first
+ *              (flag AMF_EVSTREAM_F_REPLAY)
+ *   live       every new event as it is published
+ *
+ * A record is an amf_evstream_hdr_t followed by the body of its type; `len`
+ * is the whole record.  Integers are host byte order (same host only),
+ * strings NUL-terminated.  `seq` counts events per AMF process, from 1
+ * (HELLO and LOST, made per subscriber, carry 0); together with the
+ * HELLO epoch it marks a point in the stream
+ * (tools/amf-events --seq / --since).  A subscriber that falls more than
+ * the history behind gets one LOST record with the number it missed.
+ *
+ * Reader: NFs/amf/tools/amf-events.c.
+ */
+
+#ifndef AMF_EVSTREAM_WIRE_H
+#define AMF_EVSTREAM_WIRE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AMF_EVSTREAM_SOCK_DEFAULT_PATH "/run/open5gs-amf-events.sock"
+#define AMF_EVSTREAM_WIRE_VERSION      1
+#define AMF_EVSTREAM_MAX_RECORD        128
+
+typedef enum {
+    AMF_EVSTREAM_HELLO = 0,
+    AMF_EVSTREAM_GNB_UP,           /* NG Setup accepted */
+    AMF_EVSTREAM_GNB_DOWN,         /* gNB context removed (SCTP down / reset) */
+    AMF_EVSTREAM_UE_REGISTERED,    /* Registration Complete received */
+    AMF_EVSTREAM_UE_REMOVED,       /* AMF UE context removed */
+    AMF_EVSTREAM_CNODE,            /* cnode client state (cnode/amf_cnode.c) */
+    AMF_EVSTREAM_HEALTH,           /* ServingStatus / load bucket change */
+    AMF_EVSTREAM_LOST,             /* subscriber fell behind the history */
+    AMF_EVSTREAM_TYPE_MAX,
+} amf_evstream_type_e;
+
+#define AMF_EVSTREAM_F_SNAPSHOT    0x01
+#define AMF_EVSTREAM_F_REPLAY      0x02
+
+typedef struct amf_evstream_hdr_s {
+    uint16_t len;               /* whole record, header included */
+    uint8_t  type;              /* amf_evstream_type_e */
+    uint8_t  flags;             /* AMF_EVSTREAM_F_* (set per subscriber) */
+    uint32_t reserved;
+    uint64_t seq;
+    uint64_t unix_ns;           /* CLOCK_REALTIME when published */
+} amf_evstream_hdr_t;
+
+typedef struct amf_evstream_hello_s {
+    uint64_t epoch_ns;          /* AMF start (CLOCK_REALTIME) */
+    uint64_t next_seq;          /* seq of the first live event */
+    uint64_t oldest_seq;        /* first event still in the history */
+    uint32_t pid;
+    uint32_t version;           /* AMF_EVSTREAM_WIRE_VERSION */
+} amf_evstream_hello_t;
+
+typedef struct amf_evstream_gnb_s {
+    uint32_t gnb_id;
+    uint8_t  plmn_id[3];        /* ogs_plmn_id_t, BCD */
+    uint8_t  reserved;
+    char     addr[64];          /* SCTP peer "ip:port" */
+} amf_evstream_gnb_t;
+
+typedef struct amf_evstream_ue_s {
+    char     supi[40];          /* "imsi-..." */
+} amf_evstream_ue_t;
+
+typedef enum {
+    AMF_EVSTREAM_CNODE_CONNECTED = 1,
+    AMF_EVSTREAM_CNODE_REGISTERED,  /* NodeType_Message sent */
+    AMF_EVSTREAM_CNODE_DISCONNECTED,
+} amf_evstream_cnode_state_e;
+
+typedef struct amf_evstream_cnode_s {
+    uint8_t  state;             /* amf_evstream_cnode_state_e */
+    uint8_t  reserved;
+    uint16_t port;
+    char     server[46];
+} amf_evstream_cnode_t;
+
+typedef struct amf_evstream_health_s {
+    uint8_t  status;            /* AMF_HEALTH_SERVING / _NOT_SERVING */
+    uint8_t  load_bucket;
+    uint8_t  reserved[2];
+} amf_evstream_health_t;
+
+typedef struct amf_evstream_lost_s {
+    uint64_t count;
+} amf_evstream_lost_t;
+
+static inline const char *amf_evstream_type_name(unsigned type)
+{
+    static const char *const names[AMF_EVSTREAM_TYPE_MAX] = {
+        "hello", "gnb_up", "gnb_down", "ue_registered", "ue_removed",
+        "cnode", "health", "lost" };
+    return type < AMF_EVSTREAM_TYPE_MAX ? names[type] : "unknown";
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AMF_EVSTREAM_WIRE_H */
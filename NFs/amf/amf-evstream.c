@@ -0,0 +1,548 @@
+/*
+ * AMF event stream
+ *
+ * Publisher side of the event socket; see amf-evstream.h for what is
+ * published, amf-evstream-wire.h for the records and delivery order.
+ *
+ * Events go into a ring of fixed AMF_EVSTREAM_MAX_RECORD slots indexed by
+ * seq.  Each subscriber only holds a cursor (next seq to send) and an
+ * output buffer: the publisher thread tops the buffer up from the ring
+ * and sends what the socket takes.  A subscriber that stops reading just
+ * falls behind; once its cursor leaves the ring it gets a LOST record
+ * and continues from the oldest event kept.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE             /* accept4() */
+#endif
+
+#include "ogs-app.h"
+#include "context.h"
+#include "amf-evstream.h"
+#include "amf-evstream-wire.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define SLOT_SIZE           AMF_EVSTREAM_MAX_RECORD
+#define CLIENT_MAX          64
+#define CLIENT_BUF          65536
+#define SNAPSHOT_GNB_MAX    256
+
+_Static_assert(sizeof(amf_evstream_hdr_t) == 24, "event header layout");
+_Static_assert(sizeof(amf_evstream_hdr_t) + sizeof(amf_evstream_gnb_t)
+               <= SLOT_SIZE, "gNB event does not fit a slot");
+_Static_assert(sizeof(amf_evstream_hdr_t) + sizeof(amf_evstream_hello_t)
+               <= SLOT_SIZE, "HELLO does not fit a slot");
+_Static_assert(SNAPSHOT_GNB_MAX * SLOT_SIZE + 4 * SLOT_SIZE <= CLIENT_BUF,
+               "snapshot does not fit a subscriber buffer");
+
+typedef struct client_s {
+    int         fd;
+    uint64_t    cursor;             /* next seq to send */
+    uint64_t    live_from;          /* HELLO next_seq: earlier = replay */
+    size_t      head, tail;         /* pending bytes in buf[head..tail) */
+    uint8_t     buf[CLIENT_BUF];
+} client_t;
+
+typedef struct state_rec_s {
+    uint64_t    seq;                /* 0 = none */
+    uint8_t     rec[SLOT_SIZE];
+} state_rec_t;
+
+static int              g_enable        = 0;
+static char             g_path[108]     = AMF_EVSTREAM_SOCK_DEFAULT_PATH;
+static uint32_t         g_history       = 4096;
+
+static pthread_t        g_thread;
+static volatile int     g_running       = 0;
+static int              g_listen_fd     = -1;
+static int              g_efd           = -1;
+static uint64_t         g_epoch_ns      = 0;
+
+/* Ring, seq counter and current state; written by the publishing threads
+ * (AMF, cnode, health monitor), read by the publisher thread */
+static pthread_mutex_t  g_lock          = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t          *g_ring         = NULL;
+static uint64_t         g_next_seq      = 1;
+static state_rec_t      g_gnbs[SNAPSHOT_GNB_MAX];
+static int              g_ngnbs         = 0;
+static state_rec_t      g_cnode;
+static state_rec_t      g_health;
+
+/* Publisher thread only */
+static client_t         *g_clients[CLIENT_MAX];
+static int              g_nclients      = 0;
+
+static uint64_t clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* First seq still in the ring; caller holds g_lock */
+static uint64_t oldest_seq(void)
+{
+    return g_next_seq > g_history ? g_next_seq - g_history : 1;
+}
+
+static uint8_t *ring_slot(uint64_t seq)
+{
+    return g_ring + ((seq - 1) % g_history) * SLOT_SIZE;
+}
+
+static uint16_t rec_len(const uint8_t *rec)
+{
+    return ((const amf_evstream_hdr_t *)rec)->len;
+}
+
+static uint32_t rec_gnb_id(const uint8_t *rec)
+{
+    return ((const amf_evstream_gnb_t *)
+            (rec + sizeof(amf_evstream_hdr_t)))->gnb_id;
+}
+
+/* =========================================================
+ * Publish (any thread)
+ * ========================================================= */
+
+/* Keep what a late subscriber needs beyond the history; caller holds
+ * g_lock */
+static void state_update(const uint8_t *rec, uint64_t seq)
+{
+    const amf_evstream_hdr_t *h = (const amf_evstream_hdr_t *)rec;
+    state_rec_t *s = NULL;
+    int i;
+
+    switch (h->type) {
+    case AMF_EVSTREAM_GNB_UP:
+    case AMF_EVSTREAM_GNB_DOWN:
+        for (i = 0; i < g_ngnbs; i++)
+            if (rec_gnb_id(g_gnbs[i].rec) == rec_gnb_id(rec))
+                break;
+        if (h->type == AMF_EVSTREAM_GNB_DOWN) {
+            if (i < g_ngnbs)
+                g_gnbs[i] = g_gnbs[--g_ngnbs];
+            return;
+        }
+        if (i == g_ngnbs) {
+            if (g_ngnbs == SNAPSHOT_GNB_MAX) return;   /* history only */
+            g_ngnbs++;
+        }
+        s = &g_gnbs[i];
+        break;
+    case AMF_EVSTREAM_CNODE:
+        s = &g_cnode;
+        break;
+    case AMF_EVSTREAM_HEALTH:
+        s = &g_health;
+        break;
+    default:
+        return;
+    }
+    s->seq = seq;
+    memcpy(s->rec, rec, h->len);
+}
+
+static void publish(uint8_t type, const void *body, size_t body_len)
+{
+    uint8_t rec[SLOT_SIZE];
+    amf_evstream_hdr_t *h = (amf_evstream_hdr_t *)rec;
+    uint64_t one = 1;
+
+    if (!g_running) return;
+
+    memset(h, 0, sizeof(*h));
+    h->len = (uint16_t)(sizeof(*h) + body_len);
+    h->type = type;
+    h->unix_ns = clock_ns(CLOCK_REALTIME);
+    memcpy(h + 1, body, body_len);
+
+    pthread_mutex_lock(&g_lock);
+    h->seq = g_next_seq++;
+    memcpy(ring_slot(h->seq), rec, h->len);
+    state_update(rec, h->seq);
+    pthread_mutex_unlock(&g_lock);
+
+    if (write(g_efd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        ogs_debug("[AMF-Events] eventfd write: %s", strerror(errno));
+}
+
+/* =========================================================
+ * Subscribers (publisher thread)
+ * ========================================================= */
+static void client_put(client_t *c, const void *rec, uint8_t flags)
+{
+    amf_evstream_hdr_t *h = (amf_evstream_hdr_t *)(c->buf + c->tail);
+
+    memcpy(h, rec, rec_len(rec));
+    h->flags |= flags;
+    c->tail += h->len;
+}
+
+static void client_put_synth(client_t *c, uint8_t type,
+        const void *body, size_t body_len)
+{
+    uint8_t rec[SLOT_SIZE];
+    amf_evstream_hdr_t *h = (amf_evstream_hdr_t *)rec;
+
+    memset(h, 0, sizeof(*h));
+    h->len = (uint16_t)(sizeof(*h) + body_len);
+    h->type = type;
+    h->unix_ns = clock_ns(CLOCK_REALTIME);
+    memcpy(h + 1, body, body_len);
+    client_put(c, rec, 0);
+}
+
+/* HELLO, then the state that already fell out of the ring */
+static void client_greet(client_t *c)
+{
+    amf_evstream_hello_t hello;
+    uint64_t oldest;
+    int i;
+
+    pthread_mutex_lock(&g_lock);
+    oldest = oldest_seq();
+
+    memset(&hello, 0, sizeof(hello));
+    hello.epoch_ns = g_epoch_ns;
+    hello.next_seq = g_next_seq;
+    hello.oldest_seq = oldest;
+    hello.pid = (uint32_t)getpid();
+    hello.version = AMF_EVSTREAM_WIRE_VERSION;
+    client_put_synth(c, AMF_EVSTREAM_HELLO, &hello, sizeof(hello));
+
+    for (i = 0; i < g_ngnbs; i++)
+        if (g_gnbs[i].seq < oldest)
+            client_put(c, g_gnbs[i].rec, AMF_EVSTREAM_F_SNAPSHOT);
+    if (g_cnode.seq && g_cnode.seq < oldest)
+        client_put(c, g_cnode.rec, AMF_EVSTREAM_F_SNAPSHOT);
+    if (g_health.seq && g_health.seq < oldest)
+        client_put(c, g_health.rec, AMF_EVSTREAM_F_SNAPSHOT);
+
+    c->cursor = oldest;
+    c->live_from = g_next_seq;
+    pthread_mutex_unlock(&g_lock);
+}
+
+/* Top the buffer up from the ring */
+static void client_fill(client_t *c)
+{
+    uint64_t oldest;
+
+    if (c->head == c->tail) {
+        c->head = c->tail = 0;
+    } else if (c->head > CLIENT_BUF / 2) {
+        memmove(c->buf, c->buf + c->head, c->tail - c->head);
+        c->tail -= c->head;
+        c->head = 0;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    oldest = oldest_seq();
+    if (c->cursor < oldest && CLIENT_BUF - c->tail >= SLOT_SIZE) {
+        amf_evstream_lost_t lost = { oldest - c->cursor };
+        client_put_synth(c, AMF_EVSTREAM_LOST, &lost, sizeof(lost));
+        c->cursor = oldest;
+    }
+    while (c->cursor < g_next_seq && CLIENT_BUF - c->tail >= SLOT_SIZE) {
+        client_put(c, ring_slot(c->cursor),
+                   c->cursor < c->live_from ? AMF_EVSTREAM_F_REPLAY : 0);
+        c->cursor++;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+/* Returns -1 when the subscriber is gone */
+static int client_flush(client_t *c)
+{
+    while (c->head < c->tail) {
+        ssize_t n = send(c->fd, c->buf + c->head, c->tail - c->head,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        c->head += (size_t)n;
+    }
+    return 0;
+}
+
+static void client_drop(int i)
+{
+    close(g_clients[i]->fd);
+    free(g_clients[i]);
+    g_clients[i] = g_clients[--g_nclients];
+}
+
+static void client_accept(void)
+{
+    for (;;) {
+        client_t *c;
+        int fd = accept4(g_listen_fd, NULL, NULL,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                ogs_warn("[AMF-Events] accept() failed: %s", strerror(errno));
+            return;
+        }
+        if (g_nclients >= CLIENT_MAX || !(c = malloc(sizeof(*c)))) {
+            ogs_warn("[AMF-Events] subscriber refused (%d connected)",
+                     g_nclients);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->head = c->tail = 0;
+        client_greet(c);
+        g_clients[g_nclients++] = c;
+    }
+}
+
+static void *publisher_loop(void *arg)
+{
+    struct pollfd pfd[2 + CLIENT_MAX];
+    int i;
+
+    (void)arg;
+
+    while (g_running) {
+        uint64_t kick;
+        int n;
+
+        pfd[0].fd = g_listen_fd;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = g_efd;
+        pfd[1].events = POLLIN;
+        for (i = 0; i < g_nclients; i++) {
+            pfd[2 + i].fd = g_clients[i]->fd;
+            pfd[2 + i].events = POLLIN;
+            if (g_clients[i]->head < g_clients[i]->tail)
+                pfd[2 + i].events |= POLLOUT;
+        }
+        for (i = 0; i < 2 + g_nclients; i++)
+            pfd[i].revents = 0;
+
+        n = poll(pfd, (nfds_t)(2 + g_nclients), 1000);
+        if (n < 0 && errno != EINTR) {
+            ogs_error("[AMF-Events] poll() failed: %s", strerror(errno));
+            break;
+        }
+
+        if (pfd[1].revents & POLLIN) {
+            if (read(g_efd, &kick, sizeof(kick)) < 0 && errno != EAGAIN)
+                ogs_debug("[AMF-Events] eventfd read: %s", strerror(errno));
+        }
+
+        /* Subscribers never send: readable means closed (or junk) */
+        for (i = g_nclients - 1; i >= 0; i--) {
+            short re = pfd[2 + i].revents;
+            if (re & (POLLERR | POLLHUP | POLLNVAL)) {
+                client_drop(i);
+            } else if (re & POLLIN) {
+                char junk[256];
+                ssize_t r = recv(g_clients[i]->fd, junk, sizeof(junk),
+                                 MSG_DONTWAIT);
+                if (r == 0 || (r < 0 && errno != EAGAIN && errno != EINTR))
+                    client_drop(i);
+            }
+        }
+
+        if (pfd[0].revents & POLLIN)
+            client_accept();
+
+        for (i = g_nclients - 1; i >= 0; i--) {
+            client_fill(g_clients[i]);
+            if (client_flush(g_clients[i]) < 0)
+                client_drop(i);
+        }
+    }
+
+    while (g_nclients > 0)
+        client_drop(g_nclients - 1);
+    return NULL;
+}
+
+/* =========================================================
+ * Public API
+ * ========================================================= */
+int amf_evstream_open(void)
+{
+    struct sockaddr_un sun;
+    const char *env;
+
+    env = getenv("AMF_EVSTREAM_ENABLE");
+    g_enable = env && !strcmp(env, "1");
+    if (!g_enable) return OGS_OK;
+
+    env = getenv("AMF_EVSTREAM_SOCK");
+    if (env && env[0]) {
+        if (strlen(env) >= sizeof(sun.sun_path)) {
+            ogs_warn("[AMF-Events] AMF_EVSTREAM_SOCK too long, event stream "
+                     "disabled");
+            return OGS_OK;
+        }
+        snprintf(g_path, sizeof(g_path), "%s", env);
+    }
+    env = getenv("AMF_EVSTREAM_HISTORY");
+    if (env && atoi(env) > 0) {
+        g_history = (uint32_t)atoi(env);
+        if (g_history < 64) g_history = 64;
+        if (g_history > 1048576) g_history = 1048576;
+    }
+
+    g_ring = calloc(g_history, SLOT_SIZE);
+    if (!g_ring) {
+        ogs_warn("[AMF-Events] no memory for %u events, event stream disabled",
+                 g_history);
+        return OGS_OK;
+    }
+
+    g_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    g_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    snprintf(sun.sun_path, sizeof(sun.sun_path), "%s", g_path);
+    unlink(g_path);             /* left by a killed AMF */
+    if (g_efd < 0 || g_listen_fd < 0 ||
+        bind(g_listen_fd, (struct sockaddr *)&sun, sizeof(sun)) < 0 ||
+        listen(g_listen_fd, 16) < 0) {
+        ogs_warn("[AMF-Events] cannot listen on %s: %s, event stream disabled",
+                 g_path, strerror(errno));
+        goto fail;
+    }
+
+    g_epoch_ns = clock_ns(CLOCK_REALTIME);
+    g_running = 1;
+    if (pthread_create(&g_thread, NULL, publisher_loop, NULL) != 0) {
+        ogs_error("[AMF-Events] pthread_create() failed: %s", strerror(errno));
+        g_running = 0;
+        unlink(g_path);
+        goto fail;
+    }
+
+    ogs_info("[AMF-Events] Publishing on %s (history %u events)",
+             g_path, g_history);
+    return OGS_OK;
+
+fail:
+    if (g_listen_fd >= 0) close(g_listen_fd);
+    if (g_efd >= 0) close(g_efd);
+    g_listen_fd = g_efd = -1;
+    free(g_ring);
+    g_ring = NULL;
+    return OGS_OK;
+}
+
+void amf_evstream_close(void)
+{
+    uint64_t one = 1;
+
+    if (!g_running) return;
+
+    g_running = 0;
+    if (write(g_efd, &one, sizeof(one)) < 0)
+        ogs_debug("[AMF-Events] eventfd write: %s", strerror(errno));
+    pthread_join(g_thread, NULL);
+
+    close(g_listen_fd);
+    close(g_efd);
+    g_listen_fd = g_efd = -1;
+    unlink(g_path);
+    free(g_ring);
+    g_ring = NULL;
+    ogs_info("[AMF-Events] Stopped after %llu events",
+             (unsigned long long)(g_next_seq - 1));
+}
+
+void amf_evstream_gnb_up(amf_gnb_t *gnb)
+{
+    amf_evstream_gnb_t b;
+    char buf[OGS_ADDRSTRLEN];
+
+    if (!g_running || !gnb) return;
+
+    memset(&b, 0, sizeof(b));
+    b.gnb_id = gnb->gnb_id;
+    memcpy(b.plmn_id, &gnb->plmn_id, sizeof(b.plmn_id));
+    if (gnb->sctp.addr)
+        snprintf(b.addr, sizeof(b.addr), "%s:%u",
+                 OGS_ADDR(gnb->sctp.addr, buf), OGS_PORT(gnb->sctp.addr));
+    publish(AMF_EVSTREAM_GNB_UP, &b, sizeof(b));
+}
+
+void amf_evstream_gnb_down(amf_gnb_t *gnb)
+{
+    amf_evstream_gnb_t b;
+    char buf[OGS_ADDRSTRLEN];
+
+    /* Only gNBs that were announced: an SCTP association that never
+     * finished NG Setup has no gNB-ID yet */
+    if (!g_running || !gnb || !gnb->state.ng_setup_success) return;
+
+    memset(&b, 0, sizeof(b));
+    b.gnb_id = gnb->gnb_id;
+    memcpy(b.plmn_id, &gnb->plmn_id, sizeof(b.plmn_id));
+    if (gnb->sctp.addr)
+        snprintf(b.addr, sizeof(b.addr), "%s:%u",
+                 OGS_ADDR(gnb->sctp.addr, buf), OGS_PORT(gnb->sctp.addr));
+    publish(AMF_EVSTREAM_GNB_DOWN, &b, sizeof(b));
+}
+
+void amf_evstream_ue_registered(amf_ue_t *amf_ue)
+{
+    amf_evstream_ue_t b;
+
+    if (!g_running || !amf_ue || !amf_ue->supi) return;
+
+    memset(&b, 0, sizeof(b));
+    snprintf(b.supi, sizeof(b.supi), "%s", amf_ue->supi);
+    publish(AMF_EVSTREAM_UE_REGISTERED, &b, sizeof(b));
+}
+
+void amf_evstream_ue_removed(amf_ue_t *amf_ue)
+{
+    amf_evstream_ue_t b;
+
+    if (!g_running || !amf_ue || !amf_ue->supi) return;
+
+    memset(&b, 0, sizeof(b));
+    snprintf(b.supi, sizeof(b.supi), "%s", amf_ue->supi);
+    publish(AMF_EVSTREAM_UE_REMOVED, &b, sizeof(b));
+}
+
+void amf_evstream_cnode(int state, const char *server, uint16_t port)
+{
+    amf_evstream_cnode_t b;
+
+    if (!g_running) return;
+
+    memset(&b, 0, sizeof(b));
+    b.state = (uint8_t)state;
+    b.port = port;
+    snprintf(b.server, sizeof(b.server), "%s", server ? server : "");
+    publish(AMF_EVSTREAM_CNODE, &b, sizeof(b));
+}
+
+void amf_evstream_health(uint32_t status, uint32_t load_bucket)
+{
+    amf_evstream_health_t b;
+
+    if (!g_running) return;
+
+    memset(&b, 0, sizeof(b));
+    b.status = (uint8_t)status;
+    b.load_bucket = (uint8_t)load_bucket;
+    publish(AMF_EVSTREAM_HEALTH, &b, sizeof(b));
+}
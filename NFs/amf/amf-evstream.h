@@ -0,0 +1,71 @@
+/*
+ * AMF event stream
+ *
+ * Tests and open5gs.sh used to learn that a gNB finished NG Setup, a UE
+ * registered or the cnode client registered by polling amf.log with grep
+ * every 0.25..3 s.  That costs up to a poll interval per wait, and a
+ * string change in a log line breaks it silently.
+ *
+ * With AMF_EVSTREAM_ENABLE=1 the AMF publishes these state changes as typed,
+ * length-prefixed records on a Unix stream socket (layout and delivery
+ * order: amf-evstream-wire.h).  Publishing is a memcpy into a history ring
+ * under a mutex plus an eventfd write; a publisher thread sends to the
+ * subscribers, so a slow reader never blocks the AMF thread.  A
+ * subscriber that connects late still sees the current gNBs, health and
+ * cnode state and the last AMF_EVSTREAM_HISTORY events.
+ *
+ * Reader: tools/amf-events (follow as JSON lines, or block until N
+ * events of a type arrived — tests/common.sh wait helpers).
+ *
+ * Configuration (env vars read at amf_evstream_open() time):
+ *   AMF_EVSTREAM_ENABLE   1|0  (default: 0)
+ *   AMF_EVSTREAM_SOCK     socket path
+ *                         (default: /run/open5gs-amf-events.sock)
+ *   AMF_EVSTREAM_HISTORY  events kept for late subscribers
+ *                         (default: 4096, 64..1048576)
+ */
+
+#ifndef AMF_EVSTREAM_H
+#define AMF_EVSTREAM_H
+
+#include "context.h"
+#include "amf-evstream-wire.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * amf_evstream_open() — bind the socket and start the publisher thread.
+ * Call first in amf_initialize(), before amf_cnode_start(), so the cnode
+ * and health events of this start are in the history.  Returns OGS_OK
+ * when disabled; a bind failure only disables the stream.
+ */
+int  amf_evstream_open(void);
+
+/*
+ * amf_evstream_close() — stop the publisher and remove the socket.  Call
+ * after amf_cnode_stop() in amf_terminate(); events published later
+ * (context teardown) are dropped.
+ */
+void amf_evstream_close(void);
+
+/* AMF thread: NG Setup accepted / gNB context removed */
+void amf_evstream_gnb_up(amf_gnb_t *gnb);
+void amf_evstream_gnb_down(amf_gnb_t *gnb);
+
+/* AMF thread: Registration Complete / AMF UE context removed */
+void amf_evstream_ue_registered(amf_ue_t *amf_ue);
+void amf_evstream_ue_removed(amf_ue_t *amf_ue);
+
+/* cnode client thread: state is amf_evstream_cnode_state_e */
+void amf_evstream_cnode(int state, const char *server, uint16_t port);
+
+/* Health monitor thread: ServingStatus or load bucket changed */
+void amf_evstream_health(uint32_t status, uint32_t load_bucket);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AMF_EVSTREAM_H */
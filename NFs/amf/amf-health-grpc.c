@@ -0,0 +1,637 @@
+/*
+ * AMF gRPC Health Service (grpc.health.v1) over cleartext HTTP/2
+ *
+ * One session thread polls every h2c connection handed over by the
+ * health accept loop, plus a pipe that carries new connections and
+ * status-change notifications.  All nghttp2 state is owned by that
+ * thread, so no locking is needed.
+ *
+ * See amf-health-grpc.h for the protocol summary.
+ */
+
+#include "ogs-app.h"
+#include "amf-health.h"
+#include "amf-health-grpc.h"
+
+#include <nghttp2/nghttp2.h>
+
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GRPC_PATH_CHECK     "/grpc.health.v1.Health/Check"
+#define GRPC_PATH_WATCH     "/grpc.health.v1.Health/Watch"
+
+#define GRPC_MAX_CONN_LIMIT 256
+#define GRPC_REQ_MAX        128
+#define GRPC_MSG_MAX        (5 + 256)       /* 5-byte gRPC prefix + message */
+#define GRPC_RECV_BUF       4096
+
+/* pipe messages: fd >= 0 is a new connection */
+#define GRPC_PIPE_NOTIFY    (-1)
+
+/* grpc.health.v1 ServingStatus */
+#define GRPC_SERVICE_UNKNOWN 3
+
+/* grpc-status codes used here */
+#define GRPC_STATUS_OK              "0"
+#define GRPC_STATUS_NOT_FOUND       "5"
+#define GRPC_STATUS_UNIMPLEMENTED   "12"
+
+typedef enum {
+    GRPC_CALL_UNKNOWN = 0,
+    GRPC_CALL_CHECK,
+    GRPC_CALL_WATCH,
+} grpc_call_e;
+
+typedef struct grpc_conn_s grpc_conn_t;
+
+typedef struct grpc_stream_s {
+    struct grpc_stream_s *prev, *next;      /* grpc_conn_t.streams */
+    grpc_conn_t *conn;
+    int32_t     id;
+    grpc_call_e call;
+    int         responded;                  /* response HEADERS submitted */
+    int         deferred;                   /* data provider is parked */
+    int         fixed_status;               /* >0: SERVICE_UNKNOWN for Watch */
+
+    uint8_t     req[GRPC_REQ_MAX];
+    int         req_len;
+
+    uint8_t     out[GRPC_MSG_MAX];          /* one framed gRPC message */
+    int         out_len;
+    int         out_off;
+} grpc_stream_t;
+
+struct grpc_conn_s {
+    int              fd;
+    nghttp2_session *session;
+    grpc_stream_t   *streams;
+};
+
+static pthread_t        grpc_thread;
+static volatile int     grpc_running = 0;
+static int              grpc_pipe[2] = { -1, -1 };
+static grpc_conn_t    **grpc_conns  = NULL;    /* [grpc_nconn] live */
+static int              grpc_max_conn = 0;
+static int              grpc_nconn   = 0;
+
+#define MAKE_NV(NAME, VALUE)                                                 \
+    { (uint8_t *)(NAME), (uint8_t *)(VALUE),                                 \
+      sizeof(NAME) - 1, sizeof(VALUE) - 1,                                   \
+      NGHTTP2_NV_FLAG_NO_COPY_NAME | NGHTTP2_NV_FLAG_NO_COPY_VALUE }
+
+/* =========================================================
+ * Message helpers
+ * ========================================================= */
+
+/*
+ * HealthCheckRequest { string service = 1; } inside a gRPC frame.
+ * Returns 1 if the service is known ("" or "amf"), 0 if not,
+ * -1 if the frame is malformed.
+ */
+static int grpc_service_known(const uint8_t *buf, int len)
+{
+    const uint8_t *msg;
+    uint32_t mlen;
+    int off = 0;
+
+    if (len == 0) return 1;                 /* no message: default service */
+    if (len < 5 || buf[0] != 0) return -1;  /* compressed frames unsupported */
+
+    mlen = ((uint32_t)buf[1] << 24) | ((uint32_t)buf[2] << 16) |
+           ((uint32_t)buf[3] << 8)  |  (uint32_t)buf[4];
+    if (mlen > (uint32_t)(len - 5)) return -1;
+    msg = buf + 5;
+
+    while (off < (int)mlen) {
+        uint8_t tag = msg[off++];
+        if (tag == 0x0A) {                  /* field 1: service */
+            int slen;
+            if (off >= (int)mlen || (msg[off] & 0x80)) return -1;
+            slen = msg[off++];
+            if (off + slen > (int)mlen) return -1;
+            if (slen == 0) return 1;
+            return (slen == 3 && memcmp(msg + off, "amf", 3) == 0);
+        }
+        return -1;                          /* HealthCheckRequest has no other fields */
+    }
+    return 1;
+}
+
+/* Frame the current HealthCheckResponse into st->out. */
+static void grpc_stream_stage(grpc_stream_t *st)
+{
+    uint8_t *m = st->out + 5;
+    int mlen;
+
+    if (st->fixed_status) {
+        m[0] = 0x08;
+        m[1] = (uint8_t)st->fixed_status;
+        mlen = 2;
+    } else {
+        mlen = amf_health_copy_response(m, GRPC_MSG_MAX - 5);
+        if (mlen < 0) mlen = 0;
+    }
+
+    st->out[0] = 0;                         /* not compressed */
+    st->out[1] = (uint8_t)(mlen >> 24);
+    st->out[2] = (uint8_t)(mlen >> 16);
+    st->out[3] = (uint8_t)(mlen >> 8);
+    st->out[4] = (uint8_t)mlen;
+    st->out_len = 5 + mlen;
+    st->out_off = 0;
+}
+
+/* Watch: does the last staged message differ from the current response
+ * (status or load_bucket moved)? */
+static int grpc_stream_stale(const grpc_stream_t *st)
+{
+    uint8_t cur[GRPC_MSG_MAX - 5];
+    int mlen;
+
+    if (st->fixed_status) return 0;
+    mlen = amf_health_copy_response(cur, sizeof(cur));
+    return mlen != st->out_len - 5 || memcmp(cur, st->out + 5, (size_t)mlen);
+}
+
+/* =========================================================
+ * nghttp2 callbacks
+ * ========================================================= */
+
+static ssize_t grpc_send_cb(nghttp2_session *session, const uint8_t *data,
+        size_t length, int flags, void *user_data)
+{
+    grpc_conn_t *conn = user_data;
+    ssize_t n;
+
+    (void)session;
+    (void)flags;
+
+    n = send(conn->fd, data, length, MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return NGHTTP2_ERR_WOULDBLOCK;
+        return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    return n;
+}
+
+static ssize_t grpc_data_read_cb(nghttp2_session *session, int32_t stream_id,
+        uint8_t *buf, size_t length, uint32_t *data_flags,
+        nghttp2_data_source *source, void *user_data)
+{
+    static const nghttp2_nv trailers[] = {
+        MAKE_NV("grpc-status", GRPC_STATUS_OK),
+    };
+    grpc_stream_t *st = source->ptr;
+    size_t n;
+
+    (void)user_data;
+
+    if (st->out_off >= st->out_len) {
+        /* Watch: response moved while the last message was in flight */
+        if (grpc_stream_stale(st)) {
+            grpc_stream_stage(st);
+        } else {
+            /* nothing new — park until amf_health_grpc_notify() */
+            st->deferred = 1;
+            return NGHTTP2_ERR_DEFERRED;
+        }
+    }
+
+    n = (size_t)(st->out_len - st->out_off);
+    if (n > length) n = length;
+    memcpy(buf, st->out + st->out_off, n);
+    st->out_off += (int)n;
+
+    if (st->out_off == st->out_len && st->call == GRPC_CALL_CHECK) {
+        /* Unary: message done, status goes in trailers */
+        *data_flags |= NGHTTP2_DATA_FLAG_EOF | NGHTTP2_DATA_FLAG_NO_END_STREAM;
+        if (nghttp2_submit_trailer(session, stream_id, trailers,
+                    sizeof(trailers) / sizeof(trailers[0])) != 0)
+            return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    return (ssize_t)n;
+}
+
+static int grpc_respond(nghttp2_session *session, grpc_stream_t *st)
+{
+    static const nghttp2_nv hdrs[] = {
+        MAKE_NV(":status", "200"),
+        MAKE_NV("content-type", "application/grpc"),
+    };
+    static const nghttp2_nv not_found[] = {
+        MAKE_NV(":status", "200"),
+        MAKE_NV("content-type", "application/grpc"),
+        MAKE_NV("grpc-status", GRPC_STATUS_NOT_FOUND),
+    };
+    static const nghttp2_nv unimplemented[] = {
+        MAKE_NV(":status", "200"),
+        MAKE_NV("content-type", "application/grpc"),
+        MAKE_NV("grpc-status", GRPC_STATUS_UNIMPLEMENTED),
+    };
+    nghttp2_data_provider prd;
+    int known;
+
+    st->responded = 1;
+
+    /* Trailers-only responses end the stream with the HEADERS frame */
+    if (st->call == GRPC_CALL_UNKNOWN)
+        return nghttp2_submit_response(session, st->id, unimplemented,
+                sizeof(unimplemented) / sizeof(unimplemented[0]), NULL);
+
+    known = grpc_service_known(st->req, st->req_len);
+    if (known <= 0) {
+        if (st->call == GRPC_CALL_CHECK)
+            return nghttp2_submit_response(session, st->id, not_found,
+                    sizeof(not_found) / sizeof(not_found[0]), NULL);
+        st->fixed_status = GRPC_SERVICE_UNKNOWN;
+    }
+
+    grpc_stream_stage(st);
+    prd.source.ptr    = st;
+    prd.read_callback = grpc_data_read_cb;
+    return nghttp2_submit_response(session, st->id, hdrs,
+            sizeof(hdrs) / sizeof(hdrs[0]), &prd);
+}
+
+static int grpc_begin_headers_cb(nghttp2_session *session,
+        const nghttp2_frame *frame, void *user_data)
+{
+    grpc_conn_t *conn = user_data;
+    grpc_stream_t *st;
+
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+        frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        return 0;
+
+    st = calloc(1, sizeof(*st));
+    if (!st) return NGHTTP2_ERR_CALLBACK_FAILURE;
+    st->conn = conn;
+    st->id   = frame->hd.stream_id;
+    st->next = conn->streams;
+    if (conn->streams) conn->streams->prev = st;
+    conn->streams = st;
+
+    nghttp2_session_set_stream_user_data(session, st->id, st);
+    return 0;
+}
+
+static int grpc_header_cb(nghttp2_session *session,
+        const nghttp2_frame *frame, const uint8_t *name, size_t namelen,
+        const uint8_t *value, size_t valuelen, uint8_t flags, void *user_data)
+{
+    grpc_stream_t *st;
+
+    (void)flags;
+    (void)user_data;
+
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+        frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        return 0;
+
+    st = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id);
+    if (!st || namelen != 5 || memcmp(name, ":path", 5) != 0)
+        return 0;
+
+    if (valuelen == sizeof(GRPC_PATH_CHECK) - 1 &&
+        memcmp(value, GRPC_PATH_CHECK, valuelen) == 0)
+        st->call = GRPC_CALL_CHECK;
+    else if (valuelen == sizeof(GRPC_PATH_WATCH) - 1 &&
+             memcmp(value, GRPC_PATH_WATCH, valuelen) == 0)
+        st->call = GRPC_CALL_WATCH;
+    return 0;
+}
+
+static int grpc_data_chunk_cb(nghttp2_session *session, uint8_t flags,
+        int32_t stream_id, const uint8_t *data, size_t len, void *user_data)
+{
+    grpc_stream_t *st;
+
+    (void)flags;
+    (void)user_data;
+
+    st = nghttp2_session_get_stream_user_data(session, stream_id);
+    if (!st) return 0;
+
+    if (st->req_len + (int)len > GRPC_REQ_MAX) {
+        st->req_len = GRPC_REQ_MAX + 1;     /* oversized → malformed */
+        return 0;
+    }
+    memcpy(st->req + st->req_len, data, len);
+    st->req_len += (int)len;
+    return 0;
+}
+
+static int grpc_frame_recv_cb(nghttp2_session *session,
+        const nghttp2_frame *frame, void *user_data)
+{
+    grpc_stream_t *st;
+
+    (void)user_data;
+
+    if (frame->hd.type != NGHTTP2_DATA && frame->hd.type != NGHTTP2_HEADERS)
+        return 0;
+    if (!(frame->hd.flags & NGHTTP2_FLAG_END_STREAM))
+        return 0;
+
+    st = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id);
+    if (!st || st->responded) return 0;
+
+    if (st->req_len > GRPC_REQ_MAX) st->req_len = GRPC_REQ_MAX;
+    if (grpc_respond(session, st) != 0)
+        return NGHTTP2_ERR_CALLBACK_FAILURE;
+    amf_health_count_probe(AMF_HEALTH_PROBE_GRPC);
+    return 0;
+}
+
+static int grpc_stream_close_cb(nghttp2_session *session, int32_t stream_id,
+        uint32_t error_code, void *user_data)
+{
+    grpc_conn_t *conn = user_data;
+    grpc_stream_t *st;
+
+    (void)error_code;
+
+    st = nghttp2_session_get_stream_user_data(session, stream_id);
+    if (!st) return 0;
+
+    if (st->prev) st->prev->next = st->next;
+    else conn->streams = st->next;
+    if (st->next) st->next->prev = st->prev;
+    free(st);
+    return 0;
+}
+
+/* =========================================================
+ * Connection management (session thread only)
+ * ========================================================= */
+
+static void grpc_conn_close(grpc_conn_t *conn)
+{
+    grpc_stream_t *st, *next;
+    int i;
+
+    /* nghttp2_session_del() does not run on_stream_close for open streams */
+    nghttp2_session_del(conn->session);
+    for (st = conn->streams; st; st = next) {
+        next = st->next;
+        free(st);
+    }
+    close(conn->fd);
+
+    /* Swap-remove; nghttp2 holds the conn pointer, so only the slot moves */
+    for (i = 0; i < grpc_nconn; i++) {
+        if (grpc_conns[i] == conn) {
+            grpc_conns[i] = grpc_conns[--grpc_nconn];
+            break;
+        }
+    }
+    free(conn);
+}
+
+static void grpc_conn_add(int fd)
+{
+    static const nghttp2_settings_entry settings[] = {
+        { NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 32 },
+    };
+    nghttp2_session_callbacks *cbs;
+    grpc_conn_t *conn;
+    int rv;
+
+    if (grpc_nconn >= grpc_max_conn) {
+        ogs_warn("[AMF-Health] gRPC: connection limit (%d) reached",
+                 grpc_max_conn);
+        close(fd);
+        return;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    conn = calloc(1, sizeof(*conn));
+    if (!conn || nghttp2_session_callbacks_new(&cbs) != 0) {
+        free(conn);
+        close(fd);
+        return;
+    }
+    conn->fd = fd;
+    nghttp2_session_callbacks_set_send_callback(cbs, grpc_send_cb);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(
+            cbs, grpc_begin_headers_cb);
+    nghttp2_session_callbacks_set_on_header_callback(cbs, grpc_header_cb);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+            cbs, grpc_data_chunk_cb);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(
+            cbs, grpc_frame_recv_cb);
+    nghttp2_session_callbacks_set_on_stream_close_callback(
+            cbs, grpc_stream_close_cb);
+
+    rv = nghttp2_session_server_new(&conn->session, cbs, conn);
+    nghttp2_session_callbacks_del(cbs);
+    if (rv != 0) {
+        free(conn);
+        close(fd);
+        return;
+    }
+
+    grpc_conns[grpc_nconn++] = conn;
+    nghttp2_submit_settings(conn->session, NGHTTP2_FLAG_NONE, settings,
+            sizeof(settings) / sizeof(settings[0]));
+}
+
+/* Queue a fresh message on every Watch stream whose status is out of date */
+static void grpc_push_watchers(void)
+{
+    int i;
+
+    for (i = 0; i < grpc_nconn; i++) {
+        grpc_conn_t *conn = grpc_conns[i];
+        grpc_stream_t *st;
+
+        for (st = conn->streams; st; st = st->next) {
+            if (st->call != GRPC_CALL_WATCH || !st->responded ||
+                !st->deferred || !grpc_stream_stale(st))
+                continue;
+            grpc_stream_stage(st);
+            st->deferred = 0;
+            nghttp2_session_resume_data(conn->session, st->id);
+        }
+    }
+}
+
+static void grpc_drain_pipe(void)
+{
+    int msg[64];
+    ssize_t n;
+    int i;
+
+    while ((n = read(grpc_pipe[0], msg, sizeof(msg))) > 0) {
+        for (i = 0; i < (int)(n / (ssize_t)sizeof(int)); i++) {
+            if (msg[i] >= 0)
+                grpc_conn_add(msg[i]);
+        }
+    }
+    /* a notify or not, re-checking watchers is cheap and never misses one */
+    grpc_push_watchers();
+}
+
+static void *grpc_session_loop(void *arg)
+{
+    struct pollfd *pfds;
+    uint8_t buf[GRPC_RECV_BUF];
+    int i;
+
+    (void)arg;
+
+    pfds = calloc((size_t)grpc_max_conn + 1, sizeof(*pfds));
+    if (!pfds) {
+        ogs_error("[AMF-Health] gRPC: out of memory");
+        return NULL;
+    }
+
+    ogs_info("[AMF-Health] gRPC health service (grpc.health.v1, h2c) ready "
+             "(max %d connections)", grpc_max_conn);
+
+    while (grpc_running) {
+        int nfds, rv;
+
+        /* Flush anything nghttp2 queued (SETTINGS, resumed Watch data) */
+        for (i = 0; i < grpc_nconn; i++)
+            nghttp2_session_send(grpc_conns[i]->session);
+
+        pfds[0].fd     = grpc_pipe[0];
+        pfds[0].events = POLLIN;
+        for (i = 0; i < grpc_nconn; i++) {
+            pfds[i + 1].fd     = grpc_conns[i]->fd;
+            pfds[i + 1].events = POLLIN;
+            if (nghttp2_session_want_write(grpc_conns[i]->session))
+                pfds[i + 1].events |= POLLOUT;
+        }
+        nfds = grpc_nconn + 1;
+
+        /* 500 ms so the loop notices amf_health_grpc_close() */
+        rv = poll(pfds, (nfds_t)nfds, 500);
+        if (rv < 0) {
+            if (errno == EINTR) continue;
+            ogs_error("[AMF-Health] gRPC poll() error: %s", strerror(errno));
+            break;
+        }
+
+        /* Walk backwards: grpc_conn_close() moves the last entry into i */
+        for (i = nfds - 2; i >= 0; i--) {
+            grpc_conn_t *conn = grpc_conns[i];
+            short re = pfds[i + 1].revents;
+            int dead = 0;
+
+            if (re & POLLIN) {
+                ssize_t n = recv(conn->fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    if (nghttp2_session_mem_recv(conn->session, buf,
+                                (size_t)n) < 0)
+                        dead = 1;
+                } else if (n == 0 ||
+                           (errno != EAGAIN && errno != EWOULDBLOCK &&
+                            errno != EINTR)) {
+                    dead = 1;
+                }
+            }
+            if (re & (POLLERR | POLLHUP | POLLNVAL))
+                dead = 1;
+            if (!dead && nghttp2_session_send(conn->session) != 0)
+                dead = 1;
+            if (!dead && !nghttp2_session_want_read(conn->session) &&
+                !nghttp2_session_want_write(conn->session))
+                dead = 1;
+            if (dead)
+                grpc_conn_close(conn);
+        }
+
+        if (rv == 0 || (pfds[0].revents & POLLIN))
+            grpc_drain_pipe();
+    }
+
+    while (grpc_nconn > 0)
+        grpc_conn_close(grpc_conns[0]);
+    free(pfds);
+
+    ogs_info("[AMF-Health] gRPC health service stopped");
+    return NULL;
+}
+
+/* =========================================================
+ * Internal API (amf-health.c)
+ * ========================================================= */
+
+int amf_health_grpc_open(int max_conn)
+{
+    if (max_conn <= 0) max_conn = 64;
+    if (max_conn > GRPC_MAX_CONN_LIMIT) max_conn = GRPC_MAX_CONN_LIMIT;
+
+    grpc_conns = calloc((size_t)max_conn, sizeof(*grpc_conns));
+    if (!grpc_conns) {
+        ogs_error("[AMF-Health] gRPC: out of memory");
+        return OGS_ERROR;
+    }
+    grpc_max_conn = max_conn;
+    grpc_nconn    = 0;
+
+    if (pipe(grpc_pipe) < 0) {
+        ogs_error("[AMF-Health] gRPC pipe() failed: %s", strerror(errno));
+        free(grpc_conns);
+        grpc_conns = NULL;
+        return OGS_ERROR;
+    }
+    fcntl(grpc_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(grpc_pipe[1], F_SETFL, O_NONBLOCK);
+
+    grpc_running = 1;
+    if (pthread_create(&grpc_thread, NULL, grpc_session_loop, NULL) != 0) {
+        ogs_error("[AMF-Health] gRPC pthread_create() failed: %s",
+                  strerror(errno));
+        grpc_running = 0;
+        close(grpc_pipe[0]);
+        close(grpc_pipe[1]);
+        grpc_pipe[0] = grpc_pipe[1] = -1;
+        free(grpc_conns);
+        grpc_conns = NULL;
+        return OGS_ERROR;
+    }
+    return OGS_OK;
+}
+
+void amf_health_grpc_close(void)
+{
+    if (!grpc_running) return;
+
+    grpc_running = 0;
+    pthread_join(grpc_thread, NULL);
+
+    close(grpc_pipe[0]);
+    close(grpc_pipe[1]);
+    grpc_pipe[0] = grpc_pipe[1] = -1;
+    free(grpc_conns);
+    grpc_conns = NULL;
+    ogs_info("[AMF-Health] gRPC health service closed");
+}
+
+void amf_health_grpc_handoff(int fd)
+{
+    if (!grpc_running ||
+        write(grpc_pipe[1], &fd, sizeof(fd)) != (ssize_t)sizeof(fd))
+        close(fd);
+}
+
+void amf_health_grpc_notify(void)
+{
+    int msg = GRPC_PIPE_NOTIFY;
+
+    /* A full pipe already guarantees a wake-up; dropping is fine */
+    if (grpc_running && write(grpc_pipe[1], &msg, sizeof(msg)) < 0)
+        ogs_debug("[AMF-Health] gRPC notify dropped: %s", strerror(errno));
+}
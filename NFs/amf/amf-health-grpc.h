@@ -0,0 +1,51 @@
+/*
+ * AMF gRPC Health Service (grpc.health.v1) — internal interface
+ *
+ * Cleartext HTTP/2 (h2c, prior knowledge) on the health TCP port.  The
+ * accept loop in amf-health.c sniffs the first byte of every connection:
+ * an HTTP/2 client preface starts with 'P' (0x50), which is never a valid
+ * raw length prefix (requests are < 64 bytes), so the connection is handed
+ * to the gRPC session thread instead of being answered raw.
+ *
+ *   /grpc.health.v1.Health/Check   unary, status from the cached response
+ *   /grpc.health.v1.Health/Watch   server-streaming, one message now and
+ *                                  one on every status / load_bucket
+ *                                  change
+ *
+ * Service names "" and "amf" are known; anything else is NOT_FOUND
+ * (Check) or SERVICE_UNKNOWN (Watch), as in the grpc.health.v1 spec.
+ *
+ * The response message is the cached HealthCheckResponse from
+ * amf-health.c.  Its first field (status = 1) is exactly
+ * grpc.health.v1.HealthCheckResponse; node_type / ip / port are unknown
+ * fields that standard clients skip.
+ *
+ * Configuration (env vars read at amf_health_open() time):
+ *   AMF_GRPC_ENABLE          1|0  (default: 0, needs AMF_TCP_ENABLE=1)
+ *   AMF_GRPC_MAX_CONN        concurrent HTTP/2 connections (default: 64)
+ */
+
+#ifndef AMF_HEALTH_GRPC_H
+#define AMF_HEALTH_GRPC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Start / stop the HTTP/2 session thread. */
+int  amf_health_grpc_open(int max_conn);
+void amf_health_grpc_close(void);
+
+/* Accept loop → session thread: take ownership of an h2c connection.
+ * Closes the fd if the session thread cannot accept it. */
+void amf_health_grpc_handoff(int fd);
+
+/* Monitor → session thread: status or load bucket changed, push to
+ * Watch streams. */
+void amf_health_grpc_notify(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AMF_HEALTH_GRPC_H */
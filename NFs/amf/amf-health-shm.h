@@ -0,0 +1,97 @@
+/*
+ * amf-health-shm.h — layout of the AMF shared-memory health page.
+ *
+ * The AMF health monitor (amf-health.c) publishes its snapshot into a
+ * memory-mapped file so same-host readers (docker healthcheck, sidecars,
+ * tests) can poll it without any syscall beyond the initial mmap():
+ *
+ *   /dev/shm/open5gs-amf-health   (AMF_HEALTH_SHM_PATH)
+ *
+ * Concurrency: single writer (the monitor thread), any number of readers,
+ * synchronised with a seqlock.  The writer makes `seq` odd, updates the
+ * body, then makes it even again.  Readers copy the page and retry if
+ * `seq` was odd or changed during the copy — see amf_health_page_read().
+ *
+ * Times are CLOCK_MONOTONIC nanoseconds (comparable across processes on
+ * the same host) plus one CLOCK_REALTIME stamp for humans.
+ */
+
+#ifndef AMF_HEALTH_SHM_H
+#define AMF_HEALTH_SHM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AMF_HEALTH_SHM_MAGIC        0x4d48354fU     /* "O5HM" */
+#define AMF_HEALTH_SHM_VERSION      1
+#define AMF_HEALTH_SHM_SIZE         4096
+#define AMF_HEALTH_SHM_DEFAULT_PATH "/dev/shm/open5gs-amf-health"
+
+/* ServingStatus values (open5gs_amf.proto) */
+#define AMF_HEALTH_UNKNOWN          0
+#define AMF_HEALTH_SERVING          1
+#define AMF_HEALTH_NOT_SERVING      2
+
+typedef struct amf_health_page_s {
+    /* ── header: written once at open ── */
+    uint32_t magic;             /* AMF_HEALTH_SHM_MAGIC */
+    uint32_t version;           /* AMF_HEALTH_SHM_VERSION */
+    uint32_t seq;               /* seqlock version: odd = update in progress */
+    uint32_t pid;               /* open5gs-amfd PID */
+
+    /* ── body: protected by seq ── */
+    uint32_t status;            /* AMF_HEALTH_SERVING / _NOT_SERVING */
+    uint32_t node_type;         /* always AMF(13) */
+    uint64_t heartbeat_ns;      /* last AMF main-loop iteration (monotonic) */
+    uint64_t published_ns;      /* last monitor publish (monotonic) */
+    uint64_t published_unix_ms; /* last monitor publish (wall clock) */
+    uint32_t stall_ms;          /* heartbeat age that flips to NOT_SERVING */
+    uint32_t tick_ms;           /* monitor publish interval */
+
+    /* load counters, sampled on the AMF thread */
+    uint32_t gnbs;              /* connected gNBs */
+    uint32_t amf_ues;           /* AMF UE contexts */
+    uint32_t ran_ues;           /* RAN UE contexts (NGAP UE associations) */
+    uint32_t reserved0;
+
+    /* probe counters */
+    uint64_t tcp_probes;        /* TCP health requests answered */
+    uint64_t udp_probes;        /* UDP fast-probes answered */
+    uint64_t status_changes;    /* SERVING <-> NOT_SERVING transitions */
+    uint64_t grpc_probes;       /* grpc.health.v1 Check/Watch calls */
+} amf_health_page_t;
+
+/*
+ * Lock-free consistent read of a mapped page into *out.
+ * Returns 0 on success, -1 if the page is not a valid health page or the
+ * writer kept it busy for too long.
+ */
+static inline int amf_health_page_read(
+        const volatile amf_health_page_t *page, amf_health_page_t *out)
+{
+    int tries;
+
+    if (page->magic != AMF_HEALTH_SHM_MAGIC ||
+        page->version != AMF_HEALTH_SHM_VERSION)
+        return -1;
+
+    for (tries = 0; tries < 1000; tries++) {
+        uint32_t s1 = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) continue;
+        memcpy(out, (const void *)page, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == s1)
+            return 0;
+    }
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AMF_HEALTH_SHM_H */
@@ -2,15 +2,30 @@
  * AMF TCP Health Check Server & Registration Client
  *
  * Wire-format compatible with the free5GC AMF gRPC health check.
+ * Also runs the health monitor that derives SERVING / NOT_SERVING from the
+ * AMF main-loop heartbeat and publishes it to the shared-memory page.
  *
  * See amf-health.h for the full description and configuration env vars.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE             /* recvmmsg() / sendmmsg() */
+#endif
+
 #include "ogs-app.h"
+#include "context.h"
 #include "amf-health.h"
+#include "amf-health-shm.h"
+#include "amf-health-grpc.h"
+#include "amf-evstream.h"
 
 #include <pthread.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -92,6 +107,11 @@ static int              server_fd      = -1;
 static pthread_t        server_thread;
 static volatile int     server_running = 0;
 
+/* UDP fast-probe listener (optional, see AMF_UDP_ENABLE) */
+static int              udp_fd         = -1;
+static pthread_t        udp_thread;
+static volatile int     udp_running    = 0;
+
 /* Advertised IP / port stored at open time (for health response + registration) */
 static char     g_bind_addr[64]     = "0.0.0.0";
 static char     g_advertise_ip[64]  = "0.0.0.0";
@@ -102,6 +122,78 @@ static int      g_reg_enable        = 0;
 static char     g_reg_server_ip[64] = "";
 static uint16_t g_reg_server_port   = 0;
 
+/* UDP fast-probe config */
+static int      g_udp_enable        = 0;
+static uint16_t g_udp_port          = 0;     /* 0 → same as g_port */
+static int      g_udp_batch         = 32;
+
+/* gRPC health service config (amf-health-grpc.c) */
+static int      g_grpc_enable       = 0;
+static int      g_grpc_max_conn     = 64;
+
+/* HealthCheckResponse bytes, encoded once in amf_health_open() and shared
+ * by the TCP and UDP listeners.  Only the status byte changes afterwards;
+ * the monitor thread rewrites it in place (RESP_STATUS_OFFSET). */
+static uint8_t  g_resp_buf[256];
+static int      g_resp_len          = 0;
+static int      g_resp_load_off     = 0;     /* offset of the load_bucket value */
+#define RESP_STATUS_OFFSET  1
+
+/* Health monitor + shared-memory page (see amf-health-shm.h) */
+static pthread_t        monitor_thread;
+static volatile int     monitor_running = 0;
+static int              g_shm_enable    = 1;
+static char             g_shm_path[128] = AMF_HEALTH_SHM_DEFAULT_PATH;
+static amf_health_page_t *g_page        = NULL;
+static int              g_tick_ms       = 250;
+static int              g_stall_ms      = 2000;
+static uint32_t         g_status        = AMF_HEALTH_SERVING;
+static uint32_t         g_load_bucket   = 0;
+static int              g_load_step     = 100;
+
+/* Fault injection (AMF_HEALTH_FAULT_INJECT): the monitor picks up a stall
+ * request from g_fault_path, the AMF thread then sleeps inside the loop */
+static int              g_fault_enable  = 0;
+static char             g_fault_path[128] = "/dev/shm/open5gs-amf-stall";
+static uint32_t         g_inject_stall_ms = 0;
+
+/* Watch subscribers: raw TCP connections pushed by the monitor thread,
+ * and eventfds handed to other threads (cnode session) */
+#define WATCH_MAX           64
+typedef struct tcp_watcher_s {
+    int         fd;
+    uint32_t    min_interval_ms;
+    uint64_t    last_sent_ns;
+    uint8_t     last_status;
+    uint8_t     last_load;
+} tcp_watcher_t;
+
+static pthread_mutex_t  g_watch_lock    = PTHREAD_MUTEX_INITIALIZER;
+static tcp_watcher_t    g_watchers[WATCH_MAX];
+static int              g_nwatchers     = 0;
+static int              g_watch_efds[WATCH_MAX];
+static int              g_nwatch_efds   = 0;
+
+/* Written by the AMF thread (amf_health_heartbeat), read by the monitor */
+static uint64_t         g_heartbeat_ns  = 0;
+static uint64_t         g_sample_ns     = 0;
+static uint32_t         g_gnbs          = 0;
+static uint32_t         g_amf_ues       = 0;
+static uint32_t         g_ran_ues       = 0;
+
+/* Written by the listener threads, read by the monitor */
+static uint64_t         g_tcp_probes    = 0;
+static uint64_t         g_udp_probes    = 0;
+static uint64_t         g_grpc_probes   = 0;
+static uint64_t         g_status_changes = 0;
+
+static uint64_t clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
 /* =========================================================
  * HealthCheckResponse wire encoding (built dynamically)
  *
@@ -111,20 +203,23 @@ static uint16_t g_reg_server_port   = 0;
  *     NodeType      node_type = 2;   // tag 0x10
  *     string        ip        = 3;   // tag 0x1A (length-delimited)
  *     uint32        port      = 4;   // tag 0x20
+ *     uint32        load_bucket = 6; // tag 0x30  (AMF UEs / AMF_HEALTH_LOAD_STEP)
  *   }
  *
- * Fields 1+2 are fixed; fields 3+4 are encoded from g_advertise_ip / g_port
- * at connection time so clients get full AMF identity + reachability info.
+ * Field 2 is fixed; fields 3+4 are encoded from g_advertise_ip / g_port
+ * so clients get full AMF identity + reachability info.  Field 1 always
+ * sits at RESP_STATUS_OFFSET and field 6 at g_resp_load_off (single-byte
+ * varint, capped at 127) so the monitor can patch both without re-encoding.
  * ========================================================= */
 static int build_health_response(uint8_t *buf, int bufsz)
 {
     int offset = 0;
     int vn;
 
-    /* field 1: status = SERVING(1) */
+    /* field 1: status (current monitor verdict, patched in place later) */
     if (offset + 2 > bufsz) return -1;
     buf[offset++] = 0x08;
-    buf[offset++] = 0x01;
+    buf[offset++] = (uint8_t)g_status;
 
     /* field 2: node_type = AMF(13) */
     if (offset + 2 > bufsz) return -1;
@@ -150,9 +245,100 @@ static int build_health_response(uint8_t *buf, int bufsz)
     if (vn < 0) return -1;
     offset += vn;
 
+    /* field 6: load_bucket (varint, always one byte) */
+    if (offset + 2 > bufsz) return -1;
+    buf[offset++] = 0x30;  /* tag: field 6, wire type 0 */
+    g_resp_load_off = offset;
+    buf[offset++] = (uint8_t)g_load_bucket;
+
     return offset;
 }
 
+/* =========================================================
+ * HealthCheckRequest decoding
+ *
+ *   message HealthCheckRequest {
+ *     string  service         = 1;   // tag 0x0A
+ *     fixed64 nonce           = 2;   // tag 0x11 (UDP fast-probe)
+ *     bool    watch           = 3;   // tag 0x18 (TCP / cnode subscribe)
+ *     uint32  min_interval_ms = 4;   // tag 0x20 (watch rate limit)
+ *   }
+ * ========================================================= */
+int amf_health_parse_request(const uint8_t *buf, int len,
+        amf_health_request_t *req)
+{
+    int off = 0;
+
+    memset(req, 0, sizeof(*req));
+
+    while (off < len) {
+        uint8_t tag = buf[off++];
+        switch (tag & 0x07) {
+        case 0: {                               /* varint */
+            uint64_t v = 0;
+            int shift = 0;
+            while (off < len && (buf[off] & 0x80) && shift < 63) {
+                v |= (uint64_t)(buf[off++] & 0x7F) << shift;
+                shift += 7;
+            }
+            if (off >= len) return -1;
+            v |= (uint64_t)buf[off++] << shift;
+            if (tag == 0x18)                    /* field 3: watch */
+                req->watch = v ? 1 : 0;
+            else if (tag == 0x20)               /* field 4: min_interval_ms */
+                req->min_interval_ms = v > 3600000 ? 3600000 : (uint32_t)v;
+            break;
+        }
+        case 1:                                 /* fixed64 */
+            if (off + 8 > len) return -1;
+            if (tag == 0x11) {                  /* field 2: nonce */
+                memcpy(req->nonce, buf + off, 8);
+                req->has_nonce = 1;
+            }
+            off += 8;
+            break;
+        case 2:                                 /* length-delimited */
+            /* service names are short: single-byte length only */
+            if (off >= len || (buf[off] & 0x80)) return -1;
+            off += 1 + buf[off];
+            if (off > len) return -1;
+            break;
+        case 5:                                 /* fixed32 */
+            off += 4;
+            if (off > len) return -1;
+            break;
+        default:
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Register a subscribed raw-TCP connection with the monitor (takes fd).
+ * status/load are what the reply carried, so a transition since then is
+ * pushed on the next monitor tick. */
+static void tcp_watch_add(int cfd, uint32_t min_interval_ms,
+                          uint8_t status, uint8_t load)
+{
+    tcp_watcher_t *w;
+
+    pthread_mutex_lock(&g_watch_lock);
+    if (g_nwatchers >= WATCH_MAX) {
+        pthread_mutex_unlock(&g_watch_lock);
+        ogs_warn("[AMF-Health] watch limit (%d) reached; closing subscriber",
+                 WATCH_MAX);
+        close(cfd);
+        return;
+    }
+    w = &g_watchers[g_nwatchers++];
+    w->fd              = cfd;
+    w->min_interval_ms = min_interval_ms;
+    w->last_sent_ns    = clock_ns(CLOCK_MONOTONIC);
+    w->last_status     = status;
+    w->last_load       = load;
+    pthread_mutex_unlock(&g_watch_lock);
+}
+
 /* =========================================================
  * Per-connection handler (called from accept loop)
  * ========================================================= */
@@ -160,15 +346,37 @@ static void handle_connection(int cfd)
 {
     /* Give the client 500 ms to send a HealthCheckRequest.
      * A plain TCP probe (k8s liveness, load-balancers) that sends nothing
-     * will still receive a SERVING response once the deadline fires. */
+     * will still receive the current status once the deadline fires. */
     struct timeval tv;
     tv.tv_sec  = 0;
     tv.tv_usec = 500000;
     setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 
+    /* HTTP/2 client preface ("PRI * HTTP/2.0...") starts with 'P' (0x50);
+     * a raw request never does, its varint length is < 64.  Hand gRPC
+     * clients to the session thread without consuming anything. */
+    int peeked = 1;
+    if (g_grpc_enable) {
+        uint8_t first;
+        peeked = (int)recv(cfd, &first, 1, MSG_PEEK);
+        if (peeked == 1 && first == 'P') {
+            struct timeval tv_none = { 0, 0 };
+            setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv_none, sizeof(tv_none));
+            amf_health_grpc_handoff(cfd);
+            return;
+        }
+    }
+
     uint8_t req_buf[64];
-    /* Ignore the HealthCheckRequest payload; we always reply SERVING */
-    read_delimited(cfd, req_buf, (int)sizeof(req_buf));
+    amf_health_request_t req;
+    int req_len = -1;
+    /* The reply carries the monitor's current verdict; the request only
+     * matters for watch.  Skip the read if the peek already waited out
+     * the deadline. */
+    if (peeked == 1)
+        req_len = read_delimited(cfd, req_buf, (int)sizeof(req_buf));
+    if (req_len < 0 || amf_health_parse_request(req_buf, req_len, &req) < 0)
+        memset(&req, 0, sizeof(req));
 
     /* Clear the read deadline before writing */
     struct timeval tv_zero;
@@ -176,11 +384,21 @@ static void handle_connection(int cfd)
     tv_zero.tv_usec = 0;
     setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv_zero, sizeof(tv_zero));
 
-    /* Build dynamic response: status + node_type + ip + port */
-    uint8_t resp_buf[256];
-    int resp_len = build_health_response(resp_buf, (int)sizeof(resp_buf));
-    if (resp_len > 0)
-        write_delimited(cfd, resp_buf, resp_len);
+    /* Cached response: status + node_type + ip + port + load_bucket.
+     * A watch request keeps the connection: the monitor pushes the same
+     * framing again on every transition until the client closes. */
+    uint8_t resp[sizeof(g_resp_buf)];
+    int resp_len;
+
+    amf_health_count_probe(AMF_HEALTH_PROBE_TCP);
+    resp_len = amf_health_copy_response(resp, (int)sizeof(resp));
+    if (resp_len > 0 &&
+        write_delimited(cfd, resp, resp_len) == 0 &&
+        req.watch && monitor_running) {
+        tcp_watch_add(cfd, req.min_interval_ms,
+                      resp[RESP_STATUS_OFFSET], resp[g_resp_load_off]);
+        return;
+    }
     close(cfd);
 }
 
@@ -212,20 +430,580 @@ static void *health_server_loop(void *arg)
     return NULL;
 }
 
+/* =========================================================
+ * UDP fast-probe listener (runs in udp_thread)
+ *
+ * One datagram in, one datagram out — no handshake, no length prefix:
+ *
+ *   request:  HealthCheckRequest  { service = 1; nonce = 2 (fixed64) }
+ *   response: <cached HealthCheckResponse> + { nonce = 5 (fixed64) }
+ *
+ * The nonce is copied verbatim so a collector probing thousands of
+ * endpoints can match replies to probes and drop spoofed or stale ones.
+ * A request without a nonce is dropped: the listener never answers
+ * a datagram that cannot be matched, so it is no reflector for spoofed
+ * sources.
+ *
+ * Probes are drained with recvmmsg() and answered with one sendmmsg()
+ * per batch, so a burst of N probes costs two syscalls, not 2N.
+ * ========================================================= */
+#define UDP_BATCH_MAX       64
+#define UDP_REQ_MAX         64
+#define NONCE_FIELD_LEN     9       /* tag 0x29 + 8 bytes little-endian */
+
+static void *health_udp_loop(void *arg)
+{
+    struct mmsghdr      rx[UDP_BATCH_MAX], tx[UDP_BATCH_MAX];
+    struct iovec        rx_iov[UDP_BATCH_MAX], tx_iov[UDP_BATCH_MAX];
+    struct sockaddr_in  peer[UDP_BATCH_MAX];
+    uint8_t             req[UDP_BATCH_MAX][UDP_REQ_MAX];
+    uint8_t             resp[UDP_BATCH_MAX][sizeof(g_resp_buf) + NONCE_FIELD_LEN];
+    int                 batch = g_udp_batch;
+    int                 i;
+
+    (void)arg;
+    ogs_info("[AMF-Health] UDP fast-probe listening on %s:%u (batch %d)",
+             g_bind_addr, (unsigned)g_udp_port, batch);
+
+    while (udp_running) {
+        int n, out = 0;
+
+        for (i = 0; i < batch; i++) {
+            rx_iov[i].iov_base = req[i];
+            rx_iov[i].iov_len  = UDP_REQ_MAX;
+            memset(&rx[i].msg_hdr, 0, sizeof(rx[i].msg_hdr));
+            rx[i].msg_hdr.msg_name    = &peer[i];
+            rx[i].msg_hdr.msg_namelen = sizeof(peer[i]);
+            rx[i].msg_hdr.msg_iov     = &rx_iov[i];
+            rx[i].msg_hdr.msg_iovlen  = 1;
+        }
+
+        /* Block for the first datagram (SO_RCVTIMEO lets us re-check
+         * udp_running), then take whatever else is already queued. */
+        n = recvmmsg(udp_fd, rx, (unsigned int)batch, MSG_WAITFORONE, NULL);
+        if (n < 0) {
+            if (!udp_running) break;
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+                continue;
+            if (errno == EBADF) break;
+            ogs_error("[AMF-Health] recvmmsg() error: %s", strerror(errno));
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            amf_health_request_t probe;
+            int     len = g_resp_len;
+
+            if (rx[i].msg_hdr.msg_flags & MSG_TRUNC) continue;
+            if (amf_health_parse_request(req[i], (int)rx[i].msg_len,
+                                         &probe) < 0)
+                continue;                       /* not a HealthCheckRequest */
+            if (!probe.has_nonce)
+                continue;                       /* nothing to match: drop */
+
+            memcpy(resp[out], g_resp_buf, (size_t)len);
+            resp[out][len++] = 0x29;            /* field 5, wire type 1 */
+            memcpy(resp[out] + len, probe.nonce, 8);
+            len += 8;
+
+            tx_iov[out].iov_base = resp[out];
+            tx_iov[out].iov_len  = (size_t)len;
+            memset(&tx[out].msg_hdr, 0, sizeof(tx[out].msg_hdr));
+            tx[out].msg_hdr.msg_name    = &peer[i];
+            tx[out].msg_hdr.msg_namelen = rx[i].msg_hdr.msg_namelen;
+            tx[out].msg_hdr.msg_iov     = &tx_iov[out];
+            tx[out].msg_hdr.msg_iovlen  = 1;
+            out++;
+        }
+
+        if (out > 0 && sendmmsg(udp_fd, tx, (unsigned int)out, 0) < 0)
+            ogs_debug("[AMF-Health] sendmmsg() error: %s", strerror(errno));
+        if (out > 0)
+            __atomic_fetch_add(&g_udp_probes, (uint64_t)out, __ATOMIC_RELAXED);
+    }
+
+    ogs_info("[AMF-Health] UDP fast-probe stopped");
+    return NULL;
+}
+
+static int udp_server_open(void)
+{
+    int fd;
+    int opt;
+    struct sockaddr_in addr;
+    struct timeval tv;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        ogs_error("[AMF-Health] UDP socket() failed: %s", strerror(errno));
+        return OGS_ERROR;
+    }
+
+    opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    /* 500 ms receive timeout so the loop notices amf_health_close() */
+    tv.tv_sec  = 0;
+    tv.tv_usec = 500000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(g_udp_port);
+    inet_pton(AF_INET, g_bind_addr, &addr.sin_addr);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ogs_error("[AMF-Health] UDP bind(%s:%u) failed: %s",
+                  g_bind_addr, (unsigned)g_udp_port, strerror(errno));
+        close(fd);
+        return OGS_ERROR;
+    }
+
+    udp_fd = fd;
+    udp_running = 1;
+
+    if (pthread_create(&udp_thread, NULL, health_udp_loop, NULL) != 0) {
+        ogs_error("[AMF-Health] UDP pthread_create() failed: %s",
+                  strerror(errno));
+        udp_running = 0;
+        close(udp_fd);
+        udp_fd = -1;
+        return OGS_ERROR;
+    }
+
+    return OGS_OK;
+}
+
+static void udp_server_close(void)
+{
+    if (udp_fd < 0) return;
+
+    udp_running = 0;
+    pthread_join(udp_thread, NULL);
+    close(udp_fd);
+    udp_fd = -1;
+    ogs_info("[AMF-Health] UDP fast-probe closed");
+}
+
+/* =========================================================
+ * Health monitor + shared-memory page (runs in monitor_thread)
+ *
+ * The AMF main loop stamps g_heartbeat_ns on every iteration
+ * (amf_health_heartbeat).  Every tick the monitor:
+ *
+ *   1. wakes the AMF pollset, so an idle but healthy AMF still beats;
+ *   2. flips the cached response to NOT_SERVING when the last beat is
+ *      older than AMF_HEALTH_STALL_MS (AMF thread wedged), and back;
+ *   3. publishes status + load + probe counters to the shm page.
+ *
+ * It is the only writer of the page, so the seqlock needs no mutex.
+ * ========================================================= */
+static int shm_page_open(void)
+{
+    int fd;
+    void *p;
+
+    fd = open(g_shm_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        ogs_error("[AMF-Health] open(%s) failed: %s",
+                  g_shm_path, strerror(errno));
+        return OGS_ERROR;
+    }
+    if (ftruncate(fd, AMF_HEALTH_SHM_SIZE) < 0) {
+        ogs_error("[AMF-Health] ftruncate(%s) failed: %s",
+                  g_shm_path, strerror(errno));
+        close(fd);
+        return OGS_ERROR;
+    }
+    p = mmap(NULL, AMF_HEALTH_SHM_SIZE, PROT_READ | PROT_WRITE,
+             MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        ogs_error("[AMF-Health] mmap(%s) failed: %s",
+                  g_shm_path, strerror(errno));
+        return OGS_ERROR;
+    }
+
+    /* A page left by a previous AMF keeps its seq counter so a reader
+     * holding the old mapping never sees the version go backwards.
+     * magic is written last: readers ignore the page until it is valid. */
+    g_page = p;
+    __atomic_store_n(&g_page->magic, 0, __ATOMIC_RELEASE);
+    if (g_page->seq & 1) g_page->seq++;
+    g_page->version  = AMF_HEALTH_SHM_VERSION;
+    g_page->pid      = (uint32_t)getpid();
+    __atomic_store_n(&g_page->magic, AMF_HEALTH_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    ogs_info("[AMF-Health] Shared-memory health page at %s", g_shm_path);
+    return OGS_OK;
+}
+
+static void shm_page_publish(uint64_t now_ns)
+{
+    amf_health_page_t *pg = g_page;
+
+    if (!pg) return;
+
+    __atomic_store_n(&pg->seq, pg->seq + 1, __ATOMIC_RELAXED);   /* odd */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    pg->status            = g_status;
+    pg->node_type         = 13;
+    pg->heartbeat_ns      = __atomic_load_n(&g_heartbeat_ns, __ATOMIC_RELAXED);
+    pg->published_ns      = now_ns;
+    pg->published_unix_ms = clock_ns(CLOCK_REALTIME) / 1000000ULL;
+    pg->stall_ms          = (uint32_t)g_stall_ms;
+    pg->tick_ms           = (uint32_t)g_tick_ms;
+    pg->gnbs              = __atomic_load_n(&g_gnbs, __ATOMIC_RELAXED);
+    pg->amf_ues           = __atomic_load_n(&g_amf_ues, __ATOMIC_RELAXED);
+    pg->ran_ues           = __atomic_load_n(&g_ran_ues, __ATOMIC_RELAXED);
+    pg->tcp_probes        = __atomic_load_n(&g_tcp_probes, __ATOMIC_RELAXED);
+    pg->udp_probes        = __atomic_load_n(&g_udp_probes, __ATOMIC_RELAXED);
+    pg->status_changes    = g_status_changes;
+    pg->grpc_probes       = __atomic_load_n(&g_grpc_probes, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&pg->seq, pg->seq + 1, __ATOMIC_RELEASE);   /* even */
+}
+
+/*
+ * Push the current response to raw-TCP watchers whose last push is out of
+ * date, honouring each watcher's min_interval_ms; drop closed or stuck
+ * subscribers.  A rate-limited transition is not lost: the next tick
+ * re-checks and sends the then-current state.
+ */
+static void watch_push_tcp(uint64_t now_ns)
+{
+    uint8_t status = __atomic_load_n(&g_resp_buf[RESP_STATUS_OFFSET],
+                                     __ATOMIC_RELAXED);
+    uint8_t load   = __atomic_load_n(&g_resp_buf[g_resp_load_off],
+                                     __ATOMIC_RELAXED);
+    uint8_t frame[1 + sizeof(g_resp_buf)];
+    int     flen, i;
+
+    /* [varint N][HealthCheckResponse], N < 128 */
+    frame[0] = (uint8_t)g_resp_len;
+    memcpy(frame + 1, g_resp_buf, (size_t)g_resp_len);
+    frame[1 + RESP_STATUS_OFFSET] = status;
+    frame[1 + g_resp_load_off]    = load;
+    flen = 1 + g_resp_len;
+
+    pthread_mutex_lock(&g_watch_lock);
+    for (i = g_nwatchers - 1; i >= 0; i--) {
+        tcp_watcher_t *w = &g_watchers[i];
+        uint8_t scratch[64];
+        ssize_t n;
+        int drop = 0;
+
+        /* EOF / reset from the collector ends the subscription */
+        n = recv(w->fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            drop = 1;
+
+        if (!drop && (w->last_status != status || w->last_load != load) &&
+            now_ns - w->last_sent_ns >=
+                (uint64_t)w->min_interval_ms * 1000000ULL) {
+            if (send(w->fd, frame, (size_t)flen,
+                     MSG_DONTWAIT | MSG_NOSIGNAL) != (ssize_t)flen) {
+                drop = 1;               /* dead or not reading: no backlog */
+            } else {
+                w->last_sent_ns = now_ns;
+                w->last_status  = status;
+                w->last_load    = load;
+            }
+        }
+
+        if (drop) {
+            close(w->fd);
+            g_watchers[i] = g_watchers[--g_nwatchers];
+        }
+    }
+    pthread_mutex_unlock(&g_watch_lock);
+}
+
+/* Wake every amf_health_watch_open() eventfd */
+static void watch_notify_efds(void)
+{
+    uint64_t one = 1;
+    int i;
+
+    pthread_mutex_lock(&g_watch_lock);
+    for (i = 0; i < g_nwatch_efds; i++) {
+        if (write(g_watch_efds[i], &one, sizeof(one)) < 0)
+            ogs_debug("[AMF-Health] watch notify: %s", strerror(errno));
+    }
+    pthread_mutex_unlock(&g_watch_lock);
+}
+
+/*
+ * Apply the current verdict.  Returns 1 if status or load bucket changed
+ * (the response bytes were patched and watchers must be told).
+ */
+static int monitor_update(uint32_t status, uint32_t bucket, uint64_t age_ms)
+{
+    int changed = 0;
+
+    if (status != g_status) {
+        __atomic_store_n(&g_status, status, __ATOMIC_RELAXED);
+        g_status_changes++;
+        __atomic_store_n(&g_resp_buf[RESP_STATUS_OFFSET], (uint8_t)status,
+                         __ATOMIC_RELAXED);
+        changed = 1;
+
+        if (status == AMF_HEALTH_SERVING)
+            ogs_info("[AMF-Health] AMF main loop recovered → SERVING");
+        else
+            ogs_warn("[AMF-Health] AMF main loop stalled for %llums → NOT_SERVING",
+                     (unsigned long long)age_ms);
+    }
+
+    if (bucket != g_load_bucket) {
+        ogs_debug("[AMF-Health] load bucket %u → %u", g_load_bucket, bucket);
+        g_load_bucket = bucket;
+        __atomic_store_n(&g_resp_buf[g_resp_load_off], (uint8_t)bucket,
+                         __ATOMIC_RELAXED);
+        changed = 1;
+    }
+
+    if (changed)
+        amf_evstream_health(status, bucket);
+    return changed;
+}
+
+/* AMF_HEALTH_FAULT_INJECT: `echo <ms> > $AMF_HEALTH_FAULT_PATH` stalls the
+ * AMF main loop for <ms>.  The file is consumed on pickup. */
+static void fault_poll(void)
+{
+    char buf[32];
+    ssize_t n;
+    int fd;
+
+    fd = open(g_fault_path, O_RDONLY);
+    if (fd < 0) return;
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    unlink(g_fault_path);
+    if (n <= 0) return;
+
+    buf[n] = '\0';
+    if (atoi(buf) > 0) {
+        ogs_warn("[AMF-Health] Fault injection: stalling AMF main loop "
+                 "for %dms", atoi(buf));
+        __atomic_store_n(&g_inject_stall_ms, (uint32_t)atoi(buf),
+                         __ATOMIC_RELAXED);
+        /* wake the loop so the stall starts now, not at its next timer */
+        ogs_pollset_notify(ogs_app()->pollset);
+    }
+}
+
+static void *health_monitor_loop(void *arg)
+{
+    struct timespec tick;
+
+    (void)arg;
+    tick.tv_sec  = g_tick_ms / 1000;
+    tick.tv_nsec = (long)(g_tick_ms % 1000) * 1000000L;
+
+    ogs_info("[AMF-Health] Monitor started (tick %dms, stall %dms)",
+             g_tick_ms, g_stall_ms);
+
+    while (monitor_running) {
+        uint64_t now = clock_ns(CLOCK_MONOTONIC);
+        uint64_t hb  = __atomic_load_n(&g_heartbeat_ns, __ATOMIC_RELAXED);
+        uint64_t age_ms = now > hb ? (now - hb) / 1000000ULL : 0;
+        uint32_t ues = __atomic_load_n(&g_amf_ues, __ATOMIC_RELAXED);
+        uint32_t bucket = ues / (uint32_t)g_load_step;
+
+        if (bucket > 127) bucket = 127;
+        if (monitor_update(age_ms > (uint64_t)g_stall_ms ?
+                           AMF_HEALTH_NOT_SERVING : AMF_HEALTH_SERVING,
+                           bucket, age_ms)) {
+            amf_health_grpc_notify();
+            watch_notify_efds();
+        }
+        watch_push_tcp(now);
+        shm_page_publish(now);
+
+        if (g_fault_enable)
+            fault_poll();
+
+        ogs_pollset_notify(ogs_app()->pollset);
+        nanosleep(&tick, NULL);
+    }
+
+    ogs_info("[AMF-Health] Monitor stopped");
+    return NULL;
+}
+
+void amf_health_heartbeat(void)
+{
+    uint64_t now;
+    amf_gnb_t *gnb = NULL;
+    uint32_t ran_ues = 0;
+
+    if (!monitor_running) return;
+
+    if (__atomic_load_n(&g_inject_stall_ms, __ATOMIC_RELAXED)) {
+        uint32_t ms = __atomic_exchange_n(&g_inject_stall_ms, 0,
+                                          __ATOMIC_RELAXED);
+        struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+        nanosleep(&ts, NULL);           /* AMF thread: a real stall */
+    }
+
+    now = clock_ns(CLOCK_MONOTONIC);
+    __atomic_store_n(&g_heartbeat_ns, now, __ATOMIC_RELAXED);
+
+    /* Load counters walk the context lists: sample once per tick, not on
+     * every loop iteration.  Only the AMF thread touches g_sample_ns. */
+    if (now - g_sample_ns < (uint64_t)g_tick_ms * 1000000ULL) return;
+    g_sample_ns = now;
+
+    ogs_list_for_each(&amf_self()->gnb_list, gnb)
+        ran_ues += (uint32_t)ogs_list_count(&gnb->ran_ue_list);
+
+    __atomic_store_n(&g_gnbs,
+            (uint32_t)ogs_list_count(&amf_self()->gnb_list), __ATOMIC_RELAXED);
+    __atomic_store_n(&g_amf_ues,
+            (uint32_t)ogs_list_count(&amf_self()->amf_ue_list),
+            __ATOMIC_RELAXED);
+    __atomic_store_n(&g_ran_ues, ran_ues, __ATOMIC_RELAXED);
+}
+
+int amf_health_status(void)
+{
+    return (int)__atomic_load_n(&g_status, __ATOMIC_RELAXED);
+}
+
+int amf_health_copy_response(uint8_t *buf, int bufsz)
+{
+    int len = g_resp_len;
+
+    if (len <= 0 || len > bufsz) return -1;
+    memcpy(buf, g_resp_buf, (size_t)len);
+    buf[RESP_STATUS_OFFSET] =
+        __atomic_load_n(&g_resp_buf[RESP_STATUS_OFFSET], __ATOMIC_RELAXED);
+    buf[g_resp_load_off] =
+        __atomic_load_n(&g_resp_buf[g_resp_load_off], __ATOMIC_RELAXED);
+    return len;
+}
+
+int amf_health_watch_open(void)
+{
+    int efd;
+
+    if (!monitor_running) return -1;
+
+    efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd < 0) {
+        ogs_warn("[AMF-Health] eventfd() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_watch_lock);
+    if (g_nwatch_efds >= WATCH_MAX) {
+        pthread_mutex_unlock(&g_watch_lock);
+        close(efd);
+        return -1;
+    }
+    g_watch_efds[g_nwatch_efds++] = efd;
+    pthread_mutex_unlock(&g_watch_lock);
+    return efd;
+}
+
+void amf_health_watch_close(int efd)
+{
+    int i;
+
+    if (efd < 0) return;
+
+    pthread_mutex_lock(&g_watch_lock);
+    for (i = 0; i < g_nwatch_efds; i++) {
+        if (g_watch_efds[i] == efd) {
+            g_watch_efds[i] = g_watch_efds[--g_nwatch_efds];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_watch_lock);
+    close(efd);
+}
+
+void amf_health_count_probe(amf_health_probe_e kind)
+{
+    uint64_t *ctr = kind == AMF_HEALTH_PROBE_GRPC ? &g_grpc_probes :
+                    kind == AMF_HEALTH_PROBE_UDP  ? &g_udp_probes :
+                                                    &g_tcp_probes;
+    __atomic_fetch_add(ctr, 1, __ATOMIC_RELAXED);
+}
+
+static int monitor_open(void)
+{
+    if (g_shm_enable && shm_page_open() != OGS_OK)
+        ogs_warn("[AMF-Health] Continuing without shared-memory page");
+
+    /* Count the AMF as alive from open; amf_main starts right after */
+    __atomic_store_n(&g_heartbeat_ns, clock_ns(CLOCK_MONOTONIC),
+                     __ATOMIC_RELAXED);
+    shm_page_publish(clock_ns(CLOCK_MONOTONIC));
+
+    monitor_running = 1;
+    if (pthread_create(&monitor_thread, NULL, health_monitor_loop, NULL) != 0) {
+        ogs_error("[AMF-Health] monitor pthread_create() failed: %s",
+                  strerror(errno));
+        monitor_running = 0;
+        if (g_page) {
+            munmap(g_page, AMF_HEALTH_SHM_SIZE);
+            g_page = NULL;
+        }
+        return OGS_ERROR;
+    }
+    return OGS_OK;
+}
+
+static void monitor_close(void)
+{
+    if (!monitor_running) return;
+
+    monitor_running = 0;
+    pthread_join(monitor_thread, NULL);
+
+    /* Subscribers see the connection close; eventfd owners close their own */
+    pthread_mutex_lock(&g_watch_lock);
+    while (g_nwatchers > 0)
+        close(g_watchers[--g_nwatchers].fd);
+    pthread_mutex_unlock(&g_watch_lock);
+
+    /* Leave the page in place marked NOT_SERVING: a reader that polls
+     * across an AMF restart sees the outage instead of a missing file. */
+    g_status = AMF_HEALTH_NOT_SERVING;
+    shm_page_publish(clock_ns(CLOCK_MONOTONIC));
+    if (g_page) {
+        munmap(g_page, AMF_HEALTH_SHM_SIZE);
+        g_page = NULL;
+    }
+}
+
 /* =========================================================
  * Public API — amf_health_open / amf_health_close
  * ========================================================= */
 int amf_health_open(void)
 {
     const char *env;
+    int tcp_enable;
     int port_fd;
     int opt;
     struct sockaddr_in addr;
 
     /* Read config from environment */
     env = getenv("AMF_TCP_ENABLE");
-    if (env && strcmp(env, "1") != 0) {
-        ogs_info("[AMF-Health] Disabled via AMF_TCP_ENABLE=%s", env);
+    tcp_enable = !(env && strcmp(env, "1") != 0);
+
+    env = getenv("AMF_UDP_ENABLE");
+    g_udp_enable = (env && strcmp(env, "1") == 0) ? 1 : 0;
+
+    env = getenv("AMF_HEALTH_SHM_ENABLE");
+    g_shm_enable = !(env && strcmp(env, "1") != 0);
+
+    if (!tcp_enable && !g_udp_enable && !g_shm_enable) {
+        ogs_info("[AMF-Health] Disabled (TCP, UDP and shm page all off)");
         return OGS_OK;
     }
 
@@ -256,11 +1034,78 @@ int amf_health_open(void)
             g_reg_server_port = (uint16_t)atoi(env);
     }
 
+    env = getenv("AMF_UDP_PORT");
+    g_udp_port = (env && atoi(env) > 0) ? (uint16_t)atoi(env) : g_port;
+
+    env = getenv("AMF_UDP_BATCH");
+    if (env && atoi(env) > 0)
+        g_udp_batch = atoi(env) > UDP_BATCH_MAX ? UDP_BATCH_MAX : atoi(env);
+
+    env = getenv("AMF_GRPC_ENABLE");
+    g_grpc_enable = (env && strcmp(env, "1") == 0) ? 1 : 0;
+
+    env = getenv("AMF_GRPC_MAX_CONN");
+    if (env && atoi(env) > 0)
+        g_grpc_max_conn = atoi(env);
+
+    env = getenv("AMF_HEALTH_SHM_PATH");
+    if (env && strlen(env) > 0)
+        snprintf(g_shm_path, sizeof(g_shm_path), "%s", env);
+
+    env = getenv("AMF_HEALTH_TICK_MS");
+    if (env && atoi(env) > 0)
+        g_tick_ms = atoi(env) < 10 ? 10 : (atoi(env) > 1000 ? 1000 : atoi(env));
+
+    env = getenv("AMF_HEALTH_LOAD_STEP");
+    if (env && atoi(env) > 0)
+        g_load_step = atoi(env);
+
+    env = getenv("AMF_HEALTH_FAULT_INJECT");
+    g_fault_enable = (env && strcmp(env, "1") == 0) ? 1 : 0;
+
+    env = getenv("AMF_HEALTH_FAULT_PATH");
+    if (env && strlen(env) > 0)
+        snprintf(g_fault_path, sizeof(g_fault_path), "%s", env);
+    if (g_fault_enable)
+        ogs_warn("[AMF-Health] Fault injection enabled (%s)", g_fault_path);
+
+    env = getenv("AMF_HEALTH_STALL_MS");
+    if (env && atoi(env) > 0)
+        g_stall_ms = atoi(env);
+    if (g_stall_ms < 2 * g_tick_ms)
+        g_stall_ms = 2 * g_tick_ms;     /* idle loop beats once per tick */
+
+    /* The response only depends on config, so encode it once */
+    g_resp_len = build_health_response(g_resp_buf, (int)sizeof(g_resp_buf));
+    if (g_resp_len <= 0) {
+        ogs_error("[AMF-Health] cannot encode HealthCheckResponse");
+        return OGS_ERROR;
+    }
+
+    if (monitor_open() != OGS_OK)
+        return OGS_ERROR;
+
+    /* From here on, a failure unwinds what was opened, in reverse order */
+    if (g_udp_enable && udp_server_open() != OGS_OK)
+        goto err_monitor;
+
+    if (!tcp_enable) {
+        if (g_grpc_enable)
+            ogs_warn("[AMF-Health] AMF_GRPC_ENABLE ignored: gRPC shares "
+                     "the TCP listener");
+        g_grpc_enable = 0;
+        ogs_info("[AMF-Health] TCP listener disabled via AMF_TCP_ENABLE");
+        return OGS_OK;
+    }
+
+    if (g_grpc_enable && amf_health_grpc_open(g_grpc_max_conn) != OGS_OK)
+        goto err_udp;
+
     /* Create listening socket */
     port_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (port_fd < 0) {
         ogs_error("[AMF-Health] socket() failed: %s", strerror(errno));
-        return OGS_ERROR;
+        goto err_grpc;
     }
 
     opt = 1;
@@ -274,14 +1119,12 @@ int amf_health_open(void)
     if (bind(port_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
         ogs_error("[AMF-Health] bind(%s:%u) failed: %s",
                   g_bind_addr, (unsigned)g_port, strerror(errno));
-        close(port_fd);
-        return OGS_ERROR;
+        goto err_socket;
     }
 
     if (listen(port_fd, 16) < 0) {
         ogs_error("[AMF-Health] listen() failed: %s", strerror(errno));
-        close(port_fd);
-        return OGS_ERROR;
+        goto err_socket;
     }
 
     server_fd = port_fd;
@@ -290,24 +1133,42 @@ int amf_health_open(void)
     if (pthread_create(&server_thread, NULL, health_server_loop, NULL) != 0) {
         ogs_error("[AMF-Health] pthread_create() failed: %s", strerror(errno));
         server_running = 0;
-        close(server_fd);
         server_fd = -1;
-        return OGS_ERROR;
+        goto err_socket;
     }
 
     return OGS_OK;
+
+err_socket:
+    close(port_fd);
+err_grpc:
+    amf_health_grpc_close();        /* no-op unless opened */
+err_udp:
+    udp_server_close();             /* no-op unless opened */
+err_monitor:
+    monitor_close();
+    return OGS_ERROR;
 }
 
 void amf_health_close(void)
 {
-    if (server_fd < 0) return;
+    udp_server_close();
+
+    if (server_fd >= 0) {
+        server_running = 0;
+        shutdown(server_fd, SHUT_RDWR); /* wakes the blocked accept() */
+        close(server_fd);
+        server_fd = -1;
 
-    server_running = 0;
-    close(server_fd);
-    server_fd = -1;
+        pthread_join(server_thread, NULL);
+        ogs_info("[AMF-Health] TCP health server closed");
+
+        /* after the accept loop: no more handoffs can arrive */
+        amf_health_grpc_close();
+    }
 
-    pthread_join(server_thread, NULL);
-    ogs_info("[AMF-Health] TCP health server closed");
+    /* last: the listeners above may still register watchers */
+    monitor_close();
 }
 
 /* =========================================================
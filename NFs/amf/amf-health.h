@@ -11,6 +11,30 @@
  *
  *   RegisterRequest { node_type=AMF(13), ip="<bind_addr>", port=<port> }
  *
+ * UDP fast-probe (optional, same port number by default):
+ *   one datagram per probe, no length prefix, no handshake
+ *   request:  HealthCheckRequest  { service, nonce (fixed64, field 2) }
+ *   response: HealthCheckResponse { ..., nonce (fixed64, field 5) }
+ *   The nonce is echoed verbatim; a request without one is dropped.
+ *   Probes are batched with recvmmsg/sendmmsg.
+ *
+ * gRPC (optional, same TCP port): grpc.health.v1.Health/Check and /Watch
+ *   over cleartext HTTP/2, detected by the client preface — see
+ *   amf-health-grpc.h.  Works with grpc_health_probe and k8s gRPC probes.
+ *
+ * Watch (raw TCP and cnode session):
+ *   HealthCheckRequest { watch = 3: true, min_interval_ms = 4 } subscribes:
+ *   the current response is sent at once and again on every status or
+ *   load_bucket transition, at most once per min_interval_ms (latest state
+ *   wins).  On TCP the connection stays open until the client closes it.
+ *
+ * Health monitor:
+ *   status is SERVING while the AMF main loop keeps beating
+ *   (amf_health_heartbeat) and NOT_SERVING once it stalls for longer than
+ *   AMF_HEALTH_STALL_MS.  Status, load and probe counters are published to
+ *   a seqlock-protected shared-memory page (layout: amf-health-shm.h) that
+ *   same-host readers map directly — no socket, no syscall per read.
+ *
  * Configuration (env vars read at amf_health_open() time):
  *   AMF_TCP_ENABLE           1|0  (default: 1)
  *   AMF_TCP_PORT             TCP port to bind (default: 50051)
@@ -19,28 +43,97 @@
  *   AMF_TCP_REG_ENABLE   1|0 (default: 0)
  *   AMF_TCP_REG_SERVER_IP     registration server IP
  *   AMF_TCP_REG_SERVER_PORT   registration server TCP port
+ *   AMF_UDP_ENABLE           1|0  (default: 0)
+ *   AMF_UDP_PORT             UDP port to bind (default: AMF_TCP_PORT)
+ *   AMF_UDP_BATCH            datagrams per recvmmsg/sendmmsg (default: 32, max 64)
+ *   AMF_GRPC_ENABLE          1|0  (default: 0)
+ *   AMF_GRPC_MAX_CONN        concurrent HTTP/2 connections (default: 64)
+ *   AMF_HEALTH_SHM_ENABLE    1|0  (default: 1)
+ *   AMF_HEALTH_SHM_PATH      page file (default: /dev/shm/open5gs-amf-health)
+ *   AMF_HEALTH_TICK_MS       monitor publish interval (default: 250, 10..1000)
+ *   AMF_HEALTH_STALL_MS      heartbeat age → NOT_SERVING (default: 2000)
+ *   AMF_HEALTH_LOAD_STEP     AMF UEs per load_bucket (default: 100)
+ *   AMF_HEALTH_FAULT_INJECT  1|0  test hook: `echo <ms> > AMF_HEALTH_FAULT_PATH`
+ *                            stalls the AMF main loop (default: 0)
+ *   AMF_HEALTH_FAULT_PATH    (default: /dev/shm/open5gs-amf-stall)
  */
 
 #ifndef AMF_HEALTH_H
 #define AMF_HEALTH_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef struct amf_health_request_s {
+    int         has_nonce;
+    uint8_t     nonce[8];           /* field 2, copied verbatim */
+    int         watch;              /* field 3 */
+    uint32_t    min_interval_ms;    /* field 4 */
+} amf_health_request_t;
+
+typedef enum {
+    AMF_HEALTH_PROBE_TCP = 0,
+    AMF_HEALTH_PROBE_UDP,
+    AMF_HEALTH_PROBE_GRPC,
+} amf_health_probe_e;
+
 /*
- * amf_health_open() — start the TCP health check server.
+ * amf_health_open() — start the health monitor, the TCP health check
+ * server (and the UDP fast-probe listener when AMF_UDP_ENABLE=1).
  * Call after ngap_open() in amf_initialize().
  * Returns OGS_OK on success, OGS_ERROR on failure.
  */
 int  amf_health_open(void);
 
 /*
- * amf_health_close() — stop the TCP health check server.
+ * amf_health_close() — stop the listeners and the monitor; the shm page is
+ * left in place marked NOT_SERVING.
  * Call before ngap_close() in amf_terminate().
  */
 void amf_health_close(void);
 
+/*
+ * amf_health_heartbeat() — mark the AMF main loop alive and sample load
+ * counters.  Call from amf_main() after every ogs_timer_mgr_expire().
+ * Runs on the AMF thread; a clock read and two atomic stores per call.
+ */
+void amf_health_heartbeat(void);
+
+/*
+ * amf_health_status() — current ServingStatus (AMF_HEALTH_SERVING /
+ * AMF_HEALTH_NOT_SERVING from amf-health-shm.h).  Any thread.
+ */
+int  amf_health_status(void);
+
+/*
+ * amf_health_copy_response() — copy the cached, encoded
+ * HealthCheckResponse (status, node_type, ip, port) into buf.
+ * Returns its length, or -1 if bufsz is too small.  Any thread.
+ */
+int  amf_health_copy_response(uint8_t *buf, int bufsz);
+
+/* amf_health_count_probe() — bump a probe counter on the shm page. */
+void amf_health_count_probe(amf_health_probe_e kind);
+
+/*
+ * amf_health_parse_request() — decode a HealthCheckRequest.
+ * Returns 0 on success, -1 if malformed.
+ */
+int  amf_health_parse_request(const uint8_t *buf, int len,
+        amf_health_request_t *req);
+
+/*
+ * amf_health_watch_open() — non-blocking eventfd that becomes readable on
+ * every status or load_bucket transition (read 8 bytes to re-arm), so
+ * another thread can push updates from its own poll loop.  Returns -1 if
+ * the health monitor is not running.  Release with amf_health_watch_close().
+ */
+int  amf_health_watch_open(void);
+void amf_health_watch_close(int efd);
+
 /*
  * amf_health_send_registration() — fire-and-forget registration with
  * the configured registration server.  Call from amf_state_operational
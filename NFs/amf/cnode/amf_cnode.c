@@ -20,8 +20,12 @@
  *   2. AMF sends  NodeType_Message { nodetype: AMF(13) }
  *      (same proto field as MME sends NodeType_Message { nodetype: MME(2) })
  *   3. cnode server sends HealthCheckRequest messages back on same conn
- *   4. AMF replies with HealthCheckResponse { status: SERVING(1) }
- *   5. Loop — reconnect with exponential backoff on any error
+ *   4. AMF replies with the health endpoint's cached HealthCheckResponse
+ *      (status from the health monitor; SERVING if the monitor is off)
+ *   5. A HealthCheckRequest with watch=true subscribes the session: from
+ *      then on the AMF also pushes a HealthCheckResponse on every status /
+ *      load_bucket transition, at most once per min_interval_ms
+ *   6. Loop — reconnect with exponential backoff on any error
  *
  * ── Proto wire encoding (hand-coded, no external library) ────────────
  *
@@ -29,13 +33,18 @@
  *     field 1 varint 13 → 0x08 0x0D   (2 bytes)
  *     framed: [02 00 00 00][08 0D]
  *
- *   HealthCheckResponse { status: SERVING=1 }
+ *   HealthCheckResponse { status: SERVING=1 }   (fallback, monitor off)
  *     field 1 varint 1  → 0x08 0x01   (2 bytes)
  *     framed: [02 00 00 00][08 01]
+ *
+ *   HealthCheckRequest { watch: true, min_interval_ms: 500 }
+ *     field 3 varint 1, field 4 varint 500 → 0x18 0x01 0x20 0xF4 0x03
  */
 
 #include "ogs-app.h"
 #include "cnode/amf_cnode.h"
+#include "amf-health.h"
+#include "amf-evstream.h"
 
 #include <poll.h>
 #include <pthread.h>
@@ -47,6 +56,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <time.h>
 
 /* ====================================================================
  * Framed I/O helpers
@@ -126,6 +136,23 @@ static const uint8_t NODETYPE_AMF[]       = { 0x08, 0x0D };
  */
 static const uint8_t HEALTH_RESP_SERVING[] = { 0x08, 0x01 };
 
+/* Current HealthCheckResponse: the health endpoint's cached bytes, or the
+ * static SERVING reply when the health monitor is disabled. */
+static int current_response(uint8_t *buf, int bufsz)
+{
+    int n = amf_health_copy_response(buf, bufsz);
+    if (n > 0) return n;
+    memcpy(buf, HEALTH_RESP_SERVING, sizeof HEALTH_RESP_SERVING);
+    return (int)sizeof HEALTH_RESP_SERVING;
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
 /* ====================================================================
  * Client configuration (read once at amf_cnode_start)
  * ==================================================================== */
@@ -150,6 +177,14 @@ static int serve_session(void)
     uint8_t          req_buf[256];
     int              n;
 
+    /* Watch state for this session */
+    int              watch_efd = -1;
+    uint32_t         min_interval_ms = 0;
+    uint64_t         last_push_ms = 0;
+    int              push_pending = 0;
+    uint8_t          last_sent[256];
+    int              last_sent_len = 0;
+
     memset(&srv, 0, sizeof srv);
     srv.sin_family = AF_INET;
     srv.sin_port   = htons(g_server_port);
@@ -177,60 +212,134 @@ static int serve_session(void)
 
     ogs_info("[AMF-cnode] connected to %s:%u",
              g_server_ip, (unsigned)g_server_port);
+    amf_evstream_cnode(AMF_EVSTREAM_CNODE_CONNECTED,
+                       g_server_ip, g_server_port);
 
     /* ── Step 1: Send NodeType_Message { nodetype: AMF(13) } ── */
     if (write_framed(sfd, NODETYPE_AMF, (int)sizeof NODETYPE_AMF) < 0) {
         ogs_warn("[AMF-cnode] send NodeType_Message failed: %s",
                  strerror(errno));
         close(sfd);
+        amf_evstream_cnode(AMF_EVSTREAM_CNODE_DISCONNECTED, g_server_ip,
+                           g_server_port);
         return -1;
     }
     ogs_info("[AMF-cnode] sent NodeType_Message { nodetype: AMF }");
+    amf_evstream_cnode(AMF_EVSTREAM_CNODE_REGISTERED,
+                       g_server_ip, g_server_port);
 
-    /* ── Step 2: Serve HealthCheckRequests on the same connection ── */
+    /* ── Step 2: Serve HealthCheckRequests (and watch pushes) ── */
     while (g_running) {
-        struct pollfd pfd;
+        struct pollfd pfd[2];
+        int nfds = 1;
+        int timeout = 5000;
         int rc;
 
         /* Poll for incoming data with a 5-second timeout so we can
-         * re-check g_running without blocking forever. */
-        pfd.fd      = sfd;
-        pfd.events  = POLLIN;
-        pfd.revents = 0;
-        rc = poll(&pfd, 1, 5000);
+         * re-check g_running without blocking forever.  In watch mode
+         * also wait on the health monitor's transition eventfd, and wake
+         * early if a rate-limited push is due. */
+        pfd[0].fd      = sfd;
+        pfd[0].events  = POLLIN;
+        pfd[0].revents = 0;
+        if (watch_efd >= 0) {
+            pfd[1].fd      = watch_efd;
+            pfd[1].events  = POLLIN;
+            pfd[1].revents = 0;
+            nfds = 2;
+        }
+        if (push_pending) {
+            uint64_t due = last_push_ms + min_interval_ms;
+            uint64_t now = now_ms();
+            timeout = due > now ? (int)(due - now) : 0;
+        }
+        rc = poll(pfd, (nfds_t)nfds, timeout);
 
         if (rc < 0) {
             if (errno == EINTR) continue;
             ogs_warn("[AMF-cnode] poll() error: %s", strerror(errno));
             break;
         }
-        if (rc == 0) continue;   /* timeout — loop back and check g_running */
 
-        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        if (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
             ogs_warn("[AMF-cnode] connection closed by server");
             break;
         }
 
-        /* Data available — read the full HealthCheckRequest frame */
-        n = read_framed(sfd, req_buf, (int)sizeof req_buf);
-        if (n < 0) {
-            ogs_warn("[AMF-cnode] read HealthCheckRequest failed: %s",
-                     strerror(errno));
-            break;
+        if (pfd[0].revents & POLLIN) {
+            amf_health_request_t req;
+            uint8_t resp[256];
+            int resp_len;
+
+            /* Data available — read the full HealthCheckRequest frame */
+            n = read_framed(sfd, req_buf, (int)sizeof req_buf);
+            if (n < 0) {
+                ogs_warn("[AMF-cnode] read HealthCheckRequest failed: %s",
+                         strerror(errno));
+                break;
+            }
+
+            if (amf_health_parse_request(req_buf, n, &req) == 0 &&
+                req.watch && watch_efd < 0) {
+                watch_efd = amf_health_watch_open();
+                min_interval_ms = req.min_interval_ms;
+                if (watch_efd >= 0)
+                    ogs_info("[AMF-cnode] watch subscribed "
+                             "(min interval %ums)", min_interval_ms);
+                else
+                    ogs_warn("[AMF-cnode] watch requested but health "
+                             "monitor is off; request/response only");
+            }
+
+            /* Reply with the current HealthCheckResponse */
+            resp_len = current_response(resp, (int)sizeof resp);
+            if (write_framed(sfd, resp, resp_len) < 0) {
+                ogs_warn("[AMF-cnode] send HealthCheckResponse failed: %s",
+                         strerror(errno));
+                break;
+            }
+            memcpy(last_sent, resp, (size_t)resp_len);
+            last_sent_len = resp_len;
+            last_push_ms = now_ms();
+            push_pending = 0;
+
+            ogs_debug("[AMF-cnode] health-check → status %u", resp[1]);
         }
 
-        /* Reply with HealthCheckResponse { status: SERVING } */
-        if (write_framed(sfd, HEALTH_RESP_SERVING,
-                         (int)sizeof HEALTH_RESP_SERVING) < 0) {
-            ogs_warn("[AMF-cnode] send HealthCheckResponse failed: %s",
-                     strerror(errno));
-            break;
+        /* nfds, not watch_efd: a watch subscribed above was not polled */
+        if (nfds == 2 && (pfd[1].revents & POLLIN)) {
+            uint64_t cnt;
+            if (read(watch_efd, &cnt, sizeof cnt) < 0 && errno != EAGAIN)
+                ogs_debug("[AMF-cnode] watch eventfd: %s", strerror(errno));
+            push_pending = 1;
         }
 
-        ogs_debug("[AMF-cnode] health-check → SERVING");
+        /* Watch push: latest state, once min_interval_ms has passed */
+        if (push_pending && now_ms() - last_push_ms >= min_interval_ms) {
+            uint8_t resp[256];
+            int resp_len = current_response(resp, (int)sizeof resp);
+
+            push_pending = 0;
+            if (resp_len == last_sent_len &&
+                memcmp(resp, last_sent, (size_t)resp_len) == 0)
+                continue;                   /* flapped back: nothing new */
+
+            if (write_framed(sfd, resp, resp_len) < 0) {
+                ogs_warn("[AMF-cnode] push HealthCheckResponse failed: %s",
+                         strerror(errno));
+                break;
+            }
+            memcpy(last_sent, resp, (size_t)resp_len);
+            last_sent_len = resp_len;
+            last_push_ms = now_ms();
+            ogs_info("[AMF-cnode] watch push → status %u", resp[1]);
+        }
     }
 
+    amf_health_watch_close(watch_efd);
     close(sfd);
+    amf_evstream_cnode(AMF_EVSTREAM_CNODE_DISCONNECTED,
+                       g_server_ip, g_server_port);
     return g_running ? -1 : 0;
 }
 
@@ -0,0 +1,432 @@
+/*
+ * amf-events — subscribe to the AMF event socket.
+ *
+ * Connects to the socket published by amf-evstream.c (records:
+ * amf-evstream-wire.h) and prints every event as one JSON line, or blocks
+ * until the events a test is waiting for have arrived.  Live events
+ * carry "age_us", the time from publish to print.
+ *
+ * Usage:
+ *   amf-events                          # follow: history, then live
+ *   amf-events --type ue_registered     # follow one type
+ *   amf-events --seq                    # print a stream mark "EPOCH.SEQ"
+ *   amf-events --since EPOCH.SEQ --wait ue_registered --count 20
+ *   amf-events --after 1760000000.5 --wait gnb_up --timeout 60
+ *   amf-events --wait ue_registered --match imsi-999700000000001
+ *   amf-events --last cnode             # latest known event of a type
+ *   amf-events --path /run/open5gs-amf-events.sock
+ *
+ * --since keeps events at or after the mark; if the AMF restarted since
+ * (other epoch) every event of the new AMF counts.  --after keeps events
+ * published at or after a Unix time.  Without either, --wait only counts
+ * events published after it started.  --wait counts distinct UEs
+ * (ue_*) or gNBs (gnb_*), other types every event, and prints the count.
+ * --match keeps events whose JSON line contains TEXT.  The socket is
+ * retried every 20 ms until --timeout, also across an AMF restart.
+ *
+ * Exit status: 0 ok, 1 --wait timed out or --last found nothing,
+ *              2 socket unreachable (--seq, --last, follow) or bad usage.
+ *
+ * Build: gcc -O2 -I NFs/amf -o amf-events NFs/amf/tools/amf-events.c
+ */
+
+#include "amf-evstream-wire.h"
+#include "amf-health-shm.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define RETRY_MS    20
+
+static const char *opt_path = AMF_EVSTREAM_SOCK_DEFAULT_PATH;
+static int         opt_type = -1;
+static const char *opt_match = NULL;
+static long        opt_count = 1;
+static double      opt_timeout = 30.0;
+static uint64_t    opt_since_epoch = 0, opt_since_seq = 0;
+static uint64_t    opt_after_ns = 0;
+static int         has_since = 0, has_after = 0;
+
+/* Per connection */
+static amf_evstream_hello_t g_hello;
+
+static uint64_t clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* MCC/MNC from the 3-byte BCD PLMN ID */
+static void plmn_str(const uint8_t *p, char *out, size_t len)
+{
+    int mcc = (p[0] & 0xf) * 100 + (p[0] >> 4) * 10 + (p[1] & 0xf);
+    int mnc3 = p[1] >> 4;
+
+    if (mnc3 == 0xf)
+        snprintf(out, len, "%03d-%02d", mcc, (p[2] & 0xf) * 10 + (p[2] >> 4));
+    else
+        snprintf(out, len, "%03d-%03d", mcc,
+                 (p[2] & 0xf) * 100 + (p[2] >> 4) * 10 + mnc3);
+}
+
+static int type_parse(const char *s)
+{
+    unsigned t;
+    for (t = 0; t < AMF_EVSTREAM_TYPE_MAX; t++)
+        if (!strcmp(s, amf_evstream_type_name(t))) return (int)t;
+    fprintf(stderr, "amf-events: unknown event type '%s'\n", s);
+    exit(2);
+}
+
+/* =========================================================
+ * Distinct keys for --wait (open addressing, grows at 1/2 full)
+ * ========================================================= */
+static char  **g_keys;
+static size_t  g_nkeys, g_keycap;
+
+static uint64_t fnv1a(const char *s)
+{
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) h = (h ^ (uint8_t)*s++) * 1099511628211ULL;
+    return h;
+}
+
+/* Returns 1 if the key is new */
+static int key_add(const char *key)
+{
+    size_t i;
+
+    if (2 * (g_nkeys + 1) > g_keycap) {
+        char **old = g_keys;
+        size_t oldcap = g_keycap;
+
+        g_keycap = g_keycap ? g_keycap * 2 : 1024;
+        g_keys = calloc(g_keycap, sizeof(*g_keys));
+        if (!g_keys) { perror("amf-events"); exit(2); }
+        for (i = 0; i < oldcap; i++) {
+            size_t j;
+            if (!old[i]) continue;
+            for (j = fnv1a(old[i]) & (g_keycap - 1); g_keys[j];
+                 j = (j + 1) & (g_keycap - 1))
+                ;
+            g_keys[j] = old[i];
+        }
+        free(old);
+    }
+    for (i = fnv1a(key) & (g_keycap - 1); g_keys[i];
+         i = (i + 1) & (g_keycap - 1))
+        if (!strcmp(g_keys[i], key)) return 0;
+    g_keys[i] = strdup(key);
+    g_nkeys++;
+    return 1;
+}
+
+/* =========================================================
+ * Records
+ * ========================================================= */
+
+/* One JSON line without the trailing newline; 0 if the body is short */
+static int format_event(const uint8_t *rec, char *out, size_t len,
+        char *key, size_t keylen)
+{
+    const amf_evstream_hdr_t *h = (const amf_evstream_hdr_t *)rec;
+    const uint8_t *body = rec + sizeof(*h);
+    size_t blen = h->len - sizeof(*h);
+    const char *src = h->flags & AMF_EVSTREAM_F_SNAPSHOT ? "snapshot" :
+                      h->flags & AMF_EVSTREAM_F_REPLAY ? "replay" : "live";
+    int n;
+
+    n = snprintf(out, len, "{\"seq\":%llu,\"type\":\"%s\",\"unix_ns\":%llu,"
+                 "\"src\":\"%s\"", (unsigned long long)h->seq,
+                 amf_evstream_type_name(h->type),
+                 (unsigned long long)h->unix_ns, src);
+    snprintf(key, keylen, "%llu", (unsigned long long)h->seq);
+
+    switch (h->type) {
+    case AMF_EVSTREAM_HELLO: {
+        const amf_evstream_hello_t *b = (const void *)body;
+        if (blen < sizeof(*b)) return 0;
+        n += snprintf(out + n, len - n, ",\"epoch_ns\":%llu,\"next_seq\":%llu,"
+                      "\"oldest_seq\":%llu,\"pid\":%u,\"version\":%u",
+                      (unsigned long long)b->epoch_ns,
+                      (unsigned long long)b->next_seq,
+                      (unsigned long long)b->oldest_seq, b->pid, b->version);
+        break;
+    }
+    case AMF_EVSTREAM_GNB_UP:
+    case AMF_EVSTREAM_GNB_DOWN: {
+        const amf_evstream_gnb_t *b = (const void *)body;
+        char plmn[16];
+        if (blen < sizeof(*b)) return 0;
+        plmn_str(b->plmn_id, plmn, sizeof(plmn));
+        n += snprintf(out + n, len - n,
+                      ",\"gnb_id\":%u,\"plmn\":\"%s\",\"addr\":\"%.*s\"",
+                      b->gnb_id, plmn, (int)sizeof(b->addr), b->addr);
+        snprintf(key, keylen, "%u", b->gnb_id);
+        break;
+    }
+    case AMF_EVSTREAM_UE_REGISTERED:
+    case AMF_EVSTREAM_UE_REMOVED: {
+        const amf_evstream_ue_t *b = (const void *)body;
+        if (blen < sizeof(*b)) return 0;
+        n += snprintf(out + n, len - n, ",\"supi\":\"%.*s\"",
+                      (int)sizeof(b->supi), b->supi);
+        snprintf(key, keylen, "%.*s", (int)sizeof(b->supi), b->supi);
+        break;
+    }
+    case AMF_EVSTREAM_CNODE: {
+        static const char *const states[] = {
+            "unknown", "connected", "registered", "disconnected" };
+        const amf_evstream_cnode_t *b = (const void *)body;
+        if (blen < sizeof(*b)) return 0;
+        n += snprintf(out + n, len - n,
+                      ",\"state\":\"%s\",\"server\":\"%.*s:%u\"",
+                      states[b->state < 4 ? b->state : 0],
+                      (int)sizeof(b->server), b->server, b->port);
+        break;
+    }
+    case AMF_EVSTREAM_HEALTH: {
+        const amf_evstream_health_t *b = (const void *)body;
+        if (blen < sizeof(*b)) return 0;
+        n += snprintf(out + n, len - n, ",\"status\":\"%s\",\"load_bucket\":%u",
+                      b->status == AMF_HEALTH_SERVING ? "serving" :
+                      b->status == AMF_HEALTH_NOT_SERVING ? "not_serving" :
+                      "unknown", b->load_bucket);
+        break;
+    }
+    case AMF_EVSTREAM_LOST: {
+        const amf_evstream_lost_t *b = (const void *)body;
+        if (blen < sizeof(*b)) return 0;
+        n += snprintf(out + n, len - n, ",\"count\":%llu",
+                      (unsigned long long)b->count);
+        break;
+    }
+    default:
+        break;
+    }
+    if (!(h->flags & (AMF_EVSTREAM_F_SNAPSHOT | AMF_EVSTREAM_F_REPLAY)) &&
+        h->seq)
+        n += snprintf(out + n, len - n, ",\"age_us\":%lld",
+                      (long long)(clock_ns(CLOCK_REALTIME) - h->unix_ns) / 1000);
+    snprintf(out + n, len - n, "}");
+    return 1;
+}
+
+/* --since / --after */
+static int in_window(const amf_evstream_hdr_t *h)
+{
+    if (has_since) {
+        if (g_hello.epoch_ns == opt_since_epoch && h->seq < opt_since_seq)
+            return 0;
+        if (g_hello.epoch_ns < opt_since_epoch)
+            return 0;           /* mark is from a newer AMF than this one */
+    }
+    if (has_after && h->unix_ns < opt_after_ns)
+        return 0;
+    return 1;
+}
+
+/* =========================================================
+ * Socket
+ * ========================================================= */
+static int sock_connect(void)
+{
+    struct sockaddr_un sun;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) return -1;
+    memset(&sun, 0, sizeof(sun));
+    sun.sun_family = AF_UNIX;
+    snprintf(sun.sun_path, sizeof(sun.sun_path), "%s", opt_path);
+    if (connect(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Read one record into rec; 1 ok, 0 timeout (deadline_ns, 0 = none),
+ * -1 closed */
+static int read_record(int fd, uint8_t *rec, uint64_t deadline_ns)
+{
+    size_t got = 0, want = sizeof(amf_evstream_hdr_t);
+
+    while (got < want) {
+        ssize_t n;
+
+        if (deadline_ns) {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            uint64_t now = clock_ns(CLOCK_MONOTONIC);
+            if (now >= deadline_ns) return 0;
+            if (poll(&pfd, 1, (int)((deadline_ns - now) / 1000000ULL) + 1) == 0)
+                continue;
+        }
+        n = read(fd, rec + got, want - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        got += (size_t)n;
+        if (got == sizeof(amf_evstream_hdr_t)) {
+            want = ((amf_evstream_hdr_t *)rec)->len;
+            if (want < sizeof(amf_evstream_hdr_t) ||
+                want > AMF_EVSTREAM_MAX_RECORD)
+                return -1;
+        }
+    }
+    return 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [--path SOCK] [--since EPOCH.SEQ | --after UNIX_S]\n"
+        "          [--type TYPE | --wait TYPE [--count N] [--timeout S] |\n"
+        "           --last TYPE | --seq] [--match TEXT]\n"
+        "  --path SOCK   event socket (default: %s)\n"
+        "  TYPE          gnb_up gnb_down ue_registered ue_removed cnode health\n",
+        prog, AMF_EVSTREAM_SOCK_DEFAULT_PATH);
+}
+
+int main(int argc, char **argv)
+{
+    enum { FOLLOW, WAIT, LAST, SEQ } mode = FOLLOW;
+    uint8_t rec[AMF_EVSTREAM_MAX_RECORD];
+    char line[1024], key[64], last[1024] = "";
+    uint64_t deadline;
+    int i, fd;
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--path") && i + 1 < argc) {
+            opt_path = argv[++i];
+        } else if (!strcmp(argv[i], "--type") && i + 1 < argc) {
+            opt_type = type_parse(argv[++i]);
+        } else if (!strcmp(argv[i], "--wait") && i + 1 < argc) {
+            mode = WAIT;
+            opt_type = type_parse(argv[++i]);
+        } else if (!strcmp(argv[i], "--last") && i + 1 < argc) {
+            mode = LAST;
+            opt_type = type_parse(argv[++i]);
+        } else if (!strcmp(argv[i], "--seq")) {
+            mode = SEQ;
+        } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+            opt_count = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+            opt_timeout = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--match") && i + 1 < argc) {
+            opt_match = argv[++i];
+        } else if (!strcmp(argv[i], "--since") && i + 1 < argc) {
+            unsigned long long e, s;
+            if (sscanf(argv[++i], "%llu.%llu", &e, &s) != 2) {
+                usage(argv[0]);
+                return 2;
+            }
+            opt_since_epoch = e;
+            opt_since_seq = s;
+            has_since = 1;
+        } else if (!strcmp(argv[i], "--after") && i + 1 < argc) {
+            opt_after_ns = (uint64_t)(atof(argv[++i]) * 1e9);
+            has_after = 1;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    deadline = clock_ns(CLOCK_MONOTONIC) + (uint64_t)(opt_timeout * 1e9);
+    if (mode == WAIT && !has_since && !has_after) {
+        opt_after_ns = clock_ns(CLOCK_REALTIME);
+        has_after = 1;
+    }
+
+    for (;;) {
+        uint64_t backlog_end;
+
+        fd = sock_connect();
+        if (fd < 0) {
+            struct timespec ts = { 0, RETRY_MS * 1000000L };
+            if (mode != WAIT || clock_ns(CLOCK_MONOTONIC) >= deadline) {
+                if (mode == WAIT) break;
+                fprintf(stderr, "amf-events: %s: %s\n", opt_path,
+                        strerror(errno));
+                return 2;
+            }
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        /* HELLO first */
+        if (read_record(fd, rec, mode == FOLLOW ? 0 : deadline) <= 0 ||
+            ((amf_evstream_hdr_t *)rec)->type != AMF_EVSTREAM_HELLO) {
+            close(fd);
+            if (mode == WAIT) continue;
+            fprintf(stderr, "amf-events: no HELLO from %s\n", opt_path);
+            return 2;
+        }
+        memcpy(&g_hello, rec + sizeof(amf_evstream_hdr_t), sizeof(g_hello));
+        if (mode == SEQ) {
+            printf("%llu.%llu\n", (unsigned long long)g_hello.epoch_ns,
+                   (unsigned long long)g_hello.next_seq);
+            return 0;
+        }
+        if (mode == FOLLOW && opt_type < 0 && format_event(rec, line,
+                sizeof(line), key, sizeof(key)))
+            puts(line);
+
+        /* History and snapshot end with seq next_seq - 1 */
+        backlog_end = g_hello.next_seq - 1;
+        if (mode == LAST && backlog_end == 0) {
+            close(fd);
+            return 1;
+        }
+
+        for (;;) {
+            const amf_evstream_hdr_t *h = (const amf_evstream_hdr_t *)rec;
+            int r = read_record(fd, rec, mode == FOLLOW ? 0 : deadline);
+
+            if (r <= 0) break;
+            if (format_event(rec, line, sizeof(line), key, sizeof(key)) &&
+                (opt_type < 0 || h->type == opt_type) &&
+                (h->type == AMF_EVSTREAM_LOST || in_window(h)) &&
+                (!opt_match || strstr(line, opt_match))) {
+                if (mode == FOLLOW) {
+                    puts(line);
+                } else if (mode == LAST) {
+                    snprintf(last, sizeof(last), "%s", line);
+                } else if (h->type == AMF_EVSTREAM_LOST) {
+                    fprintf(stderr, "amf-events: %s\n", line);
+                } else if (key_add(key) && (long)g_nkeys >= opt_count) {
+                    printf("%zu\n", g_nkeys);
+                    return 0;
+                }
+            }
+            if (mode == LAST && (h->flags & AMF_EVSTREAM_F_REPLAY) &&
+                h->seq >= backlog_end) {
+                close(fd);
+                if (!last[0]) return 1;
+                puts(last);
+                return 0;
+            }
+        }
+        close(fd);
+
+        /* AMF went away: follow and --last end, --wait reconnects */
+        if (mode != WAIT || clock_ns(CLOCK_MONOTONIC) >= deadline) break;
+    }
+
+    if (mode == WAIT) {
+        printf("%zu\n", g_nkeys);
+        return 1;
+    }
+    if (mode == LAST) {
+        if (!last[0]) return 1;
+        puts(last);
+    }
+    return 0;
+}
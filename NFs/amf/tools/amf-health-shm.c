@@ -0,0 +1,153 @@
+/*
+ * amf-health-shm — read the AMF shared-memory health page.
+ *
+ * Maps the page published by the AMF health monitor (amf-health.c) and
+ * prints a consistent snapshot.  Reading costs an open + mmap, no socket
+ * round-trip into the AMF, so it is cheap enough for a 1-2 s docker
+ * healthcheck interval and for tight test polling loops.
+ *
+ * Usage:
+ *   amf-health-shm                 # key=value snapshot
+ *   amf-health-shm --json          # one-line JSON snapshot
+ *   amf-health-shm --check         # exit 0 iff SERVING and page is fresh
+ *   amf-health-shm --path /dev/shm/open5gs-amf-health --max-age-ms 1500
+ *
+ * Freshness: the monitor republishes every tick_ms.  A page older than
+ * --max-age-ms (default: 4 ticks, at least 1000 ms) means the AMF process
+ * is gone even if the last published status was SERVING.
+ *
+ * Exit status: 0 healthy, 1 NOT_SERVING / stale, 2 page missing or invalid.
+ *
+ * Build: gcc -O2 -I NFs/amf -o amf-health-shm NFs/amf/tools/amf-health-shm.c
+ */
+
+#include "amf-health-shm.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static const char *status_name(uint32_t s)
+{
+    switch (s) {
+    case AMF_HEALTH_SERVING:     return "SERVING";
+    case AMF_HEALTH_NOT_SERVING: return "NOT_SERVING";
+    default:                     return "UNKNOWN";
+    }
+}
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [--path FILE] [--check] [--json] [--max-age-ms N]\n"
+        "  --path FILE       page file (default: %s)\n"
+        "  --check           exit 0 iff SERVING and fresh; prints status only\n"
+        "  --json            one-line JSON output\n"
+        "  --max-age-ms N    staleness limit (default: 4 ticks, min 1000)\n",
+        prog, AMF_HEALTH_SHM_DEFAULT_PATH);
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = getenv("AMF_HEALTH_SHM_PATH");
+    int check = 0, json = 0;
+    long max_age_ms = 0;
+    const volatile amf_health_page_t *page;
+    amf_health_page_t snap;
+    uint64_t now, pub_age_ms, hb_age_ms;
+    int fd, fresh, healthy, i;
+
+    if (!path || !path[0])
+        path = AMF_HEALTH_SHM_DEFAULT_PATH;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--path") && i + 1 < argc)
+            path = argv[++i];
+        else if (!strcmp(argv[i], "--max-age-ms") && i + 1 < argc)
+            max_age_ms = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--check"))
+            check = 1;
+        else if (!strcmp(argv[i], "--json"))
+            json = 1;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "amf-health-shm: cannot open %s\n", path);
+        return 2;
+    }
+    page = mmap(NULL, AMF_HEALTH_SHM_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        fprintf(stderr, "amf-health-shm: cannot map %s\n", path);
+        return 2;
+    }
+    if (amf_health_page_read(page, &snap) != 0) {
+        fprintf(stderr, "amf-health-shm: %s is not a valid health page\n", path);
+        return 2;
+    }
+
+    now = mono_ns();
+    pub_age_ms = now > snap.published_ns ?
+                 (now - snap.published_ns) / 1000000ULL : 0;
+    hb_age_ms  = now > snap.heartbeat_ns ?
+                 (now - snap.heartbeat_ns) / 1000000ULL : 0;
+    if (max_age_ms <= 0) {
+        max_age_ms = 4L * (long)snap.tick_ms;
+        if (max_age_ms < 1000) max_age_ms = 1000;
+    }
+    fresh   = pub_age_ms <= (uint64_t)max_age_ms;
+    healthy = fresh && snap.status == AMF_HEALTH_SERVING;
+
+    if (check) {
+        printf("%s%s\n", status_name(snap.status), fresh ? "" : " (stale)");
+    } else if (json) {
+        printf("{\"status\":\"%s\",\"fresh\":%s,\"pid\":%u,"
+               "\"published_age_ms\":%llu,\"heartbeat_age_ms\":%llu,"
+               "\"published_unix_ms\":%llu,\"tick_ms\":%u,\"stall_ms\":%u,"
+               "\"gnbs\":%u,\"amf_ues\":%u,\"ran_ues\":%u,"
+               "\"tcp_probes\":%llu,\"udp_probes\":%llu,\"grpc_probes\":%llu,"
+               "\"status_changes\":%llu}\n",
+               status_name(snap.status), fresh ? "true" : "false", snap.pid,
+               (unsigned long long)pub_age_ms, (unsigned long long)hb_age_ms,
+               (unsigned long long)snap.published_unix_ms,
+               snap.tick_ms, snap.stall_ms,
+               snap.gnbs, snap.amf_ues, snap.ran_ues,
+               (unsigned long long)snap.tcp_probes,
+               (unsigned long long)snap.udp_probes,
+               (unsigned long long)snap.grpc_probes,
+               (unsigned long long)snap.status_changes);
+    } else {
+        printf("status=%s\n",            status_name(snap.status));
+        printf("fresh=%d\n",             fresh);
+        printf("pid=%u\n",               snap.pid);
+        printf("published_age_ms=%llu\n", (unsigned long long)pub_age_ms);
+        printf("heartbeat_age_ms=%llu\n", (unsigned long long)hb_age_ms);
+        printf("tick_ms=%u\n",           snap.tick_ms);
+        printf("stall_ms=%u\n",          snap.stall_ms);
+        printf("gnbs=%u\n",              snap.gnbs);
+        printf("amf_ues=%u\n",           snap.amf_ues);
+        printf("ran_ues=%u\n",           snap.ran_ues);
+        printf("tcp_probes=%llu\n",      (unsigned long long)snap.tcp_probes);
+        printf("udp_probes=%llu\n",      (unsigned long long)snap.udp_probes);
+        printf("grpc_probes=%llu\n",     (unsigned long long)snap.grpc_probes);
+        printf("status_changes=%llu\n",  (unsigned long long)snap.status_changes);
+    }
+
+    return healthy ? 0 : 1;
+}
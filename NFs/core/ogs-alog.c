@@ -0,0 +1,677 @@
+/*
+ * ogs-alog.c — asynchronous logging backend (see ogs-alog.h).
+ *
+ * No open5GS headers, as in ogs-memstat.c: the hooks sit inside the
+ * logger, so nothing here may log or allocate from ogs_pools.
+ *
+ * Each logging thread owns one ring (single producer, the writer is the
+ * single consumer).  `head` and `tail` are byte counts that only grow;
+ * the producer publishes a record with a release store of head, the
+ * writer frees space with a release store of tail.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "ogs-alog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RING_DEFAULT_KB     1024
+#define FLUSH_DEFAULT_MS    20
+#define OUT_BUF_SIZE        (256 * 1024)
+#define MAX_RINGS           256
+#define STR_MAX             2048        /* bytes copied per %s */
+
+typedef struct rec_s {
+    uint32_t    size;           /* record bytes, 8-aligned; 0 = wrap */
+    uint8_t     level;
+    uint8_t     flags;
+    uint16_t    arg_len;
+    int32_t     err;
+    int32_t     line;
+    uint64_t    ts_ns;
+    const char *fmt;
+    const char *file;
+    const char *func;
+    const char *domain;
+} rec_t;
+
+typedef struct ring_s {
+    struct ring_s *next;
+    uint8_t       *buf;
+    uint64_t       size;        /* power of two */
+    uint64_t       head __attribute__((aligned(64)));  /* producer */
+    uint64_t       dropped;     /* producer, read by the writer */
+    uint64_t       tail __attribute__((aligned(64)));  /* writer */
+    uint64_t       dropped_seen;
+    int            closed;      /* owning thread exited */
+} ring_t;
+
+static int              g_mode = 0;             /* 0 off, 1 text, 2 binary */
+static size_t           g_ring_size = RING_DEFAULT_KB * 1024;
+static int              g_flush_ms = FLUSH_DEFAULT_MS;
+static int              g_fd = -1;
+static const void      *g_target = NULL;    /* the ogs_log_t taken over */
+static char             g_path[512];
+static pthread_t        g_thread;
+static int              g_running = 0;
+
+static pthread_mutex_t  g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   g_kick = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   g_done = PTHREAD_COND_INITIALIZER;
+static ring_t          *g_rings = NULL;         /* under g_mutex */
+static uint64_t         g_flush_req = 0;        /* under g_mutex */
+static uint64_t         g_flush_done = 0;       /* under g_mutex */
+static int              g_stop = 0;             /* under g_mutex */
+static int              g_reopen = 0;           /* under g_mutex */
+static uint64_t         g_dropped_total = 0;
+
+static pthread_once_t   g_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t    g_key;
+static __thread ring_t *tl_ring = NULL;
+static __thread int     tl_no_ring = 0;
+
+/* Writer state */
+static char            *g_out = NULL;
+static size_t           g_out_len = 0;
+
+static uint64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* =========================================================
+ * Producer side
+ * ========================================================= */
+static void ring_release(void *arg)
+{
+    ring_t *r = arg;
+    __atomic_store_n(&r->closed, 1, __ATOMIC_RELEASE);
+}
+
+static void key_create(void)
+{
+    pthread_key_create(&g_key, ring_release);
+}
+
+static ring_t *ring_get(void)
+{
+    ring_t *r;
+
+    if (tl_ring) return tl_ring;
+    if (tl_no_ring) return NULL;
+
+    r = calloc(1, sizeof(*r));
+    if (r) r->buf = malloc(g_ring_size);
+    if (!r || !r->buf) {
+        free(r);
+        tl_no_ring = 1;
+        return NULL;
+    }
+    r->size = g_ring_size;
+
+    pthread_once(&g_key_once, key_create);
+    pthread_setspecific(g_key, r);
+
+    pthread_mutex_lock(&g_mutex);
+    r->next = g_rings;
+    g_rings = r;
+    pthread_mutex_unlock(&g_mutex);
+
+    tl_ring = r;
+    return r;
+}
+
+/* Encode the arguments of format into out (OGS_ALOG_MAX_ARGS bytes) */
+static size_t encode_args(uint8_t *out, const char *fmt, va_list ap,
+        uint8_t *flags)
+{
+    uint8_t *p = out, *end = out + OGS_ALOG_MAX_ARGS;
+    ogs_alog_spec_t sp;
+
+    while (ogs_alog_spec_next(fmt, &sp)) {
+        fmt = sp.end;
+        if (sp.arg == OGS_ALOG_ARG_NONE) continue;
+
+        /* Room for the two '*' values and one 8-byte argument */
+        if (end - p < 24) {
+            *flags |= OGS_ALOG_F_TRUNCATED;
+            break;
+        }
+        if (sp.star_width) ogs_alog_put64(&p, (uint64_t)(int64_t)va_arg(ap, int));
+        if (sp.star_prec) ogs_alog_put64(&p, (uint64_t)(int64_t)va_arg(ap, int));
+
+        switch (sp.arg) {
+        case OGS_ALOG_ARG_INT:
+            ogs_alog_put64(&p, (uint64_t)(int64_t)va_arg(ap, int));
+            break;
+        case OGS_ALOG_ARG_LONG:
+            ogs_alog_put64(&p, (uint64_t)va_arg(ap, long long));
+            break;
+        case OGS_ALOG_ARG_PTR:
+            ogs_alog_put64(&p, (uint64_t)(uintptr_t)va_arg(ap, void *));
+            break;
+        case OGS_ALOG_ARG_COUNT:
+            (void)va_arg(ap, void *);
+            break;
+        case OGS_ALOG_ARG_DOUBLE:
+        case OGS_ALOG_ARG_LDOUBLE: {
+            double d = sp.arg == OGS_ALOG_ARG_LDOUBLE ?
+                       (double)va_arg(ap, long double) : va_arg(ap, double);
+            uint64_t v;
+            memcpy(&v, &d, 8);
+            ogs_alog_put64(&p, v);
+            break;
+        }
+        case OGS_ALOG_ARG_STR: {
+            const char *s = va_arg(ap, const char *);
+            size_t room = (size_t)(end - p) - 3, n;
+            uint16_t sl;
+
+            if (!s) {
+                sl = 0xffff;
+                memcpy(p, &sl, 2);
+                p += 2;
+                break;
+            }
+            /* %.Ns reads at most N bytes, which need not be terminated */
+            n = sp.prec >= 0 ? strnlen(s, (size_t)sp.prec) : strlen(s);
+            if (n > STR_MAX) n = STR_MAX;
+            if (n > room) {
+                n = room;
+                *flags |= OGS_ALOG_F_TRUNCATED;
+            }
+            sl = (uint16_t)n;
+            memcpy(p, &sl, 2);
+            memcpy(p + 2, s, n);
+            p[2 + n] = '\0';
+            p += 3 + n;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return (size_t)(p - out);
+}
+
+int ogs_alog_vprintf(const void *target, int level, int domain_id,
+        const char *domain, int err, const char *file, int line,
+        const char *func, int content_only, const char *format, va_list ap)
+{
+    uint8_t args[OGS_ALOG_MAX_ARGS];
+    uint8_t flags = content_only ? OGS_ALOG_F_CONTENT_ONLY : 0;
+    uint64_t head, tail, pos, need, room;
+    size_t arg_len;
+    ring_t *r;
+    rec_t *rec;
+    va_list cp;
+
+    (void)domain_id;
+    if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return 0;
+    if (target != g_target) return 0;   /* stderr, another file */
+    r = ring_get();
+    if (!r) return 0;
+
+    va_copy(cp, ap);
+    arg_len = encode_args(args, format, cp, &flags);
+    va_end(cp);
+
+    need = (sizeof(rec_t) + arg_len + 7) & ~(uint64_t)7;
+    head = r->head;
+    tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    pos = head & (r->size - 1);
+    room = r->size - (head - tail);
+
+    /* A record never wraps: skip the end of the buffer with a marker */
+    if (pos + need > r->size) {
+        if (room < (r->size - pos) + need) goto full;
+        ((rec_t *)(r->buf + pos))->size = 0;
+        head += r->size - pos;
+        pos = 0;
+    } else if (room < need) {
+        goto full;
+    }
+
+    rec = (rec_t *)(r->buf + pos);
+    rec->size    = (uint32_t)need;
+    rec->level   = (uint8_t)level;
+    rec->flags   = flags;
+    rec->arg_len = (uint16_t)arg_len;
+    rec->err     = err;
+    rec->line    = line;
+    rec->ts_ns   = clock_ns(CLOCK_REALTIME);
+    rec->fmt     = format;
+    rec->file    = file;
+    rec->func    = func;
+    rec->domain  = domain;
+    memcpy(rec + 1, args, arg_len);
+    __atomic_store_n(&r->head, head + need, __ATOMIC_RELEASE);
+
+    if (level <= OGS_ALOG_ERROR)
+        ogs_alog_flush();
+    return 1;
+
+full:
+    /* ERROR and FATAL are never dropped: drain what is queued so the order
+     * holds, then let upstream write this one synchronously */
+    if (level <= OGS_ALOG_ERROR) {
+        ogs_alog_flush();
+        return 0;
+    }
+    __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+void ogs_alog_flush(void)
+{
+    struct timespec ts;
+    uint64_t req;
+
+    if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 500 * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&g_mutex);
+    req = ++g_flush_req;
+    pthread_cond_signal(&g_kick);
+    while (g_flush_done < req && !g_stop)
+        if (pthread_cond_timedwait(&g_done, &g_mutex, &ts) == ETIMEDOUT)
+            break;
+    pthread_mutex_unlock(&g_mutex);
+}
+
+void ogs_alog_reopen(void)
+{
+    if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return;
+
+    pthread_mutex_lock(&g_mutex);
+    g_reopen = 1;
+    pthread_mutex_unlock(&g_mutex);
+    ogs_alog_flush();
+}
+
+uint64_t ogs_alog_dropped(void)
+{
+    return __atomic_load_n(&g_dropped_total, __ATOMIC_RELAXED);
+}
+
+/* =========================================================
+ * Writer thread
+ * ========================================================= */
+static void out_flush(void)
+{
+    size_t off = 0;
+
+    while (off < g_out_len) {
+        ssize_t n = write(g_fd, g_out + off, g_out_len - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;                      /* disk full: lose the batch */
+        }
+        off += (size_t)n;
+    }
+    g_out_len = 0;
+}
+
+static char *out_reserve(size_t n)
+{
+    if (g_out_len + n > OUT_BUF_SIZE) out_flush();
+    return g_out + g_out_len;
+}
+
+/* Binary mode: pointer -> string id, open addressing, writer only */
+typedef struct {
+    const char *ptr;
+    uint32_t    id;
+} strid_t;
+
+static strid_t  *g_ids = NULL;
+static uint32_t  g_ids_cap = 0, g_ids_used = 0, g_next_id = 1;
+
+static void out_bytes(const void *p, size_t n)
+{
+    memcpy(out_reserve(n), p, n);
+    g_out_len += n;
+}
+
+static uint32_t str_id(const char *s)
+{
+    uint32_t i, id;
+    uint16_t len;
+    size_t n;
+    uint8_t tag = OGS_ALOG_TAG_STRING;
+
+    if (!s) return 0;
+    if (g_ids_used * 2 >= g_ids_cap) {
+        uint32_t cap = g_ids_cap ? g_ids_cap * 2 : 1024, j;
+        strid_t *ids = calloc(cap, sizeof(*ids));
+        if (!ids) return 0;
+        for (j = 0; j < g_ids_cap; j++) {
+            if (!g_ids[j].ptr) continue;
+            i = (uint32_t)(((uintptr_t)g_ids[j].ptr >> 3) * 2654435761u) & (cap - 1);
+            while (ids[i].ptr) i = (i + 1) & (cap - 1);
+            ids[i] = g_ids[j];
+        }
+        free(g_ids);
+        g_ids = ids;
+        g_ids_cap = cap;
+    }
+    i = (uint32_t)(((uintptr_t)s >> 3) * 2654435761u) & (g_ids_cap - 1);
+    while (g_ids[i].ptr) {
+        if (g_ids[i].ptr == s) return g_ids[i].id;
+        i = (i + 1) & (g_ids_cap - 1);
+    }
+
+    id = g_next_id++;
+    g_ids[i].ptr = s;
+    g_ids[i].id = id;
+    g_ids_used++;
+
+    n = strlen(s);
+    len = (uint16_t)(n > 0xfffe ? 0xfffe : n);
+    out_bytes(&tag, 1);
+    out_bytes(&id, 4);
+    out_bytes(&len, 2);
+    out_bytes(s, len);
+    return id;
+}
+
+static void emit_binary(const rec_t *rec)
+{
+    uint32_t fmt = str_id(rec->fmt), file = str_id(rec->file);
+    uint32_t func = str_id(rec->func), dom = str_id(rec->domain);
+    uint8_t hdr[1 + OGS_ALOG_LOG_FIXED], *p = hdr;
+
+    *p++ = OGS_ALOG_TAG_LOG;
+    memcpy(p, &rec->ts_ns, 8);      p += 8;
+    memcpy(p, &fmt, 4);             p += 4;
+    memcpy(p, &file, 4);            p += 4;
+    memcpy(p, &func, 4);            p += 4;
+    memcpy(p, &dom, 4);             p += 4;
+    memcpy(p, &rec->line, 4);       p += 4;
+    memcpy(p, &rec->err, 4);        p += 4;
+    *p++ = rec->level;
+    *p++ = rec->flags;
+    memcpy(p, &rec->arg_len, 2);    p += 2;
+    out_bytes(hdr, (size_t)(p - hdr));
+    out_bytes(rec + 1, rec->arg_len);
+}
+
+static void emit_text(const rec_t *rec)
+{
+    char msg[8192];
+    size_t n;
+
+    ogs_alog_render(msg, sizeof(msg), rec->fmt,
+                    (const uint8_t *)(rec + 1), rec->arg_len);
+    n = ogs_alog_line(out_reserve(sizeof(msg) + 512), sizeof(msg) + 512,
+                      rec->ts_ns, rec->level, rec->domain, rec->file,
+                      rec->line, rec->err, rec->flags, msg);
+    g_out_len += n < sizeof(msg) + 511 ? n : sizeof(msg) + 511;
+}
+
+static void emit_dropped(uint64_t count)
+{
+    uint64_t now = clock_ns(CLOCK_REALTIME);
+
+    if (g_mode == 2) {
+        uint8_t tag = OGS_ALOG_TAG_DROP;
+        out_bytes(&tag, 1);
+        out_bytes(&now, 8);
+        out_bytes(&count, 8);
+    } else {
+        char msg[128];
+        size_t n;
+
+        snprintf(msg, sizeof(msg), "%llu log records dropped, ring full "
+                 "(OGS_ALOG_RING_KB=%zu)", (unsigned long long)count,
+                 g_ring_size / 1024);
+        n = ogs_alog_line(out_reserve(512), 512, now, OGS_ALOG_WARN, "alog",
+                          __FILE__, __LINE__, 0, 0, msg);
+        g_out_len += n < 511 ? n : 511;
+    }
+    __atomic_add_fetch(&g_dropped_total, count, __ATOMIC_RELAXED);
+}
+
+/* Next record of r before end, skipping wrap markers; NULL if none */
+static rec_t *ring_peek(ring_t *r, uint64_t end)
+{
+    while (r->tail < end) {
+        uint64_t pos = r->tail & (r->size - 1);
+        rec_t *rec = (rec_t *)(r->buf + pos);
+        if (rec->size) return rec;
+        r->tail += r->size - pos;
+    }
+    return NULL;
+}
+
+/* Drain every ring up to its head at entry, oldest record first */
+static void drain(void)
+{
+    ring_t *rings[MAX_RINGS], **pp, *r;
+    uint64_t ends[MAX_RINGS];
+    rec_t *heads[MAX_RINGS];
+    int n = 0, i, best;
+
+    pthread_mutex_lock(&g_mutex);
+    /* Free rings whose thread has exited and that are empty */
+    for (pp = &g_rings; (r = *pp); ) {
+        if (__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE) &&
+            r->tail == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) &&
+            r->dropped == r->dropped_seen) {
+            *pp = r->next;
+            free(r->buf);
+            free(r);
+            continue;
+        }
+        if (n < MAX_RINGS) rings[n++] = r;
+        pp = &r->next;
+    }
+    pthread_mutex_unlock(&g_mutex);
+
+    for (i = 0; i < n; i++) {
+        uint64_t d = __atomic_load_n(&rings[i]->dropped, __ATOMIC_RELAXED);
+        ends[i] = __atomic_load_n(&rings[i]->head, __ATOMIC_ACQUIRE);
+        heads[i] = ring_peek(rings[i], ends[i]);
+        if (d != rings[i]->dropped_seen) {
+            emit_dropped(d - rings[i]->dropped_seen);
+            rings[i]->dropped_seen = d;
+        }
+    }
+
+    for (;;) {
+        best = -1;
+        for (i = 0; i < n; i++)
+            if (heads[i] && (best < 0 || heads[i]->ts_ns < heads[best]->ts_ns))
+                best = i;
+        if (best < 0) break;
+
+        r = rings[best];
+        if (g_mode == 2) emit_binary(heads[best]);
+        else emit_text(heads[best]);
+        r->tail += heads[best]->size;
+        /* Hand the space back in batches, not per record */
+        if ((r->tail & 0xffff) < heads[best]->size)
+            __atomic_store_n(&r->tail, r->tail, __ATOMIC_RELEASE);
+        heads[best] = ring_peek(r, ends[best]);
+    }
+    for (i = 0; i < n; i++)
+        __atomic_store_n(&rings[i]->tail, rings[i]->tail, __ATOMIC_RELEASE);
+    out_flush();
+}
+
+static int open_output(const char *path);
+
+/* logrotate renamed the file: write what is queued to the old one, then
+ * start the path anew (binary: new header, string ids restart) */
+static void out_reopen(void)
+{
+    int fd = open_output(g_path);
+
+    if (fd < 0) return;                 /* keep writing the old file */
+    close(g_fd);
+    g_fd = fd;
+    if (g_ids) memset(g_ids, 0, g_ids_cap * sizeof(*g_ids));
+    g_ids_used = 0;
+    g_next_id = 1;
+}
+
+static void *writer_main(void *arg)
+{
+    uint64_t seen;
+    int stop, reopen;
+
+    (void)arg;
+    tl_no_ring = 1;                     /* never log from here */
+    for (;;) {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += (long)g_flush_ms * 1000000L;
+        while (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&g_mutex);
+        while (!g_stop && g_flush_req == g_flush_done)
+            if (pthread_cond_timedwait(&g_kick, &g_mutex, &ts) == ETIMEDOUT)
+                break;
+        seen = g_flush_req;
+        stop = g_stop;
+        reopen = g_reopen;
+        g_reopen = 0;
+        pthread_mutex_unlock(&g_mutex);
+
+        drain();
+        if (reopen) out_reopen();
+
+        pthread_mutex_lock(&g_mutex);
+        g_flush_done = seen;
+        pthread_cond_broadcast(&g_done);
+        pthread_mutex_unlock(&g_mutex);
+
+        if (stop) break;
+    }
+    return NULL;
+}
+
+static void alog_stop(void)
+{
+    if (!g_running) return;
+    __atomic_store_n(&g_running, 0, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&g_mutex);
+    g_stop = 1;
+    pthread_cond_signal(&g_kick);
+    pthread_mutex_unlock(&g_mutex);
+    pthread_join(g_thread, NULL);
+
+    close(g_fd);
+    g_fd = -1;
+}
+
+/* =========================================================
+ * Start: the first log file an NF adds
+ * ========================================================= */
+static int open_output(const char *path)
+{
+    char bpath[512];
+    const char *p = path;
+    int fd;
+
+    if (g_mode == 2) {
+        size_t n = strlen(path);
+        if (n > 4 && strcmp(path + n - 4, ".log") == 0) n -= 4;
+        snprintf(bpath, sizeof(bpath), "%.*s" OGS_ALOG_FILE_SUFFIX, (int)n, path);
+        p = bpath;
+    }
+    fd = open(p, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "ogs-alog: open(%s) failed: %s\n", p, strerror(errno));
+        return -1;
+    }
+
+    if (g_mode == 2) {
+        ogs_alog_file_header_t h;
+
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, OGS_ALOG_FILE_MAGIC, 8);
+        h.version = OGS_ALOG_FILE_VERSION;
+        h.pid = (uint32_t)getpid();
+        h.start_unix_ns = clock_ns(CLOCK_REALTIME);
+        snprintf(h.program, sizeof(h.program), "%s",
+                 program_invocation_short_name);
+        if (write(fd, &h, sizeof(h)) != (ssize_t)sizeof(h)) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+void ogs_alog_add_file(const void *target, const char *path)
+{
+    const char *env;
+    size_t kb = RING_DEFAULT_KB;
+
+    if (g_running || !path) return;     /* first file only */
+
+    env = getenv("OGS_ALOG");
+    if (!env || !*env || strcmp(env, "off") == 0 || strcmp(env, "0") == 0)
+        return;
+    if (strcmp(env, "text") == 0 || strcmp(env, "1") == 0) {
+        g_mode = 1;
+    } else if (strcmp(env, "binary") == 0) {
+        g_mode = 2;
+    } else {
+        fprintf(stderr, "ogs-alog: unknown OGS_ALOG=%s, logging synchronously\n", env);
+        return;
+    }
+
+    env = getenv("OGS_ALOG_RING_KB");
+    if (env && atoi(env) > 0) kb = (size_t)atoi(env);
+    if (kb < 64) kb = 64;
+    if (kb > 65536) kb = 65536;
+    g_ring_size = 64 * 1024;
+    while (g_ring_size < kb * 1024) g_ring_size <<= 1;
+
+    env = getenv("OGS_ALOG_FLUSH_MS");
+    if (env && atoi(env) > 0)
+        g_flush_ms = atoi(env) > 1000 ? 1000 : atoi(env);
+
+    g_out = malloc(OUT_BUF_SIZE);
+    if (!g_out) return;
+    snprintf(g_path, sizeof(g_path), "%s", path);
+    g_fd = open_output(path);
+    if (g_fd < 0) {
+        free(g_out);
+        g_out = NULL;
+        return;
+    }
+    if (pthread_create(&g_thread, NULL, writer_main, NULL) != 0) {
+        close(g_fd);
+        g_fd = -1;
+        return;
+    }
+    pthread_setname_np(g_thread, "ogs-alog");
+    g_target = target;
+    __atomic_store_n(&g_running, 1, __ATOMIC_RELEASE);
+    atexit(alog_stop);
+}
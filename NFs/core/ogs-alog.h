@@ -0,0 +1,412 @@
+/*
+ * ogs-alog.h — asynchronous logging backend for every NF.
+ *
+ * Upstream ogs_log_vprintf() formats each line and fprintf()+fflush()es it
+ * to /var/log/open5gs/<nf>.log on the calling thread, i.e. on the NF event
+ * loop.  With OGS_ALOG set, Dockerfile.build-all patches three hooks into
+ * lib/core/ogs-log.c:
+ *
+ *   - ogs_log_add_file() hands its log target and path to
+ *     ogs_alog_add_file(), which starts the writer thread
+ *   - ogs_log_vprintf(), once the domain level check has passed, calls
+ *     ogs_alog_vprintf() for each target; if that takes the record,
+ *     upstream formatting and writing are skipped for that target.  Only
+ *     the file target given to ogs_alog_add_file() is taken: stderr (the
+ *     container log) and any later file stay synchronous upstream targets
+ *   - ogs_log_cycle() (SIGHUP, after logrotate) calls ogs_alog_reopen(),
+ *     so the writer opens the path anew instead of writing on into the
+ *     renamed file
+ *
+ * The calling thread only copies a compact binary record into its own
+ * single-producer ring: timestamp, level, pointers to the format string,
+ * file, function and domain name, and the printf arguments (integers and
+ * doubles as 8 bytes, strings copied).  No formatting, no lock, no
+ * syscall.  A full ring drops the record and counts it; ERROR and FATAL
+ * records instead wait for the writer to drain the ring and then take the
+ * synchronous upstream path (ogs_alog_vprintf() returns 0).
+ *
+ * The four pointers are read by the writer thread later, and as map keys
+ * for the string table of the binary format, so they must stay valid and
+ * unchanged for the life of the process.  Upstream passes string literals
+ * for all of them: __FILE__, __func__, the format of the ogs_log_*() macro
+ * and the domain name given to ogs_log_install_domain().  A caller that
+ * builds a format or domain name at run time must not log through this
+ * backend (OGS_ALOG=off).
+ *
+ * One writer thread per process merges the rings by timestamp every
+ * OGS_ALOG_FLUSH_MS and writes in large batches:
+ *
+ *   text    the line upstream would have written, to the same file
+ *           ("MM/DD hh:mm:ss.mmm: [domain] LEVEL: message (file:line)")
+ *   binary  the records themselves, to <name>.alog next to the .log
+ *           (format below); open5gs-logfmt turns them into the same text
+ *
+ * ERROR and FATAL records wait until the writer has written them, so the
+ * line before an ogs_assert() abort is on disk.  A SIGKILL loses at most
+ * one flush interval.
+ *
+ * Configuration (env, read when the log file is added):
+ *   OGS_ALOG            off | text | binary   (default: off = upstream path)
+ *   OGS_ALOG_RING_KB    ring per logging thread (default: 1024, 64..65536)
+ *   OGS_ALOG_FLUSH_MS   writer interval (default: 20, 1..1000)
+ *
+ * Writer: NFs/core/ogs-alog.c.  Offline formatter:
+ * NFs/core/tools/open5gs-logfmt.c.  Benchmark: NFs/core/tools/ogs-alog-bench.c.
+ */
+
+#ifndef OGS_ALOG_H
+#define OGS_ALOG_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hooks (patched into ogs-log.c); target is the upstream ogs_log_t */
+void ogs_alog_add_file(const void *target, const char *path);
+int  ogs_alog_vprintf(const void *target, int level, int domain_id,
+        const char *domain, int err, const char *file, int line,
+        const char *func, int content_only, const char *format, va_list ap);
+void ogs_alog_reopen(void);
+
+/* Write out everything logged so far (waits up to 500 ms) */
+void ogs_alog_flush(void);
+
+/* Records dropped on full rings since start */
+uint64_t ogs_alog_dropped(void);
+
+/* ogs_log_level_e values */
+#define OGS_ALOG_FATAL          1
+#define OGS_ALOG_ERROR          2
+#define OGS_ALOG_WARN           3
+#define OGS_ALOG_INFO           4
+#define OGS_ALOG_DEBUG          5
+#define OGS_ALOG_TRACE          6
+
+#define OGS_ALOG_F_CONTENT_ONLY 0x01    /* ogs_log_print(): message only */
+#define OGS_ALOG_F_TRUNCATED    0x02    /* string arguments were cut */
+
+#define OGS_ALOG_MAX_ARGS       4096    /* encoded argument bytes per record */
+
+/* =========================================================
+ * Binary file (<name>.alog)
+ *
+ *   [header][entry]...    a restarted NF appends a new header
+ *
+ * Entries start with a one-byte tag; integers are host byte order:
+ *   'S' u32 id, u16 len, len bytes     string (format, file, function,
+ *                                       domain), before its first use
+ *   'L' u64 ts_ns (CLOCK_REALTIME), u32 fmt, u32 file, u32 func,
+ *       u32 domain, i32 line, i32 err, u8 level, u8 flags, u16 arg_len,
+ *       arg_len bytes                   one log record
+ *   'D' u64 ts_ns, u64 count           records dropped on a full ring
+ *
+ * String ids restart with every header.
+ * ========================================================= */
+#define OGS_ALOG_FILE_MAGIC     "OGSALOG1"
+#define OGS_ALOG_FILE_VERSION   1
+#define OGS_ALOG_FILE_SUFFIX    ".alog"
+
+typedef struct ogs_alog_file_header_s {
+    char     magic[8];          /* OGS_ALOG_FILE_MAGIC */
+    uint32_t version;
+    uint32_t pid;
+    uint64_t start_unix_ns;
+    char     program[32];
+} ogs_alog_file_header_t;
+
+#define OGS_ALOG_TAG_STRING     'S'
+#define OGS_ALOG_TAG_LOG        'L'
+#define OGS_ALOG_TAG_DROP       'D'
+#define OGS_ALOG_LOG_FIXED      (8 + 4 * 4 + 4 + 4 + 1 + 1 + 2)
+
+/* =========================================================
+ * printf argument encoding, shared by the writer and the formatter.
+ * Per conversion, in format order:
+ *   '*' width / precision, integers, %c, %p   8 bytes (int64)
+ *   floating point                             8 bytes (double)
+ *   %s                                         u16 len (0xffff = NULL),
+ *                                              len bytes, NUL
+ *   %n, %%, %m                                 nothing
+ * ========================================================= */
+typedef enum {
+    OGS_ALOG_ARG_NONE = 0,
+    OGS_ALOG_ARG_INT,           /* int-sized: none / hh / h */
+    OGS_ALOG_ARG_LONG,          /* 64-bit: l / ll / q / L / j / z / Z / t */
+    OGS_ALOG_ARG_DOUBLE,
+    OGS_ALOG_ARG_LDOUBLE,
+    OGS_ALOG_ARG_PTR,
+    OGS_ALOG_ARG_STR,
+    OGS_ALOG_ARG_COUNT,         /* %n: pointer consumed, not stored */
+} ogs_alog_arg_e;
+
+typedef struct ogs_alog_spec_s {
+    const char *start;          /* the '%' */
+    const char *end;            /* one past the conversion character */
+    char        flags[8];
+    char        conv;
+    int         star_width;
+    int         star_prec;
+    int         width;          /* -1: none or '*' */
+    int         prec;           /* -1: none or '*' */
+    int         arg;            /* ogs_alog_arg_e */
+    int         short_len;      /* hh / h: keep for %hhx etc. */
+    char        length[3];      /* as written, for %hh / %h */
+} ogs_alog_spec_t;
+
+/* Next conversion at or after *fmt ("%%" and plain text are skipped by
+ * the caller); returns 0 when the format has no more '%'. */
+static inline int ogs_alog_spec_next(const char *fmt, ogs_alog_spec_t *sp)
+{
+    const char *p = strchr(fmt, '%');
+    int nf = 0;
+
+    if (!p) return 0;
+    memset(sp, 0, sizeof(*sp));
+    sp->start = p++;
+    sp->width = sp->prec = -1;
+
+    while (*p && strchr("-+ #0'I", *p)) {
+        if (nf < (int)sizeof(sp->flags) - 1) sp->flags[nf++] = *p;
+        p++;
+    }
+    if (*p == '*') {
+        sp->star_width = 1;
+        p++;
+    } else if (*p >= '0' && *p <= '9') {
+        sp->width = 0;
+        while (*p >= '0' && *p <= '9') sp->width = sp->width * 10 + (*p++ - '0');
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            sp->star_prec = 1;
+            p++;
+        } else {
+            sp->prec = 0;
+            while (*p >= '0' && *p <= '9') sp->prec = sp->prec * 10 + (*p++ - '0');
+        }
+    }
+
+    if (p[0] == 'h' && p[1] == 'h') {
+        memcpy(sp->length, "hh", 2); sp->short_len = 1; p += 2;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        sp->arg = OGS_ALOG_ARG_LONG; p += 2;
+    } else if (*p == 'h') {
+        sp->length[0] = 'h'; sp->short_len = 1; p++;
+    } else if (*p && strchr("lqLjzZt", *p)) {
+        sp->arg = (*p == 'L') ? OGS_ALOG_ARG_LDOUBLE : OGS_ALOG_ARG_LONG;
+        p++;
+    }
+
+    sp->conv = *p;
+    sp->end = *p ? p + 1 : p;
+    switch (sp->conv) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        sp->arg = sp->arg ? OGS_ALOG_ARG_LONG : OGS_ALOG_ARG_INT;
+        break;
+    case 'c':
+        sp->arg = OGS_ALOG_ARG_INT;
+        break;
+    case 'f': case 'F': case 'e': case 'E':
+    case 'g': case 'G': case 'a': case 'A':
+        sp->arg = sp->arg == OGS_ALOG_ARG_LDOUBLE ?
+                  OGS_ALOG_ARG_LDOUBLE : OGS_ALOG_ARG_DOUBLE;
+        break;
+    case 'p':
+        sp->arg = OGS_ALOG_ARG_PTR;
+        break;
+    case 's':
+        sp->arg = OGS_ALOG_ARG_STR;
+        break;
+    case 'n':
+        sp->arg = OGS_ALOG_ARG_COUNT;
+        break;
+    default:                    /* %%, %m, unknown, end of string */
+        sp->arg = OGS_ALOG_ARG_NONE;
+        sp->star_width = sp->star_prec = 0;
+        break;
+    }
+    return 1;
+}
+
+static inline void ogs_alog_put64(uint8_t **p, uint64_t v)
+{
+    memcpy(*p, &v, 8);
+    *p += 8;
+}
+
+static inline int ogs_alog_get64(const uint8_t **p, const uint8_t *end,
+        uint64_t *v)
+{
+    if (end - *p < 8) return -1;
+    memcpy(v, *p, 8);
+    *p += 8;
+    return 0;
+}
+
+static inline size_t ogs_alog_cat(char *out, size_t len, size_t n,
+        const char *s, size_t slen)
+{
+    if (n + 1 < len) {
+        size_t c = slen < len - 1 - n ? slen : len - 1 - n;
+        memcpy(out + n, s, c);
+        out[n + c] = '\0';
+    }
+    return n + slen;
+}
+
+/*
+ * Render a format with encoded arguments, as vsnprintf() would have with
+ * the original ones.  Returns the length the full message would have.
+ */
+static inline size_t ogs_alog_render(char *out, size_t len, const char *fmt,
+        const uint8_t *args, size_t arg_len)
+{
+    const uint8_t *a = args, *aend = args + arg_len;
+    ogs_alog_spec_t sp;
+    size_t n = 0;
+    char spec[48], tmp[512];
+    int w, pr, r;
+    uint64_t v;
+
+    if (len) out[0] = '\0';
+    while (ogs_alog_spec_next(fmt, &sp)) {
+        n = ogs_alog_cat(out, len, n, fmt, (size_t)(sp.start - fmt));
+        fmt = sp.end;
+
+        if (sp.conv == '%') {
+            n = ogs_alog_cat(out, len, n, "%", 1);
+            continue;
+        }
+        if (sp.arg == OGS_ALOG_ARG_NONE) {
+            n = ogs_alog_cat(out, len, n, sp.start, (size_t)(sp.end - sp.start));
+            continue;
+        }
+
+        w = sp.width;
+        pr = sp.prec;
+        if (sp.star_width) {
+            if (ogs_alog_get64(&a, aend, &v)) break;
+            w = (int)(int64_t)v;
+        }
+        if (sp.star_prec) {
+            if (ogs_alog_get64(&a, aend, &v)) break;
+            pr = (int)(int64_t)v;
+        }
+        if (sp.arg == OGS_ALOG_ARG_COUNT) continue;
+
+        /* Rebuild one spec with literal width/precision and the length
+         * modifier matching what is passed below */
+        r = snprintf(spec, sizeof(spec), "%%%s", sp.flags);
+        if (w >= 0) r += snprintf(spec + r, sizeof(spec) - r, "%d", w);
+        else if (w < -1) r += snprintf(spec + r, sizeof(spec) - r, "-%d", -w);
+        if (pr >= 0) r += snprintf(spec + r, sizeof(spec) - r, ".%d", pr);
+        if (sp.arg == OGS_ALOG_ARG_INT && sp.short_len)
+            r += snprintf(spec + r, sizeof(spec) - r, "%s", sp.length);
+        else if (sp.arg == OGS_ALOG_ARG_LONG)
+            r += snprintf(spec + r, sizeof(spec) - r, "ll");
+        snprintf(spec + r, sizeof(spec) - r, "%c", sp.conv);
+
+        if (sp.arg == OGS_ALOG_ARG_STR) {
+            uint16_t sl;
+            const char *s = "(null)";
+            if (aend - a < 2) break;
+            memcpy(&sl, a, 2);
+            a += 2;
+            if (sl != 0xffff) {
+                if ((size_t)(aend - a) < (size_t)sl + 1) break;
+                s = (const char *)a;
+                a += sl + 1;
+            }
+            /* plain %s: copy straight, no size limit */
+            if (w < 0 && pr < 0 && !sp.flags[0]) {
+                n = ogs_alog_cat(out, len, n, s, strlen(s));
+                continue;
+            }
+            r = snprintf(tmp, sizeof(tmp), spec, s);
+        } else {
+            if (ogs_alog_get64(&a, aend, &v)) break;
+            switch (sp.arg) {
+            case OGS_ALOG_ARG_INT:
+                r = snprintf(tmp, sizeof(tmp), spec, (int)v);
+                break;
+            case OGS_ALOG_ARG_LONG:
+                r = snprintf(tmp, sizeof(tmp), spec, (long long)v);
+                break;
+            case OGS_ALOG_ARG_PTR:
+                r = snprintf(tmp, sizeof(tmp), spec, (void *)(uintptr_t)v);
+                break;
+            default: {
+                double d;
+                memcpy(&d, &v, 8);
+                r = snprintf(tmp, sizeof(tmp), spec, d);
+                break;
+            }
+            }
+        }
+        if (r > 0)
+            n = ogs_alog_cat(out, len, n, tmp,
+                    (size_t)r < sizeof(tmp) ? (size_t)r : sizeof(tmp) - 1);
+    }
+    return ogs_alog_cat(out, len, n, fmt, strlen(fmt));
+}
+
+/*
+ * One full line as upstream's file target writes it:
+ *   "MM/DD hh:mm:ss.mmm: [domain] LEVEL: message (file:line)\n"
+ * with " (err:strerror)" after the message when err is set; content-only
+ * records (ogs_log_print) are the message alone.  Returns the length.
+ */
+static inline size_t ogs_alog_line(char *out, size_t len, uint64_t ts_ns,
+        int level, const char *domain, const char *file, int line, int err,
+        int flags, const char *msg)
+{
+    static const char *const names[] = {
+        "", "FATAL", "ERROR", "WARNING", "INFO", "DEBUG", "TRACE" };
+    char tmp[160];
+    size_t n = 0;
+    int r;
+
+    if (len) out[0] = '\0';
+    if (!(flags & OGS_ALOG_F_CONTENT_ONLY)) {
+        time_t t = (time_t)(ts_ns / 1000000000ULL);
+        struct tm tm;
+
+        localtime_r(&t, &tm);
+        r = snprintf(tmp, sizeof(tmp), "%02d/%02d %02d:%02d:%02d.%03d: [%s] %s: ",
+                tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                (int)(ts_ns / 1000000ULL % 1000), domain ? domain : "",
+                names[level >= 0 && level <= 6 ? level : 0]);
+        n = ogs_alog_cat(out, len, n, tmp, r > 0 ? (size_t)r : 0);
+    }
+    n = ogs_alog_cat(out, len, n, msg, strlen(msg));
+    if (err) {
+        char ebuf[96];
+        const char *es = ebuf;
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+        es = strerror_r(err, ebuf, sizeof(ebuf));
+#else
+        if (strerror_r(err, ebuf, sizeof(ebuf)) != 0) ebuf[0] = '\0';
+#endif
+        r = snprintf(tmp, sizeof(tmp), " (%d:%s)", err, es);
+        n = ogs_alog_cat(out, len, n, tmp, r > 0 ? (size_t)r : 0);
+    }
+    if (!(flags & OGS_ALOG_F_CONTENT_ONLY)) {
+        r = snprintf(tmp, sizeof(tmp), " (%s:%d)\n", file ? file : "", line);
+        n = ogs_alog_cat(out, len, n, tmp, r > 0 ? (size_t)r : 0);
+    }
+    return n;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_ALOG_H */
@@ -0,0 +1,229 @@
+/*
+ * ogs-memstat.c — per-process memory statistics page (see ogs-memstat.h).
+ *
+ * No open5GS headers on purpose: ogs-pool.h includes ogs-memstat.h, and
+ * ogs_malloc() itself allocates from ogs_pools, so the registry is a
+ * static table and never allocates.  talloc is reached through weak
+ * references; a build without the talloc core context reports 0.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "ogs-memstat.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+_Static_assert(sizeof(ogs_memstat_page_t) <= OGS_MEMSTAT_SIZE,
+               "ogs_memstat_page_t does not fit OGS_MEMSTAT_SIZE");
+
+extern size_t talloc_total_size(const void *ptr) __attribute__((weak));
+extern size_t talloc_total_blocks(const void *ptr) __attribute__((weak));
+extern void *__ogs_talloc_core __attribute__((weak));
+
+typedef struct {
+    char       name[OGS_MEMSTAT_NAME_LEN];
+    const int *size;
+    const int *avail;
+} pool_ref_t;
+
+/* Registry: pools may be created off the NF thread (SBI client, UPF
+ * workers), so add/del and the publish copy share a spinlock */
+static pool_ref_t g_pools[OGS_MEMSTAT_MAX_POOLS];
+static int        g_npools      = 0;
+static uint32_t   g_generation  = 0;
+static uint32_t   g_dropped     = 0;
+static int        g_lock        = 0;
+
+/* Page */
+static int                 g_state = 0;     /* 0 not opened, 1 open, -1 off */
+static ogs_memstat_page_t *g_page  = NULL;
+static uint32_t            g_page_generation = UINT32_MAX;
+static uint64_t            g_interval_ns = 200ULL * 1000000ULL;
+static uint64_t            g_next_ns     = 0;
+static char                g_path[160];
+
+static void lock(void)
+{
+    while (__atomic_exchange_n(&g_lock, 1, __ATOMIC_ACQUIRE))
+        ;
+}
+
+static void unlock(void)
+{
+    __atomic_store_n(&g_lock, 0, __ATOMIC_RELEASE);
+}
+
+static uint64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void ogs_memstat_pool_add(const char *name, const int *size, const int *avail)
+{
+    size_t n;
+    pool_ref_t *p;
+
+    /* "&self->pool" -> "self->pool"; keep the tail if it is too long */
+    while (*name == '&' || *name == ' ' || *name == '(') name++;
+    n = strlen(name);
+    if (n >= OGS_MEMSTAT_NAME_LEN) name += n - (OGS_MEMSTAT_NAME_LEN - 1);
+
+    lock();
+    if (g_npools == OGS_MEMSTAT_MAX_POOLS) {
+        g_dropped++;
+        unlock();
+        return;
+    }
+    p = &g_pools[g_npools++];
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->size  = size;
+    p->avail = avail;
+    g_generation++;
+    unlock();
+}
+
+void ogs_memstat_pool_del(const int *avail)
+{
+    int i;
+
+    lock();
+    for (i = 0; i < g_npools; i++) {
+        if (g_pools[i].avail == avail) {
+            g_pools[i] = g_pools[--g_npools];
+            g_generation++;
+            break;
+        }
+    }
+    unlock();
+}
+
+static void page_unlink(void)
+{
+    if (g_page) unlink(g_path);
+}
+
+static int page_open(void)
+{
+    const char *env, *dir;
+    int fd;
+    void *p;
+
+    env = getenv("OGS_MEMSTAT");
+    if (env && strcmp(env, "0") == 0) return -1;
+
+    env = getenv("OGS_MEMSTAT_MS");
+    if (env && atoi(env) > 0)
+        g_interval_ns = (uint64_t)atoi(env) * 1000000ULL;
+
+    dir = getenv("OGS_MEMSTAT_DIR");
+    if (!dir || !*dir) dir = OGS_MEMSTAT_DEFAULT_DIR;
+    snprintf(g_path, sizeof(g_path), "%s/" OGS_MEMSTAT_PREFIX "%d",
+             dir, (int)getpid());
+
+    fd = open(g_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "ogs-memstat: open(%s) failed: %s\n",
+                g_path, strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, OGS_MEMSTAT_SIZE) < 0) {
+        fprintf(stderr, "ogs-memstat: ftruncate(%s) failed: %s\n",
+                g_path, strerror(errno));
+        close(fd);
+        unlink(g_path);
+        return -1;
+    }
+    p = mmap(NULL, OGS_MEMSTAT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "ogs-memstat: mmap(%s) failed: %s\n",
+                g_path, strerror(errno));
+        unlink(g_path);
+        return -1;
+    }
+
+    /* Fresh file per PID: zeroed, magic written last */
+    g_page = p;
+    g_page->version = OGS_MEMSTAT_VERSION;
+    g_page->pid     = (uint32_t)getpid();
+    snprintf(g_page->name, sizeof(g_page->name), "%s",
+             program_invocation_short_name);
+    __atomic_store_n(&g_page->magic, OGS_MEMSTAT_MAGIC, __ATOMIC_RELEASE);
+    atexit(page_unlink);
+    return 1;
+}
+
+static void publish(uint64_t now_ns)
+{
+    ogs_memstat_page_t *pg = g_page;
+    size_t tbytes = 0, tblocks = 0;
+    int i;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+
+    if (&__ogs_talloc_core && __ogs_talloc_core &&
+        talloc_total_size && talloc_total_blocks) {
+        tbytes  = talloc_total_size(__ogs_talloc_core);
+        tblocks = talloc_total_blocks(__ogs_talloc_core);
+    }
+
+    __atomic_store_n(&pg->seq, pg->seq + 1, __ATOMIC_RELAXED);   /* odd */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    pg->published_ns      = now_ns;
+    pg->published_unix_ms = clock_ns(CLOCK_REALTIME) / 1000000ULL;
+    pg->ticks++;
+    pg->heap_used         = (uint64_t)mi.uordblks;
+    pg->heap_free         = (uint64_t)mi.fordblks;
+    pg->heap_mmap         = (uint64_t)mi.hblkhd;
+    pg->talloc_bytes      = tbytes;
+    pg->talloc_blocks     = tblocks;
+
+    lock();
+    if (g_page_generation != g_generation) {
+        for (i = 0; i < g_npools; i++)
+            memcpy(pg->pools[i].name, g_pools[i].name, OGS_MEMSTAT_NAME_LEN);
+        pg->npools        = (uint32_t)g_npools;
+        pg->generation    = g_generation;
+        pg->pools_dropped = g_dropped;
+        g_page_generation = g_generation;
+    }
+    for (i = 0; i < g_npools; i++) {
+        int size  = *g_pools[i].size;
+        int avail = *g_pools[i].avail;
+        pg->pools[i].size = size > 0 ? (uint32_t)size : 0;
+        pg->pools[i].used = size > avail ? (uint32_t)(size - avail) : 0;
+    }
+    unlock();
+
+    __atomic_store_n(&pg->seq, pg->seq + 1, __ATOMIC_RELEASE);   /* even */
+}
+
+void ogs_memstat_tick(void)
+{
+    uint64_t now;
+
+    if (g_state < 0) return;
+    now = clock_ns(CLOCK_MONOTONIC_COARSE);
+    if (now < g_next_ns) return;
+    if (g_state == 0) {
+        g_state = page_open();
+        if (g_state < 0) return;
+    }
+    g_next_ns = now + g_interval_ns;
+    publish(clock_ns(CLOCK_MONOTONIC));
+}
@@ -0,0 +1,112 @@
+/*
+ * ogs-memstat.h — per-process memory statistics page for every NF.
+ *
+ * Built into libogscore only with `--build-arg OGS_MEMSTAT=1` (off by
+ * default; Dockerfile.build-all then copies ogs-memstat.c into lib/core
+ * and patches two hooks in):
+ *
+ *   - ogs_pool_init / ogs_pool_create register the pool's size / avail
+ *     counters, ogs_pool_final / ogs_pool_destroy drop them
+ *   - ogs_pollset_poll calls ogs_memstat_tick(), so the NF thread itself
+ *     publishes, at most every OGS_MEMSTAT_MS (default 200 ms)
+ *
+ * Each NF process publishes into a memory-mapped file:
+ *
+ *   /dev/shm/open5gs-memstat.<pid>     (OGS_MEMSTAT_DIR overrides /dev/shm)
+ *
+ * with glibc heap totals (mallinfo2), the talloc tree under the core
+ * context, and the size / in-use count of every registered ogs_pool.
+ * Everything is read on the NF thread, so talloc is never walked
+ * concurrently.  An idle NF blocks in poll and publishes less often;
+ * `published_ns` tells a reader how old the snapshot is.
+ *
+ * Concurrency: single writer, seqlock as in amf-health-shm.h.  The pool
+ * table is rewritten only when `generation` changes (a pool was added or
+ * removed); readers cache the names per generation.
+ *
+ * OGS_MEMSTAT=0 turns publishing off (registration stays, it is free).
+ * Reader: NFs/core/tools/open5gs-memstat.c.
+ */
+
+#ifndef OGS_MEMSTAT_H
+#define OGS_MEMSTAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OGS_MEMSTAT_MAGIC           0x534d354fU     /* "O5MS" */
+#define OGS_MEMSTAT_VERSION         1
+#define OGS_MEMSTAT_SIZE            32768
+#define OGS_MEMSTAT_MAX_POOLS       600
+#define OGS_MEMSTAT_NAME_LEN        40
+#define OGS_MEMSTAT_DEFAULT_DIR     "/dev/shm"
+#define OGS_MEMSTAT_PREFIX          "open5gs-memstat."
+
+typedef struct ogs_memstat_pool_s {
+    char     name[OGS_MEMSTAT_NAME_LEN];   /* the ogs_pool_init() argument */
+    uint32_t size;                          /* capacity */
+    uint32_t used;                          /* size - avail */
+} ogs_memstat_pool_t;
+
+typedef struct ogs_memstat_page_s {
+    /* ── header: written once at open ── */
+    uint32_t magic;             /* OGS_MEMSTAT_MAGIC */
+    uint32_t version;           /* OGS_MEMSTAT_VERSION */
+    uint32_t seq;               /* seqlock version: odd = update in progress */
+    uint32_t pid;
+    char     name[32];          /* program name, e.g. open5gs-amfd */
+
+    /* ── body: protected by seq ── */
+    uint64_t published_ns;      /* CLOCK_MONOTONIC */
+    uint64_t published_unix_ms;
+    uint64_t ticks;             /* publishes so far */
+    uint64_t heap_used;         /* mallinfo2: uordblks (arena bytes in use) */
+    uint64_t heap_free;         /* mallinfo2: fordblks */
+    uint64_t heap_mmap;         /* mallinfo2: hblkhd (mmap()ed chunks) */
+    uint64_t talloc_bytes;      /* talloc_total_size(core context) */
+    uint64_t talloc_blocks;     /* talloc_total_blocks(core context) */
+    uint32_t generation;        /* bumped when the pool set changes */
+    uint32_t npools;
+    uint32_t pools_dropped;     /* registrations beyond MAX_POOLS */
+    uint32_t reserved0;
+    ogs_memstat_pool_t pools[OGS_MEMSTAT_MAX_POOLS];
+} ogs_memstat_page_t;
+
+/* Hooks (patched into ogs-pool.h / ogs-poll.c) */
+void ogs_memstat_pool_add(const char *name, const int *size, const int *avail);
+void ogs_memstat_pool_del(const int *avail);
+void ogs_memstat_tick(void);
+
+/*
+ * Lock-free consistent read of a mapped page into *out.
+ * Returns 0 on success, -1 if the page is not valid or stayed busy.
+ */
+static inline int ogs_memstat_page_read(
+        const volatile ogs_memstat_page_t *page, ogs_memstat_page_t *out)
+{
+    int tries;
+
+    if (page->magic != OGS_MEMSTAT_MAGIC ||
+        page->version != OGS_MEMSTAT_VERSION)
+        return -1;
+
+    for (tries = 0; tries < 1000; tries++) {
+        uint32_t s1 = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) continue;
+        memcpy(out, (const void *)page, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == s1)
+            return 0;
+    }
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_MEMSTAT_H */
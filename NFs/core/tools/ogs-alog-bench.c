@@ -0,0 +1,261 @@
+/*
+ * ogs-alog-bench — cost of one log call on the NF thread.
+ *
+ * T threads each log N records shaped like the AMF's registration debug
+ * lines (SUPI string, a few integers, a hex value) through one backend:
+ *
+ *   sync    what upstream ogs-log.c does per call: format the timestamp
+ *           prefix and message, then fprintf() + fflush() to the file
+ *   text    ogs_alog_vprintf() with OGS_ALOG=text (ogs-alog.c linked in)
+ *   binary  ogs_alog_vprintf() with OGS_ALOG=binary
+ *
+ * Prints the mean and p50/p99/max per call on the logging threads, the
+ * time until the writer has drained everything, bytes written and
+ * records dropped, then a JSON summary line (tests/bench_logging.sh).
+ *
+ * Usage:
+ *   ogs-alog-bench --mode text --threads 4 --records 200000 \
+ *                  --out /tmp/bench.log [--ring-kb 1024] [--flush-ms 20]
+ *                  [--pace-us 0]
+ *
+ * --pace-us sleeps between calls, to stay under the writer's throughput
+ * and measure the no-drop cost; 0 = as fast as possible (drops likely).
+ *
+ * Build: gcc -O2 -pthread -I NFs/core -o ogs-alog-bench \
+ *            NFs/core/tools/ogs-alog-bench.c NFs/core/ogs-alog.c
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "ogs-alog.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static const char *opt_mode = "text";
+static const char *opt_out = "/tmp/ogs-alog-bench.log";
+static int opt_threads = 1;
+static long opt_records = 100000;
+static int opt_pace_us = 0;
+
+static FILE *g_sync_fp;
+static const char g_target[] = "bench";     /* stands in for the ogs_log_t */
+static pthread_mutex_t g_sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+    int       idx;
+    uint64_t *lat;              /* ns per call */
+} worker_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Upstream ogs_log_vprintf() -> file_writer(), one lock for the FILE */
+static void sync_vprintf(int level, const char *domain, const char *file,
+        int line, const char *format, va_list ap)
+{
+    static const char *const names[] = {
+        "", "FATAL", "ERROR", "WARNING", "INFO", "DEBUG", "TRACE" };
+    char buf[8192];
+    struct timeval tv;
+    struct tm tm;
+    int n;
+
+    gettimeofday(&tv, NULL);
+    localtime_r(&tv.tv_sec, &tm);
+    n = snprintf(buf, sizeof(buf), "%02d/%02d %02d:%02d:%02d.%03d: [%s] %s: ",
+            tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+            (int)(tv.tv_usec / 1000), domain, names[level]);
+    n += vsnprintf(buf + n, sizeof(buf) - (size_t)n, format, ap);
+    if (n < (int)sizeof(buf))
+        snprintf(buf + n, sizeof(buf) - (size_t)n, " (%s:%d)\n", file, line);
+
+    pthread_mutex_lock(&g_sync_mutex);
+    fprintf(g_sync_fp, "%s", buf);
+    fflush(g_sync_fp);
+    pthread_mutex_unlock(&g_sync_mutex);
+}
+
+static void bench_log(int level, const char *file, int line,
+        const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    if (g_sync_fp)
+        sync_vprintf(level, "amf", file, line, format, ap);
+    else
+        ogs_alog_vprintf(g_target, level, 1, "amf", 0, file, line, __func__,
+                         0, format, ap);
+    va_end(ap);
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *w = arg;
+    char supi[32];
+    long i;
+
+    for (i = 0; i < opt_records; i++) {
+        uint64_t t0;
+
+        snprintf(supi, sizeof(supi), "imsi-99970%010ld", (long)w->idx * opt_records + i);
+        t0 = now_ns();
+        switch (i & 3) {
+        case 0:
+            bench_log(OGS_ALOG_INFO, "gmm-sm.c", 1310,
+                "[%s] Registration request", supi);
+            break;
+        case 1:
+            bench_log(OGS_ALOG_DEBUG, "gmm-handler.c", 166,
+                "    RAN_UE_NGAP_ID[%d] AMF_UE_NGAP_ID[%lld] TAC[%d] CellID[0x%llx]",
+                (int)(i & 0xffff), (long long)i, 1, (unsigned long long)0x10 + i);
+            break;
+        case 2:
+            bench_log(OGS_ALOG_DEBUG, "nas-security.c", 87,
+                "[%s] NAS-UL count[%u] seq[%u] len=%zu",
+                supi, (unsigned)i, (unsigned)(i & 0xff), (size_t)(64 + (i & 63)));
+            break;
+        default:
+            bench_log(OGS_ALOG_INFO, "amf-sm.c", 601,
+                "[%s:%d] %s state [%.*s] %5.2f%%",
+                supi, w->idx, "gmm_state_registered", 4, "REGISTERED", 42.0);
+            break;
+        }
+        w->lat[i] = now_ns() - t0;
+        if (opt_pace_us) usleep((useconds_t)opt_pace_us);
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ring_kb = NULL, *flush_ms = NULL;
+    pthread_t *tids;
+    worker_t *w;
+    uint64_t *all, t0, t_logged, t_drained, sum = 0;
+    size_t total, k = 0;
+    char path[512];
+    struct stat st;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--mode") && i + 1 < argc)             opt_mode = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)     opt_threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--records") && i + 1 < argc)     opt_records = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)         opt_out = argv[++i];
+        else if (!strcmp(argv[i], "--ring-kb") && i + 1 < argc)     ring_kb = argv[++i];
+        else if (!strcmp(argv[i], "--flush-ms") && i + 1 < argc)    flush_ms = argv[++i];
+        else if (!strcmp(argv[i], "--pace-us") && i + 1 < argc)     opt_pace_us = atoi(argv[++i]);
+        else {
+            fprintf(stderr,
+                "Usage: ogs-alog-bench --mode sync|text|binary [--threads T] "
+                "[--records N] [--out FILE] [--ring-kb K] [--flush-ms MS] "
+                "[--pace-us US]\n");
+            return 2;
+        }
+    }
+    if (opt_threads < 1 || opt_records < 1) return 2;
+
+    /* Start from an empty file, like a fresh container */
+    snprintf(path, sizeof(path), "%s", opt_out);
+    unlink(path);
+    if (!strcmp(opt_mode, "binary")) {
+        size_t n = strlen(path);
+        if (n > 4 && !strcmp(path + n - 4, ".log")) n -= 4;
+        snprintf(path + n, sizeof(path) - n, "%s", OGS_ALOG_FILE_SUFFIX);
+        unlink(path);
+    }
+
+    if (!strcmp(opt_mode, "sync")) {
+        g_sync_fp = fopen(path, "a");
+        if (!g_sync_fp) {
+            fprintf(stderr, "ogs-alog-bench: %s: %s\n", path, strerror(errno));
+            return 2;
+        }
+    } else if (!strcmp(opt_mode, "text") || !strcmp(opt_mode, "binary")) {
+        setenv("OGS_ALOG", opt_mode, 1);
+        if (ring_kb) setenv("OGS_ALOG_RING_KB", ring_kb, 1);
+        if (flush_ms) setenv("OGS_ALOG_FLUSH_MS", flush_ms, 1);
+        ogs_alog_add_file(g_target, opt_out);
+        if (access(path, F_OK) != 0) {
+            fprintf(stderr, "ogs-alog-bench: writer did not start\n");
+            return 2;
+        }
+    } else {
+        fprintf(stderr, "ogs-alog-bench: unknown mode %s\n", opt_mode);
+        return 2;
+    }
+
+    total = (size_t)opt_threads * (size_t)opt_records;
+    tids = calloc((size_t)opt_threads, sizeof(*tids));
+    w = calloc((size_t)opt_threads, sizeof(*w));
+    all = malloc(total * sizeof(*all));
+    if (!tids || !w || !all) return 2;
+
+    t0 = now_ns();
+    for (i = 0; i < opt_threads; i++) {
+        w[i].idx = i;
+        w[i].lat = all + (size_t)i * (size_t)opt_records;
+        pthread_create(&tids[i], NULL, worker_main, &w[i]);
+    }
+    for (i = 0; i < opt_threads; i++)
+        pthread_join(tids[i], NULL);
+    t_logged = now_ns();
+
+    if (g_sync_fp) {
+        fclose(g_sync_fp);
+    } else {
+        /* One flush waits at most 500 ms: repeat until nothing is left */
+        off_t size;
+        do {
+            size = stat(path, &st) == 0 ? st.st_size : 0;
+            ogs_alog_flush();
+        } while (stat(path, &st) == 0 && st.st_size != size);
+    }
+    t_drained = now_ns();
+
+    for (k = 0; k < total; k++) sum += all[k];
+    qsort(all, total, sizeof(*all), cmp_u64);
+    if (stat(path, &st) != 0) st.st_size = 0;
+
+    printf("[ogs-alog-bench] %s: %d threads x %ld records, %.1f ns/call mean, "
+           "p50 %llu ns, p99 %llu ns, max %llu ns\n",
+           opt_mode, opt_threads, opt_records, (double)sum / (double)total,
+           (unsigned long long)all[total / 2],
+           (unsigned long long)all[total * 99 / 100],
+           (unsigned long long)all[total - 1]);
+    printf("[ogs-alog-bench] logged in %.1f ms, on disk after %.1f ms, "
+           "%lld bytes, %llu dropped\n",
+           (double)(t_logged - t0) / 1e6, (double)(t_drained - t0) / 1e6,
+           (long long)st.st_size, (unsigned long long)ogs_alog_dropped());
+    printf("{\"mode\":\"%s\",\"threads\":%d,\"records\":%zu,\"mean_ns\":%.1f,"
+           "\"p50_ns\":%llu,\"p99_ns\":%llu,\"max_ns\":%llu,\"logged_ms\":%.1f,"
+           "\"drained_ms\":%.1f,\"bytes\":%lld,\"dropped\":%llu,\"file\":\"%s\"}\n",
+           opt_mode, opt_threads, total, (double)sum / (double)total,
+           (unsigned long long)all[total / 2],
+           (unsigned long long)all[total * 99 / 100],
+           (unsigned long long)all[total - 1],
+           (double)(t_logged - t0) / 1e6, (double)(t_drained - t0) / 1e6,
+           (long long)st.st_size, (unsigned long long)ogs_alog_dropped(), path);
+
+    free(all);
+    free(w);
+    free(tids);
+    return 0;
+}
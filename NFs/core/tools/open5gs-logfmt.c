@@ -0,0 +1,252 @@
+/*
+ * open5gs-logfmt — turn OGS_ALOG=binary logs back into text.
+ *
+ * Reads <nf>.alog files written by ogs-alog.c and prints the lines
+ * upstream ogs-log.c would have written to <nf>.log, in the same format,
+ * so grep / tests/ue_latency.py work on the output unchanged.  A file
+ * holds one header per NF start; string ids restart after each header.
+ *
+ * Usage:
+ *   open5gs-logfmt /var/log/open5gs/amf.alog
+ *   open5gs-logfmt --level 3 amf.alog smf.alog    # WARNING and worse
+ *   open5gs-logfmt --follow amf.alog              # like tail -f
+ *   open5gs-logfmt --stats amf.alog               # record counts only
+ *
+ * Exit status: 0 ok, 2 unreadable or not an alog file.
+ *
+ * Build: gcc -O2 -I NFs/core -o open5gs-logfmt NFs/core/tools/open5gs-logfmt.c
+ */
+
+#include "ogs-alog.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    char    **strs;
+    uint32_t  cap;
+} strtab_t;
+
+static int opt_level = OGS_ALOG_TRACE;
+static int opt_follow = 0;
+static int opt_stats = 0;
+
+static unsigned long long n_records, n_dropped, n_starts;
+
+static void strtab_reset(strtab_t *t)
+{
+    uint32_t i;
+    for (i = 0; i < t->cap; i++) free(t->strs[i]);
+    memset(t->strs, 0, t->cap * sizeof(*t->strs));
+}
+
+static const char *strtab_get(const strtab_t *t, uint32_t id)
+{
+    return id < t->cap && t->strs[id] ? t->strs[id] : "";
+}
+
+static int strtab_set(strtab_t *t, uint32_t id, char *s)
+{
+    if (id >= t->cap) {
+        uint32_t cap = t->cap ? t->cap : 1024;
+        char **n;
+        while (cap <= id) cap *= 2;
+        n = realloc(t->strs, cap * sizeof(*n));
+        if (!n) return -1;
+        memset(n + t->cap, 0, (cap - t->cap) * sizeof(*n));
+        t->strs = n;
+        t->cap = cap;
+    }
+    free(t->strs[id]);
+    t->strs[id] = s;
+    return 0;
+}
+
+/* fread() that waits for more data in --follow mode; 0 = clean EOF */
+static int read_full(FILE *fp, void *buf, size_t n, int at_boundary)
+{
+    size_t got = 0;
+
+    for (;;) {
+        got += fread((char *)buf + got, 1, n - got, fp);
+        if (got == n) return 1;
+        if (ferror(fp)) return -1;
+        if (!opt_follow) return got == 0 && at_boundary ? 0 : -1;
+        clearerr(fp);
+        usleep(100 * 1000);
+    }
+}
+
+static void print_log(const strtab_t *t, const uint8_t *hdr,
+        const uint8_t *args, uint16_t arg_len)
+{
+    uint64_t ts;
+    uint32_t fmt, file, func, dom;
+    int32_t line, err;
+    uint8_t level, flags;
+    static char msg[65536], out[65536 + 512];
+    size_t n;
+
+    memcpy(&ts, hdr, 8);
+    memcpy(&fmt, hdr + 8, 4);
+    memcpy(&file, hdr + 12, 4);
+    memcpy(&func, hdr + 16, 4);
+    memcpy(&dom, hdr + 20, 4);
+    memcpy(&line, hdr + 24, 4);
+    memcpy(&err, hdr + 28, 4);
+    level = hdr[32];
+    flags = hdr[33];
+    (void)func;
+
+    n_records++;
+    if (level > opt_level || opt_stats) return;
+
+    ogs_alog_render(msg, sizeof(msg), strtab_get(t, fmt), args, arg_len);
+    n = ogs_alog_line(out, sizeof(out), ts, level, strtab_get(t, dom),
+                      strtab_get(t, file), line, err, flags, msg);
+    fwrite(out, 1, n < sizeof(out) ? n : sizeof(out) - 1, stdout);
+}
+
+static void print_drop(const uint8_t *rec)
+{
+    uint64_t ts, count;
+    char msg[96], out[512];
+    size_t n;
+
+    memcpy(&ts, rec, 8);
+    memcpy(&count, rec + 8, 8);
+    n_dropped += count;
+    if (OGS_ALOG_WARN > opt_level || opt_stats) return;
+
+    snprintf(msg, sizeof(msg), "%llu log records dropped, ring full",
+             (unsigned long long)count);
+    n = ogs_alog_line(out, sizeof(out), ts, OGS_ALOG_WARN, "alog",
+                      "ogs-alog.c", 0, 0, 0, msg);
+    fwrite(out, 1, n < sizeof(out) ? n : sizeof(out) - 1, stdout);
+}
+
+static int format_file(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    strtab_t strs = { NULL, 0 };
+    uint8_t fixed[OGS_ALOG_LOG_FIXED];
+    static uint8_t args[65536];
+    int rc = 0, r;
+
+    if (!fp) {
+        fprintf(stderr, "open5gs-logfmt: %s: %s\n", path, strerror(errno));
+        return 2;
+    }
+
+    for (;;) {
+        uint8_t tag;
+
+        r = read_full(fp, &tag, 1, 1);
+        if (r == 0) break;
+        if (r < 0) goto truncated;
+
+        switch (tag) {
+        case 'O': {             /* first byte of OGS_ALOG_FILE_MAGIC */
+            ogs_alog_file_header_t h;
+
+            h.magic[0] = 'O';
+            if (read_full(fp, (uint8_t *)&h + 1, sizeof(h) - 1, 0) < 0)
+                goto truncated;
+            if (memcmp(h.magic, OGS_ALOG_FILE_MAGIC, 8) != 0 ||
+                h.version != OGS_ALOG_FILE_VERSION)
+                goto corrupt;
+            strtab_reset(&strs);
+            n_starts++;
+            break;
+        }
+        case OGS_ALOG_TAG_STRING: {
+            uint32_t id;
+            uint16_t len;
+            char *s;
+
+            if (read_full(fp, &id, 4, 0) < 0 || read_full(fp, &len, 2, 0) < 0)
+                goto truncated;
+            s = malloc((size_t)len + 1);
+            if (!s) goto corrupt;
+            if (len && read_full(fp, s, len, 0) < 0) {
+                free(s);
+                goto truncated;
+            }
+            s[len] = '\0';
+            if (strtab_set(&strs, id, s) < 0) {
+                free(s);
+                goto corrupt;
+            }
+            break;
+        }
+        case OGS_ALOG_TAG_LOG: {
+            uint16_t arg_len;
+
+            if (read_full(fp, fixed, sizeof(fixed), 0) < 0) goto truncated;
+            memcpy(&arg_len, fixed + OGS_ALOG_LOG_FIXED - 2, 2);
+            if (arg_len && read_full(fp, args, arg_len, 0) < 0) goto truncated;
+            print_log(&strs, fixed, args, arg_len);
+            break;
+        }
+        case OGS_ALOG_TAG_DROP: {
+            uint8_t rec[16];
+
+            if (read_full(fp, rec, sizeof(rec), 0) < 0) goto truncated;
+            print_drop(rec);
+            break;
+        }
+        default:
+            goto corrupt;
+        }
+    }
+    goto out;
+
+truncated:
+    /* The writer was killed mid-batch: everything before is valid */
+    fprintf(stderr, "open5gs-logfmt: %s: truncated record at offset %ld\n",
+            path, ftell(fp));
+    goto out;
+corrupt:
+    fprintf(stderr, "open5gs-logfmt: %s: not an alog file or corrupt at "
+            "offset %ld\n", path, ftell(fp));
+    rc = 2;
+out:
+    strtab_reset(&strs);
+    free(strs.strs);
+    fclose(fp);
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    int i, rc = 0, files = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--level") && i + 1 < argc) {
+            opt_level = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--follow")) {
+            opt_follow = 1;
+        } else if (!strcmp(argv[i], "--stats")) {
+            opt_stats = 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr,
+                "Usage: open5gs-logfmt [--level 1-6] [--follow] [--stats] "
+                "FILE.alog...\n");
+            return 2;
+        } else {
+            int r = format_file(argv[i]);
+            if (r > rc) rc = r;
+            files++;
+        }
+    }
+    if (!files) {
+        fprintf(stderr, "open5gs-logfmt: no input file\n");
+        return 2;
+    }
+    if (opt_stats)
+        printf("starts=%llu records=%llu dropped=%llu\n",
+               n_starts, n_records, n_dropped);
+    fflush(stdout);
+    return rc;
+}
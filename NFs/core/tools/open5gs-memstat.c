@@ -0,0 +1,309 @@
+/*
+ * open5gs-memstat — sample per-NF memory inside a container.
+ *
+ * Every --interval-ms it finds the open5GS daemons (/proc/<pid>/comm is
+ * "open5gs-<nf>d") and writes one JSON line per process with:
+ *
+ *   - /proc/<pid>/smaps_rollup: Rss, Pss, Anonymous, Private_Dirty, Swap
+ *     (kB).  Unlike the container's cgroup usage (docker stats) this is
+ *     per process and has no page cache in it.
+ *   - the process's ogs-memstat page (NFs/core/ogs-memstat.h): glibc heap
+ *     in use, talloc bytes / blocks and the in-use count of every
+ *     ogs_pool, as published by the NF thread itself.
+ *
+ * Pool names are only written when a process's pool set changes (first
+ * sample, then on a new generation), as a line with "pools": the names
+ * and capacities, in the order of the "used" arrays that follow.
+ *
+ *   {"t":1718000000.123,"nf":"amf","pid":42,"pools":[["amf_ue_pool",1024],...]}
+ *   {"t":1718000000.123,"nf":"amf","pid":42,"rss_kb":..,"pss_kb":..,
+ *    "anon_kb":..,"dirty_kb":..,"swap_kb":..,"hook_age_ms":..,"heap_kb":..,
+ *    "mmap_kb":..,"talloc_kb":..,"talloc_blocks":..,"used":[3,0,...]}
+ *
+ * Without a page (an image built before the hook) only the smaps fields
+ * are written.  tests/mem_profile.py fits the per-NF slopes.
+ *
+ * Usage:
+ *   open5gs-memstat [--interval-ms 200] [--seconds 0] [-o FILE] [--once]
+ *
+ * Runs until SIGINT / SIGTERM or --seconds; --once takes one sample.
+ *
+ * Build: gcc -O2 -Wall -I NFs/core -o open5gs-memstat NFs/core/tools/open5gs-memstat.c
+ */
+
+#include "ogs-memstat.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define MAX_PROCS 64
+
+typedef struct {
+    int      pid;
+    char     nf[16];
+    const volatile ogs_memstat_page_t *page;
+    uint32_t generation;        /* pool names written for this generation */
+    int      named;
+    int      seen;
+} proc_t;
+
+static proc_t g_procs[MAX_PROCS];
+static int    g_nprocs = 0;
+static volatile sig_atomic_t g_stop = 0;
+static const char *g_dir = OGS_MEMSTAT_DEFAULT_DIR;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static uint64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* "open5gs-amfd" -> "amf"; 0 if not an open5GS daemon */
+static int nf_name(int pid, char *out, size_t len)
+{
+    char path[64], comm[32];
+    size_t n;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    f = fopen(path, "r");
+    if (!f) return 0;
+    if (!fgets(comm, sizeof(comm), f)) comm[0] = 0;
+    fclose(f);
+    comm[strcspn(comm, "\n")] = 0;
+
+    n = strlen(comm);
+    if (strncmp(comm, "open5gs-", 8) != 0 || n < 10 || comm[n - 1] != 'd')
+        return 0;
+    snprintf(out, len, "%.*s", (int)(n - 9), comm + 8);
+    return 1;
+}
+
+static const volatile ogs_memstat_page_t *page_map(int pid)
+{
+    char path[192];
+    void *p;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/" OGS_MEMSTAT_PREFIX "%d", g_dir, pid);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    p = mmap(NULL, OGS_MEMSTAT_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+static proc_t *proc_get(int pid, const char *nf)
+{
+    int i;
+
+    for (i = 0; i < g_nprocs; i++)
+        if (g_procs[i].pid == pid) return &g_procs[i];
+    if (g_nprocs == MAX_PROCS) return NULL;
+    memset(&g_procs[g_nprocs], 0, sizeof(g_procs[0]));
+    g_procs[g_nprocs].pid = pid;
+    snprintf(g_procs[g_nprocs].nf, sizeof(g_procs[0].nf), "%s", nf);
+    return &g_procs[g_nprocs++];
+}
+
+/* Drop processes that are gone */
+static void proc_sweep(void)
+{
+    int i;
+
+    for (i = g_nprocs - 1; i >= 0; i--) {
+        if (g_procs[i].seen) continue;
+        if (g_procs[i].page)
+            munmap((void *)g_procs[i].page, OGS_MEMSTAT_SIZE);
+        g_procs[i] = g_procs[--g_nprocs];
+    }
+}
+
+static int smaps(int pid, long kb[5])
+{
+    static const char *keys[5] = {
+        "Rss:", "Pss:", "Anonymous:", "Private_Dirty:", "Swap:" };
+    char path[64], line[256];
+    FILE *f;
+    int i;
+
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    f = fopen(path, "r");
+    if (!f) return -1;
+    for (i = 0; i < 5; i++) kb[i] = 0;
+    while (fgets(line, sizeof(line), f)) {
+        for (i = 0; i < 5; i++) {
+            size_t n = strlen(keys[i]);
+            if (strncmp(line, keys[i], n) == 0) {
+                kb[i] = strtol(line + n, NULL, 10);
+                break;
+            }
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static void json_str(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        if ((unsigned char)*s >= 0x20) fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+static void sample(FILE *out)
+{
+    static ogs_memstat_page_t pg;
+    double t = (double)clock_ns(CLOCK_REALTIME) / 1e9;
+    uint64_t mono = clock_ns(CLOCK_MONOTONIC);
+    struct dirent *de;
+    DIR *d;
+    int i;
+
+    for (i = 0; i < g_nprocs; i++) g_procs[i].seen = 0;
+
+    d = opendir("/proc");
+    if (!d) return;
+    while ((de = readdir(d)) != NULL) {
+        char nf[16];
+        long kb[5];
+        proc_t *p;
+        int pid;
+        uint32_t k;
+
+        if (!isdigit((unsigned char)de->d_name[0])) continue;
+        pid = atoi(de->d_name);
+        if (!nf_name(pid, nf, sizeof(nf))) continue;
+        if (smaps(pid, kb) < 0) continue;
+        p = proc_get(pid, nf);
+        if (!p) continue;
+        p->seen = 1;
+        if (!p->page) p->page = page_map(pid);
+
+        if (!p->page || ogs_memstat_page_read(p->page, &pg) < 0) {
+            fprintf(out, "{\"t\":%.3f,\"nf\":\"%s\",\"pid\":%d,\"rss_kb\":%ld,"
+                    "\"pss_kb\":%ld,\"anon_kb\":%ld,\"dirty_kb\":%ld,"
+                    "\"swap_kb\":%ld}\n",
+                    t, p->nf, pid, kb[0], kb[1], kb[2], kb[3], kb[4]);
+            continue;
+        }
+
+        if (!p->named || p->generation != pg.generation) {
+            fprintf(out, "{\"t\":%.3f,\"nf\":\"%s\",\"pid\":%d,\"pools\":[",
+                    t, p->nf, pid);
+            for (k = 0; k < pg.npools && k < OGS_MEMSTAT_MAX_POOLS; k++) {
+                char name[OGS_MEMSTAT_NAME_LEN + 1];
+                memcpy(name, pg.pools[k].name, OGS_MEMSTAT_NAME_LEN);
+                name[OGS_MEMSTAT_NAME_LEN] = 0;
+                fputs(k ? ",[" : "[", out);
+                json_str(out, name);
+                fprintf(out, ",%u]", pg.pools[k].size);
+            }
+            fprintf(out, "],\"pools_dropped\":%u}\n", pg.pools_dropped);
+            p->generation = pg.generation;
+            p->named = 1;
+        }
+
+        fprintf(out, "{\"t\":%.3f,\"nf\":\"%s\",\"pid\":%d,\"rss_kb\":%ld,"
+                "\"pss_kb\":%ld,\"anon_kb\":%ld,\"dirty_kb\":%ld,\"swap_kb\":%ld,"
+                "\"hook_age_ms\":%llu,\"heap_kb\":%llu,\"mmap_kb\":%llu,"
+                "\"talloc_kb\":%llu,\"talloc_blocks\":%llu,\"used\":[",
+                t, p->nf, pid, kb[0], kb[1], kb[2], kb[3], kb[4],
+                (unsigned long long)(mono > pg.published_ns
+                                     ? (mono - pg.published_ns) / 1000000ULL : 0),
+                (unsigned long long)(pg.heap_used / 1024),
+                (unsigned long long)(pg.heap_mmap / 1024),
+                (unsigned long long)(pg.talloc_bytes / 1024),
+                (unsigned long long)pg.talloc_blocks);
+        for (k = 0; k < pg.npools && k < OGS_MEMSTAT_MAX_POOLS; k++)
+            fprintf(out, k ? ",%u" : "%u", pg.pools[k].used);
+        fputs("]}\n", out);
+    }
+    closedir(d);
+    proc_sweep();
+    fflush(out);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [--interval-ms N] [--seconds N] [-o FILE] [--once]\n"
+        "  --interval-ms N   sample period (default: 200)\n"
+        "  --seconds N       stop after N seconds (default: 0 = until signal)\n"
+        "  -o FILE           output (default: stdout)\n"
+        "  --once            one sample, then exit\n"
+        "Env: OGS_MEMSTAT_DIR  page directory (default: %s)\n",
+        prog, OGS_MEMSTAT_DEFAULT_DIR);
+}
+
+int main(int argc, char **argv)
+{
+    long interval_ms = 200;
+    double seconds = 0;
+    int once = 0, i;
+    FILE *out = stdout;
+    uint64_t start, next;
+    const char *env;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--interval-ms") && i + 1 < argc)
+            interval_ms = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            out = fopen(argv[++i], "w");
+            if (!out) { perror(argv[i]); return 2; }
+        } else if (!strcmp(argv[i], "--once"))
+            once = 1;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (interval_ms < 10) interval_ms = 10;
+    env = getenv("OGS_MEMSTAT_DIR");
+    if (env && *env) g_dir = env;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    start = next = clock_ns(CLOCK_MONOTONIC);
+    do {
+        uint64_t now;
+
+        sample(out);
+        if (once) break;
+        next += (uint64_t)interval_ms * 1000000ULL;
+        now = clock_ns(CLOCK_MONOTONIC);
+        if (next > now) {
+            struct timespec ts = { (time_t)((next - now) / 1000000000ULL),
+                                   (long)((next - now) % 1000000000ULL) };
+            nanosleep(&ts, NULL);
+        } else {
+            next = now;                 /* fell behind: don't burst */
+        }
+        if (seconds > 0 && (double)(clock_ns(CLOCK_MONOTONIC) - start) / 1e9 >= seconds)
+            break;
+    } while (!g_stop);
+
+    if (out != stdout) fclose(out);
+    return 0;
+}
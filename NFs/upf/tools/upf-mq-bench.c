@@ -0,0 +1,1033 @@
+/*
+ * upf-mq-bench — offline harness for the multi-queue ogstun datapath.
+ *
+ * Runs the exact worker code of open5gs-upfd (upf-mq-dp.c) without a
+ * control plane, so N3 downlink throughput can be measured per worker
+ * count inside network namespaces (tests/bench_upf_mq.sh).
+ *
+ *   upf  — attach W+1 queues of a multi_queue tun, load the steering
+ *          program, install one fast-path entry per UE, run W workers.
+ *          Each worker sends from its own UDP socket so the gnb side can
+ *          spread the load with SO_REUSEPORT.  Prints one stats line per
+ *          second and a JSON summary on exit.
+ *   gnb  — receive GTP-U on port 2152 (T threads, SO_REUSEPORT), strip
+ *          the header and write the inner packet to a tun, so iperf3
+ *          servers behind it see the UE traffic.
+ *   n3rx — the UPF uplink path (upf-n3.c): receive GTP-U on port 2152
+ *          with recvmmsg (+ UDP GRO), decap fast-path TEIDs into a tun.
+ *          --batch 1 --gro 0 is the upstream one-datagram-per-syscall path.
+ *   pktgen — packet generator.  "gtpu": G-PDUs from UEs to --dst (uplink
+ *          load for n3rx).  "udp": plain UDP to the UE IPs (downlink load,
+ *          routed into the upf tun).  sendmmsg, optional UDP GSO.
+ *   sink — count GTP-U datagrams on port 2152 (downlink end point), or
+ *          plain UDP on --port (uplink end point behind the DN).
+ *   xdp  — the in-kernel path (upf-xdp.c): attach the XDP decap program
+ *          to the N3 interface and the TC encap program to the tun, and
+ *          install one uplink + downlink entry per UE.  Packets that fall
+ *          back (neighbour unresolved, too big) are read off the tun and
+ *          counted.
+ *   pool — the packet pool access pattern of gtp-path.c (2 KB clusters
+ *          and their headers handed out in FIFO ring order, one packet
+ *          copied in and its headers read back) over a pool mapped by
+ *          upf-hugepage.c, with dTLB misses from perf_event_open when the
+ *          CPU exposes them.
+ *
+ * upf, n3rx, sink and xdp print one stats line per second and a JSON
+ * summary including CPU seconds (getrusage) and CPU seconds per Gbit.
+ *
+ * Usage:
+ *   upf-mq-bench upf --tun ogstun --workers 4 --ue 10.206.0.2 --ues 8 \
+ *                    --gnb 10.77.3.2 [--qfi 9] [--cpus 1,2,3,4] \
+ *                    [--batch 32] [--gso 0|1] [--seconds 0]
+ *   upf-mq-bench gnb --tun gnbtun [--threads 4] [--seconds 0]
+ *   upf-mq-bench n3rx --tun ogstun --ue 10.206.0.2 --ues 8 [--teid 0x100] \
+ *                    [--batch 32] [--gro 0|1] [--seconds 0]
+ *   upf-mq-bench pktgen --mode gtpu|udp --dst IP --ue 10.206.0.2 --ues 8 \
+ *                    [--teid 0x100] [--size 1400] [--inner-dst 10.77.6.2] \
+ *                    [--gso 0|1] [--seconds 10]
+ *   upf-mq-bench sink [--port 2152] [--gro 0|1] [--seconds 0]
+ *   upf-mq-bench xdp --n3 IF --tun ogstun --ue 10.206.0.2 --ues 8 \
+ *                    --gnb 10.77.3.2 [--teid 0x100] [--qfi 9] \
+ *                    [--mode generic|native] [--seconds 0]
+ *   upf-mq-bench pool [--mem heap|thp|hugetlb] [--pool-mb 256] [--size 1400] \
+ *                    [--seconds 5]
+ *
+ * Build: gcc -O2 -pthread -I NFs/upf -o upf-mq-bench \
+ *            NFs/upf/tools/upf-mq-bench.c NFs/upf/upf-mq-dp.c NFs/upf/upf-n3.c \
+ *            NFs/upf/upf-xdp.c NFs/upf/upf-hugepage.c
+ */
+
+#define _GNU_SOURCE
+#include "upf-mq-dp.h"
+#include "upf-n3.h"
+#include "upf-xdp.h"
+#include "upf-hugepage.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/if_tun.h>
+#include <linux/perf_event.h>
+
+#define GNB_BATCH   64
+#define GNB_PKT_MAX 2048
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO     104
+#endif
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static double mono_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Process CPU seconds (user + system, all threads) */
+static double cpu_s(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6 +
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6;
+}
+
+/* CPU seconds spent per Gbit moved (lower is better) */
+static double cpu_per_gbit(double cpu, uint64_t bytes)
+{
+    return bytes ? cpu / ((double)bytes * 8 / 1e9) : 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: upf-mq-bench upf --tun IF --workers W --ue IP --ues M --gnb IP\n"
+        "                        [--qfi Q] [--teid T] [--cpus a,b,..]\n"
+        "                        [--batch B] [--gso 0|1] [--seconds S]\n"
+        "       upf-mq-bench gnb --tun IF [--threads T] [--seconds S]\n"
+        "       upf-mq-bench n3rx --tun IF --ue IP --ues M [--teid T]\n"
+        "                        [--batch B] [--gro 0|1] [--seconds S]\n"
+        "       upf-mq-bench pktgen --mode gtpu|udp --dst IP --ue IP --ues M\n"
+        "                        [--teid T] [--size N] [--inner-dst IP]\n"
+        "                        [--gso 0|1] [--seconds S]\n"
+        "       upf-mq-bench sink [--port P] [--gro 0|1] [--seconds S]\n"
+        "       upf-mq-bench xdp --n3 IF --tun IF --ue IP --ues M --gnb IP\n"
+        "                        [--teid T] [--qfi Q] [--mode generic|native]\n"
+        "                        [--seconds S]\n"
+        "       upf-mq-bench pool [--mem heap|thp|hugetlb] [--pool-mb MB]\n"
+        "                        [--size N] [--seconds S]\n");
+}
+
+static int tun_attach(const char *name, int flags)
+{
+    struct ifreq ifr;
+    int fd = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+
+    if (fd < 0) return -1;
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = (short)(IFF_TUN | IFF_NO_PI | flags);
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* UDP socket on port; reads time out after 200 ms so loops see g_stop
+ * (the recvmmsg() timeout only applies once a datagram has arrived) */
+static int udp_bind(uint16_t port, int reuseport)
+{
+    struct sockaddr_in sa;
+    struct timeval tv = { 0, 200 * 1000 };
+    int one = 1, fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (reuseport)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port   = htons(port);
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* =========================================================
+ * upf: multi-queue tun → workers → GTP-U
+ * ========================================================= */
+
+static int run_upf(int argc, char **argv)
+{
+    const char *tun = NULL, *ue = NULL, *gnb = NULL, *cpulist = NULL;
+    int workers = 1, ues = 1, qfi = 9, seconds = 0, batch = 32, gso = 1;
+    uint32_t teid = 0x100;
+    int fds[UPF_MQ_MAX_QUEUES], n3[UPF_MQ_MAX_QUEUES], cpus[UPF_MQ_MAX_QUEUES];
+    upf_mq_stats_t prev[UPF_MQ_MAX_QUEUES];
+    uint8_t drain[GNB_PKT_MAX];
+    uint64_t slow = 0, tot_pkts = 0, tot_bytes = 0, tot_calls = 0;
+    double t0, tlast, c0, secs;
+    int nq, q, i;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--tun") && i + 1 < argc)          tun = argv[++i];
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ue") && i + 1 < argc)      ue = argv[++i];
+        else if (!strcmp(argv[i], "--ues") && i + 1 < argc)     ues = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gnb") && i + 1 < argc)     gnb = argv[++i];
+        else if (!strcmp(argv[i], "--qfi") && i + 1 < argc)     qfi = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--teid") && i + 1 < argc)    teid = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--cpus") && i + 1 < argc)    cpulist = argv[++i];
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--batch") && i + 1 < argc)   batch = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gso") && i + 1 < argc)     gso = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (!tun || !ue || !gnb || workers < 1 || workers >= UPF_MQ_MAX_QUEUES) {
+        usage();
+        return 2;
+    }
+    nq = workers + 1;
+
+    for (q = 0; q < UPF_MQ_MAX_QUEUES; q++) cpus[q] = -1;
+    if (cpulist) {
+        char *dup = strdup(cpulist), *tok, *save = NULL;
+        for (q = 1, tok = strtok_r(dup, ",", &save); tok && q < nq;
+             q++, tok = strtok_r(NULL, ",", &save))
+            cpus[q] = atoi(tok);
+        free(dup);
+    }
+
+    if (upf_mq_dp_tun_open(tun, nq, fds) < 0) {
+        fprintf(stderr, "upf-mq-bench: attach %d queues of %s: %s "
+                "(create it with: ip tuntap add %s mode tun multi_queue)\n",
+                nq, tun, strerror(errno), tun);
+        return 1;
+    }
+    if (upf_mq_dp_steer(fds[0], 4096) < 0) {
+        fprintf(stderr, "upf-mq-bench: steering program: %s\n", strerror(errno));
+        return 1;
+    }
+    for (q = 1; q < nq; q++) {
+        n3[q] = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (n3[q] < 0) { perror("socket"); return 1; }
+    }
+    upf_mq_dp_set_gso(gso);
+    if (upf_mq_dp_start(fds, nq, n3, cpus, batch) < 0) {
+        fprintf(stderr, "upf-mq-bench: workers: %s\n", strerror(errno));
+        return 1;
+    }
+
+    for (i = 0; i < ues; i++) {
+        upf_mq_fp_t e;
+        e.ue_ip   = htonl(ntohl(inet_addr(ue)) + (uint32_t)i);
+        e.teid    = teid + (uint32_t)i;
+        e.peer_ip = inet_addr(gnb);
+        e.qfi     = (uint8_t)qfi;
+        if (upf_mq_dp_set(&e) < 0) {
+            fprintf(stderr, "upf-mq-bench: install UE %d failed\n", i);
+            return 1;
+        }
+    }
+    printf("[upf-mq-bench] %s: %d workers, %d UEs from %s → gNB %s, batch %d%s\n",
+           tun, workers, ues, ue, gnb, batch, gso ? ", GSO" : "");
+    fflush(stdout);
+
+    memset(prev, 0, sizeof(prev));
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    t0 = tlast = mono_s();
+    c0 = cpu_s();
+
+    /* Queue 0 is the slow path in the UPF; here it only counts strays */
+    while (!g_stop) {
+        struct pollfd pfd = { .fd = fds[0], .events = POLLIN };
+        double now;
+
+        if (poll(&pfd, 1, 100) > 0)
+            while (read(fds[0], drain, sizeof(drain)) > 0) slow++;
+
+        now = mono_s();
+        if (now - tlast >= 1.0) {
+            uint64_t pk = 0, by = 0;
+            char per[256];
+            int off = 0;
+
+            for (q = 1; q < nq; q++) {
+                upf_mq_stats_t st;
+                upf_mq_dp_stats(q, &st);
+                pk += st.pkts - prev[q].pkts;
+                by += st.bytes - prev[q].bytes;
+                off += snprintf(per + off, sizeof(per) - (size_t)off, " q%d=%llu",
+                                q, (unsigned long long)(st.pkts - prev[q].pkts));
+                if (off >= (int)sizeof(per)) off = (int)sizeof(per) - 1;
+                prev[q] = st;
+            }
+            printf("[upf-mq-bench] %8.0f pps %7.3f Gbit/s |%s | slow=%llu\n",
+                   (double)pk / (now - tlast), (double)by * 8 / (now - tlast) / 1e9,
+                   per, (unsigned long long)slow);
+            fflush(stdout);
+            tlast = now;
+        }
+        if (seconds > 0 && now - t0 >= seconds) break;
+    }
+
+    secs = mono_s() - t0;
+    printf("{\"workers\":%d,\"ues\":%d,\"batch\":%d,\"gso\":%d,\"seconds\":%.3f,"
+           "\"queues\":[", workers, ues, batch, upf_mq_dp_gso(), secs);
+    for (q = 1; q < nq; q++) {
+        upf_mq_stats_t st;
+        upf_mq_dp_stats(q, &st);
+        tot_pkts += st.pkts;
+        tot_bytes += st.bytes;
+        tot_calls += st.syscalls;
+        printf("%s{\"q\":%d,\"cpu\":%d,\"pkts\":%llu,\"bytes\":%llu,"
+               "\"miss\":%llu,\"drop\":%llu}", q > 1 ? "," : "", q, cpus[q],
+               (unsigned long long)st.pkts, (unsigned long long)st.bytes,
+               (unsigned long long)st.miss, (unsigned long long)st.drop);
+    }
+    printf("],\"pkts\":%llu,\"bytes\":%llu,\"slow\":%llu,\"syscalls\":%llu,"
+           "\"mpps\":%.3f,\"gbps\":%.3f,\"cpu_s\":%.3f,\"cpu_s_per_gbit\":%.3f}\n",
+           (unsigned long long)tot_pkts, (unsigned long long)tot_bytes,
+           (unsigned long long)slow, (unsigned long long)tot_calls,
+           (double)tot_pkts / secs / 1e6, (double)tot_bytes * 8 / secs / 1e9,
+           cpu_s() - c0, cpu_per_gbit(cpu_s() - c0, tot_bytes));
+
+    upf_mq_dp_stop();
+    close(fds[0]);
+    for (q = 1; q < nq; q++) close(n3[q]);
+    return 0;
+}
+
+/* =========================================================
+ * gnb: GTP-U decap → tun
+ * ========================================================= */
+
+static int g_gnb_tun = -1;
+
+/* Length of the GTP-U header at p (G-PDU only), or -1 */
+static int gtpu_hdr_len(const uint8_t *p, int len)
+{
+    int off = 8;
+
+    if (len < 8 || (p[0] >> 5) != 1 || p[1] != 0xff) return -1;
+    if (p[0] & 0x07) {
+        uint8_t next;
+        if (len < 12) return -1;
+        next = (p[0] & 0x04) ? p[11] : 0;
+        off = 12;
+        while (next) {
+            int elen;
+            if (off >= len) return -1;
+            elen = p[off] * 4;
+            if (elen == 0 || off + elen > len) return -1;
+            next = p[off + elen - 1];
+            off += elen;
+        }
+    }
+    return off;
+}
+
+static void *gnb_loop(void *arg)
+{
+    struct mmsghdr msgs[GNB_BATCH];
+    struct iovec iov[GNB_BATCH];
+    uint8_t (*bufs)[GNB_PKT_MAX];
+    int fd, i;
+
+    (void)arg;
+    bufs = malloc(sizeof(*bufs) * GNB_BATCH);
+    fd = udp_bind(UPF_MQ_GTPU_PORT, 1);
+    if (!bufs || fd < 0) {
+        perror("upf-mq-bench gnb: bind 2152");
+        free(bufs);
+        g_stop = 1;
+        return NULL;
+    }
+
+    for (i = 0; i < GNB_BATCH; i++) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len  = GNB_PKT_MAX;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (!g_stop) {
+        int n = recvmmsg(fd, msgs, GNB_BATCH, MSG_WAITFORONE, NULL);
+
+        for (i = 0; i < n; i++) {
+            int len = (int)msgs[i].msg_len;
+            int h = gtpu_hdr_len(bufs[i], len);
+            if (h > 0 && h < len &&
+                write(g_gnb_tun, bufs[i] + h, (size_t)(len - h)) < 0)
+                continue;
+        }
+    }
+    close(fd);
+    free(bufs);
+    return NULL;
+}
+
+static int run_gnb(int argc, char **argv)
+{
+    const char *tun = NULL;
+    int threads = 1, seconds = 0, i;
+    pthread_t th[UPF_MQ_MAX_QUEUES];
+    double t0;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--tun") && i + 1 < argc)          tun = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (!tun || threads < 1 || threads > UPF_MQ_MAX_QUEUES) {
+        usage();
+        return 2;
+    }
+
+    g_gnb_tun = tun_attach(tun, 0);
+    if (g_gnb_tun < 0) {
+        fprintf(stderr, "upf-mq-bench gnb: open %s: %s\n", tun, strerror(errno));
+        return 1;
+    }
+
+    printf("[upf-mq-bench] gnb: GTP-U :%d → %s, %d threads\n",
+           UPF_MQ_GTPU_PORT, tun, threads);
+    fflush(stdout);
+    for (i = 0; i < threads; i++)
+        pthread_create(&th[i], NULL, gnb_loop, NULL);
+
+    t0 = mono_s();
+    while (!g_stop && (seconds <= 0 || mono_s() - t0 < seconds))
+        usleep(100000);
+    g_stop = 1;
+    for (i = 0; i < threads; i++)
+        pthread_join(th[i], NULL);
+    close(g_gnb_tun);
+    return 0;
+}
+
+/* =========================================================
+ * n3rx: GTP-U uplink → upf-n3.c → tun
+ * ========================================================= */
+
+static void n3_slow_count(const uint8_t *pkt, int len,
+                          const struct sockaddr_in *from, void *arg)
+{
+    (void)pkt; (void)len; (void)from; (void)arg;
+}
+
+static int run_n3rx(int argc, char **argv)
+{
+    const char *tun = NULL, *ue = NULL;
+    int ues = 1, batch = 32, gro = 1, seconds = 0, fd, tfd, i;
+    uint32_t teid = 0x100;
+    upf_n3_stats_t st, prev;
+    double t0, tlast, c0, secs;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--tun") && i + 1 < argc)          tun = argv[++i];
+        else if (!strcmp(argv[i], "--ue") && i + 1 < argc)      ue = argv[++i];
+        else if (!strcmp(argv[i], "--ues") && i + 1 < argc)     ues = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--teid") && i + 1 < argc)    teid = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--batch") && i + 1 < argc)   batch = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gro") && i + 1 < argc)     gro = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (!tun || !ue || ues < 1) {
+        usage();
+        return 2;
+    }
+
+    tfd = tun_attach(tun, 0);
+    if (tfd < 0) tfd = tun_attach(tun, IFF_MULTI_QUEUE);
+    fd = udp_bind(UPF_MQ_GTPU_PORT, 0);
+    if (tfd < 0 || fd < 0) {
+        fprintf(stderr, "upf-mq-bench n3rx: %s / bind 2152: %s\n", tun, strerror(errno));
+        return 1;
+    }
+    if (upf_n3_init(ues + 16, batch, gro) < 0 ||
+        (gro && upf_n3_enable_gro(fd) < 0)) {
+        fprintf(stderr, "upf-mq-bench n3rx: init (batch %d, gro %d): %s\n",
+                batch, gro, strerror(errno));
+        return 1;
+    }
+    for (i = 0; i < ues; i++)
+        upf_n3_ul_set(teid + (uint32_t)i, htonl(ntohl(inet_addr(ue)) + (uint32_t)i));
+
+    printf("[upf-mq-bench] n3rx :%d → %s, %d UEs, batch %d%s\n",
+           UPF_MQ_GTPU_PORT, tun, ues, batch, gro ? ", GRO" : "");
+    fflush(stdout);
+
+    memset(&prev, 0, sizeof(prev));
+    t0 = tlast = mono_s();
+    c0 = cpu_s();
+    while (!g_stop) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        double now;
+
+        /* one batch per wakeup, like the UPF's poll callback */
+        if (poll(&pfd, 1, 100) > 0 &&
+            upf_n3_rx(fd, tfd, n3_slow_count, NULL) < 0)
+            break;
+
+        now = mono_s();
+        if (now - tlast >= 1.0) {
+            upf_n3_stats(&st);
+            printf("[upf-mq-bench] %8.0f pps %7.3f Gbit/s | %6.1f pkts/syscall"
+                   " | slow=%llu tun_err=%llu\n",
+                   (double)(st.fast - prev.fast) / (now - tlast),
+                   (double)(st.fast_bytes - prev.fast_bytes) * 8 / (now - tlast) / 1e9,
+                   st.syscalls > prev.syscalls ?
+                       (double)(st.dgrams - prev.dgrams) / (double)(st.syscalls - prev.syscalls) : 0,
+                   (unsigned long long)st.slow, (unsigned long long)st.tun_err);
+            fflush(stdout);
+            prev = st;
+            tlast = now;
+        }
+        if (seconds > 0 && now - t0 >= seconds) break;
+    }
+
+    upf_n3_stats(&st);
+    secs = mono_s() - t0;
+    printf("{\"batch\":%d,\"gro\":%d,\"seconds\":%.3f,\"pkts\":%llu,\"bytes\":%llu,"
+           "\"syscalls\":%llu,\"gro_dgrams\":%llu,\"slow\":%llu,\"tun_err\":%llu,"
+           "\"mpps\":%.3f,\"gbps\":%.3f,\"cpu_s\":%.3f,\"cpu_s_per_gbit\":%.3f}\n",
+           batch, gro, secs, (unsigned long long)st.fast,
+           (unsigned long long)st.fast_bytes, (unsigned long long)st.syscalls,
+           (unsigned long long)st.gro, (unsigned long long)st.slow,
+           (unsigned long long)st.tun_err, (double)st.fast / secs / 1e6,
+           (double)st.fast_bytes * 8 / secs / 1e9, cpu_s() - c0,
+           cpu_per_gbit(cpu_s() - c0, st.fast_bytes));
+    upf_n3_fini();
+    close(fd);
+    close(tfd);
+    return 0;
+}
+
+/* =========================================================
+ * pktgen: GTP-U uplink or plain UDP downlink load
+ * ========================================================= */
+
+static uint16_t ip_csum(const uint8_t *p, int len)
+{
+    uint32_t sum = 0;
+    int i;
+
+    for (i = 0; i + 1 < len; i += 2)
+        sum += (uint32_t)p[i] << 8 | p[i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+/* IPv4/UDP packet of `size` bytes from src to dst port 9 */
+static void build_inner(uint8_t *p, int size, uint32_t src, uint32_t dst)
+{
+    uint16_t c;
+
+    memset(p, 0, (size_t)size);
+    p[0] = 0x45;
+    p[2] = (uint8_t)(size >> 8); p[3] = (uint8_t)size;
+    p[8] = 64; p[9] = IPPROTO_UDP;
+    memcpy(p + 12, &src, 4);
+    memcpy(p + 16, &dst, 4);
+    c = ip_csum(p, 20);
+    p[10] = (uint8_t)(c >> 8); p[11] = (uint8_t)c;
+    p[20] = 0x30; p[21] = 0x39;                 /* sport 12345 */
+    p[23] = 9;                                  /* dport discard */
+    p[24] = (uint8_t)((size - 20) >> 8); p[25] = (uint8_t)(size - 20);
+}
+
+static int run_pktgen(int argc, char **argv)
+{
+    const char *mode = "gtpu", *dst = NULL, *ue = NULL, *inner_dst = "10.77.6.2";
+    int ues = 1, size = 1400, gso = 1, seconds = 10, fd, i, j;
+    int seg, per_msg, nmsg;
+    uint32_t teid = 0x100;
+    uint8_t *buf;
+    struct mmsghdr msgs[GNB_BATCH];
+    struct iovec iov[GNB_BATCH];
+    struct sockaddr_in to[GNB_BATCH];
+    uint8_t ctl[GNB_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+    uint64_t sent_pkts = 0;
+    double t0;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--mode") && i + 1 < argc)         mode = argv[++i];
+        else if (!strcmp(argv[i], "--dst") && i + 1 < argc)     dst = argv[++i];
+        else if (!strcmp(argv[i], "--inner-dst") && i + 1 < argc) inner_dst = argv[++i];
+        else if (!strcmp(argv[i], "--ue") && i + 1 < argc)      ue = argv[++i];
+        else if (!strcmp(argv[i], "--ues") && i + 1 < argc)     ues = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--teid") && i + 1 < argc)    teid = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)    size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gso") && i + 1 < argc)     gso = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (!ue || ues < 1 || size < 64 || size > 1472 ||
+        (strcmp(mode, "gtpu") && strcmp(mode, "udp")) ||
+        (!strcmp(mode, "gtpu") && !dst)) {
+        usage();
+        return 2;
+    }
+
+    /* gtpu: every datagram goes to dst:2152, so any run of them can be one
+     * GSO message.  udp: one message per UE (GSO needs one destination). */
+    seg = !strcmp(mode, "gtpu") ? 16 + size : size - 28;
+    per_msg = gso ? 65000 / seg : 1;
+    if (per_msg > 64) per_msg = 64;
+    nmsg = gso ? 8 : GNB_BATCH;
+
+    buf = malloc((size_t)seg * (size_t)per_msg * (size_t)nmsg);
+    fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (!buf || fd < 0) { perror("pktgen"); return 1; }
+
+    for (i = 0; i < nmsg; i++) {
+        uint32_t u = htonl(ntohl(inet_addr(ue)) + (uint32_t)(i % ues));
+
+        for (j = 0; j < per_msg; j++) {
+            uint8_t *p = buf + ((size_t)i * (size_t)per_msg + (size_t)j) * (size_t)seg;
+
+            if (!strcmp(mode, "gtpu")) {
+                uint32_t t = teid + (uint32_t)((i * per_msg + j) % ues);
+
+                u = htonl(ntohl(inet_addr(ue)) + (t - teid));
+                memset(p, 0, 16);
+                p[0] = 0x34; p[1] = 0xff;           /* G-PDU, E */
+                p[2] = (uint8_t)((size + 8) >> 8); p[3] = (uint8_t)(size + 8);
+                p[4] = (uint8_t)(t >> 24); p[5] = (uint8_t)(t >> 16);
+                p[6] = (uint8_t)(t >> 8);  p[7] = (uint8_t)t;
+                p[11] = 0x85; p[12] = 1;            /* PDU session container */
+                p[13] = 0x10; p[14] = 9;            /* UL PDU SESSION INFO, QFI 9 */
+                build_inner(p + 16, size, u, inet_addr(inner_dst));
+            } else {
+                memset(p, 0xa5, (size_t)seg);
+            }
+        }
+
+        memset(&to[i], 0, sizeof(to[i]));
+        to[i].sin_family = AF_INET;
+        if (!strcmp(mode, "gtpu")) {
+            to[i].sin_port        = htons(UPF_MQ_GTPU_PORT);
+            to[i].sin_addr.s_addr = inet_addr(dst);
+        } else {
+            to[i].sin_port        = htons(9);
+            to[i].sin_addr.s_addr = u;
+        }
+        iov[i].iov_base = buf + (size_t)i * (size_t)per_msg * (size_t)seg;
+        iov[i].iov_len  = (size_t)seg * (size_t)per_msg;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name    = &to[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(to[i]);
+        msgs[i].msg_hdr.msg_iov     = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        if (per_msg > 1) {
+            struct cmsghdr *c;
+            uint16_t g = (uint16_t)seg;
+
+            msgs[i].msg_hdr.msg_control    = ctl[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(ctl[i]);
+            c = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+            c->cmsg_level = IPPROTO_UDP;
+            c->cmsg_type  = UDP_SEGMENT;
+            c->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(c), &g, sizeof(g));
+        }
+    }
+
+    printf("[upf-mq-bench] pktgen %s → %s, %d UEs, %d B, %d pkts/msg\n", mode,
+           dst ? dst : "UE IPs", ues, size, per_msg);
+    fflush(stdout);
+
+    t0 = mono_s();
+    while (!g_stop && (seconds <= 0 || mono_s() - t0 < seconds)) {
+        int n = sendmmsg(fd, msgs, (unsigned int)nmsg, 0);
+        if (n < 0) {
+            if (errno == ENOBUFS || errno == EAGAIN || errno == ECONNREFUSED) continue;
+            perror("pktgen: sendmmsg");
+            break;
+        }
+        sent_pkts += (uint64_t)n * (uint64_t)per_msg;
+    }
+    printf("{\"mode\":\"%s\",\"pkts\":%llu,\"mpps\":%.3f}\n", mode,
+           (unsigned long long)sent_pkts, (double)sent_pkts / (mono_s() - t0) / 1e6);
+    free(buf);
+    close(fd);
+    return 0;
+}
+
+/* =========================================================
+ * sink: count GTP-U downlink (or plain UDP on --port)
+ * ========================================================= */
+
+static int run_sink(int argc, char **argv)
+{
+    int gro = 1, seconds = 0, one = 1, port = UPF_MQ_GTPU_PORT, fd, i;
+    struct mmsghdr msgs[GNB_BATCH];
+    struct iovec iov[GNB_BATCH];
+    union {
+        char           buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctl[GNB_BATCH];
+    uint8_t *bufs;
+    uint64_t pkts = 0, bytes = 0, lpkts = 0, lbytes = 0;
+    double t0, tlast, c0, secs;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--gro") && i + 1 < argc)          gro = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--port") && i + 1 < argc)    port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+
+    fd = udp_bind((uint16_t)port, 0);
+    bufs = malloc((size_t)GNB_BATCH * 65536);
+    if (fd < 0 || !bufs) { perror("upf-mq-bench sink: bind"); return 1; }
+    if (gro) setsockopt(fd, IPPROTO_UDP, UDP_GRO, &one, sizeof(one));
+
+    printf("[upf-mq-bench] sink :%d%s\n", port, gro ? ", GRO" : "");
+    fflush(stdout);
+
+    t0 = tlast = mono_s();
+    c0 = cpu_s();
+    while (!g_stop && (seconds <= 0 || mono_s() - t0 < seconds)) {
+        double now;
+        int n;
+
+        for (i = 0; i < GNB_BATCH; i++) {
+            iov[i].iov_base = bufs + (size_t)i * 65536;
+            iov[i].iov_len  = 65536;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_iov        = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen     = 1;
+            msgs[i].msg_hdr.msg_control    = ctl[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(ctl[i].buf);
+        }
+        n = recvmmsg(fd, msgs, GNB_BATCH, MSG_WAITFORONE, NULL);
+        for (i = 0; i < n; i++) {
+            struct cmsghdr *c;
+            int seg = 0, len = (int)msgs[i].msg_len;
+
+            for (c = CMSG_FIRSTHDR(&msgs[i].msg_hdr); c;
+                 c = CMSG_NXTHDR(&msgs[i].msg_hdr, c))
+                if (c->cmsg_level == IPPROTO_UDP && c->cmsg_type == UDP_GRO)
+                    memcpy(&seg, CMSG_DATA(c), sizeof(seg));
+            pkts += seg > 0 ? (uint64_t)((len + seg - 1) / seg) : 1;
+            bytes += (uint64_t)len;
+        }
+
+        now = mono_s();
+        if (now - tlast >= 1.0) {
+            printf("[upf-mq-bench] sink %8.0f pps %7.3f Gbit/s\n",
+                   (double)(pkts - lpkts) / (now - tlast),
+                   (double)(bytes - lbytes) * 8 / (now - tlast) / 1e9);
+            fflush(stdout);
+            lpkts = pkts; lbytes = bytes;
+            tlast = now;
+        }
+    }
+    secs = mono_s() - t0;
+    printf("{\"pkts\":%llu,\"bytes\":%llu,\"mpps\":%.3f,\"gbps\":%.3f,\"cpu_s\":%.3f}\n",
+           (unsigned long long)pkts, (unsigned long long)bytes,
+           (double)pkts / secs / 1e6, (double)bytes * 8 / secs / 1e9, cpu_s() - c0);
+    free(bufs);
+    close(fd);
+    return 0;
+}
+
+/* =========================================================
+ * xdp: XDP decap on N3 + TC encap on the tun (upf-xdp.c)
+ * ========================================================= */
+
+static int run_xdp(int argc, char **argv)
+{
+    const char *n3 = NULL, *tun = NULL, *ue = NULL, *gnb = NULL, *mode = "generic";
+    int ues = 1, qfi = 9, seconds = 0, tfd, i;
+    uint32_t teid = 0x100;
+    upf_xdp_stats_t st, prev;
+    uint8_t drain[GNB_PKT_MAX];
+    uint64_t fallback = 0;
+    double t0, tlast, c0, secs;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--n3") && i + 1 < argc)           n3 = argv[++i];
+        else if (!strcmp(argv[i], "--tun") && i + 1 < argc)     tun = argv[++i];
+        else if (!strcmp(argv[i], "--ue") && i + 1 < argc)      ue = argv[++i];
+        else if (!strcmp(argv[i], "--ues") && i + 1 < argc)     ues = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--gnb") && i + 1 < argc)     gnb = argv[++i];
+        else if (!strcmp(argv[i], "--teid") && i + 1 < argc)    teid = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--qfi") && i + 1 < argc)     qfi = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--mode") && i + 1 < argc)    mode = argv[++i];
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+    if (!n3 || !tun || !ue || !gnb || ues < 1 ||
+        (strcmp(mode, "generic") && strcmp(mode, "native"))) {
+        usage();
+        return 2;
+    }
+
+    /* keep the tun's carrier up and count what the TC program leaves to it */
+    tfd = tun_attach(tun, 0);
+    if (tfd < 0) tfd = tun_attach(tun, IFF_MULTI_QUEUE);
+    if (tfd < 0) {
+        fprintf(stderr, "upf-mq-bench xdp: %s: %s\n", tun, strerror(errno));
+        return 1;
+    }
+    fcntl(tfd, F_SETFL, O_NONBLOCK);
+
+    if (upf_xdp_start(n3, 0, tun, strcmp(mode, "native") ? UPF_XDP_GENERIC : UPF_XDP_NATIVE,
+                      ues + 16) < 0) {
+        fprintf(stderr, "upf-mq-bench xdp: attach to %s / %s (%s): %s\n",
+                n3, tun, mode, strerror(errno));
+        return 1;
+    }
+    for (i = 0; i < ues; i++) {
+        uint32_t u = htonl(ntohl(inet_addr(ue)) + (uint32_t)i);
+
+        if (upf_xdp_ul_set(teid + (uint32_t)i, u) < 0 ||
+            upf_xdp_dl_set(u, teid + (uint32_t)i, inet_addr(gnb), (uint8_t)qfi) < 0) {
+            fprintf(stderr, "upf-mq-bench xdp: map update: %s\n", strerror(errno));
+            upf_xdp_stop();
+            return 1;
+        }
+    }
+
+    printf("[upf-mq-bench] xdp %s (%s) ↔ %s, %d UEs\n", n3, mode, tun, ues);
+    fflush(stdout);
+
+    memset(&prev, 0, sizeof(prev));
+    t0 = tlast = mono_s();
+    c0 = cpu_s();
+    while (!g_stop) {
+        struct pollfd pfd = { .fd = tfd, .events = POLLIN };
+        double now;
+
+        if (poll(&pfd, 1, 100) > 0)
+            while (read(tfd, drain, sizeof(drain)) > 0) fallback++;
+
+        now = mono_s();
+        if (now - tlast >= 1.0) {
+            upf_xdp_stats(&st);
+            printf("[upf-mq-bench] ul %8.0f pps %7.3f Gbit/s | dl %8.0f pps %7.3f Gbit/s"
+                   " | fallback=%llu\n",
+                   (double)(st.ul_pkts - prev.ul_pkts) / (now - tlast),
+                   (double)(st.ul_bytes - prev.ul_bytes) * 8 / (now - tlast) / 1e9,
+                   (double)(st.dl_pkts - prev.dl_pkts) / (now - tlast),
+                   (double)(st.dl_bytes - prev.dl_bytes) * 8 / (now - tlast) / 1e9,
+                   (unsigned long long)fallback);
+            fflush(stdout);
+            prev = st;
+            tlast = now;
+        }
+        if (seconds > 0 && now - t0 >= seconds) break;
+    }
+
+    upf_xdp_stats(&st);
+    secs = mono_s() - t0;
+    printf("{\"mode\":\"%s\",\"seconds\":%.3f,\"ul_pkts\":%llu,\"ul_bytes\":%llu,"
+           "\"dl_pkts\":%llu,\"dl_bytes\":%llu,\"fallback\":%llu,"
+           "\"ul_mpps\":%.3f,\"dl_mpps\":%.3f,\"cpu_s\":%.3f}\n",
+           mode, secs, (unsigned long long)st.ul_pkts, (unsigned long long)st.ul_bytes,
+           (unsigned long long)st.dl_pkts, (unsigned long long)st.dl_bytes,
+           (unsigned long long)fallback, (double)st.ul_pkts / secs / 1e6,
+           (double)st.dl_pkts / secs / 1e6, cpu_s() - c0);
+    upf_xdp_stop();
+    close(tfd);
+    return 0;
+}
+
+/* =========================================================
+ * pool: packet pool walk over heap / THP / hugetlb memory
+ * ========================================================= */
+
+#define POOL_CLUSTER    2048                    /* ogs_cluster_2048_t */
+#define POOL_HDR        64                      /* ~ ogs_pkbuf_t + ogs_cluster_t */
+
+/* dTLB misses of this thread (user space), or -1 without a PMU */
+static int dtlb_open(int op)
+{
+    struct perf_event_attr pe;
+
+    memset(&pe, 0, sizeof(pe));
+    pe.size           = sizeof(pe);
+    pe.type           = PERF_TYPE_HW_CACHE;
+    pe.config         = PERF_COUNT_HW_CACHE_DTLB | (op << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    pe.exclude_kernel = 1;
+    pe.exclude_hv     = 1;
+    return (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+static uint64_t dtlb_read(int fd)
+{
+    uint64_t v = 0;
+    if (fd < 0 || read(fd, &v, sizeof(v)) != sizeof(v)) return 0;
+    return v;
+}
+
+static int run_pool(int argc, char **argv)
+{
+    const char *mem = "heap";
+    int pool_mb = 256, size = 1400, seconds = 5, kind, i;
+    int fd_ld, fd_st;
+    upf_hugepage_t hp;
+    uint8_t *hdrs, *clusters, src[POOL_CLUSTER];
+    uint32_t *ring, n, head = 0, tail = 0, idx;
+    uint64_t pkts = 0, prev = 0, sum = 0, tlb0, tlb_prev, tlb;
+    double t0, tlast, now, secs;
+    size_t bytes;
+
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--mem") && i + 1 < argc)          mem = argv[++i];
+        else if (!strcmp(argv[i], "--pool-mb") && i + 1 < argc) pool_mb = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)    size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atoi(argv[++i]);
+        else { usage(); return 2; }
+    }
+    kind = upf_hugepage_kind(mem);
+    if (kind < 0 || pool_mb < 1 || size < 64 || size > POOL_CLUSTER || seconds < 1) {
+        usage();
+        return 2;
+    }
+
+    /* headers first, then the clusters, as ogs_pkbuf_pool_create lays
+     * out its pools (and as upf-mq.c moves them) */
+    n = (uint32_t)(((size_t)pool_mb << 20) / (POOL_CLUSTER + POOL_HDR));
+    bytes = (size_t)n * (POOL_CLUSTER + POOL_HDR);
+    ring = malloc((size_t)n * sizeof(*ring));
+    if (!ring || upf_hugepage_alloc(&hp, bytes, kind) < 0) {
+        fprintf(stderr, "upf-mq-bench pool: %d MB: %s\n", pool_mb, strerror(errno));
+        return 1;
+    }
+    hdrs = hp.base;
+    clusters = hdrs + (size_t)n * POOL_HDR;
+    for (idx = 0; idx < n; idx++) ring[idx] = idx;
+    for (i = 0; i < (int)sizeof(src); i++) src[i] = (uint8_t)i;
+
+    printf("[upf-mq-bench] pool %s (asked %s), %u clusters, %d MB, %d B packets\n",
+           upf_hugepage_name(hp.kind), mem, n, pool_mb, size);
+    fflush(stdout);
+
+    fd_ld = dtlb_open(PERF_COUNT_HW_CACHE_OP_READ);
+    fd_st = dtlb_open(PERF_COUNT_HW_CACHE_OP_WRITE);
+    tlb0 = tlb_prev = dtlb_read(fd_ld) + dtlb_read(fd_st);
+
+    t0 = tlast = mono_s();
+    while (!g_stop) {
+        int k;
+
+        for (k = 0; k < 4096; k++) {
+            uint8_t *h, *c;
+
+            /* ogs_pkbuf_alloc: next free cluster + header off the ring */
+            idx = ring[head];
+            head = head + 1 == n ? 0 : head + 1;
+            h = hdrs + (size_t)idx * POOL_HDR;
+            c = clusters + (size_t)idx * POOL_CLUSTER;
+            memcpy(h, &c, sizeof(c));
+            h[8] = 1;
+
+            /* recvfrom() into the cluster, then parse GTP-U + inner IPv4 */
+            memcpy(c, src, (size_t)size);
+            sum += c[0] + c[9] + c[16 + 12] + c[16 + 19];
+
+            /* ogs_pkbuf_free: back to the tail of the ring */
+            h[8] = 0;
+            ring[tail] = idx;
+            tail = tail + 1 == n ? 0 : tail + 1;
+        }
+        pkts += 4096;
+
+        now = mono_s();
+        if (now - tlast >= 1.0) {
+            tlb = dtlb_read(fd_ld) + dtlb_read(fd_st);
+            printf("[upf-mq-bench] pool %8.3f Mpps %7.3f Gbit/s",
+                   (double)(pkts - prev) / (now - tlast) / 1e6,
+                   (double)(pkts - prev) * size * 8 / (now - tlast) / 1e9);
+            if (fd_ld >= 0)
+                printf(" | dTLB %.3f miss/pkt",
+                       (double)(tlb - tlb_prev) / (double)(pkts - prev));
+            printf("\n");
+            fflush(stdout);
+            prev = pkts;
+            tlb_prev = tlb;
+            tlast = now;
+        }
+        if (now - t0 >= seconds) break;
+    }
+
+    secs = mono_s() - t0;
+    tlb = dtlb_read(fd_ld) + dtlb_read(fd_st) - tlb0;
+    printf("{\"mem\":\"%s\",\"asked\":\"%s\",\"pool_mb\":%d,\"seconds\":%.3f,"
+           "\"pkts\":%llu,\"mpps\":%.3f,\"gbps\":%.3f,",
+           upf_hugepage_name(hp.kind), mem, pool_mb, secs, (unsigned long long)pkts,
+           (double)pkts / secs / 1e6, (double)pkts * size * 8 / secs / 1e9);
+    if (fd_ld >= 0)
+        printf("\"dtlb_miss\":%llu,\"dtlb_per_pkt\":%.4f,",
+               (unsigned long long)tlb, pkts ? (double)tlb / (double)pkts : 0);
+    else
+        printf("\"dtlb_miss\":null,\"dtlb_per_pkt\":null,");
+    printf("\"check\":%llu}\n", (unsigned long long)(sum & 0xff));
+
+    if (fd_ld >= 0) close(fd_ld);
+    if (fd_st >= 0) close(fd_st);
+    upf_hugepage_free(&hp);
+    free(ring);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    if (argc >= 2 && !strcmp(argv[1], "upf"))
+        return run_upf(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "gnb"))
+        return run_gnb(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "n3rx"))
+        return run_n3rx(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "pktgen"))
+        return run_pktgen(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "sink"))
+        return run_sink(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "xdp"))
+        return run_xdp(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "pool"))
+        return run_pool(argc - 2, argv + 2);
+    usage();
+    return 2;
+}
@@ -0,0 +1,139 @@
+/*
+ * upf-hugepage.c — packet buffer memory in 2 MB pages
+ *
+ * See upf-hugepage.h.  Plain libc + Linux uapi only, so the same file
+ * builds into open5gs-upfd and into tools/upf-mq-bench.
+ */
+
+#define _GNU_SOURCE
+#include "upf-hugepage.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <linux/memfd.h>
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB    (21 << 26)
+#endif
+#ifndef MFD_HUGE_2MB
+#define MFD_HUGE_2MB    (21 << 26)
+#endif
+
+static size_t round_2m(size_t size)
+{
+    return (size + UPF_HUGEPAGE_SIZE - 1) & ~((size_t)UPF_HUGEPAGE_SIZE - 1);
+}
+
+static void *map_hugetlb(size_t len)
+{
+    void *p = MAP_FAILED;
+    int fd = memfd_create("upf-pkbuf", MFD_CLOEXEC | MFD_HUGETLB | MFD_HUGE_2MB);
+
+    if (fd >= 0) {
+        if (ftruncate(fd, (off_t)len) == 0)
+            p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, 0);
+        close(fd);
+    }
+    if (p == MAP_FAILED)
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB |
+                 MAP_POPULATE, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/* THP set to "never" makes MADV_HUGEPAGE a silent no-op */
+static int thp_usable(void)
+{
+    char buf[128] = "";
+    int fd = open("/sys/kernel/mm/transparent_hugepage/enabled", O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) return 0;
+    if (read(fd, buf, sizeof(buf) - 1) < 0) buf[0] = '\0';
+    close(fd);
+    return strstr(buf, "[never]") == NULL && buf[0] != '\0';
+}
+
+static int map_thp(upf_hugepage_t *hp, size_t len)
+{
+    uintptr_t start;
+    size_t off;
+
+    if (!thp_usable()) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    hp->map_len = len + UPF_HUGEPAGE_SIZE;
+    hp->map = mmap(NULL, hp->map_len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (hp->map == MAP_FAILED) {
+        hp->map = NULL;
+        return -1;
+    }
+    start = ((uintptr_t)hp->map + UPF_HUGEPAGE_SIZE - 1) &
+            ~((uintptr_t)UPF_HUGEPAGE_SIZE - 1);
+    hp->base = (void *)start;
+    if (madvise(hp->base, len, MADV_HUGEPAGE) < 0) {
+        munmap(hp->map, hp->map_len);
+        hp->map = NULL;
+        return -1;
+    }
+    /* one touch per 2 MB faults in a whole huge page */
+    for (off = 0; off < len; off += UPF_HUGEPAGE_SIZE)
+        ((volatile char *)hp->base)[off] = 0;
+    return 0;
+}
+
+int upf_hugepage_alloc(upf_hugepage_t *hp, size_t size, int kind)
+{
+    memset(hp, 0, sizeof(*hp));
+    if (!size) {
+        errno = EINVAL;
+        return -1;
+    }
+    hp->len = round_2m(size);
+
+    if (kind >= UPF_HUGEPAGE_HUGETLB && (hp->base = map_hugetlb(hp->len)))
+        return hp->kind = UPF_HUGEPAGE_HUGETLB;
+    if (kind >= UPF_HUGEPAGE_THP && map_thp(hp, hp->len) == 0)
+        return hp->kind = UPF_HUGEPAGE_THP;
+
+    hp->base = mmap(NULL, hp->len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (hp->base == MAP_FAILED) {
+        hp->base = NULL;
+        return -1;
+    }
+    return hp->kind = UPF_HUGEPAGE_HEAP;
+}
+
+void upf_hugepage_free(upf_hugepage_t *hp)
+{
+    if (hp->map)
+        munmap(hp->map, hp->map_len);
+    else if (hp->base)
+        munmap(hp->base, hp->len);
+    memset(hp, 0, sizeof(*hp));
+}
+
+static const char *const g_names[] = { "heap", "thp", "hugetlb" };
+
+const char *upf_hugepage_name(int kind)
+{
+    if (kind < UPF_HUGEPAGE_HEAP || kind > UPF_HUGEPAGE_HUGETLB) return "none";
+    return g_names[kind];
+}
+
+int upf_hugepage_kind(const char *name)
+{
+    int k;
+
+    for (k = UPF_HUGEPAGE_HEAP; k <= UPF_HUGEPAGE_HUGETLB; k++)
+        if (name && !strcmp(name, g_names[k])) return k;
+    return -1;
+}
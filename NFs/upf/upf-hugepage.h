@@ -0,0 +1,60 @@
+/*
+ * upf-hugepage.h — packet buffer memory in 2 MB pages (no open5GS deps)
+ *
+ * The UPF's packet pool (gtp-path.c packet_pool) is one ring of 2 KB
+ * clusters handed out in FIFO order, so consecutive packets land in
+ * consecutive clusters and a busy UPF walks the whole pool: with 4 KB
+ * pages that is a new dTLB entry every second packet.  Backing the pool
+ * with 2 MB pages covers it with a few dozen entries.
+ *
+ * upf_hugepage_alloc() maps a zeroed, pre-faulted region, trying the
+ * requested backing and falling back to the next one:
+ *
+ *   hugetlb  memfd_create(MFD_HUGETLB | MFD_HUGE_2MB), then an anonymous
+ *            MAP_HUGETLB mapping.  Explicit 2 MB pages reserved on the
+ *            host (vm.nr_hugepages); the reservation is taken at mmap()
+ *            time, so a short pool fails here instead of with SIGBUS later
+ *   thp      anonymous mapping aligned to 2 MB with MADV_HUGEPAGE
+ *            (transparent huge pages, THP "madvise" or "always")
+ *   heap     anonymous mapping with 4 KB pages
+ *
+ * Used by the UPF (upf-mq.c) and by tools/upf-mq-bench.c.
+ */
+
+#ifndef UPF_HUGEPAGE_H
+#define UPF_HUGEPAGE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPF_HUGEPAGE_SIZE   (2u << 20)
+
+#define UPF_HUGEPAGE_HEAP       0
+#define UPF_HUGEPAGE_THP        1
+#define UPF_HUGEPAGE_HUGETLB    2
+
+typedef struct upf_hugepage_s {
+    void   *base;
+    size_t  len;            /* mapped length, a multiple of 2 MB */
+    int     kind;           /* backing actually obtained */
+    void   *map;            /* THP: the unaligned mapping */
+    size_t  map_len;
+} upf_hugepage_t;
+
+/* Map at least `size` bytes, best backing `kind` (falls back towards
+ * heap).  Returns the backing obtained, or -1 with errno. */
+int  upf_hugepage_alloc(upf_hugepage_t *hp, size_t size, int kind);
+void upf_hugepage_free(upf_hugepage_t *hp);
+
+/* "hugetlb" / "thp" / "heap" and back (-1 for anything else) */
+const char *upf_hugepage_name(int kind);
+int  upf_hugepage_kind(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_HUGEPAGE_H */
@@ -0,0 +1,622 @@
+/*
+ * upf-mq-dp.c — multi-queue ogstun downlink datapath
+ *
+ * See upf-mq-dp.h for the design.  Plain libc + Linux uapi only, so the
+ * same file builds into open5gs-upfd and into tools/upf-mq-bench.
+ */
+
+#define _GNU_SOURCE
+#include "upf-mq-dp.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <linux/if_tun.h>
+
+#define MQ_HEADROOM     16              /* GTP-U header incl. PDU session container */
+#define MQ_PKT_MAX      2048            /* tun MTU is 1400-1500; leave slack */
+#define MQ_GSO_SEGS     64              /* UDP_MAX_SEGMENTS on older kernels */
+#define MQ_GSO_BYTES    65000           /* below the 64 KB UDP payload limit */
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT     103             /* linux/udp.h, 4.18+ */
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP         17
+#endif
+
+/* =========================================================
+ * Fast-path table: open addressing, linear probing, rwlock
+ * ========================================================= */
+
+typedef struct fp_slot_s {
+    uint32_t ue_ip;                     /* 0 = empty */
+    uint32_t teid;
+    uint32_t peer_ip;
+    uint8_t  qfi;
+} fp_slot_t;
+
+static fp_slot_t        *g_table = NULL;
+static uint32_t          g_table_mask = 0;
+static int               g_table_count = 0;
+static pthread_rwlock_t  g_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static uint32_t fp_hash(uint32_t ip)
+{
+    ip ^= ip >> 16;
+    ip *= 0x45d9f3bU;
+    ip ^= ip >> 16;
+    return ip;
+}
+
+/* caller holds the lock; returns the slot holding ue_ip or the empty slot
+ * where it would go */
+static uint32_t fp_probe(uint32_t ue_ip)
+{
+    uint32_t i = fp_hash(ue_ip) & g_table_mask;
+
+    while (g_table[i].ue_ip && g_table[i].ue_ip != ue_ip)
+        i = (i + 1) & g_table_mask;
+    return i;
+}
+
+/* caller holds the write lock; backward-shift delete keeps probes short */
+static void fp_erase(uint32_t i)
+{
+    uint32_t j = i;
+
+    for (;;) {
+        uint32_t home;
+
+        j = (j + 1) & g_table_mask;
+        if (!g_table[j].ue_ip) break;
+        home = fp_hash(g_table[j].ue_ip) & g_table_mask;
+        /* move j back to i unless its home lies cyclically in (i, j] */
+        if ((j > i && (home <= i || home > j)) ||
+            (j < i && (home <= i && home > j))) {
+            g_table[i] = g_table[j];
+            i = j;
+        }
+    }
+    memset(&g_table[i], 0, sizeof(g_table[i]));
+}
+
+/* =========================================================
+ * Steering: BPF hash map (UE IP → queue) + socket filter program
+ * ========================================================= */
+
+static int g_map_fd  = -1;
+static int g_prog_fd = -1;
+static int g_nq      = 0;
+
+static long sys_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+#define INSN(CODE, DST, SRC, OFF, IMM) \
+    ((struct bpf_insn){ .code = (CODE), .dst_reg = (DST), .src_reg = (SRC), \
+                        .off = (OFF), .imm = (IMM) })
+
+static int steer_load(void)
+{
+    /* Offsets are from the network header (SKF_NET_OFF), which is where a
+     * routed packet starts on an IFF_NO_PI tun. */
+    struct bpf_insn prog[] = {
+        INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),  /* r6 = skb */
+        INSN(BPF_LD | BPF_ABS | BPF_B, 0, 0, 0, SKF_NET_OFF + 0),       /* r0 = ver/ihl */
+        INSN(BPF_ALU64 | BPF_RSH | BPF_K, BPF_REG_0, 0, 0, 4),
+        INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_0, 0, 10, 4),           /* !IPv4 → q0 */
+        INSN(BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, SKF_NET_OFF + 16),      /* r0 = daddr */
+        INSN(BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_0, -4, 0),
+        INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0),
+        INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -4),
+        INSN(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, g_map_fd),
+        INSN(0, 0, 0, 0, 0),
+        INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem),
+        INSN(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 2, 0),            /* miss → q0 */
+        INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_0, BPF_REG_0, 0, 0),    /* r0 = queue */
+        INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+        INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 0),
+        INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+    };
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+    attr.insns     = (uint64_t)(uintptr_t)prog;
+    attr.insn_cnt  = sizeof(prog) / sizeof(prog[0]);
+    attr.license   = (uint64_t)(uintptr_t)"GPL";
+    return (int)sys_bpf(BPF_PROG_LOAD, &attr);
+}
+
+/* Map keys are the UE IP in host order (what BPF_LD_ABS yields) */
+static int steer_update(uint32_t ue_ip, uint32_t queue)
+{
+    union bpf_attr attr;
+    uint32_t key = ntohl(ue_ip);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = (uint32_t)g_map_fd;
+    attr.key    = (uint64_t)(uintptr_t)&key;
+    attr.value  = (uint64_t)(uintptr_t)&queue;
+    attr.flags  = BPF_ANY;
+    return (int)sys_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+}
+
+static void steer_delete(uint32_t ue_ip)
+{
+    union bpf_attr attr;
+    uint32_t key = ntohl(ue_ip);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = (uint32_t)g_map_fd;
+    attr.key    = (uint64_t)(uintptr_t)&key;
+    sys_bpf(BPF_MAP_DELETE_ELEM, &attr);
+}
+
+int upf_mq_dp_steer(int fd0, int max_entries)
+{
+    union bpf_attr attr;
+    uint32_t slots = 1024;
+
+    if (max_entries <= 0) max_entries = 32768;
+    while (slots < (uint32_t)max_entries * 2) slots <<= 1;
+
+    g_table = calloc(slots, sizeof(*g_table));
+    if (!g_table) return -1;
+    g_table_mask  = slots - 1;
+    g_table_count = 0;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type    = BPF_MAP_TYPE_HASH;
+    attr.key_size    = sizeof(uint32_t);
+    attr.value_size  = sizeof(uint32_t);
+    attr.max_entries = (uint32_t)max_entries;
+    g_map_fd = (int)sys_bpf(BPF_MAP_CREATE, &attr);
+    if (g_map_fd < 0) goto fail;
+
+    g_prog_fd = steer_load();
+    if (g_prog_fd < 0) goto fail;
+
+    if (ioctl(fd0, TUNSETSTEERINGEBPF, &g_prog_fd) < 0) goto fail;
+    return 0;
+
+fail:
+    {
+        int err = errno;
+        if (g_prog_fd >= 0) close(g_prog_fd);
+        if (g_map_fd >= 0) close(g_map_fd);
+        g_prog_fd = g_map_fd = -1;
+        free(g_table);
+        g_table = NULL;
+        errno = err;
+    }
+    return -1;
+}
+
+/* =========================================================
+ * Queues and workers
+ * ========================================================= */
+
+typedef struct mq_worker_s {
+    pthread_t       thread;
+    int             q;
+    int             fd;
+    int             cpu;
+    upf_mq_stats_t  st;
+} mq_worker_t;
+
+static mq_worker_t   g_workers[UPF_MQ_MAX_QUEUES];
+static int           g_nworkers = 0;
+static int           g_n3_fds[UPF_MQ_MAX_QUEUES];
+static int           g_batch = 32;
+static int           g_gso = 0;
+static volatile int  g_running = 0;
+
+int upf_mq_dp_tun_open(const char *ifname, int nq, int *fds)
+{
+    struct ifreq ifr;
+    int q;
+
+    if (nq < 1 || nq > UPF_MQ_MAX_QUEUES) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (q = 0; q < nq; q++) {
+        fds[q] = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+        if (fds[q] < 0) goto fail;
+
+        memset(&ifr, 0, sizeof(ifr));
+        ifr.ifr_flags = IFF_TUN | IFF_NO_PI | IFF_MULTI_QUEUE;
+        strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+        if (ioctl(fds[q], TUNSETIFF, &ifr) < 0) {
+            close(fds[q]);
+            goto fail;
+        }
+    }
+    return 0;
+
+fail:
+    {
+        int err = errno;
+        while (--q >= 0) close(fds[q]);
+        errno = err;
+    }
+    return -1;
+}
+
+/* Build the GTP-U G-PDU header in front of an inner packet of `len`
+ * bytes at hdr + MQ_HEADROOM.  Returns the header length. */
+static int gtpu_header(uint8_t *hdr, const fp_slot_t *e, int len)
+{
+    uint8_t *h;
+    int hlen = e->qfi ? 16 : 8;
+
+    h = hdr + MQ_HEADROOM - hlen;
+    if (e->qfi) {
+        h[0]  = 0x34;                       /* v1, PT, E */
+        h[8]  = 0; h[9] = 0;                /* sequence (unused) */
+        h[10] = 0;                          /* N-PDU */
+        h[11] = 0x85;                       /* PDU Session Container */
+        h[12] = 1;                          /* 4 octets */
+        h[13] = 0x00;                       /* DL PDU SESSION INFORMATION */
+        h[14] = e->qfi & 0x3f;
+        h[15] = 0;                          /* no next extension */
+    } else {
+        h[0]  = 0x30;                       /* v1, PT */
+    }
+    h[1] = 0xff;                            /* G-PDU */
+    h[2] = (uint8_t)((hlen - 8 + len) >> 8);
+    h[3] = (uint8_t)(hlen - 8 + len);
+    h[4] = (uint8_t)(e->teid >> 24);
+    h[5] = (uint8_t)(e->teid >> 16);
+    h[6] = (uint8_t)(e->teid >> 8);
+    h[7] = (uint8_t)e->teid;
+    return hlen;
+}
+
+/* Group consecutive packets to the same gNB with the same size into one
+ * UDP GSO message (the last one of a run may be shorter).  msgs[] is
+ * rebuilt in place over iov[]; gcnt[] / gbytes[] keep per-message
+ * accounting.  Returns the number of messages. */
+static int gso_group(struct mmsghdr *msgs, struct iovec *iov,
+                     struct sockaddr_in *peers, const uint32_t *lens, int n,
+                     uint8_t (*ctl)[CMSG_SPACE(sizeof(uint16_t))],
+                     int *gcnt, uint64_t *gbytes)
+{
+    int m = 0, i = 0;
+
+    while (i < n) {
+        size_t seg = iov[i].iov_len, total = seg;
+        int j = i + 1;
+        struct msghdr *h = &msgs[m].msg_hdr;
+
+        gbytes[m] = lens[i];
+        while (j < n && j - i < MQ_GSO_SEGS &&
+               peers[j].sin_addr.s_addr == peers[i].sin_addr.s_addr &&
+               iov[j - 1].iov_len == seg && iov[j].iov_len <= seg &&
+               total + iov[j].iov_len <= MQ_GSO_BYTES) {
+            total += iov[j].iov_len;
+            gbytes[m] += lens[j];
+            j++;
+        }
+
+        memset(h, 0, sizeof(*h));
+        h->msg_name    = &peers[i];
+        h->msg_namelen = sizeof(peers[i]);
+        h->msg_iov     = &iov[i];
+        h->msg_iovlen  = (size_t)(j - i);
+        if (j - i > 1) {
+            struct cmsghdr *c;
+            uint16_t gso = (uint16_t)seg;
+
+            h->msg_control    = ctl[m];
+            h->msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            c = CMSG_FIRSTHDR(h);
+            c->cmsg_level = SOL_UDP;
+            c->cmsg_type  = UDP_SEGMENT;
+            c->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(c), &gso, sizeof(gso));
+        }
+        gcnt[m] = j - i;
+        m++;
+        i = j;
+    }
+    return m;
+}
+
+static void *worker_loop(void *arg)
+{
+    mq_worker_t *w = arg;
+    uint8_t          (*bufs)[MQ_HEADROOM + MQ_PKT_MAX];
+    uint32_t           lens[UPF_MQ_MAX_BATCH];
+    struct mmsghdr     msgs[UPF_MQ_MAX_BATCH];
+    struct iovec       iov[UPF_MQ_MAX_BATCH];
+    struct sockaddr_in peers[UPF_MQ_MAX_BATCH];
+    uint8_t            ctl[UPF_MQ_MAX_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+    int                gcnt[UPF_MQ_MAX_BATCH];
+    uint64_t           gbytes[UPF_MQ_MAX_BATCH];
+    struct pollfd      pfd;
+
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    bufs = malloc(sizeof(*bufs) * UPF_MQ_MAX_BATCH);
+    if (!bufs) return NULL;
+
+    pfd.fd     = w->fd;
+    pfd.events = POLLIN;
+
+    while (g_running) {
+        int n = 0, m, i, sent, fd, pkts = 0;
+        uint64_t bytes = 0;
+
+        /* 500 ms so the loop notices upf_mq_dp_stop() */
+        if (poll(&pfd, 1, 500) <= 0)
+            continue;
+
+        pthread_rwlock_rdlock(&g_table_lock);
+        while (n < g_batch) {
+            uint8_t *pkt = bufs[n] + MQ_HEADROOM;
+            ssize_t  len = read(w->fd, pkt, MQ_PKT_MAX);
+            uint32_t dst;
+            fp_slot_t *e;
+            int hlen;
+
+            if (len <= 0) break;
+            if (len < 20 || (pkt[0] >> 4) != 4) {
+                __atomic_add_fetch(&w->st.miss, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+            memcpy(&dst, pkt + 16, sizeof(dst));
+            e = &g_table[fp_probe(dst)];
+            if (!e->ue_ip) {
+                __atomic_add_fetch(&w->st.miss, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+
+            hlen = gtpu_header(bufs[n], e, (int)len);
+            iov[n].iov_base = bufs[n] + MQ_HEADROOM - hlen;
+            iov[n].iov_len  = (size_t)(hlen + len);
+            memset(&peers[n], 0, sizeof(peers[n]));
+            peers[n].sin_family      = AF_INET;
+            peers[n].sin_port        = htons(UPF_MQ_GTPU_PORT);
+            peers[n].sin_addr.s_addr = e->peer_ip;
+            lens[n] = (uint32_t)len;
+            n++;
+        }
+        pthread_rwlock_unlock(&g_table_lock);
+
+        if (n == 0) continue;
+
+        fd = __atomic_load_n(&g_n3_fds[w->q], __ATOMIC_RELAXED);
+        if (__atomic_load_n(&g_gso, __ATOMIC_RELAXED)) {
+            m = gso_group(msgs, iov, peers, lens, n, ctl, gcnt, gbytes);
+            sent = sendmmsg(fd, msgs, (unsigned int)m, MSG_DONTWAIT);
+            /* no UDP GSO on this kernel / route: fall back for good */
+            if (sent < 0 && (errno == EIO || errno == EINVAL ||
+                             errno == ENOPROTOOPT) && m < n) {
+                __atomic_store_n(&g_gso, 0, __ATOMIC_RELAXED);
+                __atomic_add_fetch(&w->st.gso_off, 1, __ATOMIC_RELAXED);
+                goto single;
+            }
+        } else {
+single:
+            for (i = 0; i < n; i++) {
+                memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+                msgs[i].msg_hdr.msg_name    = &peers[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+                msgs[i].msg_hdr.msg_iov     = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen  = 1;
+                gcnt[i]   = 1;
+                gbytes[i] = lens[i];
+            }
+            m = n;
+            sent = sendmmsg(fd, msgs, (unsigned int)m, MSG_DONTWAIT);
+        }
+
+        if (sent < 0) sent = 0;
+        for (i = 0; i < sent; i++) {
+            pkts  += gcnt[i];
+            bytes += gbytes[i];
+        }
+        __atomic_add_fetch(&w->st.syscalls, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&w->st.msgs, (uint64_t)sent, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&w->st.pkts, (uint64_t)pkts, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&w->st.bytes, bytes, __ATOMIC_RELAXED);
+        if (pkts < n)
+            __atomic_add_fetch(&w->st.drop, (uint64_t)(n - pkts), __ATOMIC_RELAXED);
+    }
+
+    free(bufs);
+    return NULL;
+}
+
+/* Stop and join the workers started so far; their fds stay open */
+static void workers_join(void)
+{
+    int q;
+
+    g_running = 0;
+    for (q = 1; q <= g_nworkers; q++)
+        pthread_join(g_workers[q].thread, NULL);
+    g_nworkers = 0;
+    g_nq = 0;
+}
+
+/* Close the BPF objects and free the fast-path table */
+static void steer_free(void)
+{
+    if (g_prog_fd >= 0) close(g_prog_fd);
+    if (g_map_fd >= 0) close(g_map_fd);
+    g_prog_fd = g_map_fd = -1;
+
+    pthread_rwlock_wrlock(&g_table_lock);
+    free(g_table);
+    g_table = NULL;
+    g_table_count = 0;
+    pthread_rwlock_unlock(&g_table_lock);
+}
+
+int upf_mq_dp_start(const int *fds, int nq, const int *n3_fds,
+                    const int *cpus, int batch)
+{
+    int q;
+
+    if (!g_table || nq < 2 || nq > UPF_MQ_MAX_QUEUES) {
+        errno = EINVAL;
+        return -1;
+    }
+    g_batch = batch > 0 && batch <= UPF_MQ_MAX_BATCH ? batch : 32;
+    g_nq = nq;
+    g_running = 1;
+
+    for (q = 1; q < nq; q++) {
+        mq_worker_t *w = &g_workers[q];
+
+        memset(w, 0, sizeof(*w));
+        w->q   = q;
+        w->fd  = fds[q];
+        w->cpu = cpus ? cpus[q] : -1;
+        g_n3_fds[q] = n3_fds[q];
+        fcntl(w->fd, F_SETFL, fcntl(w->fd, F_GETFL, 0) | O_NONBLOCK);
+
+        if (pthread_create(&w->thread, NULL, worker_loop, w) != 0) {
+            int err = errno;
+            g_nworkers = q - 1;
+            workers_join();
+            errno = err;
+            return -1;
+        }
+        g_nworkers = q;
+    }
+    return 0;
+}
+
+void upf_mq_dp_stop(void)
+{
+    int q, n = g_nworkers;
+
+    workers_join();
+    for (q = 1; q <= n; q++)
+        close(g_workers[q].fd);
+    steer_free();
+}
+
+void upf_mq_dp_unsteer(int fd0)
+{
+    int none = -1;
+
+    if (g_prog_fd >= 0)
+        ioctl(fd0, TUNSETSTEERINGEBPF, &none);
+    steer_free();
+}
+
+void upf_mq_dp_set_gso(int on)
+{
+    __atomic_store_n(&g_gso, on ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+int upf_mq_dp_gso(void)
+{
+    return __atomic_load_n(&g_gso, __ATOMIC_RELAXED);
+}
+
+void upf_mq_dp_set_n3(int fd)
+{
+    int q;
+
+    for (q = 1; q < UPF_MQ_MAX_QUEUES; q++)
+        __atomic_store_n(&g_n3_fds[q], fd, __ATOMIC_RELAXED);
+}
+
+/* =========================================================
+ * Entries (called from one control thread)
+ * ========================================================= */
+
+int upf_mq_dp_set(const upf_mq_fp_t *e)
+{
+    fp_slot_t *s;
+    uint32_t queue;
+
+    if (!g_table || g_nq < 2 || !e->ue_ip) return -1;
+
+    pthread_rwlock_wrlock(&g_table_lock);
+    s = &g_table[fp_probe(e->ue_ip)];
+    if (!s->ue_ip) {
+        if ((uint32_t)g_table_count * 2 >= g_table_mask + 1) {
+            pthread_rwlock_unlock(&g_table_lock);
+            return -1;
+        }
+        g_table_count++;
+    }
+    s->ue_ip   = e->ue_ip;
+    s->teid    = e->teid;
+    s->peer_ip = e->peer_ip;
+    s->qfi     = e->qfi;
+    pthread_rwlock_unlock(&g_table_lock);
+
+    /* table first, then steer: a worker never sees an unknown UE */
+    queue = 1 + fp_hash(ntohl(e->ue_ip)) % (uint32_t)(g_nq - 1);
+    if (steer_update(e->ue_ip, queue) < 0) {
+        upf_mq_dp_del(e->ue_ip);
+        return -1;
+    }
+    return 0;
+}
+
+void upf_mq_dp_del(uint32_t ue_ip)
+{
+    uint32_t i;
+
+    if (!g_table || !ue_ip) return;
+
+    /* steer back to queue 0 first; in-flight packets on a worker queue
+     * still find the entry or are counted as miss */
+    steer_delete(ue_ip);
+
+    pthread_rwlock_wrlock(&g_table_lock);
+    i = fp_probe(ue_ip);
+    if (g_table[i].ue_ip) {
+        fp_erase(i);
+        g_table_count--;
+    }
+    pthread_rwlock_unlock(&g_table_lock);
+}
+
+int upf_mq_dp_count(void)
+{
+    return g_table_count;
+}
+
+void upf_mq_dp_stats(int q, upf_mq_stats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    if (q < 1 || q > g_nworkers) return;
+    st->pkts  = __atomic_load_n(&g_workers[q].st.pkts,  __ATOMIC_RELAXED);
+    st->bytes = __atomic_load_n(&g_workers[q].st.bytes, __ATOMIC_RELAXED);
+    st->miss  = __atomic_load_n(&g_workers[q].st.miss,  __ATOMIC_RELAXED);
+    st->drop  = __atomic_load_n(&g_workers[q].st.drop,  __ATOMIC_RELAXED);
+    st->syscalls = __atomic_load_n(&g_workers[q].st.syscalls, __ATOMIC_RELAXED);
+    st->msgs     = __atomic_load_n(&g_workers[q].st.msgs,     __ATOMIC_RELAXED);
+    st->gso_off  = __atomic_load_n(&g_workers[q].st.gso_off,  __ATOMIC_RELAXED);
+}
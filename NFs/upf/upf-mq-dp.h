@@ -0,0 +1,107 @@
+/*
+ * upf-mq-dp.h — multi-queue ogstun downlink datapath (no open5GS deps)
+ *
+ * ogstun is opened with IFF_MULTI_QUEUE as N queues.  Queue 0 stays on
+ * the UPF main loop (the upstream slow path).  Queues 1..N-1 each get a
+ * worker thread pinned to a CPU.
+ *
+ * Which queue a downlink packet lands on is decided in the kernel by a
+ * tun steering eBPF program (TUNSETSTEERINGEBPF):
+ *
+ *   IPv4 dst (= UE IP) in steering map  →  queue  1 + hash(UE IP) % (N-1)
+ *   anything else                        →  queue 0 (main loop, full PFCP rules)
+ *
+ * Only UEs with a fast-path entry are in the map, so a worker never sees
+ * a packet it cannot forward: it looks the UE up, prepends the GTP-U
+ * header (with the PDU session container when a QFI is set) and sends a
+ * batch with sendmmsg() on the N3 socket.  With GSO on, consecutive
+ * packets to the same gNB of the same size go out as one UDP GSO message
+ * (UDP_SEGMENT), so a batch of bulk TCP downlink is a few sends, not one
+ * per packet.
+ *
+ * Entries are installed / removed by the caller (upf-mq.c from the N4
+ * handlers, or the bench tool).  Order makes the transition safe:
+ * set() writes the table before the steering map, del() clears the
+ * steering map before the table.
+ *
+ * Used by the UPF (upf-mq.c) and by tools/upf-mq-bench.c.
+ */
+
+#ifndef UPF_MQ_DP_H
+#define UPF_MQ_DP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPF_MQ_MAX_QUEUES   16
+#define UPF_MQ_MAX_BATCH    64
+#define UPF_MQ_GTPU_PORT    2152
+
+typedef struct upf_mq_fp_s {
+    uint32_t ue_ip;         /* network order */
+    uint32_t teid;          /* host order, remote (gNB) TEID */
+    uint32_t peer_ip;       /* network order, gNB N3 address */
+    uint8_t  qfi;           /* 0: no PDU session container */
+} upf_mq_fp_t;
+
+typedef struct upf_mq_stats_s {
+    uint64_t pkts;          /* encapsulated and sent */
+    uint64_t bytes;         /* inner bytes sent */
+    uint64_t miss;          /* steered here but no entry (removed in flight) */
+    uint64_t drop;          /* sendmmsg() short / failed */
+    uint64_t syscalls;      /* sendmmsg() calls */
+    uint64_t msgs;          /* UDP messages sent (GSO message = 1) */
+    uint64_t gso_off;       /* GSO refused by the kernel, fell back */
+} upf_mq_stats_t;
+
+/* Attach `nq` queues of the existing multi_queue tun `ifname`.
+ * fds[0..nq-1] receive the queue fds.  Returns 0, or -1 with errno. */
+int  upf_mq_dp_tun_open(const char *ifname, int nq, int *fds);
+
+/* Load the steering program on fds[0] with a map of `max_entries` UEs.
+ * Returns 0, or -1 with errno (no CAP_BPF, old kernel). */
+int  upf_mq_dp_steer(int fd0, int max_entries);
+
+/* Start workers for fds[1..nq-1].  n3_fds[q] is the UDP socket worker q
+ * sends on (the same fd for every queue is fine).  cpus[q] < 0 leaves
+ * worker q unpinned.  Returns 0, or -1 with errno: no worker is left
+ * running, the fds and the steering program stay with the caller
+ * (upf_mq_dp_unsteer()). */
+int  upf_mq_dp_start(const int *fds, int nq, const int *n3_fds,
+                     const int *cpus, int batch);
+
+/* Stop workers, close fds[1..nq-1], free the table and the BPF objects.
+ * fds[0] belongs to the caller. */
+void upf_mq_dp_stop(void);
+
+/* Undo upf_mq_dp_steer() when the workers never started: detach the
+ * program from fd0, free the table and the BPF objects. */
+void upf_mq_dp_unsteer(int fd0);
+
+/* UDP GSO on downlink egress (default off).  The workers turn it off
+ * for good if the kernel refuses it. */
+void upf_mq_dp_set_gso(int on);
+int  upf_mq_dp_gso(void);
+
+/* Change the N3 socket of every worker (0 ≤ fd).  Safe while running. */
+void upf_mq_dp_set_n3(int fd);
+
+/* Install / replace a fast-path entry.  Returns 0, or -1 if the table
+ * is full or the steering map refused the entry. */
+int  upf_mq_dp_set(const upf_mq_fp_t *e);
+
+/* Remove the entry for `ue_ip` (network order); no-op if absent. */
+void upf_mq_dp_del(uint32_t ue_ip);
+
+/* Live entry count and per-queue counters (q in 1..nq-1). */
+int  upf_mq_dp_count(void);
+void upf_mq_dp_stats(int q, upf_mq_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_MQ_DP_H */
@@ -0,0 +1,698 @@
+/*
+ * Multi-queue ogstun and batched N3 I/O for open5gs-upfd
+ *
+ * Opens ogstun as UPF_TUN_QUEUES queues, keeps queue 0 on the UPF main
+ * loop and hands queues 1..N-1 to the pinned downlink workers of
+ * upf-mq-dp.c.  The N3 GTP-U socket is drained in batches by upf-n3.c.
+ * With UPF_XDP the in-kernel path of upf-xdp.c sits in front of both.
+ * The UPF's packet pool can be moved to 2 MB pages (upf-hugepage.c) and
+ * its occupancy is exported on the metrics port.
+ * Fast-path entries (downlink and uplink) follow the N4 state of each
+ * session.
+ *
+ * See upf-mq.h for the hooks and configuration env vars.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "ogs-app.h"
+#include "context.h"
+#include "upf-mq.h"
+#include "upf-mq-dp.h"
+#include "upf-n3.h"
+#include "upf-xdp.h"
+#include "upf-hugepage.h"
+#include "ogs-metrics.h"
+
+#include <errno.h>
+#include <net/if.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* =========================================================
+ * State
+ * ========================================================= */
+static int      g_env_read = 0;
+static int      g_queues   = 1;        /* 1 → upstream single-queue tun */
+static int      g_batch    = 32;
+static int      g_max_ues  = 32768;
+static int      g_opened   = 0;        /* ogstun already handled */
+static int      g_active   = 0;        /* workers running */
+static int      g_n3_set   = 0;
+static int      g_allow_urr = 0;
+static int      g_fds[UPF_MQ_MAX_QUEUES];
+static int      g_cpus[UPF_MQ_MAX_QUEUES];
+static int      g_tun_fd   = -1;       /* ogstun queue 0: uplink fast-path writes */
+
+/* Batched N3 receive (upf-n3.c) */
+static int      g_n3_batch = 32;       /* <= 1 → upstream recvfrom() path */
+static int      g_n3_gro   = 1;
+static int      g_n3_gso   = 1;
+static int      g_n3_active = 0;
+
+/* The upstream GTP-U poll handlers we wrapped, one per N3 socket */
+#define N3_MAX_HOOKS 4
+typedef struct n3_hook_s {
+    ogs_socket_t        fd;
+    ogs_poll_handler_f  handler;
+    void               *data;
+} n3_hook_t;
+static n3_hook_t g_hooks[N3_MAX_HOOKS];
+static int       g_num_hooks = 0;
+
+/* In-kernel XDP decap / TC encap (upf-xdp.c) */
+static int      g_xdp_mode  = -1;      /* -1 off, UPF_XDP_GENERIC/NATIVE, 2 auto */
+static int      g_xdp_state = 0;       /* 0 not tried yet, 1 attached, -1 failed */
+static char     g_xdp_if[IF_NAMESIZE];
+static char     g_tun_name[IF_NAMESIZE];
+
+/* Packet pool in 2 MB pages (upf-hugepage.c) + occupancy gauges */
+#define POOL_GAUGES 2                   /* pkbuf headers, 2 KB clusters */
+static int      g_hp_kind   = -1;      /* -1 off, else best backing to try */
+static ogs_pkbuf_pool_t *g_pool = NULL;
+static upf_hugepage_t g_hp;
+static void    *g_pool_heap[3];         /* arrays ogs_pool_init() allocated */
+static ogs_timer_t *g_pool_timer = NULL;
+static ogs_metrics_inst_t *g_pool_size[POOL_GAUGES];
+static ogs_metrics_inst_t *g_pool_used[POOL_GAUGES];
+static ogs_metrics_inst_t *g_pool_bytes = NULL;
+
+/* Slow-path datagram being handed to the upstream handler */
+static struct {
+    ogs_socket_t              fd;
+    const uint8_t            *pkt;
+    int                       len;
+    const struct sockaddr_in *from;
+} g_pending = { INVALID_SOCKET, NULL, 0, NULL };
+
+static void read_env(void)
+{
+    const char *env;
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int q;
+
+    if (g_env_read) return;
+    g_env_read = 1;
+    if (ncpu < 1) ncpu = 1;
+
+    env = getenv("UPF_TUN_QUEUES");
+    if (env) g_queues = atoi(env);
+    if (g_queues < 1) g_queues = 1;
+    if (g_queues > UPF_MQ_MAX_QUEUES) g_queues = UPF_MQ_MAX_QUEUES;
+
+    /* default: worker q on CPU q, leaving CPU 0 to the main loop */
+    for (q = 0; q < UPF_MQ_MAX_QUEUES; q++)
+        g_cpus[q] = q % ncpu;
+    env = getenv("UPF_MQ_CPUS");
+    if (env && *env) {
+        char *dup = strdup(env), *tok, *save = NULL;
+        for (q = 1, tok = strtok_r(dup, ",", &save); tok && q < UPF_MQ_MAX_QUEUES;
+             q++, tok = strtok_r(NULL, ",", &save))
+            g_cpus[q] = atoi(tok);
+        free(dup);
+    }
+
+    env = getenv("UPF_MQ_BATCH");
+    if (env) g_batch = atoi(env);
+    if (g_batch < 1 || g_batch > UPF_MQ_MAX_BATCH) g_batch = 32;
+
+    env = getenv("UPF_MQ_MAX_UES");
+    if (env && atoi(env) > 0) g_max_ues = atoi(env);
+
+    env = getenv("UPF_MQ_URR");
+    g_allow_urr = env && atoi(env) == 1;
+
+    env = getenv("UPF_N3_BATCH");
+    if (env) g_n3_batch = atoi(env);
+    if (g_n3_batch > UPF_N3_MAX_BATCH) g_n3_batch = UPF_N3_MAX_BATCH;
+    env = getenv("UPF_N3_GRO");
+    if (env) g_n3_gro = atoi(env) == 1;
+    env = getenv("UPF_N3_GSO");
+    if (env) g_n3_gso = atoi(env) == 1;
+
+    env = getenv("UPF_XDP");
+    if (env && !strcmp(env, "generic"))     g_xdp_mode = UPF_XDP_GENERIC;
+    else if (env && !strcmp(env, "native")) g_xdp_mode = UPF_XDP_NATIVE;
+    else if (env && !strcmp(env, "auto"))   g_xdp_mode = 2;
+    env = getenv("UPF_XDP_IF");
+    if (env) ogs_cpystrn(g_xdp_if, env, sizeof(g_xdp_if));
+
+    env = getenv("UPF_HUGEPAGES");
+    if (env && !strcmp(env, "auto")) g_hp_kind = UPF_HUGEPAGE_HUGETLB;
+    else if (env) g_hp_kind = upf_hugepage_kind(env);
+}
+
+/* =========================================================
+ * XDP / TC fast path (upf-xdp.c)
+ * ========================================================= */
+
+/* Attach once both ogstun and the GTP-U socket exist.  The N3 interface
+ * is UPF_XDP_IF or the one holding the address the socket is bound to. */
+static void xdp_try_start(void)
+{
+    struct sockaddr_in sin;
+    socklen_t len = sizeof(sin);
+    uint32_t n3_ip = 0;
+    const char *n3_if = g_xdp_if[0] ? g_xdp_if : NULL;
+    int rv;
+
+    if (g_xdp_mode < 0 || g_xdp_state != 0 || !g_tun_name[0] ||
+        !ogs_gtp_self()->gtpu_sock)
+        return;
+
+    if (getsockname(ogs_gtp_self()->gtpu_sock->fd,
+                    (struct sockaddr *)&sin, &len) == 0 && sin.sin_family == AF_INET)
+        n3_ip = sin.sin_addr.s_addr;
+    if (!n3_ip && !n3_if) {
+        ogs_warn("[UPF-XDP] GTP-U socket bound to any address — set UPF_XDP_IF");
+        g_xdp_state = -1;
+        return;
+    }
+
+    if (g_xdp_mode == 2) {
+        rv = upf_xdp_start(n3_if, n3_ip, g_tun_name, UPF_XDP_NATIVE, g_max_ues);
+        if (rv < 0) {
+            g_xdp_mode = UPF_XDP_GENERIC;
+            rv = upf_xdp_start(n3_if, n3_ip, g_tun_name, UPF_XDP_GENERIC, g_max_ues);
+        } else {
+            g_xdp_mode = UPF_XDP_NATIVE;
+        }
+    } else {
+        rv = upf_xdp_start(n3_if, n3_ip, g_tun_name, g_xdp_mode, g_max_ues);
+    }
+    if (rv < 0) {
+        ogs_warn("[UPF-XDP] not attached (%s, needs CAP_BPF + CAP_NET_ADMIN) — "
+                 "GTP-U stays in userspace", strerror(errno));
+        g_xdp_state = -1;
+        return;
+    }
+
+    g_xdp_state = 1;
+    ogs_info("[UPF-XDP] %s XDP decap on %s, TC egress encap on %s",
+             g_xdp_mode == UPF_XDP_NATIVE ? "native" : "generic",
+             upf_xdp_n3_if(), g_tun_name);
+}
+
+/* =========================================================
+ * tun open / close (gtp-path.c)
+ * ========================================================= */
+
+ogs_socket_t upf_mq_tun_open(char *ifname, int len, int is_tap)
+{
+    int n3[UPF_MQ_MAX_QUEUES];
+    int q;
+
+    /* Only the first tun device (ogstun) gets queues */
+    if (g_opened || is_tap)
+        return ogs_tun_open(ifname, len, is_tap);
+    g_opened = 1;
+
+    read_env();
+    ogs_cpystrn(g_tun_name, ifname, sizeof(g_tun_name));
+    xdp_try_start();
+    if (g_queues <= 1)
+        return g_tun_fd = ogs_tun_open(ifname, len, is_tap);
+
+    if (upf_mq_dp_tun_open(ifname, g_queues, g_fds) < 0) {
+        ogs_error("[UPF-MQ] attach %d queues of %s failed (%s) — "
+                  "is it a multi_queue tun?", g_queues, ifname, strerror(errno));
+        return INVALID_SOCKET;
+    }
+
+    g_tun_fd = g_fds[0];
+
+    if (upf_mq_dp_steer(g_fds[0], g_max_ues) < 0) {
+        ogs_warn("[UPF-MQ] steering program not loaded (%s, needs CAP_BPF) — "
+                 "running %s on a single queue", strerror(errno), ifname);
+        goto single;
+    }
+
+    for (q = 0; q < UPF_MQ_MAX_QUEUES; q++) n3[q] = -1;
+    upf_mq_dp_set_gso(g_n3_gso);
+    if (upf_mq_dp_start(g_fds, g_queues, n3, g_cpus, g_batch) < 0) {
+        ogs_warn("[UPF-MQ] workers not started (%s) — "
+                 "running %s on a single queue", strerror(errno), ifname);
+        upf_mq_dp_unsteer(g_fds[0]);
+        goto single;
+    }
+
+    g_active = 1;
+    ogs_info("[UPF-MQ] %s: %d queues (queue 0 main loop, %d workers, batch %d%s)",
+             ifname, g_queues, g_queues - 1, g_batch, g_n3_gso ? ", GSO" : "");
+    for (q = 1; q < g_queues; q++)
+        ogs_info("[UPF-MQ]   worker %d on CPU %d", q, g_cpus[q]);
+    return g_fds[0];
+
+single:
+    /* Queue 0 alone: packets are no longer steered to 1..N-1 */
+    for (q = 1; q < g_queues; q++) close(g_fds[q]);
+    g_queues = 1;
+    return g_fds[0];
+}
+
+/* =========================================================
+ * Packet pool (gtp-path.c)
+ * ========================================================= */
+
+/* Point a freshly initialised OGS_POOL at `at`: nothing is allocated yet,
+ * so the free ring is simply rebuilt in array order.  This relies on the
+ * OGS_POOL layout and ogs_pool_init() of the pinned ogs-pool.h (free[] of
+ * element pointers, filled in array order, head = tail = 0), which
+ * Dockerfile.build-all checks before building. */
+#define POOL_BYTES(_p) \
+    ((sizeof(*(_p)->array) * (size_t)(_p)->size + 63) & ~(size_t)63)
+#define POOL_FRESH(_p) \
+    ((_p)->head == 0 && (_p)->tail == 0 && (_p)->avail == (_p)->size)
+#define POOL_MOVE(_p, _at, _old) do { \
+    __typeof__((_p)->array) _a = (void *)(_at); \
+    int _i; \
+    _Static_assert(__builtin_types_compatible_p( \
+            __typeof__((_p)->free), __typeof__((_p)->array) *), \
+            "OGS_POOL free[] is not a ring of element pointers"); \
+    (_old) = (_p)->array; \
+    for (_i = 0; _i < (_p)->size; _i++) (_p)->free[_i] = &_a[_i]; \
+    (_p)->array = _a; \
+} while (0)
+
+static void pool_gauges(void *data)
+{
+    ogs_pkbuf_pool_t *pool = data;
+
+    ogs_metrics_inst_set(g_pool_used[0], pool->pkbuf.size - pool->pkbuf.avail);
+    ogs_metrics_inst_set(g_pool_used[1],
+                         pool->cluster_2048.size - pool->cluster_2048.avail);
+    ogs_timer_start(g_pool_timer, ogs_time_from_sec(1));
+}
+
+static void pool_metrics_open(ogs_pkbuf_pool_t *pool)
+{
+    const char *labels[] = { "pool" };
+    const char *pools[POOL_GAUGES] = { "pkbuf", "cluster_2048" };
+    const char *backing[] = { "backing" };
+    const char *kind = g_hp.base ? upf_hugepage_name(g_hp.kind) : "malloc";
+    ogs_metrics_spec_t *size_spec, *used_spec, *bytes_spec;
+    int i;
+
+    size_spec = ogs_metrics_spec_new(ogs_metrics_self(),
+            OGS_METRICS_METRIC_TYPE_GAUGE, "upf_pkbuf_pool_size",
+            "Packet pool capacity", 0, 1, labels, NULL);
+    used_spec = ogs_metrics_spec_new(ogs_metrics_self(),
+            OGS_METRICS_METRIC_TYPE_GAUGE, "upf_pkbuf_pool_used",
+            "Packet pool entries in use", 0, 1, labels, NULL);
+    bytes_spec = ogs_metrics_spec_new(ogs_metrics_self(),
+            OGS_METRICS_METRIC_TYPE_GAUGE, "upf_pkbuf_pool_bytes",
+            "Packet pool memory by backing (hugetlb, thp, heap, malloc)",
+            0, 1, backing, NULL);
+
+    for (i = 0; i < POOL_GAUGES; i++) {
+        g_pool_size[i] = ogs_metrics_inst_new(size_spec, 1, &pools[i]);
+        g_pool_used[i] = ogs_metrics_inst_new(used_spec, 1, &pools[i]);
+    }
+    g_pool_bytes = ogs_metrics_inst_new(bytes_spec, 1, &kind);
+
+    ogs_metrics_inst_set(g_pool_size[0], pool->pkbuf.size);
+    ogs_metrics_inst_set(g_pool_size[1], pool->cluster_2048.size);
+    ogs_metrics_inst_set(g_pool_bytes, (int)(POOL_BYTES(&pool->pkbuf) +
+            POOL_BYTES(&pool->cluster) + POOL_BYTES(&pool->cluster_2048)));
+
+    g_pool_timer = ogs_timer_add(ogs_app()->timer_mgr, pool_gauges, pool);
+    if (g_pool_timer)
+        ogs_timer_start(g_pool_timer, ogs_time_from_sec(1));
+}
+
+ogs_pkbuf_pool_t *upf_mq_pool_create(ogs_pkbuf_config_t *config)
+{
+    ogs_pkbuf_pool_t *pool = ogs_pkbuf_pool_create(config);
+    size_t hdr, cl, data;
+    uint8_t *at;
+
+    read_env();
+    if (!pool || g_pool) return pool;
+    g_pool = pool;
+
+    /* gtp-path.c only uses 2 KB clusters; move them and the headers
+     * every packet touches */
+    hdr  = POOL_BYTES(&pool->pkbuf);
+    cl   = POOL_BYTES(&pool->cluster);
+    data = POOL_BYTES(&pool->cluster_2048);
+    if (g_hp_kind >= 0 && pool->cluster_2048.size > 0 &&
+        POOL_FRESH(&pool->pkbuf) && POOL_FRESH(&pool->cluster) &&
+        POOL_FRESH(&pool->cluster_2048)) {
+        if (upf_hugepage_alloc(&g_hp, hdr + cl + data, g_hp_kind) < 0) {
+            ogs_warn("[UPF-MEM] packet pool: %zu MB mapping failed (%s) — "
+                     "keeping malloc", (hdr + cl + data) >> 20, strerror(errno));
+        } else {
+            at = g_hp.base;
+            POOL_MOVE(&pool->pkbuf, at, g_pool_heap[0]);
+            POOL_MOVE(&pool->cluster, at + hdr, g_pool_heap[1]);
+            POOL_MOVE(&pool->cluster_2048, at + hdr + cl, g_pool_heap[2]);
+            if (g_hp.kind < g_hp_kind)
+                ogs_warn("[UPF-MEM] no free %s pages — packet pool on %s "
+                         "(reserve vm.nr_hugepages on the host)",
+                         upf_hugepage_name(g_hp_kind), upf_hugepage_name(g_hp.kind));
+            ogs_info("[UPF-MEM] packet pool: %d x 2 KB clusters, %zu MB on %s",
+                     pool->cluster_2048.size, g_hp.len >> 20,
+                     upf_hugepage_name(g_hp.kind));
+        }
+    }
+
+    pool_metrics_open(pool);
+    return pool;
+}
+
+void upf_mq_pool_destroy(ogs_pkbuf_pool_t *pool)
+{
+    int i;
+
+    if (!pool || pool != g_pool) {
+        ogs_pkbuf_pool_destroy(pool);
+        return;
+    }
+
+    if (g_pool_timer) ogs_timer_delete(g_pool_timer);
+    g_pool_timer = NULL;
+    for (i = 0; i < POOL_GAUGES; i++) {
+        if (g_pool_size[i]) ogs_metrics_inst_free(g_pool_size[i]);
+        if (g_pool_used[i]) ogs_metrics_inst_free(g_pool_used[i]);
+        g_pool_size[i] = g_pool_used[i] = NULL;
+    }
+    if (g_pool_bytes) ogs_metrics_inst_free(g_pool_bytes);
+    g_pool_bytes = NULL;
+
+    /* ogs_pool_final() frees the arrays it allocated */
+    if (g_hp.base) {
+        pool->pkbuf.array        = g_pool_heap[0];
+        pool->cluster.array      = g_pool_heap[1];
+        pool->cluster_2048.array = g_pool_heap[2];
+    }
+    ogs_pkbuf_pool_destroy(pool);
+    if (g_hp.base) upf_hugepage_free(&g_hp);
+    g_pool = NULL;
+}
+
+/* =========================================================
+ * Batched N3 receive (gtp-path.c)
+ * ========================================================= */
+
+static short g_when = 0;
+
+/* Not a fast-path G-PDU: run the upstream handler on this one datagram.
+ * Its ogs_recvfrom() call is served from g_pending. */
+static void n3_slow(const uint8_t *pkt, int len,
+                    const struct sockaddr_in *from, void *arg)
+{
+    n3_hook_t *h = arg;
+
+    g_pending.fd   = h->fd;
+    g_pending.pkt  = pkt;
+    g_pending.len  = len;
+    g_pending.from = from;
+    h->handler(g_when, h->fd, h->data);
+    g_pending.pkt  = NULL;
+}
+
+static void n3_recv_cb(short when, ogs_socket_t fd, void *data)
+{
+    g_when = when;
+    if (upf_n3_rx(fd, g_tun_fd, n3_slow, data) < 0)
+        ogs_error("[UPF-N3] recvmmsg() failed (%s)", strerror(errno));
+}
+
+static int is_udp4_socket(ogs_socket_t fd)
+{
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    int type = 0;
+    socklen_t tlen = sizeof(type);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &tlen) < 0 ||
+        type != SOCK_DGRAM)
+        return 0;                                   /* e.g. the tun fd */
+    if (getsockname(fd, (struct sockaddr *)&ss, &len) < 0)
+        return 0;
+    return ss.ss_family == AF_INET;
+}
+
+ogs_poll_t *upf_mq_pollset_add(ogs_pollset_t *pollset, short when,
+        ogs_socket_t fd, ogs_poll_handler_f handler, void *data)
+{
+    n3_hook_t *h;
+
+    read_env();
+    if (g_n3_batch <= 1 || g_num_hooks == N3_MAX_HOOKS ||
+        !(when & OGS_POLLIN) || !is_udp4_socket(fd))
+        return ogs_pollset_add(pollset, when, fd, handler, data);
+
+    if (!g_n3_active) {
+        if (upf_n3_init(g_max_ues, g_n3_batch, g_n3_gro) < 0) {
+            ogs_warn("[UPF-N3] batched receive disabled (out of memory)");
+            g_n3_batch = 1;
+            return ogs_pollset_add(pollset, when, fd, handler, data);
+        }
+        g_n3_active = 1;
+    }
+    if (g_n3_gro && upf_n3_enable_gro(fd) < 0) {
+        ogs_warn("[UPF-N3] UDP_GRO not supported (%s) — batching without GRO",
+                 strerror(errno));
+        g_n3_gro = 0;
+    }
+
+    h = &g_hooks[g_num_hooks++];
+    h->fd      = fd;
+    h->handler = handler;
+    h->data    = data;
+    ogs_info("[UPF-N3] GTP-U fd %d: recvmmsg batch %d%s", fd, g_n3_batch,
+             g_n3_gro ? ", GRO" : "");
+    return ogs_pollset_add(pollset, when, fd, n3_recv_cb, h);
+}
+
+ssize_t upf_mq_recvfrom(ogs_socket_t fd, void *buf, size_t len, int flags,
+        ogs_sockaddr_t *from)
+{
+    size_t n;
+
+    if (!g_pending.pkt || fd != g_pending.fd)
+        return ogs_recvfrom(fd, buf, len, flags, from);
+
+    n = (size_t)g_pending.len < len ? (size_t)g_pending.len : len;
+    memcpy(buf, g_pending.pkt, n);
+    if (from) {
+        memset(from, 0, sizeof(*from));
+        memcpy(&from->sin, g_pending.from, sizeof(from->sin));
+    }
+    g_pending.pkt = NULL;                   /* served once */
+    return (ssize_t)n;
+}
+
+void upf_mq_stop(void)
+{
+    int q;
+
+    g_opened = 0;
+    g_tun_fd = -1;
+
+    if (g_xdp_state == 1) {
+        upf_xdp_stats_t st;
+        upf_xdp_stats(&st);
+        ogs_info("[UPF-XDP] %llu uplink pkts decapsulated (%d TEIDs), "
+                 "%llu downlink pkts encapsulated (%d UEs)",
+                 (unsigned long long)st.ul_pkts, st.ul_entries,
+                 (unsigned long long)st.dl_pkts, st.dl_entries);
+        upf_xdp_stop();
+    }
+    g_xdp_state = 0;
+    g_tun_name[0] = '\0';
+
+    if (g_n3_active) {
+        upf_n3_stats_t st;
+        upf_n3_stats(&st);
+        ogs_info("[UPF-N3] %llu datagrams in %llu recvmmsg (%llu GRO), "
+                 "%llu fast %llu slow, %llu tun errors",
+                 (unsigned long long)st.dgrams, (unsigned long long)st.syscalls,
+                 (unsigned long long)st.gro, (unsigned long long)st.fast,
+                 (unsigned long long)st.slow, (unsigned long long)st.tun_err);
+        upf_n3_fini();
+        g_n3_active = 0;
+        g_num_hooks = 0;
+    }
+
+    if (!g_active) return;
+
+    for (q = 1; q < g_queues; q++) {
+        upf_mq_stats_t st;
+        upf_mq_dp_stats(q, &st);
+        ogs_info("[UPF-MQ] worker %d: %llu pkts %llu bytes in %llu sendmmsg "
+                 "(%llu msgs), %llu miss %llu drop%s",
+                 q, (unsigned long long)st.pkts, (unsigned long long)st.bytes,
+                 (unsigned long long)st.syscalls, (unsigned long long)st.msgs,
+                 (unsigned long long)st.miss, (unsigned long long)st.drop,
+                 st.gso_off ? ", GSO refused by kernel" : "");
+    }
+    upf_mq_dp_stop();
+    g_active = 0;
+    g_n3_set = 0;
+}
+
+/* =========================================================
+ * Session sync (n4-handler.c / context.c)
+ * ========================================================= */
+
+/* URRs that measure something keep the session on the slow path */
+static int urr_blocks(ogs_pfcp_pdr_t *pdr)
+{
+    int i;
+
+    if (g_allow_urr) return 0;
+    for (i = 0; i < pdr->num_of_urr; i++)
+        if (pdr->urr[i]->meas_method) return 1;
+    return 0;
+}
+
+/* The single PDR with source interface src_if, or NULL if there are none
+ * or several (one per QoS flow) */
+static ogs_pfcp_pdr_t *single_pdr(upf_sess_t *sess, int src_if)
+{
+    ogs_pfcp_pdr_t *pdr, *found = NULL;
+
+    ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
+        if (pdr->src_if != src_if) continue;
+        if (found) return NULL;
+        found = pdr;
+    }
+    if (!found || ogs_list_first(&found->rule_list)) return NULL;
+    return found;
+}
+
+/* The downlink PDR of a fast-path session, or NULL */
+static ogs_pfcp_pdr_t *fast_path_dl(upf_sess_t *sess)
+{
+    ogs_pfcp_pdr_t *dl = single_pdr(sess, OGS_PFCP_INTERFACE_CORE);
+    ogs_pfcp_far_t *far;
+
+    if (!dl) return NULL;
+
+    far = dl->far;
+    if (!far || far->apply_action != OGS_PFCP_APPLY_ACTION_FORW ||
+        far->dst_if != OGS_PFCP_INTERFACE_ACCESS ||
+        !far->outer_header_creation.gtpu4)
+        return NULL;
+
+    if (dl->qer && dl->qer->gate_status.dl != OGS_PFCP_GATE_OPEN)
+        return NULL;
+
+    return urr_blocks(dl) ? NULL : dl;
+}
+
+/* The uplink PDR of a fast-path session, or NULL */
+static ogs_pfcp_pdr_t *fast_path_ul(upf_sess_t *sess)
+{
+    ogs_pfcp_pdr_t *ul = single_pdr(sess, OGS_PFCP_INTERFACE_ACCESS);
+    ogs_pfcp_far_t *far;
+
+    if (!ul || !ul->f_teid_len || !ul->outer_header_removal_len)
+        return NULL;
+
+    far = ul->far;
+    if (!far || far->apply_action != OGS_PFCP_APPLY_ACTION_FORW ||
+        far->dst_if != OGS_PFCP_INTERFACE_CORE)
+        return NULL;
+
+    if (ul->qer && ul->qer->gate_status.ul != OGS_PFCP_GATE_OPEN)
+        return NULL;
+
+    return urr_blocks(ul) ? NULL : ul;
+}
+
+static void sync_dl(upf_sess_t *sess)
+{
+    ogs_pfcp_pdr_t *pdr;
+    upf_mq_fp_t e;
+    char buf[OGS_ADDRSTRLEN];
+
+    if (!g_n3_set && ogs_gtp_self()->gtpu_sock) {
+        upf_mq_dp_set_n3(ogs_gtp_self()->gtpu_sock->fd);
+        g_n3_set = 1;
+    }
+
+    pdr = fast_path_dl(sess);
+    if (!pdr || !g_n3_set) {
+        upf_mq_dp_del(sess->ipv4->addr[0]);
+        return;
+    }
+
+    memset(&e, 0, sizeof(e));
+    e.ue_ip   = sess->ipv4->addr[0];
+    e.teid    = pdr->far->outer_header_creation.teid;
+    e.peer_ip = pdr->far->outer_header_creation.addr;
+    e.qfi     = pdr->qer ? pdr->qer->qfi : pdr->qfi;
+
+    if (upf_mq_dp_set(&e) < 0)
+        ogs_warn("[UPF-MQ] fast path full (%d UEs) — %s stays on queue 0",
+                 upf_mq_dp_count(), OGS_INET_NTOP(&e.ue_ip, buf));
+    else
+        ogs_debug("[UPF-MQ] fast path UE %s TEID 0x%x QFI %d",
+                  OGS_INET_NTOP(&e.ue_ip, buf), e.teid, e.qfi);
+}
+
+static void sync_ul(upf_sess_t *sess)
+{
+    ogs_pfcp_pdr_t *pdr = fast_path_ul(sess);
+    char buf[OGS_ADDRSTRLEN];
+
+    if (!pdr) {
+        upf_n3_ul_del(sess->ipv4->addr[0]);
+        return;
+    }
+    if (upf_n3_ul_set(pdr->f_teid.teid, sess->ipv4->addr[0]) < 0)
+        ogs_warn("[UPF-N3] uplink fast path full (%d UEs) — %s stays on the "
+                 "upstream path", upf_n3_ul_count(),
+                 OGS_INET_NTOP(&sess->ipv4->addr[0], buf));
+}
+
+/* Same eligibility as the userspace fast paths; the kernel takes the
+ * packets first, the userspace entries serve whatever it passes on */
+static void sync_xdp(upf_sess_t *sess)
+{
+    uint32_t ue = sess->ipv4->addr[0];
+    ogs_pfcp_pdr_t *pdr;
+    char buf[OGS_ADDRSTRLEN];
+
+    pdr = fast_path_ul(sess);
+    if (!pdr)
+        upf_xdp_ul_del(ue);
+    else if (upf_xdp_ul_set(pdr->f_teid.teid, ue) < 0)
+        ogs_warn("[UPF-XDP] uplink map full — %s stays in userspace",
+                 OGS_INET_NTOP(&ue, buf));
+
+    pdr = fast_path_dl(sess);
+    if (!pdr)
+        upf_xdp_dl_del(ue);
+    else if (upf_xdp_dl_set(ue, pdr->far->outer_header_creation.teid,
+                            pdr->far->outer_header_creation.addr,
+                            pdr->qer ? pdr->qer->qfi : pdr->qfi) < 0)
+        ogs_warn("[UPF-XDP] downlink map full — %s stays in userspace",
+                 OGS_INET_NTOP(&ue, buf));
+}
+
+void upf_mq_sync(upf_sess_t *sess)
+{
+    if (!sess || !sess->ipv4) return;
+    if (g_active) sync_dl(sess);
+    if (g_n3_active) sync_ul(sess);
+    if (g_xdp_state == 0) xdp_try_start();
+    if (g_xdp_state == 1) sync_xdp(sess);
+}
+
+void upf_mq_forget(upf_sess_t *sess)
+{
+    if (!sess || !sess->ipv4) return;
+    if (g_active) upf_mq_dp_del(sess->ipv4->addr[0]);
+    if (g_n3_active) upf_n3_ul_del(sess->ipv4->addr[0]);
+    if (g_xdp_state == 1) {
+        upf_xdp_ul_del(sess->ipv4->addr[0]);
+        upf_xdp_dl_del(sess->ipv4->addr[0]);
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * upf-mq.h — multi-queue ogstun and batched N3 I/O for open5gs-upfd
+ *
+ * Glue between the UPF and the datapaths in upf-mq-dp.c (downlink),
+ * upf-n3.c (uplink) and, optionally, upf-xdp.c (both, in the kernel):
+ *
+ *   gtp-path.c    ogs_tun_open() → upf_mq_tun_open()  (attach N queues,
+ *                 load steering, start workers); upf_gtp_close() calls
+ *                 upf_mq_stop() first.  With UPF_MQ_HOOK_GTP the GTP-U
+ *                 socket's poll handler is wrapped so each wakeup drains
+ *                 a recvmmsg() batch; datagrams the uplink fast path does
+ *                 not take are passed one by one to the upstream handler,
+ *                 whose ogs_recvfrom() then returns the pending datagram.
+ *                 packet_pool is created through upf_mq_pool_create(),
+ *                 which can move it to 2 MB pages and exports its
+ *                 occupancy on the metrics port
+ *   n4-handler.c  every establishment / modification response first runs
+ *                 upf_mq_sync(sess), which installs or removes the UE's
+ *                 fast-path entry from the PDR/FAR/QER state just applied
+ *   context.c     upf_sess_remove() calls upf_mq_forget(sess)
+ *
+ * A session is fast-path eligible when its downlink is one plain forward:
+ * a single CORE-side PDR without SDF filters, FAR FORW to ACCESS with an
+ * IPv4 GTP-U outer header, DL gate open, no volume/time URR.  Everything
+ * else (buffering, dedicated bearers, usage reporting) stays on queue 0
+ * and the unchanged upstream path.  Uplink is the mirror image: a single
+ * ACCESS-side PDR with an F-TEID and outer header removal, FAR FORW to
+ * CORE, UL gate open, no volume/time URR.
+ *
+ * Env (read once, at tun open or N3 socket registration):
+ *   UPF_TUN_QUEUES   total queues incl. queue 0 (default: 1 = upstream)
+ *   UPF_MQ_CPUS      CPU per worker, comma list (default: 1,2,..)
+ *   UPF_MQ_BATCH     packets per read/sendmmsg batch (default: 32, max 64)
+ *   UPF_MQ_MAX_UES   steering map size (default: 32768)
+ *   UPF_MQ_URR       "1": also fast-path sessions with URRs (their DL
+ *                    volume is then not counted) (default: 0)
+ *   UPF_N3_BATCH     datagrams per N3 recvmmsg (default: 32, max 64;
+ *                    0/1 = upstream recvfrom path)
+ *   UPF_N3_GRO       "0": no UDP GRO on the N3 socket (default: 1)
+ *   UPF_N3_GSO       "0": no UDP GSO in the downlink workers (default: 1)
+ *   UPF_XDP          off | generic | native | auto (default: off).  XDP
+ *                    decap on the N3 interface + TC encap on ogstun for
+ *                    fast-path sessions; auto tries native, then generic.
+ *                    Traffic it handles is not seen by the UPF at all
+ *                    (no URR, no metrics)
+ *   UPF_XDP_IF       N3 interface (default: the one holding the GTP-U
+ *                    server address)
+ *   UPF_HUGEPAGES    off | hugetlb | thp | auto (default: off).  Map the
+ *                    packet pool's 2 KB clusters and headers from 2 MB
+ *                    pages, falling back hugetlb → thp → 4 KB pages
+ *                    (auto = hugetlb).  Pool size and occupancy are
+ *                    exported as upf_pkbuf_pool_* gauges either way
+ *
+ * ogstun must exist as a multi_queue device (start-upf.sh does this when
+ * UPF_TUN_QUEUES > 1).  Without CAP_BPF the UPF logs a warning and runs
+ * on a single queue.
+ */
+
+#ifndef UPF_MQ_H
+#define UPF_MQ_H
+
+#include "context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ogs_socket_t upf_mq_tun_open(char *ifname, int len, int is_tap);
+void upf_mq_stop(void);
+
+void upf_mq_sync(upf_sess_t *sess);
+void upf_mq_forget(upf_sess_t *sess);
+
+ogs_poll_t *upf_mq_pollset_add(ogs_pollset_t *pollset, short when,
+        ogs_socket_t fd, ogs_poll_handler_f handler, void *data);
+ssize_t upf_mq_recvfrom(ogs_socket_t fd, void *buf, size_t len, int flags,
+        ogs_sockaddr_t *from);
+
+ogs_pkbuf_pool_t *upf_mq_pool_create(ogs_pkbuf_config_t *config);
+void upf_mq_pool_destroy(ogs_pkbuf_pool_t *pool);
+
+/* gtp-path.c only: batched N3 receive, packet pool placement */
+#ifdef UPF_MQ_HOOK_GTP
+#define ogs_pkbuf_pool_create(_c)   upf_mq_pool_create(_c)
+#define ogs_pkbuf_pool_destroy(_p)  upf_mq_pool_destroy(_p)
+#undef ogs_pollset_add
+#define ogs_pollset_add(_p, _w, _fd, _h, _d) \
+    upf_mq_pollset_add(_p, _w, _fd, _h, _d)
+#undef ogs_recvfrom
+#define ogs_recvfrom(_fd, _b, _l, _f, _from) \
+    upf_mq_recvfrom(_fd, _b, _l, _f, _from)
+#endif
+
+/* n4-handler.c only: hook the two response senders */
+#ifdef UPF_MQ_HOOK_N4
+#define upf_pfcp_send_session_establishment_response(_x, _s, ...) \
+    (upf_mq_sync(_s), \
+     upf_pfcp_send_session_establishment_response(_x, _s, __VA_ARGS__))
+#define upf_pfcp_send_session_modification_response(_x, _s, ...) \
+    (upf_mq_sync(_s), \
+     upf_pfcp_send_session_modification_response(_x, _s, __VA_ARGS__))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_MQ_H */
@@ -0,0 +1,335 @@
+/*
+ * upf-n3.c — batched N3 (GTP-U) receive for the uplink
+ *
+ * See upf-n3.h for the design.  Plain libc + Linux uapi only, so the
+ * same file builds into open5gs-upfd and into tools/upf-mq-bench.
+ */
+
+#define _GNU_SOURCE
+#include "upf-n3.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#ifndef UDP_GRO
+#define UDP_GRO         104             /* linux/udp.h, 5.0+ */
+#endif
+
+#define N3_PKT_MAX      2048
+#define N3_GRO_MAX      65536
+
+/* =========================================================
+ * u32 → u32 map: open addressing, linear probing, key 0 = empty
+ * ========================================================= */
+
+typedef struct n3_map_s {
+    uint32_t *keys;
+    uint32_t *vals;
+    uint32_t  mask;
+    int       count;
+} n3_map_t;
+
+static uint32_t n3_hash(uint32_t k)
+{
+    k ^= k >> 16;
+    k *= 0x45d9f3bU;
+    k ^= k >> 16;
+    return k;
+}
+
+static int map_init(n3_map_t *m, int max_entries)
+{
+    uint32_t slots = 1024;
+
+    while (slots < (uint32_t)max_entries * 2) slots <<= 1;
+    m->keys = calloc(slots, sizeof(uint32_t));
+    m->vals = calloc(slots, sizeof(uint32_t));
+    m->mask = slots - 1;
+    m->count = 0;
+    return m->keys && m->vals ? 0 : -1;
+}
+
+static void map_fini(n3_map_t *m)
+{
+    free(m->keys);
+    free(m->vals);
+    memset(m, 0, sizeof(*m));
+}
+
+static uint32_t map_probe(const n3_map_t *m, uint32_t key)
+{
+    uint32_t i = n3_hash(key) & m->mask;
+
+    while (m->keys[i] && m->keys[i] != key)
+        i = (i + 1) & m->mask;
+    return i;
+}
+
+static uint32_t map_get(const n3_map_t *m, uint32_t key)
+{
+    return m->vals[map_probe(m, key)];      /* 0 when absent */
+}
+
+static int map_put(n3_map_t *m, uint32_t key, uint32_t val)
+{
+    uint32_t i = map_probe(m, key);
+
+    if (!m->keys[i]) {
+        if ((uint32_t)m->count * 2 >= m->mask + 1) return -1;
+        m->count++;
+        m->keys[i] = key;
+    }
+    m->vals[i] = val;
+    return 0;
+}
+
+/* backward-shift delete, same as the downlink table in upf-mq-dp.c */
+static void map_del(n3_map_t *m, uint32_t key)
+{
+    uint32_t i = map_probe(m, key), j = i;
+
+    if (!m->keys[i]) return;
+    for (;;) {
+        uint32_t home;
+
+        j = (j + 1) & m->mask;
+        if (!m->keys[j]) break;
+        home = n3_hash(m->keys[j]) & m->mask;
+        if ((j > i && (home <= i || home > j)) ||
+            (j < i && (home <= i && home > j))) {
+            m->keys[i] = m->keys[j];
+            m->vals[i] = m->vals[j];
+            i = j;
+        }
+    }
+    m->keys[i] = m->vals[i] = 0;
+    m->count--;
+}
+
+/* =========================================================
+ * State
+ * ========================================================= */
+
+static n3_map_t         g_by_teid;          /* TEID → UE IP */
+static n3_map_t         g_by_ue;            /* UE IP → TEID */
+static int              g_batch = 0;
+static int              g_gro = 0;
+static size_t           g_buf_len = 0;
+static uint8_t         *g_bufs = NULL;
+static upf_n3_stats_t   g_st;
+
+int upf_n3_init(int max_entries, int batch, int gro)
+{
+    if (g_bufs) return 0;
+    if (max_entries <= 0) max_entries = 32768;
+    if (batch < 1 || batch > UPF_N3_MAX_BATCH) batch = 32;
+
+    if (map_init(&g_by_teid, max_entries) < 0 ||
+        map_init(&g_by_ue, max_entries) < 0)
+        goto fail;
+
+    g_batch   = batch;
+    g_gro     = gro;
+    g_buf_len = gro ? N3_GRO_MAX : N3_PKT_MAX;
+    g_bufs    = malloc(g_buf_len * (size_t)batch);
+    if (!g_bufs) goto fail;
+
+    memset(&g_st, 0, sizeof(g_st));
+    return 0;
+
+fail:
+    upf_n3_fini();
+    return -1;
+}
+
+void upf_n3_fini(void)
+{
+    map_fini(&g_by_teid);
+    map_fini(&g_by_ue);
+    free(g_bufs);
+    g_bufs = NULL;
+    g_batch = 0;
+}
+
+int upf_n3_enable_gro(int fd)
+{
+    int one = 1;
+
+    if (!g_gro) {
+        errno = EINVAL;
+        return -1;
+    }
+    return setsockopt(fd, IPPROTO_UDP, UDP_GRO, &one, sizeof(one));
+}
+
+/* =========================================================
+ * Entries
+ * ========================================================= */
+
+int upf_n3_ul_set(uint32_t teid, uint32_t ue_ip)
+{
+    uint32_t old;
+
+    if (!g_bufs || !teid || !ue_ip) return -1;
+
+    old = map_get(&g_by_ue, ue_ip);
+    if (old == teid) return 0;
+    if (old) map_del(&g_by_teid, old);
+
+    if (map_put(&g_by_teid, teid, ue_ip) < 0) {
+        map_del(&g_by_ue, ue_ip);
+        return -1;
+    }
+    if (map_put(&g_by_ue, ue_ip, teid) < 0) {
+        map_del(&g_by_teid, teid);
+        return -1;
+    }
+    return 0;
+}
+
+void upf_n3_ul_del(uint32_t ue_ip)
+{
+    uint32_t teid;
+
+    if (!g_bufs || !ue_ip) return;
+    teid = map_get(&g_by_ue, ue_ip);
+    if (!teid) return;
+    map_del(&g_by_teid, teid);
+    map_del(&g_by_ue, ue_ip);
+}
+
+int upf_n3_ul_count(void)
+{
+    return g_by_ue.count;
+}
+
+/* =========================================================
+ * Receive
+ * ========================================================= */
+
+/* Offset of the inner packet of a G-PDU, or -1 for anything else */
+static int gtpu_inner(const uint8_t *p, int len)
+{
+    int off = 8;
+
+    if (len < 8 || (p[0] & 0xf0) != 0x30 || p[1] != 0xff) return -1;
+    if (p[0] & 0x07) {
+        uint8_t next;
+
+        if (len < 12) return -1;
+        next = (p[0] & 0x04) ? p[11] : 0;
+        off = 12;
+        while (next) {
+            int elen;
+
+            if (off >= len) return -1;
+            elen = p[off] * 4;
+            if (elen == 0 || off + elen > len) return -1;
+            next = p[off + elen - 1];
+            off += elen;
+        }
+    }
+    return off;
+}
+
+/* One datagram (or GRO segment): fast path, else slow */
+static void n3_one(const uint8_t *p, int len, const struct sockaddr_in *from,
+                   int tun_fd, upf_n3_slow_f slow, void *arg)
+{
+    uint32_t teid, ue, src;
+    int off;
+
+    g_st.dgrams++;
+
+    if (tun_fd < 0 || (off = gtpu_inner(p, len)) < 0 || len - off < 20 ||
+        (p[off] >> 4) != 4)
+        goto slow;
+
+    teid = (uint32_t)p[4] << 24 | (uint32_t)p[5] << 16 |
+           (uint32_t)p[6] << 8 | p[7];
+    ue = map_get(&g_by_teid, teid);
+    memcpy(&src, p + off + 12, sizeof(src));
+    if (!ue || ue != src)
+        goto slow;
+
+    if (write(tun_fd, p + off, (size_t)(len - off)) < 0) {
+        g_st.tun_err++;
+        return;
+    }
+    g_st.fast++;
+    g_st.fast_bytes += (uint64_t)(len - off);
+    return;
+
+slow:
+    g_st.slow++;
+    if (slow) slow(p, len, from, arg);
+}
+
+int upf_n3_rx(int fd, int tun_fd, upf_n3_slow_f slow, void *arg)
+{
+    struct mmsghdr     msgs[UPF_N3_MAX_BATCH];
+    struct iovec       iov[UPF_N3_MAX_BATCH];
+    struct sockaddr_in from[UPF_N3_MAX_BATCH];
+    union {
+        char           buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctl[UPF_N3_MAX_BATCH];
+    int n, i;
+
+    if (!g_bufs) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (i = 0; i < g_batch; i++) {
+        iov[i].iov_base = g_bufs + (size_t)i * g_buf_len;
+        iov[i].iov_len  = g_buf_len;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name    = &from[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+        msgs[i].msg_hdr.msg_iov     = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+        if (g_gro) {
+            msgs[i].msg_hdr.msg_control    = ctl[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(ctl[i].buf);
+        }
+    }
+
+    n = recvmmsg(fd, msgs, (unsigned int)g_batch, MSG_DONTWAIT, NULL);
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+    if (n > 0) g_st.syscalls++;
+
+    for (i = 0; i < n; i++) {
+        const uint8_t *p = iov[i].iov_base;
+        int len = (int)msgs[i].msg_len;
+        int seg = 0, off;
+        struct cmsghdr *c;
+
+        if (g_gro)
+            for (c = CMSG_FIRSTHDR(&msgs[i].msg_hdr); c;
+                 c = CMSG_NXTHDR(&msgs[i].msg_hdr, c))
+                if (c->cmsg_level == IPPROTO_UDP && c->cmsg_type == UDP_GRO)
+                    memcpy(&seg, CMSG_DATA(c), sizeof(seg));
+
+        if (seg <= 0 || seg >= len) {
+            n3_one(p, len, &from[i], tun_fd, slow, arg);
+            continue;
+        }
+        g_st.gro++;
+        for (off = 0; off < len; off += seg)
+            n3_one(p + off, len - off < seg ? len - off : seg, &from[i],
+                   tun_fd, slow, arg);
+    }
+    return n;
+}
+
+void upf_n3_stats(upf_n3_stats_t *st)
+{
+    *st = g_st;
+}
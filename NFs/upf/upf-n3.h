@@ -0,0 +1,73 @@
+/*
+ * upf-n3.h — batched N3 (GTP-U) receive for the uplink (no open5GS deps)
+ *
+ * Upstream reads one GTP-U datagram per poll wakeup.  upf_n3_rx() instead
+ * drains up to `batch` datagrams with one recvmmsg(), with UDP GRO on the
+ * socket so a burst from the gNB arrives as a few coalesced super-datagrams
+ * that are split back into segments here.
+ *
+ * For each G-PDU whose TEID has an uplink fast-path entry, and whose inner
+ * IPv4 source is that UE, the GTP-U header is stripped and the inner
+ * packet is written to ogstun straight from the receive buffer.  Everything
+ * else (echo, error indication, end marker, unknown TEID, URR sessions)
+ * is handed to the `slow` callback, which feeds it to the upstream
+ * handler unchanged.
+ *
+ * Single-threaded: the UPF calls it from its main loop, which is also
+ * where N4 installs and removes entries.
+ *
+ * Used by the UPF (upf-mq.c) and by tools/upf-mq-bench.c.
+ */
+
+#ifndef UPF_N3_H
+#define UPF_N3_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPF_N3_MAX_BATCH    64
+
+typedef void (*upf_n3_slow_f)(const uint8_t *pkt, int len,
+                              const struct sockaddr_in *from, void *arg);
+
+typedef struct upf_n3_stats_s {
+    uint64_t syscalls;      /* recvmmsg() calls that returned data */
+    uint64_t dgrams;        /* datagrams incl. GRO-split segments */
+    uint64_t gro;           /* coalesced super-datagrams received */
+    uint64_t fast;          /* decapsulated and written to the tun */
+    uint64_t fast_bytes;    /* inner bytes written */
+    uint64_t slow;          /* handed to the slow callback */
+    uint64_t tun_err;       /* tun write() failed */
+} upf_n3_stats_t;
+
+/* Allocate the TEID table (`max_entries` UEs) and `batch` receive
+ * buffers, 64 KB each with GRO, 2 KB without.  Returns 0 or -1. */
+int  upf_n3_init(int max_entries, int batch, int gro);
+void upf_n3_fini(void);
+
+/* Turn on UDP_GRO on `fd` (only after upf_n3_init with gro).  Returns 0,
+ * or -1 with errno if the kernel does not support it. */
+int  upf_n3_enable_gro(int fd);
+
+/* Install / replace the uplink entry TEID → UE IP (network order).
+ * One TEID per UE: a new TEID for the same UE replaces the old one. */
+int  upf_n3_ul_set(uint32_t teid, uint32_t ue_ip);
+void upf_n3_ul_del(uint32_t ue_ip);
+int  upf_n3_ul_count(void);
+
+/* Drain one batch from `fd`.  Fast-path packets go to `tun_fd` (< 0: no
+ * fast path), the rest to slow(arg).  Returns datagrams handled, 0 if
+ * nothing was pending, -1 on a socket error. */
+int  upf_n3_rx(int fd, int tun_fd, upf_n3_slow_f slow, void *arg);
+
+void upf_n3_stats(upf_n3_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_N3_H */
@@ -0,0 +1,785 @@
+/*
+ * upf-xdp.c — in-kernel GTP-U fast path: XDP decap + TC encap
+ *
+ * See upf-xdp.h for the design.  Plain libc + Linux uapi only, so the
+ * same file builds into open5gs-upfd and into tools/upf-mq-bench.
+ */
+
+#define _GNU_SOURCE
+#include "upf-xdp.h"
+
+#include <errno.h>
+#include <ifaddrs.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/pkt_cls.h>
+#include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
+
+#define XDP_GTPU_PORT   2152
+#define XDP_ENCAP_LEN   44              /* IPv4 20 + UDP 8 + GTP-U 16 */
+#define XDP_HDR_LEN     (ETH_HLEN + XDP_ENCAP_LEN)
+
+/* Map values.  Counters are 8-byte aligned for BPF_XADD. */
+typedef struct ul_val_s {
+    uint32_t ue_ip;
+    uint32_t pad;
+    uint64_t pkts;
+    uint64_t bytes;
+} ul_val_t;
+
+typedef struct dl_val_s {
+    uint32_t teid;                      /* network order, as on the wire */
+    uint32_t peer_ip;
+    uint8_t  qfi;
+    uint8_t  pad[7];
+    uint64_t pkts;
+    uint64_t bytes;
+} dl_val_t;
+
+static int      g_ul_fd    = -1;        /* TEID (network order) → ul_val_t */
+static int      g_ue_fd    = -1;        /* UE IP → TEID, userspace bookkeeping */
+static int      g_dl_fd    = -1;        /* UE IP → dl_val_t */
+static int      g_xdp_fd   = -1;
+static int      g_tc_fd    = -1;
+static int      g_n3_ifindex  = 0;
+static int      g_tun_ifindex = 0;
+static uint32_t g_xdp_flags = 0;
+static char     g_n3_name[IF_NAMESIZE];
+
+/* =========================================================
+ * bpf(2)
+ * ========================================================= */
+
+static long sys_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static int map_create(uint32_t key_size, uint32_t value_size, int max_entries)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type    = BPF_MAP_TYPE_HASH;
+    attr.key_size    = key_size;
+    attr.value_size  = value_size;
+    attr.max_entries = (uint32_t)max_entries;
+    return (int)sys_bpf(BPF_MAP_CREATE, &attr);
+}
+
+static int map_op(int cmd, int fd, const void *key, void *value, uint64_t flags)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = (uint32_t)fd;
+    attr.key    = (uint64_t)(uintptr_t)key;
+    attr.value  = (uint64_t)(uintptr_t)value;   /* next_key for GET_NEXT_KEY */
+    attr.flags  = flags;
+    return (int)sys_bpf(cmd, &attr);
+}
+
+/* =========================================================
+ * Assembler: the steering program in upf-mq-dp.c is short enough to
+ * count jump offsets by hand; these two use labels.
+ * ========================================================= */
+
+#define INSN(CODE, DST, SRC, OFF, IMM) \
+    ((struct bpf_insn){ .code = (CODE), .dst_reg = (DST), .src_reg = (SRC), \
+                        .off = (int16_t)(OFF), .imm = (IMM) })
+
+#define MOV_R(D, S)         INSN(BPF_ALU64 | BPF_MOV | BPF_X, D, S, 0, 0)
+#define MOV_K(D, K)         INSN(BPF_ALU64 | BPF_MOV | BPF_K, D, 0, 0, K)
+#define ADD_R(D, S)         INSN(BPF_ALU64 | BPF_ADD | BPF_X, D, S, 0, 0)
+#define ALU_K(OP, D, K)     INSN(BPF_ALU64 | (OP) | BPF_K, D, 0, 0, K)
+#define TO_BE16(D)          INSN(BPF_ALU | BPF_END | BPF_TO_BE, D, 0, 0, 16)
+#define LDX(SZ, D, S, OFF)  INSN(BPF_LDX | BPF_MEM | (SZ), D, S, OFF, 0)
+#define STX(SZ, D, S, OFF)  INSN(BPF_STX | BPF_MEM | (SZ), D, S, OFF, 0)
+#define ST(SZ, D, OFF, K)   INSN(BPF_ST | BPF_MEM | (SZ), D, 0, OFF, K)
+#define XADD(D, S, OFF)     INSN(BPF_STX | BPF_XADD | BPF_DW, D, S, OFF, 0)
+#define JMP_K(OP, D, K)     INSN(BPF_JMP | (OP) | BPF_K, D, 0, 0, K)
+#define JMP_R(OP, D, S)     INSN(BPF_JMP | (OP) | BPF_X, D, S, 0, 0)
+#define CALL(FN)            INSN(BPF_JMP | BPF_CALL, 0, 0, 0, FN)
+#define EXIT()              INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+
+#define ASM_MAX     256
+#define ASM_FIXUPS  64
+
+enum { L_PASS, L_INNER, L_SHOT, L_MAX };
+
+typedef struct asm_s {
+    struct bpf_insn insn[ASM_MAX];
+    int n;
+    int label[L_MAX];
+    struct { int at, label; } fix[ASM_FIXUPS];
+    int nfix;
+} asm_t;
+
+static void emit(asm_t *a, struct bpf_insn i)
+{
+    if (a->n < ASM_MAX) a->insn[a->n] = i;
+    a->n++;
+}
+
+static void emit_jmp(asm_t *a, struct bpf_insn i, int label)
+{
+    if (a->nfix < ASM_FIXUPS) {
+        a->fix[a->nfix].at    = a->n;
+        a->fix[a->nfix].label = label;
+    }
+    a->nfix++;
+    emit(a, i);
+}
+
+static void bind_label(asm_t *a, int label)
+{
+    a->label[label] = a->n;
+}
+
+static void emit_ld_map(asm_t *a, int reg, int map_fd)
+{
+    emit(a, INSN(BPF_LD | BPF_DW | BPF_IMM, reg, BPF_PSEUDO_MAP_FD, 0, map_fd));
+    emit(a, INSN(0, 0, 0, 0, 0));
+}
+
+static int asm_load(asm_t *a, int prog_type)
+{
+    union bpf_attr attr;
+    int i;
+
+    if (a->n > ASM_MAX || a->nfix > ASM_FIXUPS) {
+        errno = E2BIG;
+        return -1;
+    }
+    for (i = 0; i < a->nfix; i++)
+        a->insn[a->fix[i].at].off =
+            (int16_t)(a->label[a->fix[i].label] - a->fix[i].at - 1);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = (uint32_t)prog_type;
+    attr.insns     = (uint64_t)(uintptr_t)a->insn;
+    attr.insn_cnt  = (uint32_t)a->n;
+    attr.license   = (uint64_t)(uintptr_t)"GPL";
+    return (int)sys_bpf(BPF_PROG_LOAD, &attr);
+}
+
+/* =========================================================
+ * Uplink: XDP GTP-U decap
+ *
+ *   r6 ctx, r7 inner offset (50 or 58), r8 inner length, r9 inner saddr
+ *   fp-4 TEID key, fp-24..-11 saved Ethernet header
+ * ========================================================= */
+
+static int xdp_load(void)
+{
+    const int D = offsetof(struct xdp_md, data);
+    const int E = offsetof(struct xdp_md, data_end);
+    asm_t a;
+
+    memset(&a, 0, sizeof(a));
+    emit(&a, MOV_R(6, 1));
+    emit(&a, LDX(BPF_W, 2, 6, D));
+    emit(&a, LDX(BPF_W, 3, 6, E));
+    emit(&a, MOV_R(4, 2));
+    emit(&a, ALU_K(BPF_ADD, 4, 50));                        /* eth+ip+udp+gtp */
+    emit_jmp(&a, JMP_R(BPF_JGT, 4, 3), L_PASS);
+
+    /* outer: IPv4 without options or fragmentation, UDP to 2152 */
+    emit(&a, LDX(BPF_H, 5, 2, 12));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, htons(ETH_P_IP)), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 14));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 0x45), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 23));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, IPPROTO_UDP), L_PASS);
+    emit(&a, LDX(BPF_H, 5, 2, 20));
+    emit(&a, ALU_K(BPF_AND, 5, htons(0x3fff)));             /* MF | offset */
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 0), L_PASS);
+    emit(&a, LDX(BPF_H, 5, 2, 36));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, htons(XDP_GTPU_PORT)), L_PASS);
+
+    /* GTP-U G-PDU: plain (0x30) or one PDU session container (0x34) */
+    emit(&a, LDX(BPF_B, 5, 2, 43));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 0xff), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 42));
+    emit(&a, MOV_K(7, 50));
+    emit_jmp(&a, JMP_K(BPF_JEQ, 5, 0x30), L_INNER);
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 0x34), L_PASS);
+    emit(&a, MOV_R(4, 2));
+    emit(&a, ALU_K(BPF_ADD, 4, 58));
+    emit_jmp(&a, JMP_R(BPF_JGT, 4, 3), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 53));                         /* next ext type */
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 0x85), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 54));                         /* ext length */
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 1), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 57));                         /* no further ext */
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 0), L_PASS);
+    emit(&a, MOV_K(7, 58));
+
+    /* inner IPv4 */
+    bind_label(&a, L_INNER);
+    emit(&a, MOV_R(8, 2));
+    emit(&a, ADD_R(8, 7));
+    emit(&a, MOV_R(4, 8));
+    emit(&a, ALU_K(BPF_ADD, 4, 20));
+    emit_jmp(&a, JMP_R(BPF_JGT, 4, 3), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 8, 0));
+    emit(&a, ALU_K(BPF_RSH, 5, 4));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 4), L_PASS);
+    emit(&a, LDX(BPF_W, 9, 8, 12));
+    emit(&a, LDX(BPF_H, 8, 8, 2));
+    emit(&a, TO_BE16(8));                                   /* tot_len, host order */
+    emit(&a, MOV_R(4, 2));                                  /* must end the frame: */
+    emit(&a, ADD_R(4, 7));                                  /* no GSO superpacket */
+    emit(&a, ADD_R(4, 8));
+    emit_jmp(&a, JMP_R(BPF_JNE, 4, 3), L_PASS);
+
+    emit(&a, LDX(BPF_W, 5, 2, 46));
+    emit(&a, STX(BPF_W, 10, 5, -4));
+    emit(&a, LDX(BPF_W, 5, 2, 0));
+    emit(&a, STX(BPF_W, 10, 5, -24));
+    emit(&a, LDX(BPF_W, 5, 2, 4));
+    emit(&a, STX(BPF_W, 10, 5, -20));
+    emit(&a, LDX(BPF_W, 5, 2, 8));
+    emit(&a, STX(BPF_W, 10, 5, -16));
+    emit(&a, LDX(BPF_H, 5, 2, 12));
+    emit(&a, STX(BPF_H, 10, 5, -12));
+
+    /* TEID known, and the packet really comes from that UE */
+    emit_ld_map(&a, 1, g_ul_fd);
+    emit(&a, MOV_R(2, 10));
+    emit(&a, ALU_K(BPF_ADD, 2, -4));
+    emit(&a, CALL(BPF_FUNC_map_lookup_elem));
+    emit_jmp(&a, JMP_K(BPF_JEQ, 0, 0), L_PASS);
+    emit(&a, LDX(BPF_W, 5, 0, offsetof(ul_val_t, ue_ip)));
+    emit_jmp(&a, JMP_R(BPF_JNE, 5, 9), L_PASS);
+    emit(&a, MOV_K(5, 1));
+    emit(&a, XADD(0, 5, offsetof(ul_val_t, pkts)));
+    emit(&a, XADD(0, 8, offsetof(ul_val_t, bytes)));
+
+    /* drop outer headers, put the Ethernet header back in front */
+    emit(&a, MOV_R(1, 6));
+    emit(&a, MOV_R(2, 7));
+    emit(&a, ALU_K(BPF_ADD, 2, -ETH_HLEN));
+    emit(&a, CALL(BPF_FUNC_xdp_adjust_head));
+    emit_jmp(&a, JMP_K(BPF_JNE, 0, 0), L_PASS);
+    emit(&a, LDX(BPF_W, 2, 6, D));
+    emit(&a, LDX(BPF_W, 3, 6, E));
+    emit(&a, MOV_R(4, 2));
+    emit(&a, ALU_K(BPF_ADD, 4, ETH_HLEN));
+    emit_jmp(&a, JMP_R(BPF_JGT, 4, 3), L_PASS);
+    emit(&a, LDX(BPF_W, 5, 10, -24));
+    emit(&a, STX(BPF_W, 2, 5, 0));
+    emit(&a, LDX(BPF_W, 5, 10, -20));
+    emit(&a, STX(BPF_W, 2, 5, 4));
+    emit(&a, LDX(BPF_W, 5, 10, -16));
+    emit(&a, STX(BPF_W, 2, 5, 8));
+    emit(&a, LDX(BPF_H, 5, 10, -12));
+    emit(&a, STX(BPF_H, 2, 5, 12));
+
+    bind_label(&a, L_PASS);
+    emit(&a, MOV_K(0, XDP_PASS));
+    emit(&a, EXIT());
+    return asm_load(&a, BPF_PROG_TYPE_XDP);
+}
+
+/* =========================================================
+ * Downlink: TC egress GTP-U encap on ogstun
+ *
+ *   r6 skb, r7 inner length, r8 dl_val_t
+ *   fp-4 UE key, fp-128 struct bpf_fib_lookup, fp-192 outer headers
+ * ========================================================= */
+
+#define FIB     (-128)
+#define HDR     (-192)
+
+static int tc_load(uint32_t n3_ip, int max_inner)
+{
+    const int S = offsetof(struct __sk_buff, len);
+    const int D = offsetof(struct __sk_buff, data);
+    const int E = offsetof(struct __sk_buff, data_end);
+    uint8_t tmpl[XDP_HDR_LEN + 1];
+    asm_t a;
+    int i;
+
+    /* Constant part of Ethernet + IPv4 + UDP + GTP-U; MACs, lengths,
+     * daddr, checksum, TEID and QFI are filled per packet */
+    memset(tmpl, 0, sizeof(tmpl));
+    tmpl[12] = 0x08;                                        /* ETH_P_IP */
+    tmpl[14] = 0x45;
+    tmpl[22] = 64;                                          /* TTL */
+    tmpl[23] = IPPROTO_UDP;
+    memcpy(tmpl + 26, &n3_ip, 4);
+    tmpl[34] = XDP_GTPU_PORT >> 8; tmpl[35] = XDP_GTPU_PORT & 0xff;
+    tmpl[36] = XDP_GTPU_PORT >> 8; tmpl[37] = XDP_GTPU_PORT & 0xff;
+    tmpl[42] = 0x34;                                        /* v1, PT, E */
+    tmpl[43] = 0xff;                                        /* G-PDU */
+    tmpl[53] = 0x85;                                        /* PDU session container */
+    tmpl[54] = 1;                                           /* 4 bytes; DL PDU type 0 */
+
+    memset(&a, 0, sizeof(a));
+    emit(&a, MOV_R(6, 1));
+    emit(&a, LDX(BPF_W, 7, 6, S));
+    emit_jmp(&a, JMP_K(BPF_JGT, 7, max_inner), L_PASS);     /* incl. GSO skbs */
+    emit(&a, LDX(BPF_W, 2, 6, D));
+    emit(&a, LDX(BPF_W, 3, 6, E));
+    emit(&a, MOV_R(4, 2));
+    emit(&a, ALU_K(BPF_ADD, 4, 20));
+    emit_jmp(&a, JMP_R(BPF_JGT, 4, 3), L_PASS);
+    emit(&a, LDX(BPF_B, 5, 2, 0));
+    emit(&a, ALU_K(BPF_RSH, 5, 4));
+    emit_jmp(&a, JMP_K(BPF_JNE, 5, 4), L_PASS);
+    emit(&a, LDX(BPF_W, 5, 2, 16));
+    emit(&a, STX(BPF_W, 10, 5, -4));
+
+    emit_ld_map(&a, 1, g_dl_fd);
+    emit(&a, MOV_R(2, 10));
+    emit(&a, ALU_K(BPF_ADD, 2, -4));
+    emit(&a, CALL(BPF_FUNC_map_lookup_elem));
+    emit_jmp(&a, JMP_K(BPF_JEQ, 0, 0), L_PASS);
+    emit(&a, MOV_R(8, 0));
+
+    /* route + neighbour of the gNB, as seen from the N3 interface */
+    for (i = 0; i < (int)sizeof(struct bpf_fib_lookup); i += 8)
+        emit(&a, ST(BPF_DW, 10, FIB + i, 0));
+    emit(&a, ST(BPF_B, 10, FIB + offsetof(struct bpf_fib_lookup, family), AF_INET));
+    emit(&a, ST(BPF_B, 10, FIB + offsetof(struct bpf_fib_lookup, l4_protocol), IPPROTO_UDP));
+    emit(&a, MOV_R(5, 7));
+    emit(&a, ALU_K(BPF_ADD, 5, XDP_ENCAP_LEN));
+    emit(&a, STX(BPF_H, 10, 5, FIB + offsetof(struct bpf_fib_lookup, tot_len)));
+    emit(&a, ST(BPF_W, 10, FIB + offsetof(struct bpf_fib_lookup, ifindex), g_n3_ifindex));
+    emit(&a, ST(BPF_W, 10, FIB + offsetof(struct bpf_fib_lookup, ipv4_src), (int32_t)n3_ip));
+    emit(&a, LDX(BPF_W, 5, 8, offsetof(dl_val_t, peer_ip)));
+    emit(&a, STX(BPF_W, 10, 5, FIB + offsetof(struct bpf_fib_lookup, ipv4_dst)));
+    emit(&a, MOV_R(1, 6));
+    emit(&a, MOV_R(2, 10));
+    emit(&a, ALU_K(BPF_ADD, 2, FIB));
+    emit(&a, MOV_K(3, sizeof(struct bpf_fib_lookup)));
+    emit(&a, MOV_K(4, BPF_FIB_LOOKUP_OUTPUT));
+    emit(&a, CALL(BPF_FUNC_fib_lookup));
+    emit_jmp(&a, JMP_K(BPF_JNE, 0, BPF_FIB_LKUP_RET_SUCCESS), L_PASS);
+
+    /* outer headers on the stack, 16 bits at a time (stack stores must
+     * be aligned and the IPv4 header starts at offset 14) */
+    for (i = 0; i < XDP_HDR_LEN; i += 2) {
+        uint16_t v;
+        memcpy(&v, tmpl + i, 2);
+        emit(&a, ST(BPF_H, 10, HDR + i, v));
+    }
+    for (i = 0; i < ETH_ALEN; i += 2) {
+        emit(&a, LDX(BPF_H, 5, 10, FIB + offsetof(struct bpf_fib_lookup, dmac) + i));
+        emit(&a, STX(BPF_H, 10, 5, HDR + i));
+        emit(&a, LDX(BPF_H, 5, 10, FIB + offsetof(struct bpf_fib_lookup, smac) + i));
+        emit(&a, STX(BPF_H, 10, 5, HDR + ETH_ALEN + i));
+    }
+    emit(&a, MOV_R(5, 7));
+    emit(&a, ALU_K(BPF_ADD, 5, XDP_ENCAP_LEN));
+    emit(&a, TO_BE16(5));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 16));                  /* IP total length */
+    emit(&a, LDX(BPF_H, 5, 8, offsetof(dl_val_t, peer_ip)));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 30));                  /* IP daddr */
+    emit(&a, LDX(BPF_H, 5, 8, offsetof(dl_val_t, peer_ip) + 2));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 32));
+    emit(&a, MOV_R(5, 7));
+    emit(&a, ALU_K(BPF_ADD, 5, XDP_ENCAP_LEN - 20));
+    emit(&a, TO_BE16(5));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 38));                  /* UDP length */
+    emit(&a, MOV_R(5, 7));
+    emit(&a, ALU_K(BPF_ADD, 5, 8));
+    emit(&a, TO_BE16(5));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 44));                  /* GTP-U length */
+    emit(&a, LDX(BPF_H, 5, 8, offsetof(dl_val_t, teid)));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 46));
+    emit(&a, LDX(BPF_H, 5, 8, offsetof(dl_val_t, teid) + 2));
+    emit(&a, STX(BPF_H, 10, 5, HDR + 48));
+    emit(&a, LDX(BPF_B, 5, 8, offsetof(dl_val_t, qfi)));
+    emit(&a, STX(BPF_B, 10, 5, HDR + 56));
+
+    /* IPv4 header checksum */
+    emit(&a, MOV_K(1, 0));
+    emit(&a, MOV_K(2, 0));
+    emit(&a, MOV_R(3, 10));
+    emit(&a, ALU_K(BPF_ADD, 3, HDR + ETH_HLEN));
+    emit(&a, MOV_K(4, 20));
+    emit(&a, MOV_K(5, 0));
+    emit(&a, CALL(BPF_FUNC_csum_diff));
+    emit(&a, MOV_R(1, 0));
+    emit(&a, ALU_K(BPF_RSH, 1, 16));
+    emit(&a, ALU_K(BPF_AND, 0, 0xffff));
+    emit(&a, ADD_R(0, 1));
+    emit(&a, MOV_R(1, 0));
+    emit(&a, ALU_K(BPF_RSH, 1, 16));
+    emit(&a, ADD_R(0, 1));
+    emit(&a, ALU_K(BPF_XOR, 0, 0xffff));
+    emit(&a, ALU_K(BPF_AND, 0, 0xffff));
+    emit(&a, STX(BPF_H, 10, 0, HDR + 24));
+
+    /* prepend, copy, count, send out of the N3 interface */
+    emit(&a, MOV_R(1, 6));
+    emit(&a, MOV_K(2, XDP_HDR_LEN));
+    emit(&a, MOV_K(3, 0));
+    emit(&a, CALL(BPF_FUNC_skb_change_head));
+    emit_jmp(&a, JMP_K(BPF_JNE, 0, 0), L_PASS);             /* skb unchanged */
+    emit(&a, MOV_R(1, 6));
+    emit(&a, MOV_K(2, 0));
+    emit(&a, MOV_R(3, 10));
+    emit(&a, ALU_K(BPF_ADD, 3, HDR));
+    emit(&a, MOV_K(4, XDP_HDR_LEN));
+    emit(&a, MOV_K(5, 0));
+    emit(&a, CALL(BPF_FUNC_skb_store_bytes));
+    emit_jmp(&a, JMP_K(BPF_JNE, 0, 0), L_SHOT);             /* half-built: drop */
+    emit(&a, MOV_K(5, 1));
+    emit(&a, XADD(8, 5, offsetof(dl_val_t, pkts)));
+    emit(&a, XADD(8, 7, offsetof(dl_val_t, bytes)));
+    emit(&a, LDX(BPF_W, 1, 10, FIB + offsetof(struct bpf_fib_lookup, ifindex)));
+    emit(&a, MOV_K(2, 0));
+    emit(&a, CALL(BPF_FUNC_redirect));
+    emit(&a, EXIT());
+
+    bind_label(&a, L_SHOT);
+    emit(&a, MOV_K(0, TC_ACT_SHOT));
+    emit(&a, EXIT());
+    bind_label(&a, L_PASS);
+    emit(&a, MOV_K(0, TC_ACT_OK));
+    emit(&a, EXIT());
+    return asm_load(&a, BPF_PROG_TYPE_SCHED_CLS);
+}
+
+/* =========================================================
+ * rtnetlink: XDP attach, clsact qdisc + bpf filter
+ * ========================================================= */
+
+typedef union nl_req_u {
+    struct nlmsghdr nh;
+    char            buf[512];
+} nl_req_t;
+
+static struct rtattr *nla_put(struct nlmsghdr *nh, int type, const void *data, int len)
+{
+    struct rtattr *rta = (struct rtattr *)((char *)nh + NLMSG_ALIGN(nh->nlmsg_len));
+
+    rta->rta_type = (unsigned short)type;
+    rta->rta_len  = (unsigned short)RTA_LENGTH(len);
+    if (len) memcpy(RTA_DATA(rta), data, (size_t)len);
+    nh->nlmsg_len = NLMSG_ALIGN(nh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+    return rta;
+}
+
+static void nla_nest_end(struct nlmsghdr *nh, struct rtattr *nest)
+{
+    nest->rta_len = (unsigned short)((char *)nh + nh->nlmsg_len - (char *)nest);
+}
+
+static int nl_talk(struct nlmsghdr *nh)
+{
+    struct sockaddr_nl sa;
+    char buf[4096];
+    struct nlmsghdr *h;
+    int fd, n, err = 0;
+
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) return -1;
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    nh->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+    if (sendto(fd, nh, nh->nlmsg_len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0 ||
+        (n = (int)recv(fd, buf, sizeof(buf), 0)) < 0) {
+        err = -errno;
+        goto out;
+    }
+    for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, (unsigned int)n); h = NLMSG_NEXT(h, n))
+        if (h->nlmsg_type == NLMSG_ERROR) {
+            err = ((struct nlmsgerr *)NLMSG_DATA(h))->error;
+            break;
+        }
+out:
+    close(fd);
+    if (err) {
+        errno = -err;
+        return -1;
+    }
+    return 0;
+}
+
+/* prog_fd -1 detaches */
+static int xdp_attach(int ifindex, int prog_fd, uint32_t flags)
+{
+    nl_req_t req;
+    struct ifinfomsg *ifi;
+    struct rtattr *nest;
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len  = NLMSG_LENGTH(sizeof(*ifi));
+    req.nh.nlmsg_type = RTM_SETLINK;
+    ifi = NLMSG_DATA(&req.nh);
+    ifi->ifi_family = AF_UNSPEC;
+    ifi->ifi_index  = ifindex;
+    nest = nla_put(&req.nh, IFLA_XDP | NLA_F_NESTED, NULL, 0);
+    nla_put(&req.nh, IFLA_XDP_FD, &prog_fd, sizeof(prog_fd));
+    nla_put(&req.nh, IFLA_XDP_FLAGS, &flags, sizeof(flags));
+    nla_nest_end(&req.nh, nest);
+    return nl_talk(&req.nh);
+}
+
+static int tc_clsact(int type, int ifindex)
+{
+    nl_req_t req;
+    struct tcmsg *tc;
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len   = NLMSG_LENGTH(sizeof(*tc));
+    req.nh.nlmsg_type  = (unsigned short)type;
+    req.nh.nlmsg_flags = type == RTM_NEWQDISC ? NLM_F_CREATE | NLM_F_EXCL : 0;
+    tc = NLMSG_DATA(&req.nh);
+    tc->tcm_family  = AF_UNSPEC;
+    tc->tcm_ifindex = ifindex;
+    tc->tcm_handle  = TC_H_MAKE(TC_H_CLSACT, 0);
+    tc->tcm_parent  = TC_H_CLSACT;
+    nla_put(&req.nh, TCA_KIND, "clsact", sizeof("clsact"));
+    return nl_talk(&req.nh);
+}
+
+static int tc_egress_attach(int ifindex, int prog_fd)
+{
+    nl_req_t req;
+    struct tcmsg *tc;
+    struct rtattr *nest;
+    uint32_t fd = (uint32_t)prog_fd, flags = TCA_BPF_FLAG_ACT_DIRECT;
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len   = NLMSG_LENGTH(sizeof(*tc));
+    req.nh.nlmsg_type  = RTM_NEWTFILTER;
+    req.nh.nlmsg_flags = NLM_F_CREATE | NLM_F_EXCL;
+    tc = NLMSG_DATA(&req.nh);
+    tc->tcm_family  = AF_UNSPEC;
+    tc->tcm_ifindex = ifindex;
+    tc->tcm_handle  = 1;
+    tc->tcm_parent  = TC_H_MAKE(TC_H_CLSACT, TC_H_MIN_EGRESS);
+    tc->tcm_info    = TC_H_MAKE(1 << 16, htons(ETH_P_ALL));
+    nla_put(&req.nh, TCA_KIND, "bpf", sizeof("bpf"));
+    nest = nla_put(&req.nh, TCA_OPTIONS | NLA_F_NESTED, NULL, 0);
+    nla_put(&req.nh, TCA_BPF_FD, &fd, sizeof(fd));
+    nla_put(&req.nh, TCA_BPF_NAME, "upf_gtpu_encap", sizeof("upf_gtpu_encap"));
+    nla_put(&req.nh, TCA_BPF_FLAGS, &flags, sizeof(flags));
+    nla_nest_end(&req.nh, nest);
+    return nl_talk(&req.nh);
+}
+
+/* =========================================================
+ * Start / stop
+ * ========================================================= */
+
+/* Fill in whichever of name / ip is missing */
+static int resolve_n3(const char *n3_if, uint32_t *ip, char *name)
+{
+    struct ifaddrs *ifa, *i;
+    int found = 0;
+
+    if (getifaddrs(&ifa) < 0) return -1;
+    for (i = ifa; i && !found; i = i->ifa_next) {
+        uint32_t addr;
+
+        if (!i->ifa_addr || i->ifa_addr->sa_family != AF_INET) continue;
+        addr = ((struct sockaddr_in *)i->ifa_addr)->sin_addr.s_addr;
+        if (n3_if ? strcmp(i->ifa_name, n3_if) != 0 : addr != *ip) continue;
+        if (!*ip) *ip = addr;
+        strncpy(name, i->ifa_name, IF_NAMESIZE - 1);
+        found = 1;
+    }
+    freeifaddrs(ifa);
+    if (!found) {
+        errno = ENODEV;
+        return -1;
+    }
+    return 0;
+}
+
+static int if_mtu(const char *name)
+{
+    struct ifreq ifr;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0), mtu = -1;
+
+    if (fd < 0) return -1;
+    memset(&ifr, 0, sizeof(ifr));
+    snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", name);
+    if (ioctl(fd, SIOCGIFMTU, &ifr) == 0) mtu = ifr.ifr_mtu;
+    close(fd);
+    return mtu;
+}
+
+int upf_xdp_start(const char *n3_if, uint32_t n3_ip, const char *tun_if,
+                  int mode, int max_entries)
+{
+    int mtu, err;
+
+    if (g_xdp_fd >= 0) return 0;
+    if (max_entries <= 0) max_entries = 32768;
+
+    memset(g_n3_name, 0, sizeof(g_n3_name));
+    if (resolve_n3(n3_if, &n3_ip, g_n3_name) < 0) return -1;
+    g_n3_ifindex  = (int)if_nametoindex(g_n3_name);
+    g_tun_ifindex = (int)if_nametoindex(tun_if);
+    mtu = if_mtu(g_n3_name);
+    if (!g_n3_ifindex || !g_tun_ifindex || mtu < 576) {
+        errno = ENODEV;
+        return -1;
+    }
+
+    g_ul_fd = map_create(sizeof(uint32_t), sizeof(ul_val_t), max_entries);
+    g_ue_fd = map_create(sizeof(uint32_t), sizeof(uint32_t), max_entries);
+    g_dl_fd = map_create(sizeof(uint32_t), sizeof(dl_val_t), max_entries);
+    if (g_ul_fd < 0 || g_ue_fd < 0 || g_dl_fd < 0) goto fail;
+
+    g_xdp_fd = xdp_load();
+    if (g_xdp_fd < 0) goto fail;
+    g_tc_fd = tc_load(n3_ip, mtu - XDP_ENCAP_LEN);
+    if (g_tc_fd < 0) goto fail;
+
+    /* replaces a program left behind by a previous run */
+    g_xdp_flags = mode == UPF_XDP_NATIVE ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE;
+    if (xdp_attach(g_n3_ifindex, g_xdp_fd, g_xdp_flags) < 0) goto fail;
+
+    tc_clsact(RTM_DELQDISC, g_tun_ifindex);
+    if (tc_clsact(RTM_NEWQDISC, g_tun_ifindex) < 0 ||
+        tc_egress_attach(g_tun_ifindex, g_tc_fd) < 0) {
+        err = errno;
+        xdp_attach(g_n3_ifindex, -1, g_xdp_flags);
+        errno = err;
+        goto fail;
+    }
+    return 0;
+
+fail:
+    err = errno;
+    upf_xdp_stop();
+    errno = err;
+    return -1;
+}
+
+void upf_xdp_stop(void)
+{
+    if (g_xdp_flags) {
+        xdp_attach(g_n3_ifindex, -1, g_xdp_flags);
+        tc_clsact(RTM_DELQDISC, g_tun_ifindex);
+        g_xdp_flags = 0;
+    }
+    if (g_xdp_fd >= 0) close(g_xdp_fd);
+    if (g_tc_fd >= 0) close(g_tc_fd);
+    if (g_ul_fd >= 0) close(g_ul_fd);
+    if (g_ue_fd >= 0) close(g_ue_fd);
+    if (g_dl_fd >= 0) close(g_dl_fd);
+    g_xdp_fd = g_tc_fd = g_ul_fd = g_ue_fd = g_dl_fd = -1;
+}
+
+const char *upf_xdp_n3_if(void)
+{
+    return g_n3_name;
+}
+
+/* =========================================================
+ * Entries
+ * ========================================================= */
+
+int upf_xdp_ul_set(uint32_t teid, uint32_t ue_ip)
+{
+    ul_val_t v;
+    uint32_t old, key;
+
+    if (g_ul_fd < 0 || !teid || !ue_ip) return -1;
+
+    if (map_op(BPF_MAP_LOOKUP_ELEM, g_ue_fd, &ue_ip, &old, 0) == 0) {
+        if (old == teid) return 0;
+        key = htonl(old);
+        map_op(BPF_MAP_DELETE_ELEM, g_ul_fd, &key, NULL, 0);
+    }
+
+    memset(&v, 0, sizeof(v));
+    v.ue_ip = ue_ip;
+    key = htonl(teid);
+    if (map_op(BPF_MAP_UPDATE_ELEM, g_ul_fd, &key, &v, BPF_ANY) < 0) {
+        map_op(BPF_MAP_DELETE_ELEM, g_ue_fd, &ue_ip, NULL, 0);
+        return -1;
+    }
+    if (map_op(BPF_MAP_UPDATE_ELEM, g_ue_fd, &ue_ip, &teid, BPF_ANY) < 0) {
+        map_op(BPF_MAP_DELETE_ELEM, g_ul_fd, &key, NULL, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void upf_xdp_ul_del(uint32_t ue_ip)
+{
+    uint32_t teid, key;
+
+    if (g_ul_fd < 0 ||
+        map_op(BPF_MAP_LOOKUP_ELEM, g_ue_fd, &ue_ip, &teid, 0) < 0)
+        return;
+    key = htonl(teid);
+    map_op(BPF_MAP_DELETE_ELEM, g_ul_fd, &key, NULL, 0);
+    map_op(BPF_MAP_DELETE_ELEM, g_ue_fd, &ue_ip, NULL, 0);
+}
+
+int upf_xdp_dl_set(uint32_t ue_ip, uint32_t teid, uint32_t peer_ip, uint8_t qfi)
+{
+    dl_val_t v, old;
+
+    if (g_dl_fd < 0 || !ue_ip) return -1;
+
+    memset(&v, 0, sizeof(v));
+    v.teid    = htonl(teid);
+    v.peer_ip = peer_ip;
+    v.qfi     = qfi & 0x3f;
+    if (map_op(BPF_MAP_LOOKUP_ELEM, g_dl_fd, &ue_ip, &old, 0) == 0) {
+        if (old.teid == v.teid && old.peer_ip == v.peer_ip && old.qfi == v.qfi)
+            return 0;                   /* N4 modification without DL change */
+        v.pkts  = old.pkts;
+        v.bytes = old.bytes;
+    }
+    return map_op(BPF_MAP_UPDATE_ELEM, g_dl_fd, &ue_ip, &v, BPF_ANY);
+}
+
+void upf_xdp_dl_del(uint32_t ue_ip)
+{
+    if (g_dl_fd >= 0)
+        map_op(BPF_MAP_DELETE_ELEM, g_dl_fd, &ue_ip, NULL, 0);
+}
+
+void upf_xdp_stats(upf_xdp_stats_t *st)
+{
+    uint32_t key, next;
+    int first;
+
+    memset(st, 0, sizeof(*st));
+    if (g_ul_fd < 0) return;
+
+    for (first = 1; map_op(BPF_MAP_GET_NEXT_KEY, g_ul_fd,
+                           first ? NULL : &key, &next, 0) == 0; first = 0) {
+        ul_val_t v;
+        key = next;
+        if (map_op(BPF_MAP_LOOKUP_ELEM, g_ul_fd, &key, &v, 0) < 0) continue;
+        st->ul_pkts  += v.pkts;
+        st->ul_bytes += v.bytes;
+        st->ul_entries++;
+    }
+    for (first = 1; map_op(BPF_MAP_GET_NEXT_KEY, g_dl_fd,
+                           first ? NULL : &key, &next, 0) == 0; first = 0) {
+        dl_val_t v;
+        key = next;
+        if (map_op(BPF_MAP_LOOKUP_ELEM, g_dl_fd, &key, &v, 0) < 0) continue;
+        st->dl_pkts  += v.pkts;
+        st->dl_bytes += v.bytes;
+        st->dl_entries++;
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * upf-xdp.h — in-kernel GTP-U fast path: XDP decap + TC encap (no open5GS deps)
+ *
+ * Two eBPF programs, assembled at runtime like the tun steering program
+ * in upf-mq-dp.c (no clang / libbpf needed, loads on stock kernels):
+ *
+ *   uplink    XDP on the N3 interface (generic or native mode)
+ *             IPv4/UDP:2152 G-PDU, no options or one PDU session container
+ *             extension, TEID in the uplink map and inner IPv4 source =
+ *             that UE  →  strip outer IP/UDP/GTP-U, keep the Ethernet
+ *             header, XDP_PASS.  The kernel then routes (and NATs) the
+ *             inner packet as if it had come out of ogstun.
+ *   downlink  TC egress (clsact) on ogstun
+ *             IPv4 dst in the downlink map, packet fits the N3 MTU with
+ *             the 44-byte GTP-U encapsulation, and the gNB's MAC is in
+ *             the neighbour table (bpf_fib_lookup)  →  prepend Ethernet +
+ *             IPv4 + UDP + GTP-U (PDU session container with QFI) and
+ *             redirect to the N3 interface.
+ *
+ * Everything else — echo, error indication, end marker, unknown TEIDs,
+ * IP options, fragments, GSO-sized downlink, unresolved neighbours —
+ * is left untouched (XDP_PASS / TC_ACT_OK) and reaches the userspace UPF
+ * exactly as before.
+ *
+ * TEIDs are in host order, IPv4 addresses in network order, as elsewhere
+ * in upf-mq-dp.h / upf-n3.h.  Each map entry counts its packets and bytes.
+ *
+ * Used by the UPF (upf-mq.c) and by tools/upf-mq-bench.c.
+ */
+
+#ifndef UPF_XDP_H
+#define UPF_XDP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPF_XDP_GENERIC     0           /* XDP_FLAGS_SKB_MODE: any netdev */
+#define UPF_XDP_NATIVE      1           /* XDP_FLAGS_DRV_MODE: driver support needed */
+
+typedef struct upf_xdp_stats_s {
+    uint64_t ul_pkts;       /* decapsulated by XDP */
+    uint64_t ul_bytes;      /* inner bytes */
+    uint64_t dl_pkts;       /* encapsulated by TC */
+    uint64_t dl_bytes;      /* inner bytes */
+    int      ul_entries;
+    int      dl_entries;
+} upf_xdp_stats_t;
+
+/* Create the maps, load both programs, attach XDP to n3_if and TC egress
+ * to tun_if.  n3_if NULL: the interface holding n3_ip.  n3_ip 0: the
+ * first IPv4 address of n3_if.  Returns 0, or -1 with errno (nothing
+ * stays attached). */
+int  upf_xdp_start(const char *n3_if, uint32_t n3_ip, const char *tun_if,
+                   int mode, int max_entries);
+void upf_xdp_stop(void);
+
+/* The N3 interface actually used (valid after upf_xdp_start) */
+const char *upf_xdp_n3_if(void);
+
+/* Uplink: TEID → UE.  One TEID per UE: a new TEID replaces the old one. */
+int  upf_xdp_ul_set(uint32_t teid, uint32_t ue_ip);
+void upf_xdp_ul_del(uint32_t ue_ip);
+
+/* Downlink: UE → (TEID, gNB, QFI); qfi 0 still sends the container */
+int  upf_xdp_dl_set(uint32_t ue_ip, uint32_t teid, uint32_t peer_ip, uint8_t qfi);
+void upf_xdp_dl_del(uint32_t ue_ip);
+
+/* Sums the per-entry counters (walks both maps) */
+void upf_xdp_stats(upf_xdp_stats_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPF_XDP_H */
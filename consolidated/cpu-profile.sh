@@ -0,0 +1,177 @@
+#!/bin/bash
+# ============================================================
+# cpu-profile.sh — CPU placement profile for the CP and UPF containers
+# ============================================================
+# Sourced by start-cp-nfs.sh and start-upf.sh; run directly on the host
+# for the parts a container cannot reach (IRQ affinity).
+#
+# The profile (config/cpu-profile.conf, CPU_PROFILE=<path>) is one
+# "<target> <cpus>" pair per line, '#' starts a comment:
+#
+#   nrf ... amf       CP NF, started with taskset by start-cp-nfs.sh
+#   upf               UPF main loop (N3, N4, ogstun queue 0)
+#   upf.workers       downlink workers, one CPU each, cycled over the
+#                     extra ogstun queues (becomes UPF_MQ_CPUS)
+#   <c>.rps.<dev>     RPS / XPS masks of every queue of <dev>, applied in
+#   <c>.xps.<dev>     container <c> (cp | upf); needs a writable /sys
+#   irq.<glob>        affinity of the host IRQs whose /proc/interrupts
+#                     name matches <glob> (cpu-profile.sh irq, as root)
+#
+# <cpus> is a CPU list ("1", "0,2-3"), "node:<n>" for every CPU of NUMA
+# node <n>, "all", or "-" to leave the target unpinned.  CPUs outside the
+# container's allowed set (docker --cpuset-cpus) are dropped with a
+# warning; a target left with none runs unpinned.
+#
+# Usage: cpu-profile.sh show <profile>    resolved placement
+#        cpu-profile.sh irq  <profile>    apply irq.* entries (host, root)
+# ============================================================
+
+declare -gA CPU_PROFILE_MAP=()
+CPU_PROFILE_FILE=""
+
+cpu_profile_log() { echo "[$(date '+%H:%M:%S')] $1"; }
+
+# cpu_profile_load <file> — returns 1 if there is no usable profile
+cpu_profile_load() {
+    local file="$1" key val rest
+    CPU_PROFILE_MAP=()
+    CPU_PROFILE_FILE=""
+    case "$file" in ""|off|none) return 1 ;; esac
+    if [ ! -r "$file" ]; then
+        cpu_profile_log "WARNING: CPU profile $file not readable — running unpinned"
+        return 1
+    fi
+    while read -r key val rest; do
+        case "$key" in ""|\#*) continue ;; esac
+        [ -n "$val" ] && CPU_PROFILE_MAP[$key]=$val
+    done < "$file"
+    CPU_PROFILE_FILE=$file
+}
+
+# cpu_expand <list> — "0,2-3" → "0 2 3"
+cpu_expand() {
+    local r a b c out=()
+    for r in ${1//,/ }; do
+        a=${r%-*}; b=${r#*-}
+        [[ "$a" =~ ^[0-9]+$ && "$b" =~ ^[0-9]+$ ]] || continue
+        for (( c = a; c <= b; c++ )); do out+=("$c"); done
+    done
+    echo "${out[*]}"
+}
+
+# CPUs this process may run on (the container's cpuset)
+cpu_allowed() {
+    cpu_expand "$(awk '/^Cpus_allowed_list:/ { print $2 }' /proc/self/status)"
+}
+
+# cpu_profile_cpus <target> — resolved CPUs as "0,2,3"; empty = unpinned
+cpu_profile_cpus() {
+    local target="$1" spec="${CPU_PROFILE_MAP[$1]:-}" list c out=() dropped=()
+    local allowed=" $(cpu_allowed) "
+    case "$spec" in
+        ""|-|none) return 0 ;;
+        all)       list=$allowed ;;
+        node:*)    list=$(cpu_expand "$(cat "/sys/devices/system/node/node${spec#node:}/cpulist" 2>/dev/null)") ;;
+        *)         list=$(cpu_expand "$spec") ;;
+    esac
+    for c in $list; do
+        if [[ "$allowed" == *" $c "* ]]; then out+=("$c"); else dropped+=("$c"); fi
+    done
+    if [ ${#dropped[@]} -gt 0 ]; then
+        cpu_profile_log "WARNING: CPU profile: $target $spec — CPU ${dropped[*]} not available$(
+            [ ${#out[@]} -eq 0 ] && echo ", unpinned")" >&2
+    fi
+    local IFS=,
+    echo "${out[*]}"
+}
+
+# cpu_mask <cpus> — "0,2,3" → "d", 32-bit groups joined by ',' (sysfs cpumask)
+cpu_mask() {
+    local -a w=()
+    local c i max=0 out
+    for c in $(cpu_expand "$1"); do
+        (( w[c / 32] |= 1 << (c % 32) ))
+        (( c / 32 > max )) && max=$(( c / 32 ))
+    done
+    out=$(printf '%x' "${w[max]:-0}")
+    for (( i = max - 1; i >= 0; i-- )); do out+=$(printf ',%08x' "${w[i]:-0}"); done
+    echo "$out"
+}
+
+# cpu_profile_taskset <target> — CPU_PROFILE_TASKSET=(taskset -c <cpus>)
+# to prefix the target's command line, empty when unpinned
+cpu_profile_taskset() {
+    local cpus
+    cpus=$(cpu_profile_cpus "$1")
+    CPU_PROFILE_TASKSET=()
+    [ -n "$cpus" ] && CPU_PROFILE_TASKSET=(taskset -c "$cpus")
+    CPU_PROFILE_CPUS=$cpus
+}
+
+# cpu_profile_steer <container> — write <container>.rps.* / .xps.* masks
+cpu_profile_steer() {
+    local prefix="$1." key kind dev dir cpus mask q n ok
+    for key in "${!CPU_PROFILE_MAP[@]}"; do
+        case "$key" in "${prefix}rps."*|"${prefix}xps."*) ;; *) continue ;; esac
+        kind=${key#"$prefix"}; dev=${kind#*.}; kind=${kind%%.*}
+        dir=$([ "$kind" = rps ] && echo rx || echo tx)
+        if [ ! -d "/sys/class/net/$dev/queues" ]; then
+            cpu_profile_log "WARNING: CPU profile: $key — no interface $dev"
+            continue
+        fi
+        cpus=$(cpu_profile_cpus "$key")
+        [ -z "$cpus" ] && continue
+        mask=$(cpu_mask "$cpus")
+        n=0; ok=0
+        for q in /sys/class/net/"$dev"/queues/"$dir"-*/"${kind}"_cpus; do
+            [ -e "$q" ] || continue
+            n=$(( n + 1 ))
+            echo "$mask" > "$q" 2>/dev/null && ok=$(( ok + 1 ))
+        done
+        if [ "$ok" -gt 0 ]; then
+            cpu_profile_log "  ${kind^^} $dev: CPUs $cpus (mask $mask) on $ok/$n queues"
+        else
+            cpu_profile_log "WARNING: CPU profile: $key — /sys is read-only here (privileged container or set it on the host)"
+        fi
+    done
+}
+
+# cpu_profile_irq — apply irq.<glob> entries to /proc/irq/*/smp_affinity_list
+cpu_profile_irq() {
+    local key glob cpus irq name n
+    for key in "${!CPU_PROFILE_MAP[@]}"; do
+        [[ "$key" == irq.* ]] || continue
+        glob=${key#irq.}
+        cpus=$(cpu_profile_cpus "$key")
+        [ -z "$cpus" ] && continue
+        n=0
+        while read -r irq name; do
+            # shellcheck disable=SC2053
+            [[ "$name" == $glob ]] || continue
+            echo "$cpus" > "/proc/irq/$irq/smp_affinity_list" 2>/dev/null && n=$(( n + 1 ))
+        done < <(awk 'NR > 1 && $1 ~ /^[0-9]+:$/ { sub(":", "", $1); print $1, $NF }' /proc/interrupts)
+        cpu_profile_log "  IRQ $glob: CPUs $cpus on $n IRQs"
+    done
+}
+
+# ── Host-side entry point ────────────────────────────────────
+if [ "${BASH_SOURCE[0]}" = "$0" ]; then
+    case "${1:-}" in
+    show)
+        cpu_profile_load "${2:-}" || exit 1
+        for key in $(printf '%s\n' "${!CPU_PROFILE_MAP[@]}" | sort); do
+            printf '%-20s %-12s → %s\n' "$key" "${CPU_PROFILE_MAP[$key]}" \
+                "$(cpu_profile_cpus "$key")"
+        done
+        ;;
+    irq)
+        cpu_profile_load "${2:-}" || exit 1
+        [ "$(id -u)" = "0" ] || { cpu_profile_log "ERROR: irq needs root"; exit 1; }
+        cpu_profile_irq
+        ;;
+    *)
+        echo "Usage: $0 show|irq <profile>" >&2
+        exit 1
+        ;;
+    esac
+fi
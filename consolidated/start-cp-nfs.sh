@@ -2,7 +2,36 @@
 # ============================================================
 # start-cp-nfs.sh — Start all open5GS Control Plane NFs
 # ============================================================
-# Startup order: NRF → SCP → UDR → UDM → AUSF → PCF → BSF → NSSF → SMF → AMF
+# Dependency graph (each NF starts as soon as its deps are ready):
+#
+#   mongo ─┬──────────────┬──────────┬─────────┐
+#   NRF → SCP ─┬→ UDR ◄───┘  PCF ◄───┘  BSF ◄──┘
+#              ├→ UDM  AUSF  NSSF  SMF
+#              └────────┴──────┴─────┴→ AMF (after UDR..SMF, all of them)
+#
+# "Ready" is a real signal, not a sleep:
+#   port    SBI port accepts a TCP connection
+#   nrf     "NF registered" in the NF's log since this start
+#   health  AMF shared-memory health page is SERVING (amf-health-shm)
+#
+# An NF that misses NF_READY_TIMEOUT is logged and its dependents start
+# anyway, except the AMF: it waits until every dependency is ready, since
+# its health page is the container healthcheck.  Timed-out NFs are still
+# checked and become ready late.
+#
+# A startup timeline is printed at the end and written to
+# $LOGDIR/startup-timeline.txt.
+#
+# Env overrides:
+#   NF_READY_TIMEOUT   seconds per NF before its dependents start anyway;
+#                      the AMF keeps waiting (default: 30)
+#   MONGO_TIMEOUT      seconds to wait for MongoDB (default: 60)
+#   CPU_PROFILE        CPU placement profile, or "off" (default: off).
+#                      Each NF is started with taskset on its CPUs and
+#                      cp.rps/xps.* steer eth0 (cpu-profile.sh)
+#   AMF_RESPAWN        1 = start the AMF again when it exits after startup,
+#                      instead of stopping the container (default: 0;
+#                      tests/tc02 scenario D)
 # ============================================================
 
 set -uo pipefail
@@ -10,98 +39,225 @@ set -uo pipefail
 LOGDIR=/var/log/open5gs
 BINDIR=/open5gs
 CFGDIR=/etc/open5gs
+TIMELINE="$LOGDIR/startup-timeline.txt"
+
+NF_READY_TIMEOUT="${NF_READY_TIMEOUT:-30}"
+MONGO_TIMEOUT="${MONGO_TIMEOUT:-60}"
+CPU_PROFILE="${CPU_PROFILE:-off}"
+AMF_RESPAWN="${AMF_RESPAWN:-0}"
+POLL=0.05
 
 mkdir -p "$LOGDIR"
 
-log() { echo "[$(date '+%H:%M:%S')] $1"; }
+log() { echo "[$(date '+%H:%M:%S')] $*"; }
 
-wait_port() {
-    local host="$1" port="$2" max="${3:-30}" waited=0
-    while ! wget -q --spider "http://${host}:${port}" 2>/dev/null && ! nc -z "$host" "$port" 2>/dev/null; do
-        sleep 1; waited=$((waited+1))
-        [ $waited -ge $max ] && { log "WARNING: $host:$port not ready after ${max}s"; return 1; }
-    done
-    log "  $host:$port ready (${waited}s)"
+source "$(dirname "$0")/cpu-profile.sh"
+if cpu_profile_load "$CPU_PROFILE"; then
+    log "CPU profile: $CPU_PROFILE"
+    cpu_profile_steer cp
+fi
+
+# Milliseconds since script start → $NOW
+T0=${EPOCHREALTIME/[.,]/}
+now() { local t=${EPOCHREALTIME/[.,]/}; NOW=$(( (t - T0) / 1000 )); }
+fmt() { [ -z "$1" ] && { printf -- '-'; return; }; printf '%d.%03d' $(( $1 / 1000 )) $(( $1 % 1000 )); }
+
+# Real TCP connect via bash /dev/tcp.  Loopback refuses instantly; remote
+# hosts are bounded so an unroutable address cannot hang the loop.
+tcp_open() {
+    if [ "$1" = "127.0.0.1" ]; then
+        (exec 3<>"/dev/tcp/$1/$2") 2>/dev/null
+    else
+        timeout 1 bash -c "exec 3<>/dev/tcp/$1/$2" 2>/dev/null
+    fi
 }
 
-wait_mongo() {
-    local max=60 waited=0
-    log "Waiting for MongoDB..."
-    # Use bash /dev/tcp for a real TCP ping — avoids wget hanging on non-HTTP sockets
-    while ! (echo > /dev/tcp/db/27017) 2>/dev/null; do
-        sleep 2; waited=$((waited+2))
-        [ $waited -ge $max ] && { log "WARNING: MongoDB not ready after ${max}s"; break; }
+# ── NF table ─────────────────────────────────────────────────
+# name | binary | SBI port | deps (comma list) | readiness gates
+NF_TABLE=(
+    "nrf  | open5gs-nrfd  | 7777 |                               | port"
+    "scp  | open5gs-scpd  | 7778 | nrf                           | port,nrf"
+    "udr  | open5gs-udrd  | 7786 | scp,mongo                     | port,nrf"
+    "udm  | open5gs-udmd  | 7785 | scp                           | port,nrf"
+    "ausf | open5gs-ausfd | 7784 | scp                           | port,nrf"
+    "pcf  | open5gs-pcfd  | 7782 | scp,mongo                     | port,nrf"
+    "bsf  | open5gs-bsfd  | 7787 | scp,mongo                     | port,nrf"
+    "nssf | open5gs-nssfd | 7783 | scp                           | port,nrf"
+    "smf  | open5gs-smfd  | 7781 | scp                           | port,nrf"
+    "amf  | open5gs-amfd  | 7780 | udr,udm,ausf,pcf,bsf,nssf,smf | port,nrf,health"
+)
+
+# The health gate needs the page reader and the page (AMF_HEALTH_SHM_ENABLE)
+HEALTH_GATE=0
+if [ -x "$BINDIR/amf-health-shm" ] && [ "${AMF_HEALTH_SHM_ENABLE:-1}" = "1" ]; then
+    HEALTH_GATE=1
+fi
+
+NAMES=()
+declare -A BIN PORT DEPS GATES STATE PID LOGOFF CPUS
+declare -A T_START T_PORT T_REG T_HEALTH T_READY
+
+for row in "${NF_TABLE[@]}"; do
+    IFS='|' read -r name bin port deps gates <<< "${row// /}"
+    NAMES+=("$name")
+    BIN[$name]=$bin
+    PORT[$name]=$port
+    DEPS[$name]=$deps
+    GATES[$name]=$gates
+    [ "$HEALTH_GATE" = "0" ] && GATES[$name]=${gates/,health/}
+    STATE[$name]=pending
+done
+STATE[mongo]=pending
+
+# A timed-out dependency unblocks every NF but the AMF
+deps_ready() {
+    local d
+    for d in ${DEPS[$1]//,/ }; do
+        case "${STATE[$d]}" in
+        ready) ;;
+        timeout) [ "$1" != amf ] || return 1 ;;
+        *) return 1 ;;
+        esac
     done
-    log "  MongoDB ready (${waited}s)"
-    sleep 1
 }
 
-# ── 0. Wait for MongoDB ──────────────────────────────────────
-wait_mongo
-
-# ── 1. NRF (Network Repository Function) ────────────────────
-log "Starting NRF (port 7777)..."
-"$BINDIR/open5gs-nrfd" -c "$CFGDIR/nrf.yaml" >> "$LOGDIR/nrf.log" 2>&1 &
-NRF_PID=$!
-sleep 3
-
-# ── 2. SCP (Service Communication Proxy) ────────────────────
-log "Starting SCP (port 7778)..."
-"$BINDIR/open5gs-scpd" -c "$CFGDIR/scp.yaml" >> "$LOGDIR/scp.log" 2>&1 &
-SCP_PID=$!
-sleep 2
-
-# ── 3. UDR (Unified Data Repository) ────────────────────────
-log "Starting UDR (port 7786)..."
-"$BINDIR/open5gs-udrd" -c "$CFGDIR/udr.yaml" >> "$LOGDIR/udr.log" 2>&1 &
-UDR_PID=$!
-sleep 1
-
-# ── 4. UDM (Unified Data Management) ────────────────────────
-log "Starting UDM (port 7785)..."
-"$BINDIR/open5gs-udmd" -c "$CFGDIR/udm.yaml" >> "$LOGDIR/udm.log" 2>&1 &
-UDM_PID=$!
-sleep 1
-
-# ── 5. AUSF (Authentication Server Function) ────────────────
-log "Starting AUSF (port 7784)..."
-"$BINDIR/open5gs-ausfd" -c "$CFGDIR/ausf.yaml" >> "$LOGDIR/ausf.log" 2>&1 &
-AUSF_PID=$!
-sleep 1
-
-# ── 6. PCF (Policy Control Function) ────────────────────────
-log "Starting PCF (port 7782)..."
-"$BINDIR/open5gs-pcfd" -c "$CFGDIR/pcf.yaml" >> "$LOGDIR/pcf.log" 2>&1 &
-PCF_PID=$!
-sleep 1
-
-# ── 7. BSF (Binding Support Function) ────────────────────────
-log "Starting BSF (port 7787)..."
-"$BINDIR/open5gs-bsfd" -c "$CFGDIR/bsf.yaml" >> "$LOGDIR/bsf.log" 2>&1 &
-BSF_PID=$!
-sleep 1
-
-# ── 8. NSSF (Network Slice Selection Function) ───────────────
-log "Starting NSSF (port 7783)..."
-"$BINDIR/open5gs-nssfd" -c "$CFGDIR/nssf.yaml" >> "$LOGDIR/nssf.log" 2>&1 &
-NSSF_PID=$!
-sleep 1
-
-# ── 9. SMF (Session Management Function) ─────────────────────
-log "Starting SMF (port 7781)..."
-"$BINDIR/open5gs-smfd" -c "$CFGDIR/smf.yaml" >> "$LOGDIR/smf.log" 2>&1 &
-SMF_PID=$!
-sleep 2
-
-# ── 10. AMF (Access and Mobility Management Function) ─────────
-log "Starting AMF (port 7780, NGAP 38412)..."
-"$BINDIR/open5gs-amfd" -c "$CFGDIR/amf.yaml" >> "$LOGDIR/amf.log" 2>&1 &
-AMF_PID=$!
-sleep 2
+start_nf() {
+    local nf="$1" logf="$LOGDIR/$1.log"
+    LOGOFF[$nf]=$(stat -c %s "$logf" 2>/dev/null || echo 0)
+    cpu_profile_taskset "$nf"
+    CPUS[$nf]=$CPU_PROFILE_CPUS
+    "${CPU_PROFILE_TASKSET[@]}" "$BINDIR/${BIN[$nf]}" -c "$CFGDIR/$nf.yaml" >> "$logf" 2>&1 &
+    PID[$nf]=$!
+    now; T_START[$nf]=$NOW
+    STATE[$nf]=starting
+    log "Starting ${nf^^} (port ${PORT[$nf]}) after [${DEPS[$nf]:-none}]${CPUS[$nf]:+ on CPU ${CPUS[$nf]}}"
+}
+
+# Check each gate once; returns 0 when all gates have passed
+check_nf() {
+    local nf="$1" ok=0
+    case ",${GATES[$nf]}," in *,port,*)
+        if [ -z "${T_PORT[$nf]:-}" ]; then
+            if tcp_open 127.0.0.1 "${PORT[$nf]}"; then now; T_PORT[$nf]=$NOW; else ok=1; fi
+        fi ;;
+    esac
+    case ",${GATES[$nf]}," in *,nrf,*)
+        if [ -z "${T_REG[$nf]:-}" ]; then
+            if tail -c +$(( ${LOGOFF[$nf]} + 1 )) "$LOGDIR/$nf.log" 2>/dev/null \
+                    | grep -q "NF registered"; then
+                now; T_REG[$nf]=$NOW
+            else
+                ok=1
+            fi
+        fi ;;
+    esac
+    case ",${GATES[$nf]}," in *,health,*)
+        if [ -z "${T_HEALTH[$nf]:-}" ]; then
+            if "$BINDIR/amf-health-shm" --check >/dev/null 2>&1; then
+                now; T_HEALTH[$nf]=$NOW
+            else
+                ok=1
+            fi
+        fi ;;
+    esac
+    return $ok
+}
+
+write_timeline() {
+    local nf total
+    now; total=$NOW
+    {
+        printf '%-6s %-29s %8s %8s %8s %8s %8s  %-8s %s\n' \
+            NF AFTER START PORT NRF-REG HEALTH READY STATE CPUS
+        printf '%-6s %-29s %8s %8s %8s %8s %8s  %-8s %s\n' \
+            mongo - - - - - "$(fmt "${T_READY[mongo]:-}")" "${STATE[mongo]}" -
+        for nf in "${NAMES[@]}"; do
+            printf '%-6s %-29s %8s %8s %8s %8s %8s  %-8s %s\n' "$nf" "${DEPS[$nf]:--}" \
+                "$(fmt "${T_START[$nf]:-}")" "$(fmt "${T_PORT[$nf]:-}")" \
+                "$(fmt "${T_REG[$nf]:-}")" "$(fmt "${T_HEALTH[$nf]:-}")" \
+                "$(fmt "${T_READY[$nf]:-}")" "${STATE[$nf]}" "${CPUS[$nf]:-all}"
+        done
+        if [ -n "$FAILED" ]; then
+            echo "CP startup failed after $(fmt "$total")s:${FAILED}"
+        else
+            echo "CP ready in $(fmt "$total")s (seconds since container start)"
+        fi
+    } > "$TIMELINE"
+    while IFS= read -r line; do log "  $line"; done < "$TIMELINE"
+}
+
+# ── Event loop: start what is unblocked, check what is starting ──
+log "Starting CP NFs (dependency-driven, ${NF_READY_TIMEOUT}s per-NF timeout)"
+FAILED=""
+while :; do
+    busy=0
+
+    if [ "${STATE[mongo]}" = "pending" ]; then
+        busy=1
+        now
+        if tcp_open db 27017; then
+            STATE[mongo]=ready; T_READY[mongo]=$NOW
+            log "  MongoDB ready ($(fmt "$NOW")s)"
+        elif [ "$NOW" -ge $(( MONGO_TIMEOUT * 1000 )) ]; then
+            STATE[mongo]=timeout; T_READY[mongo]=$NOW
+            log "WARNING: MongoDB not ready after ${MONGO_TIMEOUT}s"
+        fi
+    fi
+
+    for nf in "${NAMES[@]}"; do
+        case "${STATE[$nf]}" in
+        pending)
+            busy=1
+            deps_ready "$nf" && start_nf "$nf"
+            ;;
+        starting)
+            busy=1
+            if ! kill -0 "${PID[$nf]}" 2>/dev/null; then
+                STATE[$nf]=failed
+                FAILED="$FAILED $nf"
+                log "ERROR: ${nf^^} exited during startup — see $LOGDIR/$nf.log"
+            elif check_nf "$nf"; then
+                now; STATE[$nf]=ready; T_READY[$nf]=$NOW
+                log "  ${nf^^} ready ($(fmt $(( NOW - ${T_START[$nf]} )))s after start)"
+            else
+                now
+                if [ $(( NOW - ${T_START[$nf]} )) -ge $(( NF_READY_TIMEOUT * 1000 )) ]; then
+                    STATE[$nf]=timeout; T_READY[$nf]=$NOW
+                    wait_note=""
+                    case ",${DEPS[amf]}," in
+                    *,$nf,*) wait_note=", the AMF waits for it" ;;
+                    esac
+                    log "WARNING: ${nf^^} not ready after ${NF_READY_TIMEOUT}s" \
+                        "(gates ${GATES[$nf]}) — continuing${wait_note}"
+                fi
+            fi
+            ;;
+        timeout)
+            # Still watched: the AMF may be waiting for it
+            if ! kill -0 "${PID[$nf]}" 2>/dev/null; then
+                STATE[$nf]=failed
+                FAILED="$FAILED $nf"
+                log "ERROR: ${nf^^} exited during startup — see $LOGDIR/$nf.log"
+            elif check_nf "$nf"; then
+                now; STATE[$nf]=ready; T_READY[$nf]=$NOW
+                log "  ${nf^^} ready late ($(fmt $(( NOW - ${T_START[$nf]} )))s after start)"
+            fi
+            ;;
+        esac
+    done
+
+    [ -n "$FAILED" ] && break
+    [ "$busy" = "0" ] && break
+    sleep "$POLL"
+done
 
 log ""
 log "========================================="
-log "  All open5GS CP NFs started"
+if [ -n "$FAILED" ]; then
+    log "  CP startup FAILED:${FAILED}"
+else
+    log "  All open5GS CP NFs started"
+fi
 log "  NRF:  7777  SCP: 7778"
 log "  AMF:  7780  SMF: 7781"
 log "  PCF:  7782  NSSF:7783"
@@ -109,8 +265,24 @@ log "  AUSF: 7784  UDM: 7785"
 log "  UDR:  7786  BSF: 7787"
 log "  NGAP: 38412 (SCTP)"
 log "========================================="
+write_timeline
 log ""
 
-# Keep container alive — wait for any process to exit
-wait -n 2>/dev/null || wait
-log "One or more NFs exited. Container stopping."
+[ -n "$FAILED" ] && { log "Container stopping."; exit 1; }
+
+# Keep container alive — wait for any process to exit.  Only a lone AMF
+# exit is survivable, and only with AMF_RESPAWN=1.
+RESPAWNS=0
+while :; do
+    wait -n 2>/dev/null
+    dead=""
+    for nf in "${NAMES[@]}"; do
+        kill -0 "${PID[$nf]}" 2>/dev/null || dead="$dead $nf"
+    done
+    [ -z "$dead" ] && continue
+    [ "$AMF_RESPAWN" = "1" ] && [ "$dead" = " amf" ] || break
+    RESPAWNS=$((RESPAWNS + 1))
+    log "AMF (pid ${PID[amf]}) exited — respawn #${RESPAWNS} (AMF_RESPAWN=1)"
+    start_nf amf
+done
+log "NF(s) exited:${dead}. Container stopping."
@@ -2,11 +2,39 @@
 # ============================================================
 # start-upf.sh — Start open5GS UPF with TUN interface setup
 # ============================================================
+# Env overrides:
+#   UPF_TUN_QUEUES   ogstun queues (default: 1).  > 1 creates a
+#                    multi_queue tun; the UPF keeps queue 0 on its main
+#                    loop and runs one pinned downlink worker per extra
+#                    queue (NFs/upf/upf-mq.h)
+#   UPF_NAT_MODE     auto | nftables | iptables (default: auto).  nftables
+#                    adds a flowtable so established UE flows bypass the
+#                    NAT ruleset; auto falls back to iptables MASQUERADE
+#                    when nft or the flowtable is unavailable (upf-nat.sh)
+#   UPF_XDP          off | generic | native | auto (default: off).  XDP
+#                    GTP-U decap on N3 + TC encap on ogstun, attached by
+#                    the UPF itself (NFs/upf/upf-xdp.h); programs left by a
+#                    previous run are removed here first
+#   UPF_HUGEPAGES    off | hugetlb | thp | auto (default: off).  Packet
+#                    pool in 2 MB pages; hugetlb needs vm.nr_hugepages
+#                    reserved on the host, and falls back to thp / 4 KB
+#   CPU_PROFILE      CPU placement profile, or "off" (default: off).  Pins
+#                    the UPF main loop (upf), sets UPF_MQ_CPUS from
+#                    upf.workers unless given, and steers ogstun / eth0
+#                    with upf.rps/xps.* (cpu-profile.sh)
+# ============================================================
 
 set -e
 
 log() { echo "[$(date '+%H:%M:%S')] $1"; }
 
+UPF_TUN_QUEUES="${UPF_TUN_QUEUES:-1}"
+export UPF_TUN_QUEUES
+UPF_NAT_MODE="${UPF_NAT_MODE:-auto}"
+UPF_XDP="${UPF_XDP:-off}"
+UPF_HUGEPAGES="${UPF_HUGEPAGES:-off}"
+CPU_PROFILE="${CPU_PROFILE:-off}"
+
 log "Setting up ogstun TUN interface..."
 
 # Read UE subnet/gateway from config (YAML: "    - subnet: 10.206.0.0/16" and "      gateway: 10.206.0.1")
@@ -21,11 +49,16 @@ log "  UE subnet: ${UE_SUBNET}  gateway: ${UE_GW}/${UE_PREFIX}"
 if ip link show ogstun >/dev/null 2>&1; then
     log "  Removing stale ogstun..."
     ip link set ogstun down 2>/dev/null || true
-    ip tuntap del name ogstun mode tun 2>/dev/null || true
+    ip link del ogstun 2>/dev/null || true
 fi
 
-# Create fresh TUN interface
-ip tuntap add name ogstun mode tun
+# Create fresh TUN interface (multi_queue cannot be toggled later)
+if [ "$UPF_TUN_QUEUES" -gt 1 ]; then
+    log "  ${UPF_TUN_QUEUES} queues (multi_queue), CPUs: ${UPF_MQ_CPUS:-default}"
+    ip tuntap add name ogstun mode tun multi_queue
+else
+    ip tuntap add name ogstun mode tun
+fi
 ip addr add "${UE_GW}/${UE_PREFIX}" dev ogstun
 ip link set ogstun up
 
@@ -33,12 +66,50 @@ ip link set ogstun up
 sysctl -w net.ipv4.ip_forward=1
 
 # NAT: UE traffic goes out via ogstun, masquerade for internet access
-iptables -t nat -F POSTROUTING 2>/dev/null || true
-iptables -t nat -A POSTROUTING -s "${UE_SUBNET}" ! -o ogstun -j MASQUERADE
-iptables -I FORWARD 1 -j ACCEPT
+"$(dirname "$0")/upf-nat.sh" "$UPF_NAT_MODE" "${UE_SUBNET}" ogstun
+
+# XDP: a restarted container shares the netns, so drop stale programs.
+# Decapsulated UE packets enter on the N3 interface, not on ogstun.
+if [ "$UPF_XDP" != "off" ]; then
+    log "  XDP GTP-U fast path: ${UPF_XDP} on ${UPF_XDP_IF:-the N3 interface}"
+    for dev in $(ls /sys/class/net); do
+        ip link set dev "$dev" xdpgeneric off 2>/dev/null || true
+        ip link set dev "$dev" xdpdrv off 2>/dev/null || true
+    done
+    for f in /proc/sys/net/ipv4/conf/*/rp_filter; do
+        echo 0 > "$f" 2>/dev/null || true
+    done
+    export UPF_XDP
+fi
+
+if [ "$UPF_HUGEPAGES" != "off" ]; then
+    log "  Packet pool: ${UPF_HUGEPAGES}, 2 MB pages free: $(awk '/HugePages_Free/ {print $2}' /proc/meminfo)"
+    export UPF_HUGEPAGES
+fi
+
+# CPU profile: main loop, workers (one CPU each, cycled over the extra
+# queues) and RPS/XPS of ogstun + eth0.  Steering is set after ogstun is up.
+CPU_PROFILE_TASKSET=()
+source "$(dirname "$0")/cpu-profile.sh"
+if cpu_profile_load "$CPU_PROFILE"; then
+    log "  CPU profile: $CPU_PROFILE"
+    cpu_profile_taskset upf
+    [ -n "$CPU_PROFILE_CPUS" ] && log "  UPF main loop on CPU $CPU_PROFILE_CPUS"
+    workers=($(cpu_expand "$(cpu_profile_cpus upf.workers)"))
+    if [ -z "${UPF_MQ_CPUS:-}" ] && [ ${#workers[@]} -gt 0 ] && [ "$UPF_TUN_QUEUES" -gt 1 ]; then
+        list=()
+        for (( q = 0; q < UPF_TUN_QUEUES - 1; q++ )); do
+            list+=("${workers[q % ${#workers[@]}]}")
+        done
+        UPF_MQ_CPUS=$(IFS=,; echo "${list[*]}")
+        export UPF_MQ_CPUS
+        log "  UPF workers on CPUs $UPF_MQ_CPUS"
+    fi
+    cpu_profile_steer upf
+fi
 
 log "TUN interface ogstun is up:"
 ip addr show ogstun
 
 log "Starting open5GS UPF..."
-exec /open5gs/open5gs-upfd -c /etc/open5gs/upf.yaml
+exec "${CPU_PROFILE_TASKSET[@]}" /open5gs/open5gs-upfd -c /etc/open5gs/upf.yaml
@@ -0,0 +1,101 @@
+#!/bin/bash
+# ============================================================
+# upf-nat.sh — UE NAT for the UPF (nftables flowtable or iptables)
+# ============================================================
+# Usage: upf-nat.sh <mode> <ue-subnet> [tun-dev] [n6-dev ...]
+#
+#   nftables  table inet upf_nat: MASQUERADE in postrouting, plus a
+#             software flowtable on tun-dev + n6-dev.  The first packets
+#             of a UE flow go through the ruleset and conntrack as usual;
+#             once the flow is established it is added to the flowtable
+#             and later packets are forwarded (and NAT-ed) from the
+#             ingress hook, skipping the forward/postrouting chains.
+#   iptables  upstream behaviour: POSTROUTING MASQUERADE + FORWARD ACCEPT
+#             for every packet
+#   auto      nftables if `nft` is installed and the kernel accepts the
+#             flowtable (nf_flow_table), else iptables
+#   off       remove both
+#
+# tun-dev defaults to ogstun, n6-dev to the default-route interface.
+# Rules from a previous run are removed first, so it can be re-run.
+# Prints the mode that was applied as the last line.
+# ============================================================
+
+set -e
+
+log() { echo "[$(date '+%H:%M:%S')] $1"; }
+
+MODE="${1:?usage: upf-nat.sh <auto|nftables|iptables|off> <ue-subnet> [tun-dev] [n6-dev ...]}"
+UE_SUBNET="${2:?ue subnet missing}"
+TUN_DEV="${3:-ogstun}"
+shift 2; [ $# -gt 0 ] && shift
+N6_DEVS=("$@")
+if [ ${#N6_DEVS[@]} -eq 0 ]; then
+    N6_DEVS=($(ip -4 route show default | awk '{for (i = 1; i < NF; i++) if ($i == "dev") print $(i + 1)}' | sort -u))
+fi
+
+nat_clear() {
+    nft delete table inet upf_nat 2>/dev/null || true
+    if command -v iptables >/dev/null 2>&1; then
+        iptables -t nat -D POSTROUTING -s "${UE_SUBNET}" ! -o "${TUN_DEV}" -j MASQUERADE 2>/dev/null || true
+        iptables -D FORWARD -j ACCEPT 2>/dev/null || true
+    fi
+}
+
+nat_nftables() {
+    local devs
+    devs=$(printf '"%s", ' "${TUN_DEV}" "${N6_DEVS[@]}")
+    nft -f - <<EOF
+table inet upf_nat {
+    flowtable ft {
+        hook ingress priority filter
+        devices = { ${devs%, } }
+    }
+    chain forward {
+        type filter hook forward priority filter; policy accept;
+        ct state established meta l4proto { tcp, udp } flow add @ft
+    }
+    chain postrouting {
+        type nat hook postrouting priority srcnat; policy accept;
+        ip saddr ${UE_SUBNET} oifname != "${TUN_DEV}" masquerade
+    }
+}
+EOF
+}
+
+nat_iptables() {
+    iptables -t nat -A POSTROUTING -s "${UE_SUBNET}" ! -o "${TUN_DEV}" -j MASQUERADE
+    iptables -I FORWARD 1 -j ACCEPT
+}
+
+nat_clear
+
+case "$MODE" in
+    off)
+        echo off
+        ;;
+    nftables)
+        nat_nftables
+        log "  NAT: nftables MASQUERADE + flowtable on ${TUN_DEV} ${N6_DEVS[*]}"
+        echo nftables
+        ;;
+    iptables)
+        nat_iptables
+        log "  NAT: iptables MASQUERADE for ${UE_SUBNET}"
+        echo iptables
+        ;;
+    auto)
+        if command -v nft >/dev/null 2>&1 && [ ${#N6_DEVS[@]} -gt 0 ] && nat_nftables 2>/dev/null; then
+            log "  NAT: nftables MASQUERADE + flowtable on ${TUN_DEV} ${N6_DEVS[*]}"
+            echo nftables
+        else
+            log "  NAT: nftables flowtable unavailable — iptables MASQUERADE for ${UE_SUBNET}"
+            nat_iptables
+            echo iptables
+        fi
+        ;;
+    *)
+        echo "upf-nat.sh: unknown mode '$MODE'" >&2
+        exit 1
+        ;;
+esac
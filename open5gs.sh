@@ -21,6 +21,8 @@
 #   ./open5gs.sh remove               # Remove all containers and volumes
 #   ./open5gs.sh status               # Show container status
 #   ./open5gs.sh logs [nf]            # Tail logs
+#   ./open5gs.sh events [type]        # Follow AMF events (gNB, UE, cnode, health)
+#   ./open5gs.sh profile amf --seconds 30 [--offcpu]  # Per-NF flamegraphs
 # ============================================================
 
 set -uo pipefail
@@ -88,6 +90,13 @@ wait_healthy() {
     return 1
 }
 
+# AMF event stream subscriber in open5gs-cp (NFs/amf/tools/amf-events.c)
+amf_events() {
+    docker exec open5gs-cp sh -c \
+        'exec /open5gs/amf-events --path "${AMF_EVSTREAM_SOCK:-/run/open5gs-amf-events.sock}" "$@"' \
+        amf-events "$@" 2>/dev/null
+}
+
 setup_sctp_forward() {
     cleanup_sctp_forward 2>/dev/null
     modprobe sctp 2>/dev/null || true
@@ -204,7 +213,8 @@ cmd_build() {
         hdr ""
 
         log "Step 1/3: Building all open5GS + UERANSIM from source..."
-        docker build -f Dockerfile.build-all -t "open5gs-builder:${OPEN5GS_VERSION}" .
+        docker build -f Dockerfile.build-all --build-arg OGS_MEMSTAT="${OGS_MEMSTAT:-0}" \
+            -t "open5gs-builder:${OPEN5GS_VERSION}" .
 
         log "Source build complete."
         log "Step 2/3: Extracting built binaries to build-output/..."
@@ -252,11 +262,13 @@ cmd_start() {
     local debug_mode=false
     local custom_mcc="" custom_mnc="" custom_tac=""
     local custom_sst="" custom_sd=""
+    local cpu_profile=false
 
     while [[ $# -gt 0 ]]; do
         case "$1" in
             --ueransim) with_ueransim=true ;;
             --debug)    debug_mode=true ;;
+            --cpu-profile) cpu_profile=true ;;
             --mcc)      custom_mcc="$2";  shift ;;
             --mnc)      custom_mnc="$2";  shift ;;
             --tac)      custom_tac="$2";  shift ;;
@@ -289,6 +301,18 @@ cmd_start() {
 
     mkdir -p logs/cp logs/upf
 
+    # CPU placement: the containers read the mounted $cfg_dir/cpu-profile.conf;
+    # host IRQ affinity (irq.* entries) can only be set from here
+    if [ "$cpu_profile" = true ]; then
+        export CPU_PROFILE=/etc/open5gs/cpu-profile.conf
+        log "Using CPU profile ${cfg_dir}/cpu-profile.conf"
+        if [ "$(id -u)" = "0" ]; then
+            ./consolidated/cpu-profile.sh irq "${cfg_dir}/cpu-profile.conf"
+        elif grep -q '^irq\.' "${cfg_dir}/cpu-profile.conf"; then
+            warn "irq.* entries need root — host IRQ affinity left unchanged"
+        fi
+    fi
+
     hdr ""
     hdr "  Starting open5GS 5G SA Core"
     hdr ""
@@ -316,7 +340,16 @@ cmd_start() {
 
     if [ "$with_ueransim" = true ]; then
         log "Starting UERANSIM gNB..."
+        local t_gnb
+        t_gnb=$(date +%s.%N)
         CONFIG_DIR="$cfg_dir" docker compose -f "$COMPOSE_FILE" --profile ueransim up -d ueransim
+        if amf_events --seq >/dev/null; then
+            if amf_events --after "$t_gnb" --wait gnb_up --timeout 30 >/dev/null; then
+                ok "gNB completed NG Setup"
+            else
+                warn "gNB did not complete NG Setup within 30s — ./open5gs.sh logs gnb"
+            fi
+        fi
     fi
 
     setup_sctp_forward
@@ -345,7 +378,7 @@ cmd_stop() {
     hdr "Stopping open5GS..."
     cleanup_sctp_forward 2>/dev/null || true
     cleanup_dataplane 2>/dev/null || true
-    docker compose -f "$COMPOSE_FILE" --profile ueransim down
+    docker compose -f "$COMPOSE_FILE" --profile ueransim --profile bench down
     ok "Stopped."
 }
 
@@ -353,7 +386,7 @@ cmd_remove() {
     hdr "Removing all open5GS containers and volumes..."
     cleanup_sctp_forward 2>/dev/null || true
     cleanup_dataplane 2>/dev/null || true
-    docker compose -f "$COMPOSE_FILE" --profile ueransim down -v --remove-orphans
+    docker compose -f "$COMPOSE_FILE" --profile ueransim --profile bench down -v --remove-orphans
     ok "Removed."
 }
 
@@ -494,6 +527,19 @@ cmd_logs() {
     fi
 }
 
+cmd_profile() {
+    local runner=()
+
+    if [ $# -eq 0 ]; then
+        echo "Usage: ./open5gs.sh profile <nf|all> ... [--seconds N] [--offcpu] [--freq HZ] [--unwind dwarf|fp] [--out DIR] [-- command ...]"
+        return 2
+    fi
+    # perf on the NF processes of another PID namespace needs root
+    [ "$(id -u)" = 0 ] || runner=(sudo)
+    log "Profiling: $*"
+    "${runner[@]}" ./tools/profile/profile.sh "$@"
+}
+
 cmd_provision() {
     local imsi_plain="${IMSI#imsi-}"
 
@@ -562,16 +608,22 @@ cmd_provision() {
 
 cmd_bulk_provision() {
     local count=5
-    local same_key=false
     local start_imsi="${IMSI#imsi-}"
     local start_key="$K"
+    local dnn="$DNN" batch=1000
+    local extra=() key_step=byte
 
     while [[ $# -gt 0 ]]; do
         case "$1" in
             --count)      count="$2";      shift ;;
-            --same-key)   same_key=true ;;
+            --same-key)   extra+=(--same-key) ;;
+            --key-full)   key_step=full ;;
             --imsi)       start_imsi="$2"; shift ;;
             --key)        start_key="$2";  shift ;;
+            --dnn)        dnn="$2";        shift ;;
+            --batch)      batch="$2";      shift ;;
+            --engine)     extra+=(--engine "$2"); shift ;;
+            --template)   extra+=(--template "$2"); shift ;;
         esac
         shift
     done
@@ -579,72 +631,31 @@ cmd_bulk_provision() {
     hdr ""
     hdr "  Bulk provisioning ${count} subscribers"
     hdr ""
+    log "  IMSI: ${start_imsi} .. (+$((count - 1)))  DNN: ${dnn}  batch: ${batch}"
+
+    # js: one mongosh connection, unordered insertMany batches.  image: BSON
+    # stamped from a compiled template, piped into mongorestore.  K's last
+    # byte is incremented per subscriber (mod 256) unless --same-key;
+    # --key-full increments the whole K instead
+    local summary
+    summary=$(./tools/provision/bulk-provision.sh --count "$count" \
+        --imsi "$start_imsi" --key "$start_key" --opc "$OPC" \
+        --sst "$SST" --sd "$SD" --dnn "$dnn" --batch "$batch" \
+        --key-step "$key_step" "${extra[@]}" \
+        | while IFS= read -r line; do
+            case "$line" in '{"count"'*) echo "$line" ;; *) log "$line" >&2 ;; esac
+        done)
+    if [ -z "$summary" ]; then
+        err "Bulk provision failed (is open5gs-mongodb running?)"
+        return 1
+    fi
 
-    local imsi_num="${start_imsi: -10}"  # last 10 digits
-    local imsi_prefix="${start_imsi:0:${#start_imsi}-10}"
-
-    for i in $(seq 0 $((count - 1))); do
-        local cur_imsi="${imsi_prefix}$(printf '%010d' $((10#$imsi_num + i)))"
-        local cur_k="$start_key"
-        if [ "$same_key" = false ]; then
-            # Increment last byte of key
-            local key_end="${start_key: -2}"
-            local key_start="${start_key:0:${#start_key}-2}"
-            cur_k="${key_start}$(printf '%02x' $(( (16#${key_end} + i) % 256 )))"
-        fi
-
-        docker exec open5gs-mongodb mongosh 'mongodb://localhost:27017/open5gs' --quiet --eval "
-            db.subscribers.deleteOne({ imsi: '${cur_imsi}' });
-            db.subscribers.insertOne({
-                imsi: '${cur_imsi}',
-                subscribed_rau_tau_timer: 12,
-                network_access_mode: 0,
-                subscriber_status: 0,
-                access_restriction_data: 32,
-                slice: [{
-                    sst: ${SST},
-                    sd: '${SD}',
-                    default_indicator: true,
-                    session: [{
-                        name: '${DNN}',
-                        type: 3,
-                        pcc_rule: [],
-                        ambr: {
-                            uplink:   { value: 1, unit: 3 },
-                            downlink: { value: 1, unit: 3 }
-                        },
-                        qos: {
-                            index: 9,
-                            arp: {
-                                priority_level: 8,
-                                pre_emption_capability: 1,
-                                pre_emption_vulnerability: 1
-                            }
-                        }
-                    }]
-                }],
-                ambr: {
-                    uplink:   { value: 1, unit: 3 },
-                    downlink: { value: 1, unit: 3 }
-                },
-                security: {
-                    k:   '${cur_k^^}',
-                    opc: '${OPC^^}',
-                    amf: '${AMF_FIELD}',
-                    sqn: NumberLong(32)
-                },
-                schema_version: 1,
-                __v: 0
-            });
-            print('Provisioned: ${cur_imsi}');
-        " 2>/dev/null && ok "  [${cur_imsi}]" || warn "  [${cur_imsi}] FAILED"
-    done
-
-    local total
-    total=$(docker exec open5gs-mongodb mongosh 'mongodb://localhost:27017/open5gs' \
-        --quiet --eval "db.subscribers.countDocuments()" 2>/dev/null | tail -1)
+    local per_sec secs total
+    per_sec=$(echo "$summary" | grep -o '"per_sec":[0-9]*' | cut -d: -f2)
+    secs=$(echo "$summary" | grep -o '"seconds":[0-9.]*' | cut -d: -f2)
+    total=$(echo "$summary" | grep -o '"total":[0-9]*' | cut -d: -f2)
     hdr ""
-    ok "Bulk provision complete. Total subscribers: ${total}"
+    ok "Provisioned ${count} subscribers in ${secs}s (${per_sec}/s). Total subscribers: ${total}"
     hdr ""
 }
 
@@ -655,8 +666,20 @@ cmd_ue() {
     case "$sub_cmd" in
         start)
             log "Starting UERANSIM UE..."
+            local t_ue
+            t_ue=$(date +%s.%N)
             docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue.yaml
-            sleep 3
+            if amf_events --seq >/dev/null; then
+                # Returns as soon as the AMF has the Registration Complete
+                if amf_events --after "$t_ue" --wait ue_registered \
+                        --match "\"imsi-${IMSI#imsi-}\"" --timeout 15 >/dev/null; then
+                    ok "UE imsi-${IMSI#imsi-} registered"
+                else
+                    warn "UE imsi-${IMSI#imsi-} not registered within 15s"
+                fi
+            else
+                sleep 3
+            fi
             log "Checking UE status..."
             docker exec open5gs-ueransim ./nr-cli imsi-${IMSI#imsi-} --exec "status" 2>/dev/null || \
                 log "UE CLI not yet available, check logs: ./open5gs.sh logs gnb"
@@ -675,6 +698,16 @@ cmd_ue() {
     esac
 }
 
+cmd_events() {
+    local args=()
+    [ -n "${1:-}" ] && args=(--type "$1")
+    if ! amf_events --seq >/dev/null; then
+        err "AMF event stream not available (AMF_EVSTREAM_ENABLE=1 and a rebuilt image needed)"
+        return 1
+    fi
+    amf_events ${args[@]+"${args[@]}"}
+}
+
 cmd_help() {
     hdr ""
     hdr "  open5gs.sh - open5GS 5G SA Core Manager"
@@ -689,12 +722,14 @@ cmd_help() {
     echo "    start --debug             Start with debug logging"
     echo "    start --mcc X --mnc Y --tac Z  Custom PLMN"
     echo "    start --sst X --sd Y           Custom slice (SST/SD)"
+    echo "    start --cpu-profile       Pin NFs/UPF threads per config/cpu-profile.conf"
     echo "    stop                      Stop all containers"
     echo "    remove                    Remove containers + volumes"
     echo ""
     echo "  ${BOLD}Subscriber commands:${NC}"
     echo "    provision                 Provision default subscriber"
-    echo "    bulk-provision --count N  Provision N subscribers"
+    echo "    bulk-provision --count N  Provision N subscribers (--same-key --key-full --dnn internet,ims --batch B)"
+    echo "    bulk-provision --count N --engine image   ... from a compiled BSON template (10^5+)"
     echo ""
     echo "  ${BOLD}UE commands:${NC}"
     echo "    ue start                  Launch UE simulator"
@@ -704,6 +739,8 @@ cmd_help() {
     echo "  ${BOLD}Monitor commands:${NC}"
     echo "    status                    Show full system status"
     echo "    logs [nf]                 Tail logs (nf: amf/smf/upf/nrf/ausf/udm/udr/pcf/nssf/bsf/gnb)"
+    echo "    events [type]             Follow AMF events as JSON (gnb_up, ue_registered, cnode, health, ...)"
+    echo "    profile <nf|all> --seconds N  perf CPU flamegraphs per NF (--offcpu: blocked time too)"
     hdr ""
     echo "  ${BOLD}Default PLMN:${NC}  MCC=${MCC} MNC=${MNC} TAC=${TAC}"
     echo "  ${BOLD}Default IMSI:${NC}  ${IMSI}"
@@ -723,6 +760,8 @@ case "${1:-help}" in
     remove)         cmd_remove ;;
     status)         cmd_status ;;
     logs)           cmd_logs "${2:-}" ;;
+    events)         cmd_events "${2:-}" ;;
+    profile)        cmd_profile "${@:2}" ;;
     provision)      cmd_provision ;;
     bulk-provision) cmd_bulk_provision "${@:2}" ;;
     ue)             cmd_ue "${@:2}" ;;
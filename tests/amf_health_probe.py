@@ -0,0 +1,427 @@
+#!/usr/bin/env python3
+"""
+amf_health_probe.py — Client for the AMF health endpoint (amf-health.c).
+
+Speaks all three transports served on port 50051:
+
+  TCP  [varint: N][N bytes: HealthCheckRequest]  →  [varint: N][HealthCheckResponse]
+       (one connection per probe; the AMF closes after replying —
+        unless the request sets watch=true, then it keeps pushing a
+        response on every status / load_bucket transition: --watch)
+
+  UDP  [HealthCheckRequest { service, nonce }]   →  [HealthCheckResponse { ..., nonce }]
+       (one datagram per probe; the nonce is echoed so replies can be matched)
+
+  gRPC grpc.health.v1.Health/Check over cleartext HTTP/2 (AMF_GRPC_ENABLE=1)
+       (minimal built-in h2c client — no grpcio needed; --watch streams
+        /Watch and prints every status push)
+
+Usage:
+  # One TCP probe
+  python3 tests/amf_health_probe.py --host 10.200.100.16
+
+  # 1000 UDP probes, 64 in flight, report RTT percentiles
+  python3 tests/amf_health_probe.py --host 10.200.100.16 --udp --count 1000 --window 64
+
+  # Machine-readable summary
+  python3 tests/amf_health_probe.py --host 10.200.100.16 --udp --count 200 --json
+
+  # grpc.health.v1 Check, then follow /Watch for 30 s
+  python3 tests/amf_health_probe.py --host 10.200.100.16 --grpc --count 10
+  python3 tests/amf_health_probe.py --host 10.200.100.16 --grpc --watch 30
+
+  # Raw TCP subscription, pushes rate-limited to one per 500 ms, JSON lines
+  python3 tests/amf_health_probe.py --host 10.200.100.16 --watch 30 \
+      --min-interval 500 --json
+
+Exit status: 0 if every probe returned SERVING, 1 otherwise.
+"""
+
+import argparse
+import json
+import os
+import select
+import socket
+import struct
+import sys
+import time
+
+STATUS_NAMES = {0: "UNKNOWN", 1: "SERVING", 2: "NOT_SERVING"}
+
+
+# ── Proto helpers (hand-coded, no external library) ───────────────────────────
+
+def varint_encode(v: int) -> bytes:
+    out = bytearray()
+    while True:
+        b = v & 0x7F
+        v >>= 7
+        if v:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def varint_decode(data: bytes, i: int):
+    val, shift = 0, 0
+    while i < len(data):
+        b = data[i]; i += 1
+        val |= (b & 0x7F) << shift
+        shift += 7
+        if not (b & 0x80):
+            return val, i
+    raise ValueError("truncated varint")
+
+
+def encode_request(service: str = "", nonce=None, watch: bool = False,
+                   min_interval_ms: int = 0) -> bytes:
+    """HealthCheckRequest { service = 1; nonce = 2 (fixed64);
+                            watch = 3; min_interval_ms = 4 }"""
+    out = b""
+    if service:
+        s = service.encode()
+        out += b"\x0a" + varint_encode(len(s)) + s
+    if nonce is not None:
+        out += b"\x11" + struct.pack("<Q", nonce)
+    if watch:
+        out += b"\x18\x01"
+    if min_interval_ms:
+        out += b"\x20" + varint_encode(min_interval_ms)
+    return out
+
+
+def decode_response(data: bytes) -> dict:
+    """HealthCheckResponse { status=1, node_type=2, ip=3, port=4, nonce=5,
+                             load_bucket=6 }"""
+    msg, i = {}, 0
+    while i < len(data):
+        tag = data[i]; i += 1
+        field, wt = tag >> 3, tag & 0x07
+        if wt == 0:
+            val, i = varint_decode(data, i)
+            msg[{1: "status", 2: "node_type", 4: "port",
+                 6: "load_bucket"}.get(field, field)] = val
+        elif wt == 1:
+            msg["nonce" if field == 5 else field] = struct.unpack_from("<Q", data, i)[0]
+            i += 8
+        elif wt == 2:
+            n, i = varint_decode(data, i)
+            val = data[i:i + n]; i += n
+            msg["ip" if field == 3 else field] = val.decode(errors="replace")
+        elif wt == 5:
+            i += 4
+        else:
+            raise ValueError(f"unsupported wire type {wt}")
+    return msg
+
+
+# ── Transports ────────────────────────────────────────────────────────────────
+
+def probe_tcp(host: str, port: int, timeout: float) -> dict:
+    """One TCP probe: connect, send HealthCheckRequest{}, read delimited reply."""
+    t0 = time.perf_counter()
+    with socket.create_connection((host, port), timeout=timeout) as s:
+        req = encode_request()
+        s.sendall(varint_encode(len(req)) + req)
+        buf = b""
+        while True:
+            chunk = s.recv(256)
+            if not chunk:
+                break
+            buf += chunk
+    n, i = varint_decode(buf, 0)
+    msg = decode_response(buf[i:i + n])
+    msg["rtt_us"] = (time.perf_counter() - t0) * 1e6
+    return msg
+
+
+def watch_tcp(host: str, port: int, duration: float, min_interval_ms: int,
+              timeout: float):
+    """Subscribe on the raw TCP port for `duration` s; yields (unix_t, msg)
+    for the initial response and every pushed transition."""
+    deadline = time.monotonic() + duration
+    with socket.create_connection((host, port), timeout=timeout) as s:
+        req = encode_request(watch=True, min_interval_ms=min_interval_ms)
+        s.sendall(varint_encode(len(req)) + req)
+        buf = b""
+        while True:
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return
+            s.settimeout(left)
+            try:
+                chunk = s.recv(512)
+            except socket.timeout:
+                return
+            if not chunk:
+                return
+            buf += chunk
+            while buf:
+                try:
+                    n, i = varint_decode(buf, 0)
+                except ValueError:
+                    break
+                if len(buf) < i + n:
+                    break
+                yield time.time(), decode_response(buf[i:i + n])
+                buf = buf[i + n:]
+
+
+def probe_udp(host: str, port: int, count: int, window: int, timeout: float):
+    """Pipeline `count` UDP probes with up to `window` outstanding.
+    Returns (replies, lost) where replies is a list of decoded messages."""
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.connect((host, port))
+    s.setblocking(False)
+
+    pending = {}            # nonce → send time
+    replies, sent, lost = [], 0, 0
+    base = int.from_bytes(os.urandom(8), "little")
+
+    while sent < count or pending:
+        while sent < count and len(pending) < window:
+            nonce = (base + sent) & 0xFFFFFFFFFFFFFFFF
+            s.send(encode_request(nonce=nonce))
+            pending[nonce] = time.perf_counter()
+            sent += 1
+
+        r, _, _ = select.select([s], [], [], timeout)
+        if not r:
+            lost += len(pending)
+            pending.clear()
+            continue
+
+        while True:
+            try:
+                data = s.recv(512)
+            except BlockingIOError:
+                break
+            now = time.perf_counter()
+            try:
+                msg = decode_response(data)
+            except ValueError:
+                continue
+            t_sent = pending.pop(msg.get("nonce"), None)
+            if t_sent is None:
+                continue        # stale or spoofed — nonce does not match
+            msg["rtt_us"] = (now - t_sent) * 1e6
+            replies.append(msg)
+
+    s.close()
+    return replies, lost
+
+
+# ── gRPC over h2c (just enough HTTP/2 for grpc.health.v1) ─────────────────────
+
+H2_PREFACE = b"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+H2_DATA, H2_HEADERS, H2_RST, H2_SETTINGS, H2_PING, H2_GOAWAY = 0, 1, 3, 4, 6, 7
+H2_END_STREAM, H2_ACK, H2_END_HEADERS = 0x1, 0x1, 0x4
+
+
+def h2_frame(ftype: int, flags: int, sid: int, payload: bytes = b"") -> bytes:
+    return (struct.pack(">I", len(payload))[1:] + bytes([ftype, flags])
+            + struct.pack(">I", sid) + payload)
+
+
+def hpack_literal(name: str, value: str) -> bytes:
+    """Literal header field without indexing, new name, no Huffman."""
+    n, v = name.encode(), value.encode()
+    return b"\x00" + bytes([len(n)]) + n + bytes([len(v)]) + v
+
+
+def grpc_open(host: str, port: int, method: str, timeout: float,
+              service: str = ""):
+    """Open an h2c connection and start one grpc.health.v1 call (stream 1)."""
+    s = socket.create_connection((host, port), timeout=timeout)
+    hdrs = b"".join(hpack_literal(k, v) for k, v in (
+        (":method", "POST"), (":scheme", "http"),
+        (":path", f"/grpc.health.v1.Health/{method}"),
+        (":authority", f"{host}:{port}"),
+        ("content-type", "application/grpc"), ("te", "trailers")))
+    msg = encode_request(service)
+    s.sendall(H2_PREFACE + h2_frame(H2_SETTINGS, 0, 0)
+              + h2_frame(H2_HEADERS, H2_END_HEADERS, 1, hdrs)
+              + h2_frame(H2_DATA, H2_END_STREAM, 1,
+                         b"\x00" + struct.pack(">I", len(msg)) + msg))
+    return s
+
+
+def grpc_messages(s):
+    """Yield decoded HealthCheckResponse dicts from stream 1 until it ends."""
+    buf, data = b"", b""
+
+    def need(n):
+        nonlocal buf
+        while len(buf) < n:
+            chunk = s.recv(4096)
+            if not chunk:
+                raise EOFError("connection closed")
+            buf += chunk
+
+    while True:
+        need(9)
+        length = int.from_bytes(buf[0:3], "big")
+        ftype, flags = buf[3], buf[4]
+        sid = int.from_bytes(buf[5:9], "big") & 0x7FFFFFFF
+        need(9 + length)
+        payload, buf = buf[9:9 + length], buf[9 + length:]
+
+        if ftype == H2_SETTINGS and not flags & H2_ACK:
+            s.sendall(h2_frame(H2_SETTINGS, H2_ACK, 0))
+        elif ftype == H2_PING and not flags & H2_ACK:
+            s.sendall(h2_frame(H2_PING, H2_ACK, 0, payload))
+        elif ftype == H2_DATA and sid == 1:
+            data += payload
+            while len(data) >= 5:
+                n = int.from_bytes(data[1:5], "big")
+                if len(data) < 5 + n:
+                    break
+                yield decode_response(data[5:5 + n])
+                data = data[5 + n:]
+            if payload:     # keep the server's send window open for Watch
+                s.sendall(h2_frame(8, 0, 0, struct.pack(">I", len(payload)))
+                          + h2_frame(8, 0, 1, struct.pack(">I", len(payload))))
+        if (sid == 1 and flags & H2_END_STREAM) or ftype in (H2_RST, H2_GOAWAY):
+            return
+
+
+def probe_grpc(host: str, port: int, timeout: float) -> dict:
+    """One grpc.health.v1 Check on a fresh h2c connection."""
+    t0 = time.perf_counter()
+    with grpc_open(host, port, "Check", timeout) as s:
+        for msg in grpc_messages(s):
+            msg["rtt_us"] = (time.perf_counter() - t0) * 1e6
+            return msg
+    raise ValueError("Check returned no message (grpc-status != OK)")
+
+
+def watch_grpc(host: str, port: int, duration: float, timeout: float):
+    """Follow grpc.health.v1 Watch for `duration` s; yields (t, msg)."""
+    t0 = time.monotonic()
+    with grpc_open(host, port, "Watch", timeout) as s:
+        s.settimeout(max(0.1, duration))
+        try:
+            for msg in grpc_messages(s):
+                yield time.monotonic() - t0, msg
+                s.settimeout(max(0.1, duration - (time.monotonic() - t0)))
+        except socket.timeout:
+            return
+
+
+# ── Reporting ─────────────────────────────────────────────────────────────────
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return 0.0
+    k = min(len(sorted_vals) - 1, int(round(p / 100.0 * (len(sorted_vals) - 1))))
+    return sorted_vals[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="AMF health endpoint probe")
+    parser.add_argument("--host",    default="10.200.100.16",
+                        help="AMF health address (default: 10.200.100.16)")
+    parser.add_argument("--port",    type=int, default=50051,
+                        help="Health port (default: 50051)")
+    parser.add_argument("--udp",     action="store_true",
+                        help="Use the UDP fast-probe instead of TCP")
+    parser.add_argument("--grpc",    action="store_true",
+                        help="Use grpc.health.v1 over h2c instead of raw TCP")
+    parser.add_argument("--watch",   type=float, metavar="SECS", default=0,
+                        help="Subscribe for SECS and print every pushed status "
+                             "(raw TCP watch, or gRPC Watch with --grpc)")
+    parser.add_argument("--min-interval", type=int, metavar="MS", default=0,
+                        help="Raw TCP watch: at most one push per MS (default: 0)")
+    parser.add_argument("--count",   type=int, default=1,
+                        help="Number of probes (default: 1)")
+    parser.add_argument("--window",  type=int, default=16,
+                        help="UDP probes in flight (default: 16)")
+    parser.add_argument("--timeout", type=float, default=2.0,
+                        help="Per-probe timeout in seconds (default: 2.0)")
+    parser.add_argument("--json",    action="store_true",
+                        help="Print a JSON summary instead of text")
+    args = parser.parse_args()
+
+    if args.watch > 0 and not args.grpc:
+        pushes = 0
+        try:
+            for t, msg in watch_tcp(args.host, args.port, args.watch,
+                                    args.min_interval, args.timeout):
+                pushes += 1
+                name = STATUS_NAMES.get(msg.get("status", 0), "UNKNOWN")
+                if args.json:
+                    print(json.dumps({"t": round(t, 6), "status": name,
+                                      "load_bucket": msg.get("load_bucket")}),
+                          flush=True)
+                else:
+                    print(f"[probe] {time.strftime('%H:%M:%S', time.localtime(t))}"
+                          f".{int(t * 1000) % 1000:03d} watch status={name} "
+                          f"load_bucket={msg.get('load_bucket')}", flush=True)
+        except OSError as e:
+            print(f"[probe] watch failed: {e}", file=sys.stderr)
+        sys.exit(0 if pushes else 1)
+
+    if args.grpc and args.watch > 0:
+        pushes = 0
+        for t, msg in watch_grpc(args.host, args.port, args.watch, args.timeout):
+            pushes += 1
+            print(f"[probe] +{t:7.3f}s Watch "
+                  f"status={STATUS_NAMES.get(msg.get('status', 0), 'UNKNOWN')}",
+                  flush=True)
+        sys.exit(0 if pushes else 1)
+
+    replies, lost = [], 0
+    t0 = time.perf_counter()
+    if args.udp:
+        replies, lost = probe_udp(args.host, args.port, args.count,
+                                  args.window, args.timeout)
+    else:
+        probe = probe_grpc if args.grpc else probe_tcp
+        for _ in range(args.count):
+            try:
+                replies.append(probe(args.host, args.port, args.timeout))
+            except (OSError, ValueError, EOFError) as e:
+                print(f"[probe] {'gRPC' if args.grpc else 'TCP'} probe failed: {e}",
+                      file=sys.stderr)
+                lost += 1
+    elapsed = time.perf_counter() - t0
+
+    rtts = sorted(m["rtt_us"] for m in replies)
+    serving = sum(1 for m in replies if m.get("status") == 1)
+    summary = {
+        "transport": "udp" if args.udp else ("grpc" if args.grpc else "tcp"),
+        "host": args.host, "port": args.port,
+        "sent": args.count, "received": len(replies), "lost": lost,
+        "serving": serving,
+        "probes_per_sec": round(len(replies) / elapsed, 1) if elapsed > 0 else 0,
+        "rtt_us": {
+            "p50": round(percentile(rtts, 50), 1),
+            "p99": round(percentile(rtts, 99), 1),
+            "max": round(rtts[-1], 1) if rtts else 0,
+        },
+    }
+    if replies:
+        last = replies[-1]
+        summary["status"] = STATUS_NAMES.get(last.get("status", 0), "UNKNOWN")
+        summary["node_type"] = last.get("node_type")
+        summary["ip"] = last.get("ip")
+
+    if args.json:
+        print(json.dumps(summary))
+    else:
+        print(f"[probe] {summary['transport'].upper()} {args.host}:{args.port}  "
+              f"sent={args.count} received={len(replies)} lost={lost} "
+              f"serving={serving}")
+        if replies:
+            print(f"[probe] status={summary['status']} node_type={summary['node_type']} "
+                  f"ip={summary['ip']}")
+            print(f"[probe] rtt p50={summary['rtt_us']['p50']}us "
+                  f"p99={summary['rtt_us']['p99']}us max={summary['rtt_us']['max']}us  "
+                  f"({summary['probes_per_sec']} probes/s)")
+
+    sys.exit(0 if replies and serving == args.count else 1)
+
+
+if __name__ == "__main__":
+    main()
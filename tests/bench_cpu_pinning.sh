@@ -0,0 +1,198 @@
+#!/bin/bash
+# ============================================================
+# bench_cpu_pinning.sh — per-NF latency, unpinned vs CPU profile
+# ============================================================
+# Runs the stack twice, once with CPU_PROFILE=off and once with the
+# mounted config/cpu-profile.conf (consolidated/cpu-profile.sh).  Each
+# run restarts open5gs-cp and open5gs-upf, keeps BENCH_UES UEs
+# re-registering in UERANSIM as background load, and meanwhile probes
+# every NF's main loop:
+#
+#   SBI NFs   HTTP/2 GET over one h2c connection per NF (curl), timed
+#             per request; every NF answers on its own event loop, an
+#             unknown API with an error
+#   UPF       GTP-U Echo Request → Echo Response on N3 (port 2152)
+#
+# Reports p50 / p99 latency per NF and mode.  Restores the original
+# CPU_PROFILE when done.
+#
+# Usage: tests/bench_cpu_pinning.sh
+# Env:   BENCH_UES       UEs re-registering as load (default: 20)
+#        BENCH_SAMPLES   probes per NF and mode (default: 500)
+#        BENCH_CHURN     seconds between UE restarts (default: 5)
+#
+# Needs docker, a built stack, curl with HTTP/2 and python3 on the host.
+# ============================================================
+
+source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
+
+BENCH_UES="${BENCH_UES:-20}"
+BENCH_SAMPLES="${BENCH_SAMPLES:-500}"
+BENCH_CHURN="${BENCH_CHURN:-5}"
+PROFILE=/etc/open5gs/cpu-profile.conf
+ORIG_PROFILE="${CPU_PROFILE:-off}"
+workdir_init bench_cpu_pinning
+
+NFS=(nrf scp amf smf pcf nssf ausf udm udr bsf upf)
+declare -A SBI_PORT=(
+    [nrf]=7777 [scp]=7778 [amf]=7780 [smf]=7781 [pcf]=7782
+    [nssf]=7783 [ausf]=7784 [udm]=7785 [udr]=7786 [bsf]=7787
+)
+
+header "Bench: per-NF latency — unpinned vs CPU profile"
+
+for tool in docker curl python3; do
+    if ! command -v $tool >/dev/null 2>&1; then
+        warn "$tool not installed — skipped"
+        exit 0
+    fi
+done
+if ! curl -V | grep -q HTTP2; then
+    warn "curl has no HTTP/2 support — skipped"
+    exit 0
+fi
+if [ ! -f "$CONFIG_DIR/cpu-profile.conf" ]; then
+    fail "no $CONFIG_DIR/cpu-profile.conf"
+    exit 1
+fi
+
+ensure_core_running
+
+# ── Helpers ──────────────────────────────────────────────────
+# restart_core <profile> — same order as open5gs.sh start: CP, then a
+# fresh UPF for a clean PFCP association, then the gNB
+restart_core() {
+    (cd "$PROJECT_DIR" && CONFIG_DIR=config CPU_PROFILE="$1" \
+        docker compose -f "$COMPOSE_FILE" up -d --force-recreate open5gs-cp >/dev/null 2>&1)
+    wait_cp_healthy 120 || return 1
+    (cd "$PROJECT_DIR" && CONFIG_DIR=config CPU_PROFILE="$1" \
+        docker compose -f "$COMPOSE_FILE" up -d --force-recreate open5gs-upf >/dev/null 2>&1)
+    docker restart open5gs-ueransim >/dev/null 2>&1
+    wait_gnb_connected 60
+}
+
+# UEs re-registering every BENCH_CHURN seconds until killed
+ue_churn() {
+    while :; do
+        docker exec -d open5gs-ueransim ./nr-ue -c ./config/bench-ue.yaml -n "$BENCH_UES"
+        sleep "$BENCH_CHURN"
+        docker exec open5gs-ueransim pkill -f "nr-ue" 2>/dev/null
+        sleep 1
+    done
+}
+
+# probe_sbi <port> — one latency in ms per line
+probe_sbi() {
+    local urls=() i
+    for (( i = 0; i < BENCH_SAMPLES; i++ )); do
+        urls+=("http://$CP_IP:$1/nnrf-nfm/v1/nf-instances?limit=1")
+    done
+    curl -s --http2-prior-knowledge --max-time 120 \
+        -w '%{stderr}%{time_total}\n' "${urls[@]}" 2>&1 >/dev/null \
+        | awk '/^[0-9.]+$/ { printf "%.3f\n", $1 * 1000 }'
+}
+
+# probe_upf — GTP-U echo round trips in ms, one per line
+probe_upf() {
+    python3 - "$UPF_IP" "$BENCH_SAMPLES" <<'PYEOF'
+import socket, struct, sys, time
+ip, n = sys.argv[1], int(sys.argv[2])
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.settimeout(1.0)
+for seq in range(n):
+    # GTPv1-U, S flag, Echo Request (type 1), seq number
+    req = struct.pack("!BBHIHBB", 0x32, 1, 4, 0, seq & 0xffff, 0, 0)
+    t0 = time.perf_counter()
+    s.sendto(req, (ip, 2152))
+    try:
+        while True:
+            buf, _ = s.recvfrom(512)
+            if len(buf) >= 10 and buf[1] == 2 and struct.unpack("!H", buf[8:10])[0] == seq & 0xffff:
+                break
+    except socket.timeout:
+        continue
+    print("%.3f" % ((time.perf_counter() - t0) * 1000))
+PYEOF
+}
+
+# pct <file> <p> — p-th percentile of one number per line
+pct() {
+    sort -n "$1" | awk -v p="$2" '{ v[NR] = $1 }
+        END { if (NR) { i = int(NR * p / 100 + 0.5); if (i < 1) i = 1; print v[i] } }'
+}
+
+teardown() {
+    docker exec open5gs-ueransim pkill -f "nr-ue" 2>/dev/null
+    info "Restoring CPU_PROFILE=$ORIG_PROFILE"
+    restart_core "$ORIG_PROFILE" >/dev/null
+}
+on_exit teardown
+on_exit 'kill $CHURN_PID 2>/dev/null'
+
+# ── Load: BENCH_UES subscribers sharing one key (nr-ue -n) ───
+info "Provisioning ${BENCH_UES} subscribers..."
+provision_subscribers "$BENCH_UES" internet same-key >/dev/null ||
+    { fail "provisioning failed"; exit 1; }
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "$WORKDIR/bench-ue.yaml" "internet"
+
+# ── Runs ─────────────────────────────────────────────────────
+for mode in off profile; do
+    prof=off
+    [ "$mode" = profile ] && prof=$PROFILE
+    info "Run: CPU_PROFILE=$prof — restarting CP and UPF"
+    if ! restart_core "$prof"; then
+        fail "$mode: core did not come back"
+        exit 1
+    fi
+    [ "$mode" = profile ] &&
+        cp_startup_timeline | awk 'NR > 2 && NF >= 9 { printf "%s=%s ", $1, $NF } END { print "" }' \
+            | { read -r l; info "CP NF CPUs: $l"; }
+    docker cp "$WORKDIR/bench-ue.yaml" open5gs-ueransim:/ueransim/config/bench-ue.yaml
+
+    ue_churn > /dev/null 2>&1 &
+    CHURN_PID=$!
+    sleep "$BENCH_CHURN"
+    info "Probing ${#NFS[@]} NFs, ${BENCH_SAMPLES} samples each, ${BENCH_UES} UEs re-registering"
+    for nf in "${NFS[@]}"; do
+        if [ "$nf" = upf ]; then
+            probe_upf > "$WORKDIR/$mode.$nf"
+        else
+            probe_sbi "${SBI_PORT[$nf]}" > "$WORKDIR/$mode.$nf"
+        fi
+    done
+    kill $CHURN_PID 2>/dev/null
+    wait $CHURN_PID 2>/dev/null
+    docker exec open5gs-ueransim pkill -f "nr-ue" 2>/dev/null
+done
+
+# ── Report ───────────────────────────────────────────────────
+echo ""
+printf "  %-5s %10s %10s   %10s %10s\n" "" "unpinned" "" "profile" ""
+printf "  %-5s %10s %10s   %10s %10s\n" NF "p50 ms" "p99 ms" "p50 ms" "p99 ms"
+for nf in "${NFS[@]}"; do
+    printf "  %-5s %10s %10s   %10s %10s\n" "$nf" \
+        "$(pct "$WORKDIR/off.$nf" 50)" "$(pct "$WORKDIR/off.$nf" 99)" \
+        "$(pct "$WORKDIR/profile.$nf" 50)" "$(pct "$WORKDIR/profile.$nf" 99)"
+    perf_record bench_cpu_pinning "${nf}_p99_ms_unpinned" "$(pct "$WORKDIR/off.$nf" 99)" ms lower
+    perf_record bench_cpu_pinning "${nf}_p99_ms_profile" "$(pct "$WORKDIR/profile.$nf" 99)" ms lower
+done
+echo ""
+
+# AMF, SMF and the UPF are the NFs the profile separates: their tail
+# latency under load must not get worse
+RC=0
+for nf in "${NFS[@]}"; do
+    if [ ! -s "$WORKDIR/off.$nf" ] || [ ! -s "$WORKDIR/profile.$nf" ]; then
+        fail "$nf: no answers to the latency probe"
+        RC=1
+        continue
+    fi
+    case "$nf" in amf|smf|upf) ;; *) continue ;; esac
+    b=$(pct "$WORKDIR/off.$nf" 99); a=$(pct "$WORKDIR/profile.$nf" 99)
+    if awk -v a="$a" -v b="$b" 'BEGIN { exit !(a < b) }'; then
+        pass "$nf: p99 ${b} → ${a} ms with the CPU profile"
+    else
+        warn "$nf: no p99 gain (${b} → ${a} ms) — fewer CPUs than the profile expects?"
+    fi
+done
+exit $RC
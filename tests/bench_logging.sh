@@ -0,0 +1,209 @@
+#!/bin/bash
+# ============================================================
+# bench_logging.sh — synchronous vs asynchronous NF logging
+# ============================================================
+# Part 1 (offline): `ogs-alog-bench` logs AMF-shaped records through each
+# backend and times the call on the logging thread:
+#
+#   sync    upstream ogs-log.c: format, fprintf() + fflush() per line
+#   text    NFs/core/ogs-alog.c, same lines written by the writer thread
+#   binary  NFs/core/ogs-alog.c, records to .alog, formatted offline by
+#           open5gs-logfmt
+#
+# and checks that all three produce the same lines.
+#
+# Part 2 (needs the stack): UE registration rate with tests/ue_load.sh,
+# once per run below, restarting open5gs-cp between runs:
+#
+#   info:off     config/, upstream logging
+#   debug:off    config-debug/, upstream logging
+#   debug:text   config-debug/, OGS_ALOG=text
+#
+# (binary is not run there: ue_load.sh reads the text amf.log.)  Restores
+# CONFIG_DIR=config and the compose default OGS_ALOG when done.
+#
+# Usage: tests/bench_logging.sh [--offline]
+# Env:   BENCH_RECORDS   records per thread in part 1 (default: 200000)
+#        BENCH_THREADS   logging threads in part 1 (default: 1, one NF loop)
+#        BENCH_PACE_US   sleep between calls in part 1 (default: 2; 0 =
+#                        burst, expect drops)
+#        BENCH_UES       UEs per run in part 2 (default: 200)
+#        BENCH_RATE      registrations/s in part 2 (default: 100)
+#        OGS_ALOG_BENCH  path to ogs-alog-bench (default: build-output or
+#                        compiled from NFs/core with gcc); open5gs-logfmt
+#                        is found or built next to it
+# ============================================================
+
+source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
+
+BENCH_RECORDS="${BENCH_RECORDS:-200000}"
+BENCH_THREADS="${BENCH_THREADS:-1}"
+BENCH_PACE_US="${BENCH_PACE_US:-2}"
+BENCH_UES="${BENCH_UES:-200}"
+BENCH_RATE="${BENCH_RATE:-100}"
+OFFLINE=0
+[ "$1" = "--offline" ] && OFFLINE=1
+workdir_init bench_logging
+RESTORE=0
+
+header "Bench: NF logging — synchronous vs asynchronous ring"
+
+BIN="$PROJECT_DIR/build-output/open5gs/bin"
+BENCH="${OGS_ALOG_BENCH:-$BIN/ogs-alog-bench}"
+LOGFMT="$(dirname "$BENCH")/open5gs-logfmt"
+if [ ! -x "$BENCH" ] || [ ! -x "$LOGFMT" ]; then
+    BENCH="$WORKDIR/ogs-alog-bench"
+    LOGFMT="$WORKDIR/open5gs-logfmt"
+    info "Building ogs-alog-bench and open5gs-logfmt from NFs/core"
+    gcc -O2 -Wall -pthread -I "$PROJECT_DIR/NFs/core" -o "$BENCH" \
+        "$PROJECT_DIR/NFs/core/tools/ogs-alog-bench.c" \
+        "$PROJECT_DIR/NFs/core/ogs-alog.c" || { fail "build failed"; exit 1; }
+    gcc -O2 -Wall -I "$PROJECT_DIR/NFs/core" -o "$LOGFMT" \
+        "$PROJECT_DIR/NFs/core/tools/open5gs-logfmt.c" || { fail "build failed"; exit 1; }
+fi
+
+# restart_cp <config dir> <OGS_ALOG> — CP, then a fresh UPF for a clean
+# PFCP association, then the gNB (as bench_cpu_pinning.sh)
+restart_cp() {
+    (cd "$PROJECT_DIR" && CONFIG_DIR="$1" OGS_ALOG="$2" \
+        docker compose -f "$COMPOSE_FILE" up -d --force-recreate open5gs-cp >/dev/null 2>&1)
+    wait_cp_healthy 120 || return 1
+    (cd "$PROJECT_DIR" && CONFIG_DIR="$1" \
+        docker compose -f "$COMPOSE_FILE" up -d --force-recreate open5gs-upf >/dev/null 2>&1)
+    docker restart open5gs-ueransim >/dev/null 2>&1
+    wait_gnb_connected 60
+}
+
+teardown() {
+    [ "$RESTORE" = 1 ] || return
+    info "Restoring CONFIG_DIR=config, default OGS_ALOG"
+    (cd "$PROJECT_DIR" && unset OGS_ALOG && CONFIG_DIR=config \
+        docker compose -f "$COMPOSE_FILE" up -d --force-recreate open5gs-cp >/dev/null 2>&1)
+    wait_cp_healthy 120 >/dev/null
+    (cd "$PROJECT_DIR" && CONFIG_DIR=config \
+        docker compose -f "$COMPOSE_FILE" up -d --force-recreate open5gs-upf >/dev/null 2>&1)
+    docker restart open5gs-ueransim >/dev/null 2>&1
+}
+on_exit teardown
+
+# jget <key> <file> — field from the JSON summary line
+jget() { grep -o "\"$1\":\"\\?[0-9.a-z]*" "$2" | tail -1 | cut -d: -f2 | tr -d '"'; }
+
+RC=0
+
+# ── Part 1: cost per log call ────────────────────────────────
+MODES=(sync text binary)
+for m in "${MODES[@]}"; do
+    info "Run: $m, ${BENCH_THREADS} thread(s) x ${BENCH_RECORDS} records, pace ${BENCH_PACE_US} us"
+    "$BENCH" --mode "$m" --threads "$BENCH_THREADS" --records "$BENCH_RECORDS" \
+        --pace-us "$BENCH_PACE_US" --out "$WORKDIR/$m.log" > "$WORKDIR/$m.json" 2>&1
+done
+
+echo ""
+printf "  %-7s %10s %10s %10s %12s %10s %9s\n" MODE "mean ns" "p50 ns" "p99 ns" "on disk ms" MB dropped
+for m in "${MODES[@]}"; do
+    f="$WORKDIR/$m.json"
+    if ! grep -q '"mean_ns"' "$f"; then
+        printf "  %-7s %s\n" "$m" "no result — $(tail -1 "$f")"
+        continue
+    fi
+    printf "  %-7s %10s %10s %10s %12s %10s %9s\n" "$m" "$(jget mean_ns "$f")" \
+        "$(jget p50_ns "$f")" "$(jget p99_ns "$f")" "$(jget drained_ms "$f")" \
+        "$(awk -v b="$(jget bytes "$f")" 'BEGIN { printf "%.1f", b / 1048576 }')" \
+        "$(jget dropped "$f")"
+    perf_record bench_logging "${m}_call_p50_ns" "$(jget p50_ns "$f")" ns lower
+    perf_record bench_logging "${m}_call_p99_ns" "$(jget p99_ns "$f")" ns lower
+done
+echo ""
+
+for m in "${MODES[@]}"; do
+    grep -q '"mean_ns"' "$WORKDIR/$m.json" || { fail "$m: no result"; RC=1; }
+done
+[ $RC -eq 0 ] || exit $RC
+
+# Same lines from every backend (timestamps cut), unless records were dropped
+"$LOGFMT" "$WORKDIR/binary.alog" > "$WORKDIR/binary.txt"
+sum() { cut -c21- "$1" | sort | md5sum | cut -d' ' -f1; }
+if [ "$(jget dropped "$WORKDIR/text.json")" != 0 ] ||
+   [ "$(jget dropped "$WORKDIR/binary.json")" != 0 ]; then
+    warn "records dropped (ring full) — output not compared; raise BENCH_PACE_US"
+elif [ "$(sum "$WORKDIR/sync.log")" = "$(sum "$WORKDIR/text.log")" ] &&
+     [ "$(sum "$WORKDIR/sync.log")" = "$(sum "$WORKDIR/binary.txt")" ]; then
+    pass "text and formatted binary output match upstream's $(wc -l < "$WORKDIR/sync.log") lines"
+else
+    fail "async output differs from upstream's lines"
+    diff <(cut -c21- "$WORKDIR/sync.log" | sort) <(cut -c21- "$WORKDIR/text.log" | sort) | head -5
+    RC=1
+fi
+
+b=$(jget p50_ns "$WORKDIR/sync.json")
+for m in text binary; do
+    a=$(jget p50_ns "$WORKDIR/$m.json")
+    if awk -v a="$a" -v b="$b" 'BEGIN { exit !(a < b) }'; then
+        pass "$m: log call p50 ${b} → ${a} ns, p99 $(jget p99_ns "$WORKDIR/sync.json") → $(jget p99_ns "$WORKDIR/$m.json") ns"
+    else
+        warn "$m: no gain over sync (p50 ${b} → ${a} ns)"
+    fi
+done
+
+[ "$OFFLINE" = 1 ] && exit $RC
+if ! command -v docker >/dev/null 2>&1; then
+    warn "docker not installed — registration runs skipped"
+    exit $RC
+fi
+
+# ── Part 2: registration rate, debug logging on vs off ───────
+ensure_core_running
+RESTORE=1
+RUNS=(info:off debug:off debug:text)
+for run in "${RUNS[@]}"; do
+    level=${run%%:*}; alog=${run##*:}
+    cfg=config
+    [ "$level" = debug ] && cfg=config-debug
+    info "Run: $level logging, OGS_ALOG=$alog — restarting CP"
+    if ! restart_cp "$cfg" "$alog"; then
+        fail "$run: core did not come back"
+        exit 1
+    fi
+    "$TESTS_DIR/ue_load.sh" --ues "$BENCH_UES" --rate "$BENCH_RATE" \
+        --json "$WORKDIR/$run.reg.json" > "$WORKDIR/$run.reg.out" 2>&1 ||
+        warn "$run: not every UE registered"
+    kill_all_ues
+done
+
+echo ""
+printf "  %-11s %10s %10s %10s\n" RUN "reg/s" "p50 ms" "p99 ms"
+for run in "${RUNS[@]}"; do
+    read -r achieved p50 p99 < <(python3 - "$WORKDIR/$run.reg.json" <<'PYEOF' 2>/dev/null
+import json, sys
+r = json.load(open(sys.argv[1]))
+d = r["registration_ms"] or {}
+g = lambda v: "-" if v is None else v
+print(g(r["achieved_per_sec"]), g(d.get("p50")), g(d.get("p99")))
+PYEOF
+)
+    printf "  %-11s %10s %10s %10s\n" "$run" "${achieved:--}" "${p50:--}" "${p99:--}"
+    key=${run/:/_}
+    perf_record bench_logging "${key}_reg_per_sec" "${achieved:--}" reg/s higher
+    perf_record bench_logging "${key}_reg_p99_ms" "${p99:--}" ms lower
+    eval "ACH_${key}=\"${achieved:--}\""
+done
+echo ""
+
+for run in "${RUNS[@]}"; do
+    key=${run/:/_}
+    v="ACH_${key}"
+    if [ "${!v}" = "-" ]; then
+        fail "$run: no registration result"
+        tail -3 "$WORKDIR/$run.reg.out" | sed 's/^/    /'
+        RC=1
+    fi
+done
+[ $RC -eq 0 ] || exit $RC
+
+if awk -v a="$ACH_debug_text" -v b="$ACH_debug_off" 'BEGIN { exit !(a >= b) }'; then
+    pass "debug logging: ${ACH_debug_off} → ${ACH_debug_text} reg/s with OGS_ALOG=text (info: ${ACH_info_off})"
+else
+    warn "debug logging: no gain with OGS_ALOG=text (${ACH_debug_off} → ${ACH_debug_text} reg/s)"
+fi
+exit $RC
@@ -0,0 +1,135 @@
+#!/bin/bash
+# ============================================================
+# bench_upf_hugepage.sh — UPF packet pool on 4 KB vs 2 MB pages (offline)
+# ============================================================
+# Replays the access pattern of the UPF's packet pool (gtp-path.c
+# packet_pool: 2 KB clusters + headers handed out in FIFO ring order, one
+# packet copied in and its GTP-U / inner IPv4 headers read back) with
+# `upf-mq-bench pool`, once per backing of NFs/upf/upf-hugepage.c:
+#
+#   heap     4 KB pages (what upstream malloc() gives the pool)
+#   thp      transparent huge pages (MADV_HUGEPAGE)
+#   hugetlb  explicit 2 MB pages (memfd MFD_HUGETLB)
+#
+# Reports Mpps, Gbit/s copied and dTLB misses per packet (perf_event_open;
+# shown as n/a on VMs without a PMU).  As root, reserves the hugetlb pages
+# for the run and restores vm.nr_hugepages afterwards; otherwise hugetlb
+# runs only if enough pages are already free.
+#
+# Usage: tests/bench_upf_hugepage.sh [backing ...]   (default: heap thp hugetlb)
+# Env:   BENCH_POOL_MB  pool size in MB (default: 256)
+#        BENCH_SECONDS  seconds per run (default: 5)
+#        BENCH_SIZE     packet size in bytes (default: 1400)
+#        UPF_MQ_BENCH   path to upf-mq-bench (default: build-output or
+#                       compiled from NFs/upf with gcc)
+# ============================================================
+
+source "$(dirname "$0")/common.sh"
+
+BENCH_POOL_MB="${BENCH_POOL_MB:-256}"
+BENCH_SECONDS="${BENCH_SECONDS:-5}"
+BENCH_SIZE="${BENCH_SIZE:-1400}"
+workdir_init bench_upf_hugepage
+NR_HUGEPAGES=/proc/sys/vm/nr_hugepages
+HP_SAVED=""
+
+header "Bench: UPF packet pool — 4 KB vs THP vs hugetlb pages"
+
+if [ $# -gt 0 ]; then
+    MODES=("$@")
+else
+    MODES=(heap thp hugetlb)
+fi
+
+BENCH="${UPF_MQ_BENCH:-$PROJECT_DIR/build-output/open5gs/bin/upf-mq-bench}"
+if [ ! -x "$BENCH" ]; then
+    BENCH="$WORKDIR/upf-mq-bench"
+    info "Building upf-mq-bench from NFs/upf"
+    gcc -O2 -Wall -pthread -I "$PROJECT_DIR/NFs/upf" -o "$BENCH" \
+        "$PROJECT_DIR/NFs/upf/tools/upf-mq-bench.c" \
+        "$PROJECT_DIR/NFs/upf/upf-mq-dp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-n3.c" \
+        "$PROJECT_DIR/NFs/upf/upf-xdp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-hugepage.c" || { fail "build failed"; exit 1; }
+fi
+
+teardown() {
+    [ -n "$HP_SAVED" ] && echo "$HP_SAVED" > $NR_HUGEPAGES
+}
+on_exit teardown
+
+# jget <key> <file> — field from the JSON summary line
+jget() { grep -o "\"$1\":\"\\?[0-9.a-z]*" "$2" | tail -1 | cut -d: -f2 | tr -d '"'; }
+# dtlb <file> — dTLB misses per packet, empty without a PMU
+dtlb() { jget dtlb_per_pkt "$1" | grep -v null; }
+
+# ── hugetlb reservation ──────────────────────────────────────
+need=$(( BENCH_POOL_MB / 2 + 4 ))
+free_hp=$(awk '/HugePages_Free/ { print $2 }' /proc/meminfo)
+if [[ " ${MODES[*]} " == *" hugetlb "* ]] && [ "${free_hp:-0}" -lt "$need" ]; then
+    if [ "$(id -u)" = "0" ] && [ -w $NR_HUGEPAGES ]; then
+        HP_SAVED=$(cat $NR_HUGEPAGES)
+        echo $(( HP_SAVED + need - free_hp )) > $NR_HUGEPAGES
+        free_hp=$(awk '/HugePages_Free/ { print $2 }' /proc/meminfo)
+        info "Reserved 2 MB pages: $free_hp free (vm.nr_hugepages was $HP_SAVED)"
+    fi
+    [ "${free_hp:-0}" -lt "$need" ] &&
+        warn "only ${free_hp:-0} of $need 2 MB pages free — hugetlb will fall back"
+fi
+
+# ── Runs ─────────────────────────────────────────────────────
+for m in "${MODES[@]}"; do
+    info "Run: $m, ${BENCH_POOL_MB} MB pool, ${BENCH_SIZE} B packets, ${BENCH_SECONDS}s"
+    "$BENCH" pool --mem "$m" --pool-mb "$BENCH_POOL_MB" --size "$BENCH_SIZE" \
+        --seconds "$BENCH_SECONDS" > "$WORKDIR/$m.log" 2>&1
+done
+
+# ── Report ───────────────────────────────────────────────────
+echo ""
+printf "  %-8s %-8s %8s %8s %14s\n" ASKED GOT Mpps Gbit/s "dTLB miss/pkt"
+for m in "${MODES[@]}"; do
+    f="$WORKDIR/$m.log"
+    if ! grep -q '"mpps"' "$f"; then
+        printf "  %-8s %s\n" "$m" "no result — $(tail -1 "$f")"
+        continue
+    fi
+    t=$(dtlb "$f")
+    printf "  %-8s %-8s %8s %8s %14s\n" "$m" "$(jget mem "$f")" \
+        "$(jget mpps "$f")" "$(jget gbps "$f")" "${t:-n/a}"
+    perf_record bench_upf_hugepage "$(jget mem "$f")_mpps" "$(jget mpps "$f")" Mpps higher
+done
+echo ""
+
+# 2 MB pages must cut dTLB misses (when counted) or raise throughput
+RC=0
+base="$WORKDIR/heap.log"
+if [ ! -f "$base" ]; then
+    pass "pool runs completed for: ${MODES[*]}"
+    exit 0
+elif ! grep -q '"mpps"' "$base"; then
+    fail "heap: no result"
+    exit 1
+fi
+for m in thp hugetlb; do
+    f="$WORKDIR/$m.log"
+    [ -f "$f" ] || continue
+    got=$(jget mem "$f")
+    if [ -z "$got" ]; then
+        fail "$m: no result"
+        RC=1
+    elif [ "$got" != "$m" ]; then
+        warn "$m: not available, fell back to $got"
+    elif [ -n "$(dtlb "$base")" ]; then
+        b=$(dtlb "$base"); a=$(dtlb "$f")
+        if awk -v a="$a" -v b="$b" 'BEGIN { exit !(a < b) }'; then
+            pass "$m: dTLB misses/pkt $b → $a, $(jget mpps "$base") → $(jget mpps "$f") Mpps"
+        else
+            warn "$m: no dTLB gain ($b → $a misses/pkt)"
+        fi
+    elif awk -v a="$(jget mpps "$f")" -v b="$(jget mpps "$base")" 'BEGIN { exit !(a > b) }'; then
+        pass "$m: $(jget mpps "$base") → $(jget mpps "$f") Mpps (no PMU for dTLB counts)"
+    else
+        warn "$m: no throughput gain ($(jget mpps "$base") → $(jget mpps "$f") Mpps, no PMU for dTLB counts)"
+    fi
+done
+exit $RC
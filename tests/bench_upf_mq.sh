@@ -0,0 +1,182 @@
+#!/bin/bash
+# ============================================================
+# bench_upf_mq.sh — Multi-queue ogstun N3 downlink scaling (offline)
+# ============================================================
+# Runs the UPF's multi-queue datapath (NFs/upf/upf-mq-dp.c, via the
+# upf-mq-bench harness) between three network namespaces and measures
+# iperf3 TCP throughput for 1 worker vs N workers.  No containers needed.
+#
+#   mqb-dn  (iperf3 clients)
+#     │ veth 10.77.6.0/24
+#   mqb-upf  mqbtun: multi_queue tun, 10.206.0.1/16 (= ogstun)
+#            upf-mq-bench upf: queues → workers → GTP-U
+#     │ veth 10.77.3.0/24 (N3)
+#   mqb-gnb  upf-mq-bench gnb: GTP-U → gnbtun, which holds the UE IPs
+#            (iperf3 servers, one per UE)
+#
+# Uplink (TCP ACKs) is routed plainly gnb → upf → dn; only the downlink
+# goes through GTP-U, which is the path the workers parallelise.
+#
+# Usage: sudo tests/bench_upf_mq.sh [workers ...]   (default: 1 and nproc-1)
+# Env:   BENCH_UES      UE count / parallel iperf3 streams (default: 8)
+#        BENCH_SECONDS  iperf3 duration per run (default: 10)
+#        UPF_MQ_BENCH   path to upf-mq-bench (default: build-output or
+#                       compiled from NFs/upf with gcc)
+#
+# Needs root, iproute2, iperf3 and /dev/net/tun.
+# ============================================================
+
+source "$(dirname "$0")/common.sh"
+
+BENCH_UES="${BENCH_UES:-8}"
+BENCH_SECONDS="${BENCH_SECONDS:-10}"
+UE_FIRST="10.206.0.2"
+GNB_N3="10.77.3.2"
+NS_DN=mqb-dn
+NS_UPF=mqb-upf
+NS_GNB=mqb-gnb
+workdir_init bench_upf_mq
+
+header "Bench: multi-queue ogstun N3 downlink scaling"
+
+# ── Prerequisites ────────────────────────────────────────────
+if [ "$(id -u)" != "0" ]; then
+    warn "needs root (network namespaces) — skipped"
+    exit 0
+fi
+if ! command -v iperf3 >/dev/null 2>&1; then
+    warn "iperf3 not installed — skipped (apt-get install iperf3)"
+    exit 0
+fi
+if [ ! -c /dev/net/tun ]; then
+    warn "/dev/net/tun missing — skipped"
+    exit 0
+fi
+
+BENCH="${UPF_MQ_BENCH:-$PROJECT_DIR/build-output/open5gs/bin/upf-mq-bench}"
+if [ ! -x "$BENCH" ]; then
+    BENCH="$WORKDIR/upf-mq-bench"
+    info "Building upf-mq-bench from NFs/upf"
+    gcc -O2 -Wall -pthread -I "$PROJECT_DIR/NFs/upf" -o "$BENCH" \
+        "$PROJECT_DIR/NFs/upf/tools/upf-mq-bench.c" \
+        "$PROJECT_DIR/NFs/upf/upf-mq-dp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-n3.c" \
+        "$PROJECT_DIR/NFs/upf/upf-xdp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-hugepage.c" || { fail "build failed"; exit 1; }
+fi
+
+if [ $# -gt 0 ]; then
+    WORKERS=("$@")
+else
+    NPROC=$(nproc)
+    WORKERS=(1)
+    [ "$NPROC" -gt 2 ] && WORKERS+=($(( NPROC - 1 > 8 ? 8 : NPROC - 1 )))
+    [ "$NPROC" -le 2 ] && WORKERS+=(2)
+fi
+
+# ue_ip <index> → 10.206.0.(2+i)
+ue_ip() { echo "10.206.$(( (2 + $1) / 256 )).$(( (2 + $1) % 256 ))"; }
+
+teardown() {
+    local ns
+    for ns in $NS_DN $NS_UPF $NS_GNB; do
+        ip netns pids $ns 2>/dev/null | xargs -r kill 2>/dev/null
+        ip netns del $ns 2>/dev/null
+    done
+}
+on_exit teardown
+teardown
+
+# ── Topology ─────────────────────────────────────────────────
+info "Creating namespaces $NS_DN ↔ $NS_UPF ↔ $NS_GNB ($BENCH_UES UEs)"
+for ns in $NS_DN $NS_UPF $NS_GNB; do
+    ip netns add $ns
+    ip -n $ns link set lo up
+    ip netns exec $ns sysctl -qw net.ipv4.conf.all.rp_filter=0 net.ipv4.conf.default.rp_filter=0
+done
+
+ip link add n6u netns $NS_UPF type veth peer name n6d netns $NS_DN
+ip link add n3u netns $NS_UPF type veth peer name n3g netns $NS_GNB
+ip -n $NS_DN  addr add 10.77.6.2/24 dev n6d
+ip -n $NS_UPF addr add 10.77.6.1/24 dev n6u
+ip -n $NS_UPF addr add 10.77.3.1/24 dev n3u
+ip -n $NS_GNB addr add $GNB_N3/24 dev n3g
+ip -n $NS_DN  link set n6d up
+ip -n $NS_UPF link set n6u up
+ip -n $NS_UPF link set n3u up
+ip -n $NS_GNB link set n3g up
+ip -n $NS_DN route add default via 10.77.6.1
+ip -n $NS_GNB route add 10.77.6.0/24 via 10.77.3.1
+ip netns exec $NS_UPF sysctl -qw net.ipv4.ip_forward=1
+
+# UPF side: multi_queue tun owning the UE subnet, like ogstun
+ip -n $NS_UPF tuntap add name mqbtun mode tun multi_queue
+ip -n $NS_UPF addr add 10.206.0.1/16 dev mqbtun
+ip -n $NS_UPF link set mqbtun mtu 1400 up
+
+# gNB side: decap into gnbtun, which holds the UE addresses
+ip netns exec $NS_GNB "$BENCH" gnb --tun gnbtun --threads 8 \
+    > "$WORKDIR/gnb.log" 2>&1 &
+for _ in $(seq 1 50); do ip -n $NS_GNB link show gnbtun >/dev/null 2>&1 && break; sleep 0.1; done
+ip -n $NS_GNB link set gnbtun mtu 1400 up
+for i in $(seq 0 $(( BENCH_UES - 1 ))); do
+    ip -n $NS_GNB addr add "$(ue_ip $i)/32" dev gnbtun
+    ip netns exec $NS_GNB iperf3 -s -B "$(ue_ip $i)" -p $(( 5201 + i )) -D
+done
+sleep 0.5
+
+# ── Runs ─────────────────────────────────────────────────────
+declare -A RESULT
+for w in "${WORKERS[@]}"; do
+    # worker q on CPU q (mod nproc), as the UPF does by default
+    CPUS=$(for q in $(seq 1 "$w"); do echo $(( q % $(nproc) )); done | paste -sd,)
+    info "Run: $w worker(s) on CPUs $CPUS, $BENCH_UES streams, ${BENCH_SECONDS}s"
+    ip netns exec $NS_UPF "$BENCH" upf --tun mqbtun --workers "$w" --cpus "$CPUS" \
+        --ue $UE_FIRST --ues "$BENCH_UES" --gnb $GNB_N3 \
+        > "$WORKDIR/upf-$w.log" 2>&1 &
+    BPID=$!
+    sleep 0.5
+    if ! kill -0 $BPID 2>/dev/null; then
+        fail "upf-mq-bench did not start:"
+        sed 's/^/    /' "$WORKDIR/upf-$w.log"
+        exit 1
+    fi
+
+    CPIDS=()
+    for i in $(seq 0 $(( BENCH_UES - 1 ))); do
+        ip netns exec $NS_DN iperf3 -c "$(ue_ip $i)" -p $(( 5201 + i )) \
+            -t "$BENCH_SECONDS" -J > "$WORKDIR/iperf-$w-$i.json" 2>&1 &
+        CPIDS+=($!)
+    done
+    wait "${CPIDS[@]}"
+
+    kill $BPID 2>/dev/null; wait $BPID 2>/dev/null
+    RESULT[$w]=$(cat "$WORKDIR"/iperf-$w-*.json | awk '
+        /"sum_received"/ { r = 1 }
+        r && /"bits_per_second"/ { gsub(/[,}]/, "", $2); s += $2; r = 0 }
+        END { printf "%.2f", s / 1e9 }')
+    info "  $(tail -1 "$WORKDIR/upf-$w.log")"
+    info "  ${RESULT[$w]} Gbit/s"
+done
+
+# ── Report ───────────────────────────────────────────────────
+echo ""
+printf "  %-8s %12s %8s\n" WORKERS "Gbit/s" SCALE
+BASE=${RESULT[${WORKERS[0]}]}
+for w in "${WORKERS[@]}"; do
+    printf "  %-8s %12s %7sx\n" "$w" "${RESULT[$w]}" \
+        "$(awk -v a="${RESULT[$w]}" -v b="$BASE" 'BEGIN { printf "%.2f", (b > 0) ? a / b : 0 }')"
+    perf_record bench_upf_mq "dl_gbps_${w}w" "${RESULT[$w]}" Gbit/s higher
+done
+echo ""
+
+LAST=${WORKERS[${#WORKERS[@]}-1]}
+if awk -v a="${RESULT[$LAST]}" -v b="$BASE" 'BEGIN { exit !(b > 0 && a > b * 1.2) }'; then
+    pass "N3 downlink scales with workers (${BASE} → ${RESULT[$LAST]} Gbit/s)"
+elif awk -v b="$BASE" 'BEGIN { exit !(b > 0) }'; then
+    warn "no scaling from ${WORKERS[0]} to $LAST workers — check CPU count / pinning"
+else
+    fail "no traffic measured"
+    workdir_keep
+    exit 1
+fi
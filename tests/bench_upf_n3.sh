@@ -0,0 +1,179 @@
+#!/bin/bash
+# ============================================================
+# bench_upf_n3.sh — Batched GTP-U I/O before/after (offline)
+# ============================================================
+# Measures the UPF N3 paths with a local packet generator, once as
+# upstream does it (one datagram per syscall) and once batched:
+#
+#   uplink    gNB → N3 → decap → ogstun            (NFs/upf/upf-n3.c)
+#             before: recvmmsg batch 1, no GRO
+#             after:  recvmmsg batch 32 + UDP GRO
+#   downlink  ogstun → encap → N3 → gNB             (NFs/upf/upf-mq-dp.c)
+#             before: 1 worker, batch 1, no GSO
+#             after:  1 worker, batch 32 + UDP GSO
+#
+#   n3b-gnb  pktgen gtpu (uplink load) / sink (downlink end point)
+#     │ veth 10.77.3.0/24 (N3)
+#   n3b-upf  n3btun (multi_queue, 10.206.0.1/16) + upf-mq-bench n3rx / upf
+#     │ veth 10.77.6.0/24 (N6)
+#   n3b-dn   pktgen udp (downlink load to the UE IPs)
+#
+# Reports Mpps and CPU seconds per Gbit for the UPF-side process.  The
+# generator runs at full speed and shares the host's CPUs, so compare
+# CPU/Gbit between rows rather than absolute Mpps on small hosts.
+#
+# Usage: sudo tests/bench_upf_n3.sh
+# Env:   BENCH_UES      UEs / TEIDs (default: 64)
+#        BENCH_SECONDS  seconds per run (default: 5)
+#        BENCH_SIZE     inner packet size in bytes (default: 1400)
+#        UPF_MQ_BENCH   path to upf-mq-bench (default: build-output or
+#                       compiled from NFs/upf with gcc)
+# ============================================================
+
+source "$(dirname "$0")/common.sh"
+
+BENCH_UES="${BENCH_UES:-64}"
+BENCH_SECONDS="${BENCH_SECONDS:-5}"
+BENCH_SIZE="${BENCH_SIZE:-1400}"
+UE_FIRST="10.206.0.2"
+NS_GNB=n3b-gnb
+NS_UPF=n3b-upf
+NS_DN=n3b-dn
+workdir_init bench_upf_n3
+
+header "Bench: batched GTP-U I/O (recvmmsg/GRO, sendmmsg/GSO)"
+
+if [ "$(id -u)" != "0" ]; then
+    warn "needs root (network namespaces) — skipped"
+    exit 0
+fi
+if [ ! -c /dev/net/tun ]; then
+    warn "/dev/net/tun missing — skipped"
+    exit 0
+fi
+
+BENCH="${UPF_MQ_BENCH:-$PROJECT_DIR/build-output/open5gs/bin/upf-mq-bench}"
+if [ ! -x "$BENCH" ]; then
+    BENCH="$WORKDIR/upf-mq-bench"
+    info "Building upf-mq-bench from NFs/upf"
+    gcc -O2 -Wall -pthread -I "$PROJECT_DIR/NFs/upf" -o "$BENCH" \
+        "$PROJECT_DIR/NFs/upf/tools/upf-mq-bench.c" \
+        "$PROJECT_DIR/NFs/upf/upf-mq-dp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-n3.c" \
+        "$PROJECT_DIR/NFs/upf/upf-xdp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-hugepage.c" || { fail "build failed"; exit 1; }
+fi
+
+teardown() {
+    local ns
+    for ns in $NS_GNB $NS_UPF $NS_DN; do
+        ip netns pids $ns 2>/dev/null | xargs -r kill 2>/dev/null
+        ip netns del $ns 2>/dev/null
+    done
+}
+on_exit teardown
+teardown
+
+# jget <key> <file> — numeric field from the JSON summary line
+jget() { grep -o "\"$1\":[0-9.]*" "$2" | tail -1 | cut -d: -f2; }
+
+# ── Topology ─────────────────────────────────────────────────
+info "Creating namespaces $NS_GNB ↔ $NS_UPF ↔ $NS_DN"
+for ns in $NS_GNB $NS_UPF $NS_DN; do
+    ip netns add $ns
+    ip -n $ns link set lo up
+done
+ip link add n3u netns $NS_UPF type veth peer name n3g netns $NS_GNB
+ip link add n6u netns $NS_UPF type veth peer name n6d netns $NS_DN
+ip -n $NS_GNB addr add 10.77.3.2/24 dev n3g
+ip -n $NS_UPF addr add 10.77.3.1/24 dev n3u
+ip -n $NS_UPF addr add 10.77.6.1/24 dev n6u
+ip -n $NS_DN  addr add 10.77.6.2/24 dev n6d
+ip -n $NS_GNB link set n3g up
+ip -n $NS_UPF link set n3u up
+ip -n $NS_UPF link set n6u up
+ip -n $NS_DN  link set n6d up
+ip -n $NS_DN route add default via 10.77.6.1
+ip netns exec $NS_UPF sysctl -qw net.ipv4.ip_forward=1
+
+ip -n $NS_UPF tuntap add name n3btun mode tun multi_queue
+ip -n $NS_UPF addr add 10.206.0.1/16 dev n3btun
+ip -n $NS_UPF link set n3btun mtu 1400 up
+# Uplink inner packets go to a blackhole, so only the N3 → tun path is measured
+ip -n $NS_UPF route add blackhole 10.77.9.0/24
+
+# run_ul / run_dl <name> <upf-side options...> — with the matching load generator
+run_ul() {
+    local name="$1"; shift
+    ip netns exec $NS_UPF "$BENCH" n3rx --tun n3btun --ue $UE_FIRST \
+        --ues "$BENCH_UES" --seconds $(( BENCH_SECONDS + 1 )) "$@" \
+        > "$WORKDIR/$name.log" 2>&1 &
+    local pid=$!
+    sleep 0.5
+    ip netns exec $NS_GNB "$BENCH" pktgen --mode gtpu --dst 10.77.3.1 \
+        --ue $UE_FIRST --ues "$BENCH_UES" --size "$BENCH_SIZE" \
+        --inner-dst 10.77.9.9 --seconds "$BENCH_SECONDS" > "$WORKDIR/$name.gen" 2>&1
+    wait $pid
+}
+
+run_dl() {
+    local name="$1"; shift
+    ip netns exec $NS_GNB "$BENCH" sink --seconds $(( BENCH_SECONDS + 2 )) \
+        > "$WORKDIR/$name.sink" 2>&1 &
+    local spid=$!
+    ip netns exec $NS_UPF "$BENCH" upf --tun n3btun --workers 1 --ue $UE_FIRST \
+        --ues "$BENCH_UES" --gnb 10.77.3.2 --seconds $(( BENCH_SECONDS + 1 )) "$@" \
+        > "$WORKDIR/$name.log" 2>&1 &
+    local pid=$!
+    sleep 0.5
+    ip netns exec $NS_DN "$BENCH" pktgen --mode udp --ue $UE_FIRST \
+        --ues "$BENCH_UES" --size "$BENCH_SIZE" --seconds "$BENCH_SECONDS" \
+        > "$WORKDIR/$name.gen" 2>&1
+    wait $pid $spid
+}
+
+ROWS=(ul-before ul-after dl-before dl-after)
+info "Uplink before: batch 1, no GRO (${BENCH_SECONDS}s)"
+run_ul ul-before --batch 1 --gro 0
+info "Uplink after: batch 32 + GRO"
+run_ul ul-after --batch 32 --gro 1
+info "Downlink before: 1 worker, batch 1, no GSO"
+run_dl dl-before --batch 1 --gso 0
+info "Downlink after: 1 worker, batch 32 + GSO"
+run_dl dl-after --batch 32 --gso 1
+
+# ── Report ───────────────────────────────────────────────────
+echo ""
+printf "  %-10s %8s %8s %10s %12s %14s\n" RUN Mpps Gbit/s pkts/call CPU-s "CPU-s/Gbit"
+for r in "${ROWS[@]}"; do
+    f="$WORKDIR/$r.log"
+    if ! grep -q '"mpps"' "$f"; then
+        printf "  %-10s %s\n" "$r" "no result — $(tail -1 "$f")"
+        continue
+    fi
+    pkts=$(jget pkts "$f"); calls=$(jget syscalls "$f")
+    printf "  %-10s %8s %8s %10s %12s %14s\n" "$r" "$(jget mpps "$f")" \
+        "$(jget gbps "$f")" \
+        "$(awk -v p="$pkts" -v c="$calls" 'BEGIN { printf "%.1f", (c > 0) ? p / c : 0 }')" \
+        "$(jget cpu_s "$f")" "$(jget cpu_s_per_gbit "$f")"
+    perf_record bench_upf_n3 "${r}_mpps" "$(jget mpps "$f")" Mpps higher
+    perf_record bench_upf_n3 "${r}_cpu_s_per_gbit" "$(jget cpu_s_per_gbit "$f")" s lower
+done
+echo ""
+
+# Batched runs must need less CPU per Gbit than the per-datagram runs
+RC=0
+for d in ul dl; do
+    b=$(jget cpu_s_per_gbit "$WORKDIR/$d-before.log")
+    a=$(jget cpu_s_per_gbit "$WORKDIR/$d-after.log")
+    if [ -z "$a" ] || [ -z "$b" ] || [ "$(jget pkts "$WORKDIR/$d-after.log")" = "0" ]; then
+        fail "${d}: no traffic measured"
+        RC=1
+    elif awk -v a="$a" -v b="$b" 'BEGIN { exit !(a < b) }'; then
+        pass "${d}: CPU per Gbit ${b}s → ${a}s with batching"
+    else
+        warn "${d}: no CPU/Gbit gain (${b}s → ${a}s)"
+    fi
+done
+[ "$RC" != "0" ] && workdir_keep
+exit $RC
@@ -0,0 +1,191 @@
+#!/bin/bash
+# ============================================================
+# bench_upf_nat.sh — UE NAT: iptables MASQUERADE vs nftables flowtable
+# ============================================================
+# Applies consolidated/upf-nat.sh (the UPF container's NAT setup) in a
+# router namespace and measures UE → DN traffic through it, once per mode:
+#
+#   nb-ue   UE 10.206.0.2 (iperf3 client, UDP echo client)
+#     │ veth nbtun (stands in for ogstun, 10.206.0.1/16)
+#   nb-upf  upf-nat.sh <mode> 10.206.0.0/16 nbtun nbn6
+#     │ veth nbn6 10.77.6.1/24 (N6)
+#   nb-dn   10.77.6.2, no route back to 10.206/16 (iperf3 server, UDP echo)
+#
+# The DN only sees the UPF's N6 address, so every run also checks that
+# MASQUERADE works.  Reports iperf3 TCP Gbit/s (BENCH_STREAMS parallel
+# streams) and UDP request/response latency p50/p99, which includes the
+# same Python socket overhead in both modes.
+#
+# Usage: sudo tests/bench_upf_nat.sh [mode ...]   (default: iptables nftables)
+# Env:   BENCH_SECONDS  iperf3 duration per run (default: 10)
+#        BENCH_STREAMS  parallel TCP streams (default: 4)
+#        BENCH_RR       UDP request/response round trips (default: 5000)
+#
+# Needs root, iproute2, iperf3, python3, iptables and nft.
+# ============================================================
+
+source "$(dirname "$0")/common.sh"
+
+BENCH_SECONDS="${BENCH_SECONDS:-10}"
+BENCH_STREAMS="${BENCH_STREAMS:-4}"
+BENCH_RR="${BENCH_RR:-5000}"
+NS_UE=nb-ue
+NS_UPF=nb-upf
+NS_DN=nb-dn
+NAT_SH="$PROJECT_DIR/consolidated/upf-nat.sh"
+workdir_init bench_upf_nat
+
+header "Bench: UE NAT — iptables MASQUERADE vs nftables flowtable"
+
+if [ "$(id -u)" != "0" ]; then
+    warn "needs root (network namespaces) — skipped"
+    exit 0
+fi
+for tool in iperf3 python3; do
+    if ! command -v $tool >/dev/null 2>&1; then
+        warn "$tool not installed — skipped"
+        exit 0
+    fi
+done
+
+if [ $# -gt 0 ]; then
+    MODES=("$@")
+else
+    MODES=(iptables nftables)
+fi
+for m in "${MODES[@]}"; do
+    tool=$([ "$m" = nftables ] && echo nft || echo "$m")
+    if ! command -v "$tool" >/dev/null 2>&1; then
+        warn "$tool not installed — skipped (apt-get install iptables nftables)"
+        exit 0
+    fi
+done
+
+teardown() {
+    local ns
+    for ns in $NS_UE $NS_UPF $NS_DN; do
+        ip netns pids $ns 2>/dev/null | xargs -r kill 2>/dev/null
+        ip netns del $ns 2>/dev/null
+    done
+}
+on_exit teardown
+teardown
+
+# ── Topology ─────────────────────────────────────────────────
+info "Creating namespaces $NS_UE ↔ $NS_UPF ↔ $NS_DN"
+for ns in $NS_UE $NS_UPF $NS_DN; do
+    ip netns add $ns
+    ip -n $ns link set lo up
+done
+ip link add nbtun netns $NS_UPF type veth peer name nbue netns $NS_UE
+ip link add nbn6 netns $NS_UPF type veth peer name nbdn netns $NS_DN
+ip -n $NS_UE  addr add 10.206.0.2/16 dev nbue
+ip -n $NS_UPF addr add 10.206.0.1/16 dev nbtun
+ip -n $NS_UPF addr add 10.77.6.1/24 dev nbn6
+ip -n $NS_DN  addr add 10.77.6.2/24 dev nbdn
+ip -n $NS_UE  link set nbue up
+ip -n $NS_UPF link set nbtun up
+ip -n $NS_UPF link set nbn6 up
+ip -n $NS_DN  link set nbdn up
+ip -n $NS_UE route add default via 10.206.0.1
+ip netns exec $NS_UPF sysctl -qw net.ipv4.ip_forward=1
+
+# DN side: iperf3 server + UDP echo that records the peer address it saw
+ip netns exec $NS_DN iperf3 -s -D -p 5201
+cat > "$WORKDIR/rr.py" <<'PYEOF'
+import socket, sys, time
+if sys.argv[1] == "server":
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.bind(("0.0.0.0", 7777))
+    while True:
+        d, a = s.recvfrom(64)
+        if d == b"who":
+            d = a[0].encode()
+        try:
+            s.sendto(d, a)
+        except OSError:
+            pass                        # no route back: NAT not applied
+n = int(sys.argv[3])
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.settimeout(1.0)
+s.connect((sys.argv[2], 7777))
+s.send(b"who")
+try:
+    peer = s.recv(64).decode()
+except socket.timeout:
+    print('{"peer":"none"}')
+    sys.exit(1)
+lat, lost = [], 0
+for i in range(n):
+    t = time.perf_counter()
+    s.send(b"x" * 32)
+    try:
+        s.recv(64)
+    except socket.timeout:
+        lost += 1
+        continue
+    lat.append((time.perf_counter() - t) * 1e6)
+lat.sort()
+q = lambda p: lat[min(len(lat) - 1, int(len(lat) * p))] if lat else 0
+print('{"peer":"%s","p50_us":%.1f,"p99_us":%.1f,"lost":%d}' % (peer, q(0.5), q(0.99), lost))
+PYEOF
+ip netns exec $NS_DN python3 "$WORKDIR/rr.py" server &
+sleep 0.5
+
+# jget <key> <file> — field from a JSON summary line
+jget() { grep -o "\"$1\":\"\\?[0-9.a-z]*" "$2" | tail -1 | cut -d: -f2 | tr -d '"'; }
+
+# ── Runs ─────────────────────────────────────────────────────
+declare -A GBPS P50 P99 APPLIED
+for m in "${MODES[@]}"; do
+    APPLIED[$m]=$(ip netns exec $NS_UPF "$NAT_SH" "$m" 10.206.0.0/16 nbtun nbn6 2>&1 | tail -1)
+    info "Run: $m (applied: ${APPLIED[$m]}), $BENCH_STREAMS streams, ${BENCH_SECONDS}s"
+
+    ip netns exec $NS_UE python3 "$WORKDIR/rr.py" client 10.77.6.2 "$BENCH_RR" \
+        > "$WORKDIR/rr-$m.json" 2>&1
+    P50[$m]=$(jget p50_us "$WORKDIR/rr-$m.json")
+    P99[$m]=$(jget p99_us "$WORKDIR/rr-$m.json")
+    peer=$(jget peer "$WORKDIR/rr-$m.json")
+    if [ "$peer" != "10.77.6.1" ]; then
+        fail "$m: DN saw source '${peer:-none}', expected 10.77.6.1 (MASQUERADE)"
+        sed 's/^/    /' "$WORKDIR/rr-$m.json"
+        workdir_keep
+        exit 1
+    fi
+
+    ip netns exec $NS_UE iperf3 -c 10.77.6.2 -p 5201 -P "$BENCH_STREAMS" \
+        -t "$BENCH_SECONDS" -J > "$WORKDIR/iperf-$m.json" 2>&1
+    GBPS[$m]=$(awk '
+        /"sum_received"/ { r = 1 }
+        r && /"bits_per_second"/ { gsub(/[,}]/, "", $2); s = $2; r = 0 }
+        END { printf "%.2f", s / 1e9 }' "$WORKDIR/iperf-$m.json")
+    info "  ${GBPS[$m]} Gbit/s, UDP RR p50 ${P50[$m]}µs p99 ${P99[$m]}µs"
+done
+ip netns exec $NS_UPF "$NAT_SH" off 10.206.0.0/16 nbtun nbn6 >/dev/null 2>&1
+
+# ── Report ───────────────────────────────────────────────────
+echo ""
+printf "  %-10s %10s %10s %10s\n" MODE "Gbit/s" "p50 µs" "p99 µs"
+for m in "${MODES[@]}"; do
+    printf "  %-10s %10s %10s %10s\n" "${APPLIED[$m]}" "${GBPS[$m]}" "${P50[$m]}" "${P99[$m]}"
+    perf_record bench_upf_nat "${APPLIED[$m]}_gbps" "${GBPS[$m]}" Gbit/s higher
+    perf_record bench_upf_nat "${APPLIED[$m]}_rr_p50_us" "${P50[$m]}" us lower
+    perf_record bench_upf_nat "${APPLIED[$m]}_rr_p99_us" "${P99[$m]}" us lower
+done
+echo ""
+
+if [ -n "${GBPS[iptables]}" ] && [ -n "${GBPS[nftables]}" ]; then
+    if [ "${APPLIED[nftables]}" != "nftables" ]; then
+        warn "nftables flowtable not applied (kernel without nf_flow_table?)"
+    elif awk -v a="${GBPS[nftables]}" -v b="${GBPS[iptables]}" 'BEGIN { exit !(b > 0 && a > b) }'; then
+        pass "flowtable beats MASQUERADE chain (${GBPS[iptables]} → ${GBPS[nftables]} Gbit/s)"
+    elif awk -v b="${GBPS[iptables]}" 'BEGIN { exit !(b > 0) }'; then
+        warn "no throughput gain from the flowtable (${GBPS[iptables]} → ${GBPS[nftables]} Gbit/s)"
+    else
+        fail "no traffic measured"
+        workdir_keep
+        exit 1
+    fi
+else
+    pass "NAT verified for: ${MODES[*]}"
+fi
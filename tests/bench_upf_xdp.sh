@@ -0,0 +1,201 @@
+#!/bin/bash
+# ============================================================
+# bench_upf_xdp.sh — GTP-U in userspace vs XDP decap / TC encap (offline)
+# ============================================================
+# Measures the UPF N3 paths over veth with a local packet generator, once
+# through the batched userspace path and once through the in-kernel path
+# of NFs/upf/upf-xdp.c (generic XDP, as in the docker network):
+#
+#   uplink    gNB → N3 → decap → N6 → DN
+#             user: upf-mq-bench n3rx, recvmmsg batch 32 + GRO → tun
+#             xdp:  XDP on the N3 veth strips the outer headers
+#   downlink  DN → N6 → tun → encap → N3 → gNB
+#             user: upf-mq-bench upf, 1 worker, batch 32 + GSO
+#             xdp:  TC egress on the tun prepends the headers, redirects
+#
+#   xb-gnb  pktgen gtpu (uplink load) / sink :2152 (downlink end point)
+#     │ veth 10.77.3.0/24 (N3)
+#   xb-upf  xbtun (multi_queue, 10.206.0.1/16) + upf-mq-bench n3rx|upf|xdp
+#     │ veth 10.77.6.0/24 (N6)
+#   xb-dn   pktgen udp (downlink load) / sink :9 (uplink end point)
+#
+# Both generators send one datagram per message (no GSO): a gNB does not
+# send UDP GSO superpackets, and the XDP path leaves them to userspace.
+# Reports delivered Mpps / Gbit/s at the far sink and host CPU seconds per
+# delivered Gbit (from /proc/stat: kernel time is where XDP runs, so
+# per-process CPU would miss it).  Generator and sink run in every row.
+#
+# Usage: sudo tests/bench_upf_xdp.sh
+# Env:   BENCH_UES      UEs / TEIDs (default: 64)
+#        BENCH_SECONDS  seconds per run (default: 5)
+#        BENCH_SIZE     inner packet size in bytes (default: 1400)
+#        BENCH_XDP_MODE generic | native (default: generic)
+#        UPF_MQ_BENCH   path to upf-mq-bench (default: build-output or
+#                       compiled from NFs/upf with gcc)
+# ============================================================
+
+source "$(dirname "$0")/common.sh"
+
+BENCH_UES="${BENCH_UES:-64}"
+BENCH_SECONDS="${BENCH_SECONDS:-5}"
+BENCH_SIZE="${BENCH_SIZE:-1400}"
+BENCH_XDP_MODE="${BENCH_XDP_MODE:-generic}"
+UE_FIRST="10.206.0.2"
+NS_GNB=xb-gnb
+NS_UPF=xb-upf
+NS_DN=xb-dn
+workdir_init bench_upf_xdp
+
+header "Bench: GTP-U userspace vs XDP decap / TC encap"
+
+if [ "$(id -u)" != "0" ]; then
+    warn "needs root (network namespaces, BPF) — skipped"
+    exit 0
+fi
+if [ ! -c /dev/net/tun ]; then
+    warn "/dev/net/tun missing — skipped"
+    exit 0
+fi
+
+BENCH="${UPF_MQ_BENCH:-$PROJECT_DIR/build-output/open5gs/bin/upf-mq-bench}"
+if [ ! -x "$BENCH" ]; then
+    BENCH="$WORKDIR/upf-mq-bench"
+    info "Building upf-mq-bench from NFs/upf"
+    gcc -O2 -Wall -pthread -I "$PROJECT_DIR/NFs/upf" -o "$BENCH" \
+        "$PROJECT_DIR/NFs/upf/tools/upf-mq-bench.c" \
+        "$PROJECT_DIR/NFs/upf/upf-mq-dp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-n3.c" \
+        "$PROJECT_DIR/NFs/upf/upf-xdp.c" \
+        "$PROJECT_DIR/NFs/upf/upf-hugepage.c" || { fail "build failed"; exit 1; }
+fi
+
+teardown() {
+    local ns
+    for ns in $NS_GNB $NS_UPF $NS_DN; do
+        ip netns pids $ns 2>/dev/null | xargs -r kill 2>/dev/null
+        ip netns del $ns 2>/dev/null
+    done
+}
+on_exit teardown
+teardown
+
+# jget <key> <file> — numeric field from the JSON summary line
+jget() { grep -o "\"$1\":[0-9.]*" "$2" | tail -1 | cut -d: -f2; }
+
+# busy jiffies of the whole host (user + nice + system + irq + softirq)
+cpu_busy() { awk '/^cpu / { print $2 + $3 + $4 + $7 + $8 }' /proc/stat; }
+
+# ── Topology ─────────────────────────────────────────────────
+info "Creating namespaces $NS_GNB ↔ $NS_UPF ↔ $NS_DN"
+for ns in $NS_GNB $NS_UPF $NS_DN; do
+    ip netns add $ns
+    ip -n $ns link set lo up
+done
+ip link add xbn3u netns $NS_UPF type veth peer name xbn3g netns $NS_GNB
+ip link add xbn6u netns $NS_UPF type veth peer name xbn6d netns $NS_DN
+ip -n $NS_GNB addr add 10.77.3.2/24 dev xbn3g
+ip -n $NS_UPF addr add 10.77.3.1/24 dev xbn3u
+ip -n $NS_UPF addr add 10.77.6.1/24 dev xbn6u
+ip -n $NS_DN  addr add 10.77.6.2/24 dev xbn6d
+ip -n $NS_GNB link set xbn3g up
+ip -n $NS_UPF link set xbn3u up
+ip -n $NS_UPF link set xbn6u up
+ip -n $NS_DN  link set xbn6d up
+ip -n $NS_DN route add default via 10.77.6.1
+ip netns exec $NS_UPF sysctl -qw net.ipv4.ip_forward=1
+# decapsulated UE packets arrive on the N3 veth, not on the tun
+for c in all default xbn3u; do
+    ip netns exec $NS_UPF sysctl -qw net.ipv4.conf.$c.rp_filter=0
+done
+
+ip -n $NS_UPF tuntap add name xbtun mode tun multi_queue
+ip -n $NS_UPF addr add 10.206.0.1/16 dev xbtun
+ip -n $NS_UPF link set xbtun up
+
+# TC encap needs the gNB's MAC in the neighbour table (bpf_fib_lookup)
+GNB_MAC=$(ip -n $NS_GNB link show xbn3g | awk '/link\/ether/ { print $2 }')
+ip -n $NS_UPF neigh replace 10.77.3.2 lladdr "$GNB_MAC" dev xbn3u nud permanent
+
+# run <name> <ul|dl> <upf-side mode and options...> — with the matching
+# generator and sink; records host CPU over the generator's run
+run() {
+    local name="$1" dir="$2"; shift 2
+    local sink_ns sink_port c0 c1
+    if [ "$dir" = ul ]; then
+        sink_ns=$NS_DN;  sink_port=9
+    else
+        sink_ns=$NS_GNB; sink_port=2152
+    fi
+    ip netns exec $sink_ns "$BENCH" sink --port $sink_port \
+        --seconds $(( BENCH_SECONDS + 2 )) > "$WORKDIR/$name.sink" 2>&1 &
+    local spid=$!
+    ip netns exec $NS_UPF "$BENCH" "$@" --ue $UE_FIRST --ues "$BENCH_UES" \
+        --seconds $(( BENCH_SECONDS + 1 )) > "$WORKDIR/$name.log" 2>&1 &
+    local pid=$!
+    sleep 0.5
+    c0=$(cpu_busy)
+    if [ "$dir" = ul ]; then
+        ip netns exec $NS_GNB "$BENCH" pktgen --mode gtpu --dst 10.77.3.1 \
+            --ue $UE_FIRST --ues "$BENCH_UES" --size "$BENCH_SIZE" --gso 0 \
+            --inner-dst 10.77.6.2 --seconds "$BENCH_SECONDS" > "$WORKDIR/$name.gen" 2>&1
+    else
+        ip netns exec $NS_DN "$BENCH" pktgen --mode udp --ue $UE_FIRST \
+            --ues "$BENCH_UES" --size "$BENCH_SIZE" --gso 0 \
+            --seconds "$BENCH_SECONDS" > "$WORKDIR/$name.gen" 2>&1
+    fi
+    c1=$(cpu_busy)
+    echo "$(( c1 - c0 ))" > "$WORKDIR/$name.cpu"
+    wait $pid $spid
+}
+
+XDP_ARGS=(xdp --n3 xbn3u --tun xbtun --gnb 10.77.3.2 --mode "$BENCH_XDP_MODE")
+ROWS=(ul-user ul-xdp dl-user dl-xdp)
+info "Uplink userspace: recvmmsg batch 32 + GRO (${BENCH_SECONDS}s)"
+run ul-user ul n3rx --tun xbtun --batch 32 --gro 1
+info "Uplink XDP decap ($BENCH_XDP_MODE)"
+run ul-xdp ul "${XDP_ARGS[@]}"
+info "Downlink userspace: 1 worker, batch 32 + GSO"
+run dl-user dl upf --tun xbtun --workers 1 --gnb 10.77.3.2 --batch 32 --gso 1
+info "Downlink TC encap"
+run dl-xdp dl "${XDP_ARGS[@]}"
+
+if ! grep -q '"ul_pkts"' "$WORKDIR/ul-xdp.log"; then
+    warn "XDP/TC programs not attached — $(tail -1 "$WORKDIR/ul-xdp.log")"
+    exit 0
+fi
+
+# ── Report ───────────────────────────────────────────────────
+HZ=$(getconf CLK_TCK)
+declare -A CPG
+echo ""
+printf "  %-8s %8s %8s %12s %14s\n" RUN Mpps Gbit/s "host CPU-s" "CPU-s/Gbit"
+for r in "${ROWS[@]}"; do
+    f="$WORKDIR/$r.sink"
+    pkts=$(jget pkts "$f"); bytes=$(jget bytes "$f"); jif=$(cat "$WORKDIR/$r.cpu")
+    CPG[$r]=$(awk -v b="${bytes:-0}" -v j="$jif" -v hz="$HZ" \
+        'BEGIN { printf "%.3f", (b > 0) ? (j / hz) / (b * 8 / 1e9) : 0 }')
+    printf "  %-8s %8s %8s %12s %14s\n" "$r" \
+        "$(awk -v p="${pkts:-0}" -v s="$BENCH_SECONDS" 'BEGIN { printf "%.3f", p / s / 1e6 }')" \
+        "$(awk -v b="${bytes:-0}" -v s="$BENCH_SECONDS" 'BEGIN { printf "%.3f", b * 8 / s / 1e9 }')" \
+        "$(awk -v j="$jif" -v hz="$HZ" 'BEGIN { printf "%.2f", j / hz }')" "${CPG[$r]}"
+    perf_record bench_upf_xdp "${r}_cpu_s_per_gbit" "${CPG[$r]}" s lower
+done
+echo ""
+info "XDP/TC counters: uplink $(jget ul_pkts "$WORKDIR/ul-xdp.log") decapsulated, downlink $(jget dl_pkts "$WORKDIR/dl-xdp.log") encapsulated, $(jget fallback "$WORKDIR/dl-xdp.log") left to the tun"
+
+# The in-kernel path must need less host CPU per delivered Gbit
+RC=0
+for d in ul dl; do
+    b=${CPG[$d-user]}; a=${CPG[$d-xdp]}
+    if [ "$(jget pkts "$WORKDIR/$d-xdp.sink")" = "0" ] ||
+       [ "$(jget ${d}_pkts "$WORKDIR/$d-xdp.log")" = "0" ]; then
+        fail "${d}: no traffic through the XDP/TC path"
+        RC=1
+    elif awk -v a="$a" -v b="$b" 'BEGIN { exit !(a > 0 && a < b) }'; then
+        pass "${d}: host CPU per Gbit ${b}s → ${a}s in the kernel"
+    else
+        warn "${d}: no CPU/Gbit gain (${b}s → ${a}s)"
+    fi
+done
+[ "$RC" != "0" ] && workdir_keep
+exit $RC
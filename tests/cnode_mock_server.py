@@ -8,6 +8,8 @@ Implements the server side of the AMF cnode protocol:
   3. Send  HealthCheckRequest { service: "" }
   4. Read  HealthCheckResponse { status: SERVING(1) }
   5. Keep looping health-checks until AMF disconnects or --count is reached
+  6. With --watch: send HealthCheckRequest { watch: true } instead and print
+     every HealthCheckResponse the AMF pushes on status / load transitions
 
 Wire format (same as working MME sendData / recvData):
   [ uint32_t payload_length (4 bytes, native little-endian) ][ proto payload ]
@@ -25,6 +27,9 @@ Usage:
   # Stay running and accept reconnects (e.g. while testing AMF backoff)
   python3 tests/cnode_mock_server.py --port 9090 --loop
 
+  # Subscribe instead of polling; print pushes for 60 s (max 1 per 500 ms)
+  python3 tests/cnode_mock_server.py --port 9090 --watch 60 --min-interval 500
+
 Expected AMF environment variables:
   AMF_CNODE_ENABLE=1
   AMF_CNODE_SERVER_IP=<this host's IP>
@@ -162,6 +167,50 @@ def handle_session(conn: socket.socket, addr, interval: float, count: int) -> bo
     return True
 
 
+def handle_watch(conn: socket.socket, duration: float, min_interval_ms: int) -> bool:
+    """
+    After registration, subscribe with HealthCheckRequest { watch: true }
+    and print every pushed HealthCheckResponse for `duration` seconds.
+    Returns True if at least the initial response arrived.
+    """
+    req = b"\x18\x01"                              # field 3: watch = true
+    if min_interval_ms:
+        v, enc = min_interval_ms, bytearray()
+        while True:
+            b = v & 0x7F; v >>= 7
+            enc.append(b | 0x80 if v else b)
+            if not v:
+                break
+        req += b"\x20" + bytes(enc)                  # field 4: min_interval_ms
+    try:
+        write_framed(conn, req)
+    except OSError as e:
+        print(f"  [server] ERROR sending watch request: {e}", flush=True)
+        return False
+    print(f"  [server] → HealthCheckRequest {{ watch: true, "
+          f"min_interval_ms: {min_interval_ms} }}", flush=True)
+
+    pushes = 0
+    t0 = time.monotonic()
+    while time.monotonic() - t0 < duration:
+        conn.settimeout(max(0.1, duration - (time.monotonic() - t0)))
+        try:
+            resp = read_framed(conn)
+        except socket.timeout:
+            break
+        except (EOFError, OSError) as e:
+            print(f"  [server] watch ended: {e}", flush=True)
+            break
+        status = parse_field1_varint(resp)
+        kind = "initial" if pushes == 0 else "push"
+        print(f"  [server] ← +{time.monotonic() - t0:7.3f}s {kind:7s} "
+              f"status={STATUS_NAMES.get(status, status)}  [{resp.hex()}]",
+              flush=True)
+        pushes += 1
+    print(f"  [server] watch: {pushes} message(s) in {duration:.0f}s", flush=True)
+    return pushes > 0
+
+
 # ── Main ──────────────────────────────────────────────────────────────────────
 
 def main():
@@ -175,6 +224,10 @@ def main():
                         help="Health checks to send per session (default: 3, 0=infinite)")
     parser.add_argument("--loop",     action="store_true",
                         help="Keep accepting new connections (for backoff/reconnect testing)")
+    parser.add_argument("--watch",    type=float, metavar="SECS", default=0,
+                        help="Subscribe (watch=true) after registration and print pushes for SECS")
+    parser.add_argument("--min-interval", type=int, metavar="MS", default=0,
+                        help="With --watch: ask the AMF for at most one push per MS")
     args = parser.parse_args()
 
     srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
@@ -207,6 +260,8 @@ def main():
         print(f"[mock cnode server] session {session_num}: connection from {addr[0]}:{addr[1]}", flush=True)
 
         ok = handle_session(conn, addr, args.interval, args.count)
+        if ok and args.watch > 0:
+            ok = handle_watch(conn, args.watch, args.min_interval)
         conn.close()
 
         if ok:
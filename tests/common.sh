@@ -9,6 +9,32 @@ COMPOSE_FILE="$PROJECT_DIR/docker-compose.yaml"
 CONFIG_DIR="$PROJECT_DIR/config"
 TESTS_DIR="$SCRIPT_DIR"
 
+# Deployment under test.  The defaults are the one ./open5gs.sh starts;
+# run_all.sh --jobs points each worker at its own isolated copy (compose
+# project, container prefix, /24 and config dir; docker-compose.yaml reads
+# the same variables).
+O5GS_PREFIX="${O5GS_PREFIX:-open5gs}"
+O5GS_SUBNET="${O5GS_SUBNET:-10.200.100}"
+O5GS_PROJECT="${O5GS_PROJECT:-}"            # empty = compose default
+O5GS_CONFIG_DIR="${O5GS_CONFIG_DIR:-config}" # relative to PROJECT_DIR
+export O5GS_PREFIX O5GS_SUBNET
+
+# Container names and addresses of the deployment under test
+o5gs_names() {
+    CP_CTR="${O5GS_PREFIX}-cp"
+    UPF_CTR="${O5GS_PREFIX}-upf"
+    UERANSIM_CTR="${O5GS_PREFIX}-ueransim"
+    MONGO_CTR="${O5GS_PREFIX}-mongodb"
+    DN_SINK_CTR="${O5GS_PREFIX}-dn-sink"
+    O5GS_NET="${O5GS_PREFIX}-net"
+    CP_IP="${O5GS_SUBNET}.16"
+    UPF_IP="${O5GS_SUBNET}.17"
+    AMF_HEALTH_IP="$CP_IP"
+    # tools/provision/*.sh (provision_subscribers) take it from the environment
+    export MONGO_CONTAINER="$MONGO_CTR"
+}
+o5gs_names
+
 # Colors
 RED=$'\033[0;31m'
 GREEN=$'\033[0;32m'
@@ -26,11 +52,12 @@ AMF_FIELD="8000"
 BASE_K="0c57e15a2cb86087097a6b50d42531de"
 OPC="109ee52735ae6d3849112cf4175029c7"
 AMF_CNODE_DEFAULT_PORT=9090
+AMF_HEALTH_DEFAULT_PORT=50051
 
 # Auto-detect PLMN from running gNB config inside UERANSIM container
 _detect_plmn() {
     local gnb_cfg
-    gnb_cfg=$(docker exec open5gs-ueransim cat ./config/gnb.yaml 2>/dev/null)
+    gnb_cfg=$(docker exec $UERANSIM_CTR cat ./config/gnb.yaml 2>/dev/null)
     if [ -n "$gnb_cfg" ]; then
         MCC=$(echo "$gnb_cfg" | grep '^mcc:' | head -1 | awk '{print $2}' | tr -d "'\"")
         MNC=$(echo "$gnb_cfg" | grep '^mnc:' | head -1 | awk '{print $2}' | tr -d "'\"")
@@ -45,7 +72,7 @@ _detect_plmn() {
 _detect_plmn
 
 # Auto-detect the default IMSI from the UE config inside the container
-DEFAULT_IMSI=$(docker exec open5gs-ueransim grep '^supi:' ./config/ue.yaml 2>/dev/null | awk '{print $2}' | tr -d "'\"")
+DEFAULT_IMSI=$(docker exec $UERANSIM_CTR grep '^supi:' ./config/ue.yaml 2>/dev/null | awk '{print $2}' | tr -d "'\"")
 DEFAULT_IMSI="${DEFAULT_IMSI:-imsi-${MCC}${MNC}0000050641}"
 
 pass() { echo -e "  ${GREEN}PASS${NC}: $1"; }
@@ -75,27 +102,263 @@ wait_container() {
     return 1
 }
 
-# Wait for open5gs-cp to be healthy (NRF SBI on port 7777)
+# Read the AMF shared-memory health page (amf-health-shm.h) inside open5gs-cp.
+# Usage: amf_health_page [--check|--json]  — exit 0 iff SERVING and fresh
+amf_health_page() {
+    docker exec $CP_CTR /open5gs/amf-health-shm "$@" 2>/dev/null
+}
+
+# Read one field from the health page, e.g. amf_health_field amf_ues
+amf_health_field() {
+    amf_health_page | awk -F= -v k="$1" '$1 == k { print $2 }'
+}
+
+# Per-NF memory sampler (NFs/core/tools/open5gs-memstat.c) in a container:
+# smaps_rollup plus each NF's ogs-memstat page, one JSON line per process
+# every [interval_ms].  Images built before the sampler get a static copy
+# compiled from source.  Usage: memstat_start <container> [interval_ms]
+memstat_start() {
+    local c="$1" bin=/open5gs/open5gs-memstat
+    if ! docker exec "$c" test -x "$bin" 2>/dev/null; then
+        local tmp
+        bin=/tmp/open5gs-memstat
+        tmp=$(mktemp -d)
+        gcc -O2 -static -I "$PROJECT_DIR/NFs/core" -o "$tmp/open5gs-memstat" \
+            "$PROJECT_DIR/NFs/core/tools/open5gs-memstat.c" 2>/dev/null && \
+            docker cp "$tmp/open5gs-memstat" "$c:$bin" >/dev/null 2>&1
+        rm -rf "$tmp"
+        docker exec "$c" test -x "$bin" 2>/dev/null || return 1
+    fi
+    docker exec -d "$c" sh -c "echo \$\$ > /tmp/memstat.pid; \
+        exec $bin --interval-ms ${2:-200} -o /tmp/memstat.jsonl"
+}
+
+# Stop the sampler and copy its samples out.  Usage: memstat_stop <container> <file>
+memstat_stop() {
+    docker exec "$1" sh -c 'kill -INT $(cat /tmp/memstat.pid) 2>/dev/null; sleep 0.5'
+    docker exec "$1" cat /tmp/memstat.jsonl > "$2" 2>/dev/null
+}
+
+# Append one benchmark result to the perf store (tests/perf_store.py), keyed
+# by git commit and config.  Empty or "-" values are skipped, so a step that
+# produced no number leaves no record.  PERF_RECORD=0 turns recording off.
+# Usage: perf_record <test> <metric> <value> <unit> <higher|lower>
+perf_record() {
+    [ "${PERF_RECORD:-1}" = "0" ] && return 0
+    [ -z "$3" ] || [ "$3" = "-" ] && return 0
+    python3 "$TESTS_DIR/perf_store.py" record "$1" "$2" "$3" --unit "$4" --better "$5" || true
+}
+
+# perf_record for values read out of a JSON report, one per spec; <key> is
+# a dotted path into the report (null or missing: skipped).
+# Usage: perf_record_report <test> <report.json> <key>:<metric>:<unit>:<higher|lower> ...
+# e.g.   perf_record_report tc11 "$REPORT_FILE" capacity_registration_ms.p50:registration_p50_ms:ms:lower
+perf_record_report() {
+    local test="$1" report="$2" metric value unit better
+    shift 2
+    [ "${PERF_RECORD:-1}" = "0" ] && return 0
+    while read -r metric value unit better; do
+        perf_record "$test" "$metric" "$value" "$unit" "$better"
+    done < <(python3 - "$report" "$@" <<'PYEOF'
+import json, sys
+try:
+    r = json.load(open(sys.argv[1]))
+except (OSError, ValueError):
+    r = {}
+for spec in sys.argv[2:]:
+    key, metric, unit, better = spec.split(":")
+    v = r
+    for k in key.split("."):
+        v = v.get(k) if isinstance(v, dict) else None
+    print(metric, "-" if v is None else v, unit, better)
+PYEOF
+)
+}
+
+# Scratch directory for one run, removed on exit after the commands given
+# to on_exit (last registered runs first).  workdir_keep leaves it in place,
+# e.g. to keep a failed run's logs.
+# Usage: workdir_init <name>   — sets WORKDIR=/tmp/<name>.XXXXXX
+workdir_init() {
+    WORKDIR=$(mktemp -d "/tmp/$1.XXXXXX") || exit 1
+    _ON_EXIT=()
+    _KEEP_WORKDIR=0
+    trap _run_on_exit EXIT
+}
+
+# Usage: on_exit <command ...>, e.g. on_exit kill_all_ues
+on_exit() {
+    _ON_EXIT+=("$*")
+}
+
+workdir_keep() {
+    _KEEP_WORKDIR=1
+    info "logs kept in $WORKDIR"
+}
+
+_run_on_exit() {
+    local i
+    for (( i = ${#_ON_EXIT[@]} - 1; i >= 0; i-- )); do
+        eval "${_ON_EXIT[$i]}"
+    done
+    [ "$_KEEP_WORKDIR" = "1" ] || rm -rf "$WORKDIR"
+}
+
+# Default report path for one run: tests/logs/<name>_<timestamp>[.<ext>]
+# Usage: REPORT_FILE=$(report_path <name> [ext])
+report_path() {
+    mkdir -p "$TESTS_DIR/logs"
+    echo "$TESTS_DIR/logs/$1_$(date '+%Y%m%d_%H%M%S')${2:+.$2}"
+}
+
+# Write stdin to a report file, creating its directory.
+# Usage: <command> | report_write <file>
+report_write() {
+    mkdir -p "$(dirname "$1")"
+    cat > "$1"
+    info "Report saved to: $1"
+}
+
+# Wait for open5gs-cp to be healthy (AMF SERVING on its shm health page).
+# Polls the page directly every second instead of waiting for the next
+# docker healthcheck round; falls back to docker's health status on images
+# built before the page reader existed.
 wait_cp_healthy() {
     local max="${1:-120}"
     local waited=0
     while [ $waited -lt "$max" ]; do
-        local health
-        health=$(docker inspect --format='{{.State.Health.Status}}' open5gs-cp 2>/dev/null || echo "unknown")
-        [ "$health" = "healthy" ] && return 0
-        sleep 5
-        waited=$((waited + 5))
+        local rc
+        amf_health_page --check >/dev/null; rc=$?
+        [ $rc -eq 0 ] && return 0
+        if [ $rc -ge 126 ]; then
+            local health
+            health=$(docker inspect --format='{{.State.Health.Status}}' $CP_CTR 2>/dev/null || echo "unknown")
+            [ "$health" = "healthy" ] && return 0
+        fi
+        sleep 1
+        waited=$((waited + 1))
     done
     return 1
 }
 
-# Wait for UERANSIM gNB to show NG Setup in logs (polls with timeout)
+# Per-NF startup timeline written by start-cp-nfs.sh on the last CP start
+cp_startup_timeline() {
+    docker exec $CP_CTR cat /var/log/open5gs/startup-timeline.txt 2>/dev/null
+}
+
+# Wait for a UE to reach RM-REGISTERED (polls nr-cli every second).
+# Usage: wait_ue_registered <imsi> [max_seconds]
+wait_ue_registered() {
+    local imsi="$1" max="${2:-30}" waited=0
+    while [ $waited -lt "$max" ]; do
+        docker exec $UERANSIM_CTR ./nr-cli "$imsi" -e "status" 2>/dev/null \
+            | grep -q "RM-REGISTERED" && return 0
+        sleep 1
+        waited=$((waited + 1))
+    done
+    return 1
+}
+
+# AMF event stream (NFs/amf/amf-evstream.c): gNB / UE / cnode / health state
+# changes as records on a Unix socket in open5gs-cp, read with
+# /open5gs/amf-events (NFs/amf/tools/amf-events.c).  The wait helpers below
+# block on it and fall back to polling the AMF log on images without it
+# or with AMF_EVSTREAM_ENABLE=0.
+# Usage: amf_events [amf-events args], e.g. amf_events --last cnode
+amf_events() {
+    docker exec $CP_CTR sh -c \
+        'exec /open5gs/amf-events --path "${AMF_EVSTREAM_SOCK:-/run/open5gs-amf-events.sock}" "$@"' \
+        amf-events "$@" 2>/dev/null
+}
+
+# Exit 0 if the AMF in open5gs-cp is publishing events
+amf_events_available() {
+    amf_events --seq >/dev/null
+}
+
+# Byte offset of an NF log in open5gs-cp, so a test reads only what follows.
+# For the AMF the mark also carries the event stream position ("OFFSET@EPOCH.SEQ")
+# when the stream is up; cp_log_since and wait_amf_registrations take either.
+# Usage: mark=$(cp_log_mark amf)
+cp_log_mark() {
+    local off seq
+    off=$(docker exec $CP_CTR stat -c %s "/var/log/open5gs/$1.log" 2>/dev/null) || off=0
+    if [ "$1" = amf ] && seq=$(amf_events --seq); then
+        echo "${off}@${seq}"
+    else
+        echo "$off"
+    fi
+}
+
+# An NF log from a mark on.  Usage: cp_log_since <nf> <mark>
+cp_log_since() {
+    docker exec $CP_CTR tail -c +$(( ${2%%@*} + 1 )) "/var/log/open5gs/$1.log" 2>/dev/null
+}
+
+# Wait until <count> distinct UEs completed registration since <mark>:
+# blocks on ue_registered events when the mark has a stream position,
+# else polls "Registration complete" in the AMF log every second.  Prints
+# the count reached.
+# Usage: wait_amf_registrations <mark> <count> [max_seconds]
+wait_amf_registrations() {
+    local mark="$1" count="$2" max="${3:-60}" waited=0 n=0
+    if [ "$mark" != "${mark#*@}" ]; then
+        n=$(amf_events --since "${mark#*@}" --wait ue_registered \
+            --count "$count" --timeout "$max")
+        if [ -n "$n" ]; then
+            echo "$n"
+            [ "$n" -ge "$count" ]
+            return
+        fi
+    fi
+    mark=${mark%%@*}
+    while :; do
+        n=$(docker exec $CP_CTR sh -c "tail -c +$(( mark + 1 )) /var/log/open5gs/amf.log \
+            | grep -o '\[imsi-[0-9]*\] Registration complete' | sort -u | wc -l" 2>/dev/null)
+        n="${n:-0}"
+        [ "$n" -ge "$count" ] || [ $waited -ge "$max" ] && break
+        sleep 1
+        waited=$((waited + 1))
+    done
+    echo "$n"
+    [ "$n" -ge "$count" ]
+}
+
+# Start <count> UEs from one nr-ue process (UERANSIM multi-UE mode): IMSIs
+# incremented from [first_imsi] (default: the config's), all with the
+# config's K — provision them with "same-key".  [tempo_ms] spaces the UEs'
+# starts (nr-ue -t).  [log] keeps nr-ue's output in that file in the
+# container (per-UE lines, for ue_latency.py --ue-log).
+# Usage: start_ue_group <config-in-container> <count> [first_imsi] [tempo_ms] [log]
+start_ue_group() {
+    local args=(-c "$1" -n "$2")
+    [ -n "${3:-}" ] && args+=(-i "imsi-${3#imsi-}")
+    [ -n "${4:-}" ] && args+=(-t "$4")
+    if [ -n "${5:-}" ]; then
+        docker exec -d $UERANSIM_CTR sh -c "exec ./nr-ue ${args[*]} > $5 2>&1"
+    else
+        docker exec -d $UERANSIM_CTR ./nr-ue "${args[@]}"
+    fi
+}
+
+# Wait for the UERANSIM gNB to complete NG Setup since its container
+# started: a gnb_up event from the AMF, or NG Setup in the gNB's log
+# (polled every 3 s) without the event stream.
+# Usage: wait_gnb_connected [max_seconds]
 wait_gnb_connected() {
     local max="${1:-60}"
-    local waited=0
+    local waited=0 started
+    if amf_events_available; then
+        started=$(date -d "$(docker inspect -f '{{.State.StartedAt}}' $UERANSIM_CTR 2>/dev/null)" \
+            +%s.%N 2>/dev/null)
+        if [ -n "$started" ]; then
+            amf_events --after "$started" --wait gnb_up --timeout "$max" >/dev/null
+            return
+        fi
+    fi
     while [ $waited -lt "$max" ]; do
         local logs
-        logs=$(docker logs open5gs-ueransim --tail 50 2>&1)
+        logs=$(docker logs $UERANSIM_CTR --tail 50 2>&1)
         if echo "$logs" | grep -qi "NG Setup\|ngSetup\|NGAP"; then
             return 0
         fi
@@ -111,7 +374,7 @@ provision_subscriber() {
     local imsi_plain="$1"
     local k="$2"
     local opc="$3"
-    docker exec open5gs-mongodb mongosh 'mongodb://localhost:27017/open5gs' \
+    docker exec $MONGO_CTR mongosh 'mongodb://localhost:27017/open5gs' \
         --quiet --eval "
             db.subscribers.deleteOne({ imsi: '${imsi_plain}' });
             db.subscribers.insertOne({
@@ -158,12 +421,33 @@ provision_subscriber() {
         " 2>/dev/null
 }
 
+# Provision <count> subscribers BASE_SUPI, BASE_SUPI+1, ... in one mongosh
+# session (tools/provision/bulk-provision.sh).  K is hex_add BASE_K i, as
+# the per-UE configs expect, or BASE_K for all with "same-key" (nr-ue -n).
+# PROVISION_ENGINE=image stamps the documents from a compiled BSON template
+# instead (tools/provision/sub_template.py) — for 10^5+ subscribers.
+# The set is a cached fixture (tools/provision/fixture.sh): provisioned and
+# dumped the first time, restored from tests/.fixtures/ after that.
+# PROVISION_CACHE=0 always provisions.
+# Prints the JSON summary line ({"count":..,"per_sec":..,"fixture":..}).
+# Usage: provision_subscribers <count> [dnns] [same-key]
+provision_subscribers() {
+    local count="$1" dnns="${2:-internet}" extra=(--engine "${PROVISION_ENGINE:-js}") out
+    local tool="$PROJECT_DIR/tools/provision/fixture.sh provision"
+    [ "${PROVISION_CACHE:-1}" = "0" ] && tool="$PROJECT_DIR/tools/provision/bulk-provision.sh"
+    [ "${3:-}" = "same-key" ] && extra+=(--same-key)
+    out=$($tool --count "$count" \
+        --imsi "$BASE_SUPI" --key "$BASE_K" --opc "$OPC" --sst "$SST" --sd "$SD" \
+        --dnn "$dnns" "${extra[@]}" 2>/dev/null) || return 1
+    echo "${out##*$'\n'}"
+}
+
 # Provision a subscriber with both internet + ims sessions (for TC03)
 provision_subscriber_multi_apn() {
     local imsi_plain="$1"
     local k="$2"
     local opc="$3"
-    docker exec open5gs-mongodb mongosh 'mongodb://localhost:27017/open5gs' \
+    docker exec $MONGO_CTR mongosh 'mongodb://localhost:27017/open5gs' \
         --quiet --eval "
             db.subscribers.deleteOne({ imsi: '${imsi_plain}' });
             db.subscribers.insertOne({
@@ -311,37 +595,69 @@ UECFG
 
 # Kill all UE processes inside UERANSIM container
 kill_all_ues() {
-    docker exec open5gs-ueransim pkill -f "nr-ue" 2>/dev/null || true
+    docker exec $UERANSIM_CTR pkill -f "nr-ue" 2>/dev/null || true
     sleep 2
 }
 
 # Reset UERANSIM: kill UEs, restart container to clear accumulated UE context
 reset_ueransim() {
     kill_all_ues
-    docker restart open5gs-ueransim >/dev/null 2>&1
+    docker restart $UERANSIM_CTR >/dev/null 2>&1
     sleep 10
 }
 
-# check_amf_cnode_log() — return 0 if AMF log shows cnode is active.
-# Looks for "[AMF-cnode] connected" or "[AMF-cnode] registered" in the log.
+# check_amf_cnode_log() — return 0 if the cnode client is active: a cnode
+# event from the AMF, or any "[AMF-cnode]" line in its log.
 check_amf_cnode_log() {
-    docker exec open5gs-cp cat /var/log/open5gs/amf.log 2>/dev/null \
+    if amf_events_available; then
+        amf_events --last cnode >/dev/null
+        return
+    fi
+    docker exec $CP_CTR cat /var/log/open5gs/amf.log 2>/dev/null \
         | grep -q "\[AMF-cnode\]"
 }
 
-# check_amf_cnode_registered() — return 0 if AMF log shows successful registration.
+# check_amf_cnode_registered() — return 0 once the cnode client has sent
+# NodeType_Message (registered), waiting up to [max_seconds] (default: 10)
+# on the event stream; without it, checks the AMF log once.
 check_amf_cnode_registered() {
-    docker exec open5gs-cp cat /var/log/open5gs/amf.log 2>/dev/null \
-        | grep -q "\[AMF-cnode\] registered as AMF"
+    if amf_events_available; then
+        amf_events --after 0 --wait cnode --match '"state":"registered"' \
+            --timeout "${1:-10}" >/dev/null
+        return
+    fi
+    docker exec $CP_CTR cat /var/log/open5gs/amf.log 2>/dev/null \
+        | grep -q "\[AMF-cnode\] sent NodeType_Message"
+}
+
+# docker compose on the deployment under test (O5GS_* above): its project,
+# container names, subnet and config dir, also for the gNB/UE configs.
+# Usage: o5gs_compose [compose args], e.g. o5gs_compose --profile bench up -d dn-sink
+o5gs_compose() {
+    (cd "$PROJECT_DIR" && CONFIG_DIR="$O5GS_CONFIG_DIR" RAN_CONFIG_DIR="$O5GS_CONFIG_DIR" \
+        docker compose ${O5GS_PROJECT:+-p "$O5GS_PROJECT"} -f "$COMPOSE_FILE" "$@")
+}
+
+# Recreate open5gs-cp with extra environment for the test-only switches the
+# compose file leaves off (AMF_RESPAWN, AMF_HEALTH_FAULT_INJECT, ...), then
+# wait for it to be healthy.  Without arguments: back to the compose
+# defaults.  The gNB loses its NG association; restart UERANSIM afterwards.
+# Usage: cp_recreate [VAR=value ...]
+cp_recreate() {
+    (
+        for kv in "$@"; do export "$kv"; done
+        o5gs_compose up -d --force-recreate --no-deps open5gs-cp >/dev/null 2>&1
+    ) || return 1
+    wait_cp_healthy 120
 }
 
 # Ensure UERANSIM container is running (start if not)
 _ensure_ueransim() {
     local state
-    state=$(docker inspect --format='{{.State.Status}}' open5gs-ueransim 2>/dev/null || echo "missing")
+    state=$(docker inspect --format='{{.State.Status}}' $UERANSIM_CTR 2>/dev/null || echo "missing")
     if [ "$state" != "running" ]; then
         info "Starting UERANSIM..."
-        cd "$PROJECT_DIR" && CONFIG_DIR=config docker compose -f "$COMPOSE_FILE" --profile ueransim up -d ueransim >/dev/null 2>&1
+        o5gs_compose --profile ueransim up -d ueransim >/dev/null 2>&1
         sleep 10
     fi
 }
@@ -349,8 +665,13 @@ _ensure_ueransim() {
 # Ensure core is running, or start it. Also clean residual UE state.
 ensure_core_running() {
     local cp_state
-    cp_state=$(docker inspect --format='{{.State.Status}}' open5gs-cp 2>/dev/null || echo "missing")
-    if [ "$cp_state" != "running" ]; then
+    cp_state=$(docker inspect --format='{{.State.Status}}' $CP_CTR 2>/dev/null || echo "missing")
+    if [ "$cp_state" != "running" ] && [ -n "$O5GS_PROJECT" ]; then
+        # Isolated instance (run_all.sh --jobs): no host SCTP/dataplane setup
+        info "Core not running. Starting compose project ${O5GS_PROJECT}..."
+        o5gs_compose --profile ueransim up -d open5gs-mongodb open5gs-cp open5gs-upf ueransim >/dev/null 2>&1
+        wait_cp_healthy 120 || warn "$CP_CTR not healthy after 120s"
+    elif [ "$cp_state" != "running" ]; then
         info "Core not running. Starting with: ./open5gs.sh start --ueransim"
         cd "$PROJECT_DIR" && ./open5gs.sh start --ueransim
     else
@@ -361,7 +682,7 @@ ensure_core_running() {
     kill_all_ues
     # Restart gNB to clear accumulated UE context (avoids cross-test interference)
     info "Resetting UERANSIM gNB (clearing residual state)..."
-    docker restart open5gs-ueransim >/dev/null 2>&1
+    docker restart $UERANSIM_CTR >/dev/null 2>&1
     sleep 10
     # Auto-provision DEFAULT_IMSI if not already in DB
     _ensure_default_subscriber
@@ -371,15 +692,15 @@ ensure_core_running() {
 _ensure_default_subscriber() {
     local supi_plain="${DEFAULT_IMSI#imsi-}"
     local count
-    count=$(docker exec open5gs-mongodb mongosh 'mongodb://localhost:27017/open5gs' \
+    count=$(docker exec $MONGO_CTR mongosh 'mongodb://localhost:27017/open5gs' \
         --quiet --eval "db.subscribers.countDocuments({ imsi: '${supi_plain}' })" 2>/dev/null | tail -1)
     if [ "${count:-0}" -gt 0 ] 2>/dev/null; then
         return 0  # already provisioned
     fi
     info "Auto-provisioning DEFAULT_IMSI (${DEFAULT_IMSI})..."
     local ue_k ue_opc
-    ue_k=$(docker exec open5gs-ueransim grep '^key:' ./config/ue.yaml 2>/dev/null | awk '{print $2}' | tr -d "'\"")
-    ue_opc=$(docker exec open5gs-ueransim grep '^op:' ./config/ue.yaml 2>/dev/null | awk '{print $2}' | tr -d "'\"")
+    ue_k=$(docker exec $UERANSIM_CTR grep '^key:' ./config/ue.yaml 2>/dev/null | awk '{print $2}' | tr -d "'\"")
+    ue_opc=$(docker exec $UERANSIM_CTR grep '^op:' ./config/ue.yaml 2>/dev/null | awk '{print $2}' | tr -d "'\"")
     ue_k="${ue_k:-$BASE_K}"
     ue_opc="${ue_opc:-$OPC}"
     provision_subscriber "$supi_plain" "$ue_k" "$ue_opc"
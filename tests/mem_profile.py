@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""
+mem_profile.py — per-NF leak verdicts from open5gs-memstat samples.
+
+Reads the JSON lines written by open5gs-memstat (NFs/core/tools/) in the
+CP and UPF containers, and a marks file with one "<cycle> <unix time>"
+line per finished register/deregister cycle (taken once the UEs are gone
+and the core has settled).  For every NF it takes the last sample at or
+before each mark and fits a least-squares line over the cycles after
+--warmup, per metric:
+
+  pss_kb, anon_kb     /proc/<pid>/smaps_rollup (no page cache, per process)
+  heap_kb             glibc heap in use (ogs-memstat hook)
+  talloc_kb           talloc tree under the core context (hook)
+  pool <name>         in-use entries of each ogs_pool (hook)
+
+Verdict per NF:
+
+  leak   a pool grows by >= --pool-slope entries per cycle (default 0.5,
+         i.e. one leaked context every other cycle), or heap / talloc /
+         anon grows by >= --slope-kb per cycle, with R^2 >= --min-r2
+  warn   a memory slope is over --slope-kb but the fit is noisy (R^2 below
+         --min-r2), or the NF restarted during the run
+  ok     otherwise
+
+A pool's in-use count is exact, so with one UE per cycle a context that
+is never freed shows up as a slope of 1.0 in that NF's pool.
+
+Usage:
+  python3 tests/mem_profile.py --samples cp.jsonl --samples upf.jsonl \\
+      --marks marks.txt --ues-per-cycle 1 --json report.json
+
+Prints a table (and writes the JSON report with the per-cycle values and
+the full time series).  Exit status: 1 if any NF leaks, else 0.
+"""
+
+import argparse
+import bisect
+import json
+import sys
+
+MEM_METRICS = ("pss_kb", "anon_kb", "heap_kb", "talloc_kb")
+FIT_METRICS = ("anon_kb", "heap_kb", "talloc_kb")      # leak / warn inputs
+
+
+def load(paths):
+    """-> {nf: {"pids": [..], "samples": [(t, rec, {pool: used})]}}"""
+    nfs = {}
+    names = {}                                  # pid -> [pool names]
+    for path in paths:
+        with open(path, errors="replace") as f:
+            for line in f:
+                try:
+                    r = json.loads(line)
+                except ValueError:
+                    continue                    # a line cut off by the stop
+                if "pools" in r:
+                    names[r["pid"]] = [p[0] for p in r["pools"]]
+                    continue
+                d = nfs.setdefault(r["nf"], {"pids": [], "samples": []})
+                if r["pid"] not in d["pids"]:
+                    d["pids"].append(r["pid"])
+                pools = {}
+                for name, used in zip(names.get(r["pid"], ()), r.get("used", ())):
+                    pools[name] = pools.get(name, 0) + used
+                d["samples"].append((r["t"], r, pools))
+    for d in nfs.values():
+        d["samples"].sort(key=lambda s: s[0])
+    return nfs
+
+
+def fit(xs, ys):
+    """Least squares -> (slope, r2); r2 is 1.0 for a flat line."""
+    n = len(xs)
+    if n < 2:
+        return 0.0, 0.0
+    mx, my = sum(xs) / float(n), sum(ys) / float(n)
+    sxx = sum((x - mx) ** 2 for x in xs)
+    sxy = sum((x - mx) * (y - my) for x, y in zip(xs, ys))
+    syy = sum((y - my) ** 2 for y in ys)
+    if sxx == 0:
+        return 0.0, 0.0
+    slope = sxy / sxx
+    r2 = 1.0 if syy == 0 else (sxy * sxy) / (sxx * syy)
+    return slope, r2
+
+
+def analyze(nfs, marks, warmup, slope_kb, pool_slope, min_r2, ues_per_cycle):
+    report = {}
+    for nf, d in sorted(nfs.items()):
+        ts = [s[0] for s in d["samples"]]
+        cycles, rows = [], []
+        for c, t in marks:
+            i = bisect.bisect_right(ts, t) - 1
+            if i >= 0:
+                cycles.append(c)
+                rows.append(d["samples"][i])
+        fitted = [(c, r) for c, r in zip(cycles, rows) if c > warmup]
+        xs = [c for c, _ in fitted]
+
+        per_cycle = {m: [r[1].get(m) for r in rows] for m in MEM_METRICS}
+        slopes, reasons, verdict = {}, [], "ok"
+        for m in MEM_METRICS:
+            ys = [r[1].get(m) for _, r in fitted]
+            if len(xs) < 3 or any(y is None for y in ys):
+                continue
+            s, r2 = fit(xs, ys)
+            slopes[m] = {"per_cycle": round(s, 2), "r2": round(r2, 3),
+                         "per_ue": round(s / ues_per_cycle, 2)}
+            if m not in FIT_METRICS or s < slope_kb:
+                continue
+            if r2 >= min_r2:
+                verdict = "leak"
+                reasons.append("%s +%.1f kB/cycle (R2 %.2f)" % (m, s, r2))
+            else:
+                if verdict == "ok":
+                    verdict = "warn"
+                reasons.append("%s +%.1f kB/cycle, noisy (R2 %.2f)" % (m, s, r2))
+
+        pools = {}
+        names = sorted(set(n for _, r in fitted for n in r[2]))
+        for name in names:
+            ys = [r[2].get(name, 0) for _, r in fitted]
+            if len(xs) < 3 or ys[-1] == ys[0]:
+                continue
+            s, r2 = fit(xs, ys)
+            pools[name] = {"per_cycle": round(s, 2), "r2": round(r2, 3),
+                           "start": ys[0], "end": ys[-1]}
+            if s >= pool_slope and r2 >= min_r2:
+                verdict = "leak"
+                reasons.append("pool %s +%.2f/cycle (%d -> %d)" % (name, s, ys[0], ys[-1]))
+
+        if len(d["pids"]) > 1:
+            if verdict == "ok":
+                verdict = "warn"
+            reasons.append("restarted (pids %s)" % ",".join(map(str, d["pids"])))
+        if len(xs) < 3:
+            verdict = "n/a"
+            reasons.append("fewer than 3 cycles after warm-up")
+
+        report[nf] = {
+            "pid": d["pids"][-1],
+            "verdict": verdict,
+            "reasons": reasons,
+            "hook": any("heap_kb" in s[1] for s in d["samples"]),
+            "slopes": slopes,
+            "pools": pools,
+            "cycles": {"cycle": cycles, **per_cycle},
+            "series": {"t": ts, **{m: [s[1].get(m) for s in d["samples"]]
+                                   for m in MEM_METRICS}},
+        }
+    return report
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--samples", action="append", required=True,
+                    help="open5gs-memstat output (repeatable)")
+    ap.add_argument("--marks", required=True, help="'<cycle> <unix time>' per line")
+    ap.add_argument("--ues-per-cycle", type=int, default=1)
+    ap.add_argument("--warmup", type=int, default=2, help="cycles left out of the fit")
+    ap.add_argument("--slope-kb", type=float, default=8.0)
+    ap.add_argument("--pool-slope", type=float, default=0.5)
+    ap.add_argument("--min-r2", type=float, default=0.8)
+    ap.add_argument("--json", help="write the full report here")
+    a = ap.parse_args()
+
+    marks = []
+    with open(a.marks) as f:
+        for line in f:
+            p = line.split()
+            if len(p) == 2:
+                marks.append((int(p[0]), float(p[1])))
+
+    report = analyze(load(a.samples), marks, a.warmup, a.slope_kb, a.pool_slope,
+                     a.min_r2, max(1, a.ues_per_cycle))
+
+    if a.json:
+        with open(a.json, "w") as f:
+            json.dump({"cycles": len(marks), "ues_per_cycle": a.ues_per_cycle,
+                       "warmup": a.warmup,
+                       "thresholds": {"slope_kb": a.slope_kb, "pool_slope": a.pool_slope,
+                                      "min_r2": a.min_r2},
+                       "nfs": report}, f)
+
+    print("%-6s %8s %8s %11s %11s %11s  %-7s %s"
+          % ("NF", "PSS kB", "ΔPSS", "anon/cyc", "heap/cyc", "talloc/cyc", "verdict", "why"))
+    for nf, r in report.items():
+        pss = [v for v in r["cycles"]["pss_kb"] if v is not None]
+        g = lambda m: "%+.1f" % r["slopes"][m]["per_cycle"] if m in r["slopes"] else "-"
+        print("%-6s %8s %8s %11s %11s %11s  %-7s %s"
+              % (nf, pss[-1] if pss else "-", "%+d" % (pss[-1] - pss[0]) if pss else "-",
+                 g("anon_kb"), g("heap_kb"), g("talloc_kb"), r["verdict"],
+                 "; ".join(r["reasons"])))
+
+    sys.exit(1 if any(r["verdict"] == "leak" for r in report.values()) else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+"""
+perf_store.py — performance results store and regression comparator.
+
+Benchmark-type tests (tc09 health RTT, tc10 memory slope, tc11 / ue_load
+registration rate, the bench_*.sh user-plane numbers) append one JSON line
+per metric to an append-only store:
+
+  tests/.perf/results.jsonl          (PERF_STORE overrides)
+
+  {"ts":..,"run":"20250101_120000","commit":"3f2a..","dirty":false,
+   "config":"9c1e0b7d2a41","test":"tc11","metric":"capacity_per_sec",
+   "value":120,"unit":"reg/s","better":"higher"}
+
+"commit" is the checked-out tree (HEAD, plus "-dirty" with local changes);
+"config" is a hash of config/, docker-compose.yaml, the host CPU count and
+PERF_CONFIG, so runs on another host or with another cpu-profile.conf never
+form each other's baseline.  "run" groups the metrics of one run_all.sh
+invocation (PERF_RUN_ID).
+
+compare takes every value of the current commit as the candidate and the
+values of the last --window earlier commits with the same config as the
+rolling baseline, and per (test, metric) computes the 95% confidence
+interval of the difference of the means (Welch; with a single candidate
+run the baseline's spread is used for both sides).  Verdict:
+
+  regression  the whole interval is on the worse side and the mean moved
+              by >= --threshold (default 5%)
+  improved    the same, on the better side
+  ok          otherwise (no significant change)
+  n/a         fewer than 2 values in total on one side, or no baseline
+
+Repeated runs (run_all.sh --repeat N) narrow the interval; a 10% loss
+with a few percent run-to-run noise is flagged with 3 runs per side.
+
+Usage:
+  perf_store.py record <test> <metric> <value> [--unit U] [--better higher|lower]
+  perf_store.py compare [--window 5] [--threshold 5] [--test T] [--json FILE]
+  perf_store.py show [--test T] [--metric M]
+
+Exit status of compare: 1 if any metric regressed, else 0.
+"""
+
+import argparse
+import fcntl
+import hashlib
+import json
+import math
+import os
+import subprocess
+import sys
+import time
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.dirname(TESTS_DIR)
+STORE = os.environ.get("PERF_STORE") or os.path.join(TESTS_DIR, ".perf", "results.jsonl")
+
+# Two-sided 95% Student t quantiles, df 1..30
+T975 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+
+def t975(df):
+    if df < 1:
+        return float("inf")
+    df = int(df)
+    return T975[df - 1] if df <= len(T975) else 1.96
+
+
+def git(*args):
+    try:
+        return subprocess.run(("git", "-C", PROJECT_DIR) + args, capture_output=True,
+                              text=True, timeout=10).stdout.strip()
+    except (OSError, subprocess.SubprocessError):
+        return ""
+
+
+def commit_id():
+    """-> (commit, dirty); tests/ itself does not make the tree dirty"""
+    head = git("rev-parse", "HEAD") or "unknown"
+    dirty = bool(git("status", "--porcelain", "--untracked-files=no", "--", ".",
+                     ":(exclude)tests"))
+    return head + ("-dirty" if dirty else ""), dirty
+
+
+def config_id():
+    h = hashlib.sha256()
+    paths = [os.path.join(PROJECT_DIR, "docker-compose.yaml")]
+    cfg = os.path.join(PROJECT_DIR, "config")
+    if os.path.isdir(cfg):
+        paths += [os.path.join(cfg, n) for n in sorted(os.listdir(cfg))]
+    for p in paths:
+        try:
+            with open(p, "rb") as f:
+                h.update(os.path.basename(p).encode() + b"\0" + f.read() + b"\0")
+        except OSError:
+            pass
+    h.update(("nproc=%d\0" % (os.cpu_count() or 0)).encode())
+    h.update(os.environ.get("PERF_CONFIG", "").encode())
+    return h.hexdigest()[:12]
+
+
+def load(path):
+    recs = []
+    try:
+        with open(path, errors="replace") as f:
+            for line in f:
+                try:
+                    r = json.loads(line)
+                except ValueError:
+                    continue                    # a line cut off by a crash
+                if isinstance(r.get("value"), (int, float)):
+                    recs.append(r)
+    except OSError:
+        pass
+    return recs
+
+
+def record(a):
+    try:
+        value = float(a.value)
+    except ValueError:
+        print("perf_store: %s/%s: not a number: %r" % (a.test, a.metric, a.value),
+              file=sys.stderr)
+        return 2
+    if not math.isfinite(value):
+        return 2
+    commit, dirty = commit_id()
+    r = {"ts": round(time.time(), 3),
+         "run": os.environ.get("PERF_RUN_ID") or time.strftime("%Y%m%d_%H%M%S"),
+         "commit": commit, "dirty": dirty, "config": config_id(),
+         "test": a.test, "metric": a.metric,
+         "value": int(value) if value.is_integer() else value,
+         "unit": a.unit, "better": a.better}
+    os.makedirs(os.path.dirname(STORE), exist_ok=True)
+    # One write() per line under an exclusive lock: parallel runs append safely
+    with open(STORE, "a") as f:
+        fcntl.flock(f, fcntl.LOCK_EX)
+        f.write(json.dumps(r, separators=(",", ":")) + "\n")
+    return 0
+
+
+def stats(xs):
+    """-> (n, mean, variance or None)"""
+    n = len(xs)
+    m = sum(xs) / n
+    v = sum((x - m) ** 2 for x in xs) / (n - 1) if n > 1 else None
+    return n, m, v
+
+
+def diff_ci(base, cand):
+    """95% CI of mean(cand) - mean(base) -> (lo, hi) or None"""
+    nb, mb, vb = stats(base)
+    nc, mc, vc = stats(cand)
+    d = mc - mb
+    if vb is not None and vc is not None:
+        se2 = vb / nb + vc / nc
+        if se2 == 0:
+            return d, d
+        df = se2 ** 2 / ((vb / nb) ** 2 / (nb - 1) + (vc / nc) ** 2 / (nc - 1)) \
+            if vb and vc else (nb - 1 if vb else nc - 1)
+    elif vb is not None or vc is not None:
+        v = vb if vb is not None else vc        # one side has a single value
+        se2 = v * (1.0 / nb + 1.0 / nc)
+        df = (nb if vb is not None else nc) - 1
+    else:
+        return None
+    half = t975(df) * math.sqrt(se2)
+    return d - half, d + half
+
+
+def by_commit(recs, config, test, metric):
+    """-> [(commit, [values])] in the order the commits were first seen"""
+    order, vals = [], {}
+    for r in recs:
+        if r["config"] != config or r["test"] != test or r["metric"] != metric:
+            continue
+        if r["commit"] not in vals:
+            order.append(r["commit"])
+            vals[r["commit"]] = []
+        vals[r["commit"]].append(float(r["value"]))
+    return [(c, vals[c]) for c in order]
+
+
+def compare(a):
+    recs = load(STORE)
+    commit = a.commit or commit_id()[0]
+    config = a.config or config_id()
+    keys = []
+    for r in recs:
+        k = (r["test"], r["metric"])
+        if r["commit"] == commit and r["config"] == config and k not in keys \
+                and (not a.test or r["test"] == a.test):
+            keys.append(k)
+    if not keys:
+        print("perf_store: no results for %s (config %s) in %s" % (commit[:12], config, STORE))
+        return 0
+
+    rows = []
+    for test, metric in keys:
+        hist = by_commit(recs, config, test, metric)
+        cand = dict(hist)[commit]
+        base_commits = [c for c, _ in hist if c != commit][-a.window:]
+        base = [v for c, vs in hist if c in base_commits for v in vs]
+        last = next(r for r in reversed(recs) if r["commit"] == commit
+                    and r["test"] == test and r["metric"] == metric)
+        row = {"test": test, "metric": metric, "unit": last.get("unit", ""),
+               "better": last.get("better", "higher"),
+               "baseline": {"commits": len(base_commits), "n": len(base)},
+               "candidate": {"n": len(cand), "mean": sum(cand) / len(cand)},
+               "change_pct": None, "ci_pct": None, "verdict": "n/a"}
+        if base:
+            mb = sum(base) / len(base)
+            row["baseline"]["mean"] = mb
+            ci = diff_ci(base, cand)
+            if mb != 0:
+                row["change_pct"] = (row["candidate"]["mean"] - mb) * 100.0 / abs(mb)
+            if ci is not None and mb != 0:
+                lo, hi = (x * 100.0 / abs(mb) for x in ci)
+                row["ci_pct"] = [lo, hi]
+                worse = (hi < 0) if row["better"] == "higher" else (lo > 0)
+                better = (lo > 0) if row["better"] == "higher" else (hi < 0)
+                big = abs(row["change_pct"]) >= a.threshold
+                row["verdict"] = "regression" if worse and big else \
+                    "improved" if better and big else "ok"
+        rows.append(row)
+
+    fmt = lambda v: "-" if v is None else ("%.4g" % v)
+    print("candidate %s  config %s  baseline: last %d commit(s)  threshold %.1f%%"
+          % (commit[:12], config, a.window, a.threshold))
+    print("%-18s %-28s %12s %4s %12s %4s %9s %19s  %s"
+          % ("TEST", "METRIC", "BASELINE", "n", "CANDIDATE", "n", "CHANGE", "95% CI", "VERDICT"))
+    for r in rows:
+        ci = "[%+.1f%%, %+.1f%%]" % tuple(r["ci_pct"]) if r["ci_pct"] else "-"
+        print("%-18s %-28s %12s %4d %12s %4d %9s %19s  %s"
+              % (r["test"], "%s (%s%s)" % (r["metric"], "↑" if r["better"] == "higher" else "↓",
+                                           (" " + r["unit"]) if r["unit"] else ""),
+                 fmt(r["baseline"].get("mean")), r["baseline"]["n"],
+                 fmt(r["candidate"]["mean"]), r["candidate"]["n"],
+                 "%+.1f%%" % r["change_pct"] if r["change_pct"] is not None else "-",
+                 ci, r["verdict"]))
+    if a.json:
+        with open(a.json, "w") as f:
+            json.dump({"commit": commit, "config": config, "window": a.window,
+                       "threshold_pct": a.threshold, "metrics": rows}, f, indent=2)
+    return 1 if any(r["verdict"] == "regression" for r in rows) else 0
+
+
+def show(a):
+    recs = load(STORE)
+    config = a.config or config_id()
+    keys = []
+    for r in recs:
+        k = (r["test"], r["metric"])
+        if r["config"] == config and k not in keys and (not a.test or r["test"] == a.test) \
+                and (not a.metric or r["metric"] == a.metric):
+            keys.append(k)
+    for test, metric in keys:
+        print("%s %s" % (test, metric))
+        for commit, vs in by_commit(recs, config, test, metric)[-a.last:]:
+            n, m, v = stats(vs)
+            half = t975(n - 1) * math.sqrt(v / n) if v is not None else None
+            print("  %-18s n=%-3d %12.4g %s" % (commit[:18], n, m,
+                                                 "± %.3g" % half if half is not None else ""))
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("record", help="append one metric value")
+    p.add_argument("test")
+    p.add_argument("metric")
+    p.add_argument("value")
+    p.add_argument("--unit", default="")
+    p.add_argument("--better", choices=("higher", "lower"), default="higher")
+
+    p = sub.add_parser("compare", help="current commit vs the rolling baseline")
+    p.add_argument("--window", type=int, default=5, help="baseline commits (default: 5)")
+    p.add_argument("--threshold", type=float, default=5.0,
+                   help="smallest change that counts, in %% (default: 5)")
+    p.add_argument("--test", help="only this test")
+    p.add_argument("--commit", help="candidate commit (default: the checked-out tree)")
+    p.add_argument("--config", help="config hash (default: the current one)")
+    p.add_argument("--json", help="write the comparison here")
+
+    p = sub.add_parser("show", help="per-commit history")
+    p.add_argument("--test")
+    p.add_argument("--metric")
+    p.add_argument("--last", type=int, default=10, help="commits per metric (default: 10)")
+    p.add_argument("--config", help="config hash (default: the current one)")
+
+    a = ap.parse_args()
+    sys.exit({"record": record, "compare": compare, "show": show}[a.cmd](a))
+
+
+if __name__ == "__main__":
+    main()
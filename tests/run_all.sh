@@ -6,6 +6,25 @@
 #   ./run_all.sh              # Run all tests
 #   ./run_all.sh 1 3 5        # Run TC01, TC03, TC05 only
 #   ./run_all.sh --list       # List available tests
+#   ./run_all.sh --repeat 3 9 11   # Run TC09, TC11 three times each
+#   ./run_all.sh --jobs 4     # Run on 4 deployments at once (TEST_JOBS=4)
+#   ./run_all.sh --jobs 4 --keep   # ... and leave the extra ones running
+#
+# --jobs N runs independent tests concurrently on N deployments: the one
+# ./open5gs.sh started plus N-1 isolated copies, each its own compose
+# project o5gs-pK with containers o5gs-pK-*, subnet 10.200.(100+K).0/24,
+# NGAP host port 38412+K and the config copied to tests/.instances/pK with
+# those addresses.  The copies get no host SCTP forward or setup_dataplane
+# routes/iptables.  Tests with an "# exclusive:" header line need the host
+# to themselves; they run afterwards, one at a time on the shared
+# deployment, once the copies are down.  Output of a parallel test goes
+# only to its log; the summary merges all results with the deployment
+# each ran on.
+#
+# Benchmark numbers (tc09 RTT, tc10 slopes, tc11 capacity, tc12 throughput,
+# ...) go to the perf store, tagged with this run; at the end perf_store.py
+# compares the current commit with the last 5 commits on the same config and
+# a significant regression fails the run.  PERF_RECORD=0 turns this off.
 # ============================================================
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
@@ -15,6 +34,7 @@ LOG_DIR="$SCRIPT_DIR/logs"
 mkdir -p "$LOG_DIR"
 TIMESTAMP=$(date '+%Y%m%d_%H%M%S')
 SUMMARY_LOG="$LOG_DIR/run_${TIMESTAMP}.log"
+export PERF_RUN_ID="$TIMESTAMP"
 
 # Test registry
 declare -A TC_NAME
@@ -28,6 +48,8 @@ TC_NAME[7]="RAN Config Update"
 TC_NAME[8]="NG Reset"
 TC_NAME[9]="AMF TCP Health Check"
 TC_NAME[10]="Memory Leak / Stability"
+TC_NAME[11]="Registration Storm"
+TC_NAME[12]="User-plane Throughput"
 
 declare -A TC_SCRIPT
 TC_SCRIPT[1]="tc01_parallel_registration.sh"
@@ -40,14 +62,35 @@ TC_SCRIPT[7]="tc07_ran_config_update.sh"
 TC_SCRIPT[8]="tc08_ng_reset.sh"
 TC_SCRIPT[9]="tc09_amf_health_check.sh"
 TC_SCRIPT[10]="tc10_memory_leak.sh"
+TC_SCRIPT[11]="tc11_registration_storm.sh"
+TC_SCRIPT[12]="tc12_user_plane.sh"
+
+# Tests that must not share the host with other tests under --jobs: host
+# iptables/routes (setup_dataplane), host ports, or benchmark numbers that
+# other deployments' load would skew.  Each script declares it in its
+# header comment as "# exclusive: <reason>"; one that touches host
+# networking without declaring it is treated as exclusive anyway.
+declare -A TC_EXCLUSIVE
+tc_exclusive() {
+    local f="$SCRIPT_DIR/$1" reason
+    reason=$(awk '!/^#/ { exit } sub(/^# exclusive:[ \t]*/, "") { print; exit }' "$f" 2>/dev/null)
+    if [ -z "$reason" ] && grep -Eq '^[^#]*(setup_dataplane|iptables|ip route|sysctl -w)' "$f" 2>/dev/null; then
+        reason="host networking (no \"# exclusive:\" header)"
+    fi
+    echo "$reason"
+}
+for i in "${!TC_SCRIPT[@]}"; do
+    TC_EXCLUSIVE[$i]=$(tc_exclusive "${TC_SCRIPT[$i]}")
+done
 
 # Parse arguments
 if [ "${1:-}" = "--list" ]; then
     echo ""
     echo -e "${BOLD}Available open5GS Test Cases:${NC}"
     echo ""
-    for i in $(seq 1 10); do
-        printf "  TC%02d: %s  [%s]\n" "$i" "${TC_NAME[$i]}" "${TC_SCRIPT[$i]}"
+    for i in $(seq 1 12); do
+        printf "  TC%02d: %s  [%s]%s\n" "$i" "${TC_NAME[$i]}" "${TC_SCRIPT[$i]}" \
+            "${TC_EXCLUSIVE[$i]:+  (exclusive: ${TC_EXCLUSIVE[$i]})}"
     done
     echo ""
     exit 0
@@ -55,60 +98,233 @@ fi
 
 # Determine which tests to run
 TESTS_TO_RUN=()
-if [ $# -eq 0 ]; then
-    TESTS_TO_RUN=(1 2 3 4 5 6 7 8 9 10)
-else
-    for arg in "$@"; do
-        if [[ "$arg" =~ ^[0-9]+$ ]]; then
-            TESTS_TO_RUN+=("$arg")
-        fi
-    done
+REPEAT=1
+JOBS="${TEST_JOBS:-1}"
+KEEP=0
+while [ $# -gt 0 ]; do
+    if [ "$1" = "--repeat" ] && [[ "${2:-}" =~ ^[0-9]+$ ]]; then
+        REPEAT="$2"
+        shift
+    elif [ "$1" = "--jobs" ] && [[ "${2:-}" =~ ^[0-9]+$ ]]; then
+        JOBS="$2"
+        shift
+    elif [ "$1" = "--keep" ]; then
+        KEEP=1
+    elif [[ "$1" =~ ^[0-9]+$ ]]; then
+        TESTS_TO_RUN+=("$1")
+    fi
+    shift
+done
+[ ${#TESTS_TO_RUN[@]} -eq 0 ] && TESTS_TO_RUN=(1 2 3 4 5 6 7 8 9 10 11 12)
+if ! [[ "$JOBS" =~ ^[0-9]+$ ]] || [ "$JOBS" -lt 1 ] || [ "$JOBS" -gt 64 ]; then
+    echo -e "${RED}ERROR: --jobs must be 1..64${NC}"
+    exit 1
 fi
 
 header "open5GS Test Suite"
-echo "  Running ${#TESTS_TO_RUN[@]} test(s)"
+echo "  Running ${#TESTS_TO_RUN[@]} test(s)$([ "$REPEAT" -gt 1 ] && echo ", ${REPEAT} times each")$([ "$JOBS" -gt 1 ] && echo ", ${JOBS} in parallel")"
 echo "  Log: $SUMMARY_LOG"
 echo ""
 
 # Verify core is reachable before running tests
-cp_state=$(docker inspect --format='{{.State.Status}}' open5gs-cp 2>/dev/null || echo "not found")
+cp_state=$(docker inspect --format='{{.State.Status}}' $CP_CTR 2>/dev/null || echo "not found")
 if [ "$cp_state" != "running" ]; then
-    echo -e "${RED}ERROR: open5gs-cp is not running. Start with: ./open5gs.sh start --ueransim${NC}"
+    echo -e "${RED}ERROR: $CP_CTR is not running. Start with: ./open5gs.sh start --ueransim${NC}"
     exit 1
 fi
 
-# Run tests
+# ── Deployments ─────────────────────────────────────────────
+# Slot 0 is the deployment under test above; slot K > 0 is the isolated
+# copy o5gs-pK.
+INSTANCE_DIR="$SCRIPT_DIR/.instances"
+
+# Point this (sub)shell and the tests it starts at slot <k>
+use_slot() {
+    local k="$1"
+    [ "$k" -eq 0 ] && return
+    export O5GS_PREFIX="o5gs-p$k" O5GS_PROJECT="o5gs-p$k"
+    export O5GS_SUBNET="10.200.$(( 100 + k ))"
+    export O5GS_CONFIG_DIR="tests/.instances/p$k/config"
+    export O5GS_LOG_DIR="./tests/.instances/p$k/logs"
+    export O5GS_NGAP_PORT=$(( 38412 + k )) O5GS_WEBUI_PORT=$(( 4000 + k ))
+    o5gs_names
+}
+
+slot_name() {
+    if [ "$1" -eq 0 ]; then echo "$O5GS_PREFIX"; else echo "o5gs-p$1"; fi
+}
+
+# Start copy <k> from config/ with its own addresses; exit 0 once healthy
+instance_up() {
+    local k="$1" dir="$INSTANCE_DIR/p$1"
+    (
+        use_slot "$k"
+        rm -rf "$dir/config"
+        mkdir -p "$dir/logs/cp" "$dir/logs/upf"
+        cp -r "$PROJECT_DIR/config" "$dir/config"
+        sed -i "s/10\.200\.100\./${O5GS_SUBNET}./g; s/\bopen5gs-cp\b/${CP_CTR}/g" "$dir"/config/*.yaml
+        o5gs_compose --profile ueransim up -d open5gs-mongodb open5gs-cp open5gs-upf ueransim \
+            > "$dir/up.log" 2>&1 && wait_cp_healthy 180
+    )
+}
+
+instance_down() {
+    (
+        use_slot "$1"
+        o5gs_compose --profile ueransim --profile bench down -v --remove-orphans >/dev/null 2>&1
+    )
+}
+
+SLOTS=(0)
+INSTANCES=()
+instances_down() {
+    [ "$KEEP" = 1 ] && return
+    local k
+    for k in "${INSTANCES[@]}"; do
+        instance_down "$k"
+    done
+    INSTANCES=()
+}
+
+# ── Results ─────────────────────────────────────────────────
+# A repeated test keeps its worst result (FAILED over PASSED)
 declare -A RESULTS
-for tc_num in "${TESTS_TO_RUN[@]}"; do
-    script="${TC_SCRIPT[$tc_num]}"
-    name="${TC_NAME[$tc_num]}"
-    script_path="$SCRIPT_DIR/$script"
-    tc_log="$LOG_DIR/tc$(printf '%02d' $tc_num)_${TIMESTAMP}.log"
+declare -A RAN_ON
+
+tc_log_path() {
+    local log="$LOG_DIR/tc$(printf '%02d' "$1")_${TIMESTAMP}"
+    [ "$REPEAT" -gt 1 ] && log="${log}_$2"
+    echo "${log}.log"
+}
+
+# Usage: note_result <tc_num> <log> <slot>
+note_result() {
+    local tc_num="$1" tc_log="$2" where
+    if [ "${RESULTS[$tc_num]:-}" = "FAILED" ]; then
+        :
+    elif grep -q "PASSED\|PASS\b" "$tc_log" 2>/dev/null; then
+        RESULTS[$tc_num]="PASSED"
+    elif grep -q "FAILED\|FAIL\b" "$tc_log" 2>/dev/null; then
+        RESULTS[$tc_num]="FAILED"
+    else
+        RESULTS[$tc_num]="COMPLETED"
+    fi
+    where=$(slot_name "$3")
+    case " ${RAN_ON[$tc_num]:-} " in
+        *" $where "*) ;;
+        *) RAN_ON[$tc_num]="${RAN_ON[$tc_num]:+${RAN_ON[$tc_num]} }$where" ;;
+    esac
+}
+
+# Run one test in the foreground on slot <k>, output to its log and the terminal
+# Usage: run_tc <tc_num> <rep> <k>
+run_tc() {
+    local tc_num="$1" rep="$2" k="$3"
+    local script_path="$SCRIPT_DIR/${TC_SCRIPT[$tc_num]}"
+    local tc_log
+    tc_log=$(tc_log_path "$tc_num" "$rep")
 
-    echo -e "${BOLD}Running TC$(printf '%02d' $tc_num): ${name}${NC}"
+    echo -e "${BOLD}Running TC$(printf '%02d' $tc_num): ${TC_NAME[$tc_num]}$([ "$REPEAT" -gt 1 ] && echo " (${rep}/${REPEAT})")$([ "$JOBS" -gt 1 ] && echo " on $(slot_name "$k")")${NC}"
 
     if [ ! -f "$script_path" ]; then
-        echo -e "  ${YELLOW}SKIP${NC}: Script not found: $script"
+        echo -e "  ${YELLOW}SKIP${NC}: Script not found: ${TC_SCRIPT[$tc_num]}"
         RESULTS[$tc_num]="SKIP"
-        continue
+        return
     fi
 
     # Run the test, capture output to log and display
     set +e
-    bash "$script_path" 2>&1 | tee "$tc_log"
-    exit_code=${PIPESTATUS[0]}
+    (use_slot "$k"; bash "$script_path") 2>&1 | tee "$tc_log"
     set -e
 
-    if grep -q "PASSED\|PASS\b" "$tc_log" 2>/dev/null; then
-        RESULTS[$tc_num]="PASSED"
-    elif grep -q "FAILED\|FAIL\b" "$tc_log" 2>/dev/null; then
-        RESULTS[$tc_num]="FAILED"
-    else
-        RESULTS[$tc_num]="COMPLETED"
+    note_result "$tc_num" "$tc_log" "$k"
+    echo ""
+}
+
+# Run tests
+if [ "$JOBS" -eq 1 ]; then
+    for (( rep=1; rep<=REPEAT; rep++ )); do
+    for tc_num in "${TESTS_TO_RUN[@]}"; do
+        run_tc "$tc_num" "$rep" 0
+    done
+    done
+else
+    QUEUE=()
+    SERIAL=()
+    for (( rep=1; rep<=REPEAT; rep++ )); do
+    for tc_num in "${TESTS_TO_RUN[@]}"; do
+        if [ -n "${TC_EXCLUSIVE[$tc_num]:-}" ]; then
+            SERIAL+=("$tc_num:$rep")
+        else
+            QUEUE+=("$tc_num:$rep")
+        fi
+    done
+    done
+
+    trap 'jobs -p | xargs -r kill 2>/dev/null; instances_down' EXIT
+    trap 'exit 130' INT TERM
+
+    # One copy per slot beyond the shared one (at most one per parallel test)
+    n_inst=$(( JOBS - 1 ))
+    [ "$n_inst" -ge "${#QUEUE[@]}" ] && n_inst=$(( ${#QUEUE[@]} - 1 ))
+    if [ "$n_inst" -gt 0 ]; then
+        info "Starting ${n_inst} isolated deployment(s)..."
+        declare -A UP_PID
+        for (( k=1; k<=n_inst; k++ )); do
+            instance_up "$k" &
+            UP_PID[$k]=$!
+            INSTANCES+=("$k")
+        done
+        for (( k=1; k<=n_inst; k++ )); do
+            if wait "${UP_PID[$k]}"; then
+                pass "$(slot_name "$k") up (10.200.$(( 100 + k )).0/24)"
+                SLOTS+=("$k")
+            else
+                warn "$(slot_name "$k") did not become healthy — see $INSTANCE_DIR/p$k/up.log"
+            fi
+        done
+        echo ""
     fi
 
+    # Worker pool: each free slot takes the next queued test
+    declare -A SLOT_PID SLOT_JOB SLOT_T0
+    next=0
+    while [ "$next" -lt "${#QUEUE[@]}" ] || [ "${#SLOT_PID[@]}" -gt 0 ]; do
+        for k in "${SLOTS[@]}"; do
+            [ -n "${SLOT_PID[$k]:-}" ] && continue
+            [ "$next" -ge "${#QUEUE[@]}" ] && break
+            job="${QUEUE[$next]}"
+            next=$(( next + 1 ))
+            tc_num="${job%%:*}"
+            tc_log=$(tc_log_path "$tc_num" "${job#*:}")
+            printf "  ${CYAN}START${NC}   TC%02d: %s on %s\n" "$tc_num" "${TC_NAME[$tc_num]}" "$(slot_name "$k")"
+            (use_slot "$k"; bash "$SCRIPT_DIR/${TC_SCRIPT[$tc_num]}") > "$tc_log" 2>&1 &
+            SLOT_PID[$k]=$!
+            SLOT_JOB[$k]="$job"
+            SLOT_T0[$k]=$SECONDS
+        done
+        wait -n 2>/dev/null || true
+        for k in "${!SLOT_PID[@]}"; do
+            kill -0 "${SLOT_PID[$k]}" 2>/dev/null && continue
+            job="${SLOT_JOB[$k]}"
+            tc_num="${job%%:*}"
+            tc_log=$(tc_log_path "$tc_num" "${job#*:}")
+            note_result "$tc_num" "$tc_log" "$k"
+            printf "  %-6s  TC%02d: %s on %s (%ds)  %s\n" "${RESULTS[$tc_num]}" "$tc_num" \
+                "${TC_NAME[$tc_num]}" "$(slot_name "$k")" $(( SECONDS - SLOT_T0[$k] )) "$tc_log"
+            unset "SLOT_PID[$k]"
+        done
+    done
     echo ""
-done
+
+    # Exclusive tests: copies down, then one at a time on the shared deployment
+    instances_down
+    for job in "${SERIAL[@]}"; do
+        tc_num="${job%%:*}"
+        info "TC$(printf '%02d' "$tc_num") runs alone: ${TC_EXCLUSIVE[$tc_num]}"
+        run_tc "$tc_num" "${job#*:}" 0
+    done
+fi
 
 # Summary
 echo ""
@@ -123,6 +339,7 @@ skipped=0
 for tc_num in "${TESTS_TO_RUN[@]}"; do
     result="${RESULTS[$tc_num]:-SKIP}"
     name="${TC_NAME[$tc_num]}"
+    [ "$JOBS" -gt 1 ] && [ -n "${RAN_ON[$tc_num]:-}" ] && name="${name}  [${RAN_ON[$tc_num]}]"
     case "$result" in
         PASSED)
             printf "  ${GREEN}PASSED${NC}  TC%02d: %s\n" "$tc_num" "$name" | tee -a "$SUMMARY_LOG"
@@ -147,4 +364,17 @@ echo -e "  Total: ${#TESTS_TO_RUN[@]}  |  ${GREEN}Passed: ${passed}${NC}  |  ${R
 echo -e "  Logs saved to: $LOG_DIR/" | tee -a "$SUMMARY_LOG"
 echo ""
 
-[ "$failed" -eq 0 ]
+# Performance: this commit against the rolling baseline
+perf_rc=0
+if [ "${PERF_RECORD:-1}" != "0" ]; then
+    echo -e "${BOLD}  Performance vs baseline${NC}" | tee -a "$SUMMARY_LOG"
+    python3 "$SCRIPT_DIR/perf_store.py" compare --json "$LOG_DIR/perf_${TIMESTAMP}.json" \
+        2>&1 | sed 's/^/  /' | tee -a "$SUMMARY_LOG"
+    perf_rc=${PIPESTATUS[0]}
+    if [ "$perf_rc" -ne 0 ]; then
+        echo -e "  ${RED}PERF REGRESSION${NC}: see $LOG_DIR/perf_${TIMESTAMP}.json" | tee -a "$SUMMARY_LOG"
+    fi
+    echo ""
+fi
+
+[ "$failed" -eq 0 ] && [ "$perf_rc" -eq 0 ]
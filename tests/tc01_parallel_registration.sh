@@ -11,45 +11,40 @@ header "TC01: Parallel UE Registration (${NUM_UES} UEs)"
 
 ensure_core_running
 
-# Step 1: Provision subscribers
+# Step 1: Provision subscribers (one K for all: nr-ue -n increments the IMSI only)
 info "Provisioning ${NUM_UES} subscribers..."
-for (( i=0; i<NUM_UES; i++ )); do
-    supi_num=$(supi_add "$BASE_SUPI" "$i")
-    k=$(hex_add "$BASE_K" "$i")
-    provision_subscriber "$supi_num" "$k" "$OPC"
-done
-pass "Provisioned ${NUM_UES} subscribers"
+if provision_subscribers "$NUM_UES" internet same-key >/dev/null; then
+    pass "Provisioned ${NUM_UES} subscribers"
+else
+    fail "Bulk provisioning of ${NUM_UES} subscribers failed"
+fi
 
-# Step 2: Generate UE configs and launch all UEs simultaneously
-info "Generating configs and launching ${NUM_UES} UEs in parallel..."
+# Step 2: Launch all UEs from one nr-ue process
+info "Launching ${NUM_UES} UEs in parallel (nr-ue -n ${NUM_UES})..."
 kill_all_ues
 TMPDIR=$(mktemp -d)
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "${TMPDIR}/ue-group.yaml" "internet"
+docker cp "${TMPDIR}/ue-group.yaml" $UERANSIM_CTR:/ueransim/config/ue-group.yaml
+AMF_MARK=$(cp_log_mark amf)
+start_ue_group ./config/ue-group.yaml "$NUM_UES"
 
-for (( i=0; i<NUM_UES; i++ )); do
-    supi_num=$(supi_add "$BASE_SUPI" "$i")
-    k=$(hex_add "$BASE_K" "$i")
-    generate_ue_config "$supi_num" "$k" "$OPC" "${TMPDIR}/ue${i}.yaml" "internet"
-    docker cp "${TMPDIR}/ue${i}.yaml" open5gs-ueransim:/ueransim/config/ue${i}.yaml
-    docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue${i}.yaml
-done
-
-info "Waiting 20s for all UEs to register..."
-sleep 20
+info "Waiting for ${NUM_UES} registrations in the AMF log (max 60s)..."
+wait_amf_registrations "$AMF_MARK" "$NUM_UES" 60 >/dev/null
 
-# Step 3: Verify all registered
+# Step 3: Verify all registered (AMF "Registration complete" per IMSI)
+cp_log_since amf "$AMF_MARK" > "${TMPDIR}/amf.log"
 registered=0
 for (( i=0; i<NUM_UES; i++ )); do
-    supi_num=$(supi_add "$BASE_SUPI" "$i")
-    imsi="imsi-${supi_num}"
-    status=$(docker exec open5gs-ueransim ./nr-cli "$imsi" -e "status" 2>/dev/null)
-    if echo "$status" | grep -q "RM-REGISTERED"; then
+    imsi="imsi-$(printf "%0${#BASE_SUPI}d" $(( 10#$BASE_SUPI + i )))"
+    if grep -q "\[${imsi}\] Registration complete" "${TMPDIR}/amf.log"; then
         pass "UE ${imsi}: REGISTERED"
         registered=$((registered + 1))
     else
         fail "UE ${imsi}: NOT REGISTERED"
-        echo "$status" | head -3
     fi
 done
+info "Registration latency: $(python3 "$TESTS_DIR/ue_latency.py" --amf "${TMPDIR}/amf.log" \
+    --imsi "$BASE_SUPI" --expect "$NUM_UES" | sed -n 2p)"
 
 # Cleanup
 kill_all_ues
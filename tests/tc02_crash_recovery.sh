@@ -1,123 +1,335 @@
 #!/bin/bash
 # ============================================================
 # TC02: Component Crash & Recovery
-# Test resilience after UPF, CP, and MongoDB restarts
+# Test resilience after UPF, CP, MongoDB and AMF restarts, and time
+# each recovery
+# ============================================================
+# For every crash the test takes three times, in ms from the crash:
+#   serving    the crashed component works again: UPF PFCP-associated with
+#              the SMF, or the AMF health page SERVING (fresh, new pid)
+#   first_reg  first UE "Registration complete" in the AMF log
+#   all_ues    all TC02_UES UEs registered again
+# Scenarios:
+#   A  UPF container restart          C  MongoDB restart, then CP restart
+#   B  CP container kill + start      D  AMF process kill -9, respawned by
+#                                        start-cp-nfs.sh (AMF_RESPAWN=1, set
+#                                        by recreating the CP for D only)
+# UERANSIM's gNB does not redo NG Setup on its own and nr-ue does not keep
+# its 5G-GUTI across restarts, so after each crash the test restarts the
+# UERANSIM container and the UEs register from scratch: all_ues includes
+# that.
+# The three times per scenario go to the perf store (lower is better).
+#
+# Env:   TC02_UES        UEs registered around each crash (default: 3)
+#        TC02_TIMEOUT    seconds per recovery step (default: 120)
+#        TC02_SCENARIOS  default: "A B C D"
+# exclusive: recovery times
 # ============================================================
 source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
 
-header "TC02: Component Crash & Recovery"
-
-ensure_core_running
+TC02_UES="${TC02_UES:-3}"
+TC02_TIMEOUT="${TC02_TIMEOUT:-120}"
+TC02_SCENARIOS="${TC02_SCENARIOS:-A B C D}"
 
-IMSI="$DEFAULT_IMSI"
+header "TC02: Component Crash & Recovery (${TC02_UES} UEs)"
 
-# ── Test A: UPF Crash & Recovery ──────────────────────────────
-echo ""
-info "=== Test A: UPF Crash & Recovery ==="
-
-# Register baseline UE
-docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue.yaml
-sleep 12
+ensure_core_running
 
-status=$(docker exec open5gs-ueransim ./nr-cli "$IMSI" -e "status" 2>/dev/null)
-if echo "$status" | grep -q "RM-REGISTERED"; then
-    pass "Baseline UE registered"
-else
-    fail "Baseline registration failed — aborting TC02"
+workdir_init tc02
+CP_RECREATED=0
+# Scenario D turns AMF_RESPAWN on: back to the compose defaults afterwards
+cleanup() {
     kill_all_ues
-    exit 1
-fi
+    if [ "$CP_RECREATED" = 1 ]; then
+        info "Recreating ${CP_CTR} with the compose defaults..."
+        cp_recreate || warn "${CP_CTR} not healthy after recreate"
+        reset_ueransim
+    fi
+}
+on_exit cleanup
 
-# Kill and restart UPF
-info "Restarting UPF (simulating crash)..."
 kill_all_ues
-docker restart open5gs-upf >/dev/null 2>&1
-sleep 15
-
-# Restart gNB to clear stale state, then re-register
-docker restart open5gs-ueransim >/dev/null 2>&1
-sleep 10
-docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue.yaml
-sleep 12
-
-status=$(docker exec open5gs-ueransim ./nr-cli "$IMSI" -e "status" 2>/dev/null)
-if echo "$status" | grep -q "RM-REGISTERED"; then
-    pass "Test A: UE re-registered after UPF restart"
+info "Provisioning ${TC02_UES} subscribers..."
+if provision_subscribers "$TC02_UES" internet same-key >/dev/null; then
+    pass "Provisioned ${TC02_UES} subscribers"
 else
-    fail "Test A: UE failed to re-register after UPF restart"
+    fail "Bulk provisioning of ${TC02_UES} subscribers failed — aborting TC02"
+    exit 1
 fi
-kill_all_ues
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "$WORKDIR/tc02-ue.yaml" "internet"
 
-# ── Test B: Control Plane Crash & Recovery ─────────────────────
-echo ""
-info "=== Test B: Control Plane (CP) Crash & Recovery ==="
+now_ms() { date +%s%3N; }
 
-info "Restarting open5gs-cp (simulating CP crash)..."
-docker restart open5gs-cp >/dev/null 2>&1
+# Copy the UE config in (again after a UERANSIM restart) and start the group
+start_ues() {
+    docker cp "$WORKDIR/tc02-ue.yaml" $UERANSIM_CTR:/ueransim/config/tc02-ue.yaml >/dev/null 2>&1
+    start_ue_group ./config/tc02-ue.yaml "$TC02_UES"
+}
 
-# Wait for CP to become healthy (NRF SBI check)
-info "Waiting for CP to recover (up to 120s)..."
-if wait_cp_healthy 120; then
-    pass "CP recovered and is healthy"
-else
-    fail "CP did not recover within 120s"
-fi
+# Baseline before a crash: all UEs registered.  Usage: baseline <scenario>
+baseline() {
+    local mark n
+    kill_all_ues
+    mark=$(cp_log_mark amf)
+    start_ues
+    n=$(wait_amf_registrations "$mark" "$TC02_UES" 60)
+    if [ "$n" -ge "$TC02_UES" ]; then
+        pass "Test $1: baseline ${n}/${TC02_UES} UEs registered"
+    else
+        fail "Test $1: baseline registration ${n}/${TC02_UES}"
+        return 1
+    fi
+}
 
-# Restart UERANSIM to reconnect gNB after CP restart
-docker restart open5gs-ueransim >/dev/null 2>&1
-if wait_gnb_connected 60; then
-    info "gNB reconnected after CP restart"
-else
-    warn "gNB did not show NG Setup within 60s"
-fi
-sleep 5
+# Block until the AMF health page is SERVING and fresh, published by a pid
+# other than [old_pid]; prints ms since <t0>.  One docker exec polls every
+# 50 ms inside the container and is re-entered while the container is down.
+# Usage: wait_serving_ms <t0> [old_pid]
+wait_serving_ms() {
+    local t0="$1" old="${2:-none}" deadline=$(( $1 + TC02_TIMEOUT * 1000 ))
+    while [ "$(now_ms)" -lt "$deadline" ]; do
+        if docker exec $CP_CTR sh -c "
+            end=\$(( \$(date +%s) + $TC02_TIMEOUT ))
+            while [ \$(date +%s) -lt \$end ]; do
+                case \"\$(/open5gs/amf-health-shm --json 2>/dev/null)\" in
+                    *'\"pid\":$old,'*) ;;
+                    *'\"status\":\"SERVING\",\"fresh\":true'*) exit 0 ;;
+                esac
+                sleep 0.05
+            done
+            exit 1" 2>/dev/null; then
+            echo $(( $(now_ms) - t0 ))
+            return 0
+        fi
+        sleep 0.2
+    done
+    return 1
+}
 
-docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue.yaml
-sleep 20
+# Block until <pattern> shows in an NF log after <mark>; prints ms since <t0>
+# Usage: wait_log_ms <t0> <nf> <mark> <pattern>
+wait_log_ms() {
+    local t0="$1" deadline=$(( $1 + TC02_TIMEOUT * 1000 ))
+    while [ "$(now_ms)" -lt "$deadline" ]; do
+        if docker exec $CP_CTR sh -c "
+            end=\$(( \$(date +%s) + $TC02_TIMEOUT ))
+            while [ \$(date +%s) -lt \$end ]; do
+                tail -c +$(( $3 + 1 )) /var/log/open5gs/$2.log 2>/dev/null \
+                    | grep -q '$4' && exit 0
+                sleep 0.05
+            done
+            exit 1" 2>/dev/null; then
+            echo $(( $(now_ms) - t0 ))
+            return 0
+        fi
+        sleep 0.2
+    done
+    return 1
+}
 
-status=$(docker exec open5gs-ueransim ./nr-cli "$IMSI" -e "status" 2>/dev/null)
-if echo "$status" | grep -q "RM-REGISTERED"; then
-    pass "Test B: UE re-registered after CP restart"
-else
-    fail "Test B: UE failed to re-register after CP restart"
-fi
-kill_all_ues
+# Restart UERANSIM (new gNB NG Setup), start the UEs and time their
+# registrations since <t0>.  Sets FIRST_MS and ALL_MS ("-" if not reached).
+# Usage: ues_back <t0> <amf-log-mark>
+ues_back() {
+    local t0="$1" mark="$2" deadline=$(( $1 + TC02_TIMEOUT * 1000 )) n
+    FIRST_MS="-" ALL_MS="-"
+    docker restart -t 1 $UERANSIM_CTR >/dev/null 2>&1
+    wait_gnb_connected 60 || warn "gNB did not show NG Setup within 60s"
+    start_ues
+    # Event stream: block on the first, then on all registrations
+    if [ "$mark" != "${mark#*@}" ]; then
+        amf_events --since "${mark#*@}" --wait ue_registered --count 1 \
+            --timeout "$TC02_TIMEOUT" >/dev/null || return 1
+        FIRST_MS=$(( $(now_ms) - t0 ))
+        wait_amf_registrations "$mark" "$TC02_UES" \
+            $(( (deadline - $(now_ms)) / 1000 + 1 )) >/dev/null || return 1
+        ALL_MS=$(( $(now_ms) - t0 ))
+        return 0
+    fi
+    while [ "$(now_ms)" -lt "$deadline" ]; do
+        n=$(cp_log_since amf "$mark" \
+            | grep -o '\[imsi-[0-9]*\] Registration complete' | sort -u | wc -l)
+        [ "$n" -ge 1 ] && [ "$FIRST_MS" = "-" ] && FIRST_MS=$(( $(now_ms) - t0 ))
+        if [ "$n" -ge "$TC02_UES" ]; then
+            ALL_MS=$(( $(now_ms) - t0 ))
+            return 0
+        fi
+        sleep 0.25
+    done
+    return 1
+}
+
+fmt_ms() { [ "$1" = "-" ] && echo "-" || printf '%d.%03ds' $(( $1 / 1000 )) $(( $1 % 1000 )); }
+
+declare -A R_SERVING R_FIRST R_ALL R_RESULT
+FAILURES=0
+
+# Record one scenario: perf store, summary row, pass/fail line
+# Usage: report <scenario> <label> <serving_ms>
+report() {
+    local s="$1" label="$2"
+    R_SERVING[$s]="$3" R_FIRST[$s]="$FIRST_MS" R_ALL[$s]="$ALL_MS"
+    perf_record tc02 "${s}_serving_ms"   "$3"        ms lower
+    perf_record tc02 "${s}_first_reg_ms" "$FIRST_MS" ms lower
+    perf_record tc02 "${s}_all_ues_ms"   "$ALL_MS"   ms lower
+    if [ "$ALL_MS" != "-" ]; then
+        R_RESULT[$s]=PASS
+        pass "Test ${s}: ${TC02_UES} UEs re-registered after ${label} \
+(serving $(fmt_ms "$3"), first $(fmt_ms "$FIRST_MS"), all $(fmt_ms "$ALL_MS"))"
+    else
+        R_RESULT[$s]=FAIL
+        FAILURES=$((FAILURES + 1))
+        fail "Test ${s}: UEs did not all re-register after ${label} within ${TC02_TIMEOUT}s"
+    fi
+}
+
+# start-cp-nfs.sh gates each NF on its port + NRF registration; show how
+# long each step took on the last CP start
+show_timeline() {
+    local timeline
+    timeline=$(cp_startup_timeline)
+    [ -z "$timeline" ] && return
+    info "CP startup timeline (seconds since container start):"
+    echo "$timeline" | while IFS= read -r line; do echo "    $line"; done
+    if echo "$timeline" | grep -qE " (timeout|failed) +[^ ]+$"; then
+        warn "Some NFs did not reach readiness during startup"
+    fi
+}
+
+# ── Test A: UPF Crash & Recovery ──────────────────────────────
+scenario_A() {
+    echo ""
+    info "=== Test A: UPF Crash & Recovery ==="
+    baseline A || return 1
+    kill_all_ues
+
+    local smf_mark amf_mark t0 serving
+    smf_mark=$(cp_log_mark smf)
+    amf_mark=$(cp_log_mark amf)
+    info "Restarting UPF (simulating crash)..."
+    t0=$(now_ms)
+    docker restart -t 0 $UPF_CTR >/dev/null 2>&1
+    if serving=$(wait_log_ms "$t0" smf "$smf_mark" "PFCP associated"); then
+        info "UPF PFCP-associated with the SMF $(fmt_ms "$serving") after the crash"
+    else
+        serving="-"
+        warn "No new PFCP association in the SMF log within ${TC02_TIMEOUT}s"
+    fi
+    ues_back "$t0" "$amf_mark"
+    report A "UPF restart" "$serving"
+}
+
+# ── Test B: Control Plane Crash & Recovery ─────────────────────
+scenario_B() {
+    echo ""
+    info "=== Test B: Control Plane (CP) Crash & Recovery ==="
+    baseline B || return 1
+    kill_all_ues
+
+    local amf_mark t0 serving
+    amf_mark=$(cp_log_mark amf)
+    info "Killing and starting $CP_CTR (simulating CP crash)..."
+    t0=$(now_ms)
+    docker restart -t 0 $CP_CTR >/dev/null 2>&1
+    if serving=$(wait_serving_ms "$t0"); then
+        pass "CP recovered and is healthy ($(fmt_ms "$serving") after the crash)"
+    else
+        serving="-"
+        fail "CP did not recover within ${TC02_TIMEOUT}s"
+    fi
+    show_timeline
+    ues_back "$t0" "$amf_mark"
+    report B "CP restart" "$serving"
+}
 
 # ── Test C: MongoDB Crash & Recovery ──────────────────────────
-echo ""
-info "=== Test C: MongoDB Crash & Recovery ==="
+scenario_C() {
+    echo ""
+    info "=== Test C: MongoDB Crash & Recovery ==="
+    baseline C || return 1
+    kill_all_ues
 
-info "Restarting open5gs-mongodb (simulating DB crash)..."
-docker restart open5gs-mongodb >/dev/null 2>&1
-sleep 15
+    local amf_mark t0 serving
+    amf_mark=$(cp_log_mark amf)
+    info "Restarting $MONGO_CTR (simulating DB crash)..."
+    t0=$(now_ms)
+    docker restart -t 0 $MONGO_CTR >/dev/null 2>&1
 
-# CP should reconnect to MongoDB automatically; also restart CP to force reconnect
-info "Restarting CP after MongoDB recovery..."
-docker restart open5gs-cp >/dev/null 2>&1
-if wait_cp_healthy 120; then
-    pass "CP healthy after MongoDB restart"
-else
-    fail "CP unhealthy after MongoDB restart"
-fi
+    # CP should reconnect to MongoDB automatically; also restart CP to force reconnect
+    info "Restarting CP after MongoDB recovery..."
+    docker restart $CP_CTR >/dev/null 2>&1
+    if serving=$(wait_serving_ms "$t0"); then
+        pass "CP healthy after MongoDB restart ($(fmt_ms "$serving") after the crash)"
+    else
+        serving="-"
+        fail "CP unhealthy after MongoDB restart"
+    fi
+    ues_back "$t0" "$amf_mark"
+    report C "MongoDB restart" "$serving"
+}
 
-docker restart open5gs-ueransim >/dev/null 2>&1
-if wait_gnb_connected 60; then
-    info "gNB reconnected after MongoDB+CP restart"
-else
-    warn "gNB did not show NG Setup within 60s"
-fi
-sleep 5
-docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue.yaml
-sleep 20
+# ── Test D: AMF Process Crash & Respawn ────────────────────────
+scenario_D() {
+    echo ""
+    info "=== Test D: AMF Process Crash & Respawn ==="
+    if [ "$(docker exec $CP_CTR sh -c 'echo ${AMF_RESPAWN:-0}' 2>/dev/null)" != "1" ]; then
+        info "Recreating ${CP_CTR} with AMF_RESPAWN=1..."
+        CP_RECREATED=1
+        if ! cp_recreate AMF_RESPAWN=1; then
+            fail "${CP_CTR} not healthy after recreate"
+            return 1
+        fi
+        docker restart -t 1 $UERANSIM_CTR >/dev/null 2>&1
+        wait_gnb_connected 60 || warn "gNB did not show NG Setup within 60s"
+    fi
+    baseline D || return 1
 
-status=$(docker exec open5gs-ueransim ./nr-cli "$IMSI" -e "status" 2>/dev/null)
-if echo "$status" | grep -q "RM-REGISTERED"; then
-    pass "Test C: UE re-registered after MongoDB restart"
-else
-    fail "Test C: UE failed to re-register after MongoDB restart"
-fi
-kill_all_ues
+    local amf_mark t0 serving old_pid
+    old_pid=$(amf_health_field pid)
+    amf_mark=$(cp_log_mark amf)
+    if [ -z "$old_pid" ]; then
+        fail "No AMF pid on the health page"
+        return 1
+    fi
+    info "kill -9 open5gs-amfd (pid ${old_pid})..."
+    t0=$(now_ms)
+    docker exec $CP_CTR kill -9 "$old_pid" 2>/dev/null
+    if serving=$(wait_serving_ms "$t0" "$old_pid"); then
+        pass "Respawned AMF SERVING $(fmt_ms "$serving") after the kill"
+    else
+        serving="-"
+        fail "AMF not SERVING again within ${TC02_TIMEOUT}s"
+    fi
+
+    ues_back "$t0" "$amf_mark"
+    report D "AMF kill -9" "$serving"
+}
+
+for s in $TC02_SCENARIOS; do
+    case "$s" in
+        A|B|C|D) scenario_$s || { R_RESULT[$s]=FAIL; FAILURES=$((FAILURES + 1)); } ;;
+        *) warn "unknown scenario '${s}', skipped" ;;
+    esac
+done
 
 # Summary
 echo ""
-echo -e "${BOLD}TC02 Complete${NC}: Crash recovery tested for UPF, CP, and MongoDB."
+info "Recovery times (from the crash):"
+printf '    %-4s %-18s %10s %10s %10s  %s\n' TEST CRASH SERVING FIRST-REG ALL-UES RESULT
+for s in $TC02_SCENARIOS; do
+    case "$s" in
+        A) label="UPF restart" ;;      B) label="CP restart" ;;
+        C) label="MongoDB restart" ;;  D) label="AMF kill -9" ;;
+        *) continue ;;
+    esac
+    printf '    %-4s %-18s %10s %10s %10s  %s\n' "$s" "$label" \
+        "$(fmt_ms "${R_SERVING[$s]:--}")" "$(fmt_ms "${R_FIRST[$s]:--}")" \
+        "$(fmt_ms "${R_ALL[$s]:--}")" "${R_RESULT[$s]:--}"
+done
+
+echo ""
+if [ "$FAILURES" -gt 0 ]; then
+    echo -e "${RED}${BOLD}TC02 FAILED${NC}: ${FAILURES} recovery step(s) failed"
+    exit 1
+fi
+echo -e "${GREEN}${BOLD}TC02 PASSED${NC}: Recovered from crashes: ${TC02_SCENARIOS}"
@@ -16,6 +16,14 @@
 #   Step 3  — Wire-format handshake simulation (host server + container client)
 #             proves the same framing code works for registration AND health check
 #   Step 4  — If AMF_CNODE_SERVER_IP configured: connectivity + registration log
+#   Step 5  — If AMF_UDP_ENABLE=1: UDP fast-probe with nonce echo (port 50051)
+#   Step 6  — Shared-memory health page: SERVING, fresh, load counters sane
+#   Step 7  — If AMF_GRPC_ENABLE=1: grpc.health.v1 Check + Watch over h2c
+#   Step 8  — Raw TCP watch: initial push, then time from an injected
+#             main-loop stall to NOT_SERVING arriving.  AMF_HEALTH_FAULT_INJECT
+#             is off in compose: the CP is recreated with it on for this
+#             step and back to the defaults at exit
+# exclusive: health probe RTT, stall detection time
 # ============================================================
 source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
 
@@ -23,16 +31,26 @@ header "TC09: AMF cnode Registration & Health Check"
 
 ensure_core_running
 
+CP_RECREATED=0
+cleanup() {
+    if [ "$CP_RECREATED" = 1 ]; then
+        info "Recreating ${CP_CTR} with the compose defaults..."
+        cp_recreate || warn "${CP_CTR} not healthy after recreate"
+        reset_ueransim
+    fi
+}
+trap cleanup EXIT
+
 # ── Detect Docker bridge gateway (host IP reachable from container) ───────────
-DOCKER_HOST_IP=$(docker network inspect open5gs-net \
+DOCKER_HOST_IP=$(docker network inspect $O5GS_NET \
     --format '{{range .IPAM.Config}}{{.Gateway}}{{end}}' 2>/dev/null \
     | head -1)
-DOCKER_HOST_IP="${DOCKER_HOST_IP:-10.200.100.1}"
+DOCKER_HOST_IP="${DOCKER_HOST_IP:-${O5GS_SUBNET}.1}"
 info "Docker bridge gateway (host IP from container): ${DOCKER_HOST_IP}"
 
 # ── Step 1: AMF_CNODE_ENABLE env var ─────────────────────────────────────────
 info "Step 1: Checking AMF_CNODE_ENABLE environment variable..."
-cnode_enable=$(docker exec open5gs-cp printenv AMF_CNODE_ENABLE 2>/dev/null || echo "")
+cnode_enable=$(docker exec $CP_CTR printenv AMF_CNODE_ENABLE 2>/dev/null || echo "")
 if [ "$cnode_enable" = "1" ]; then
     pass "AMF_CNODE_ENABLE=1 (cnode client enabled)"
 else
@@ -41,7 +59,7 @@ fi
 
 # ── Step 2: AMF log check ─────────────────────────────────────────────────────
 info "Step 2: Checking AMF log for [AMF-cnode] messages..."
-amf_log=$(docker exec open5gs-cp cat /var/log/open5gs/amf.log 2>/dev/null)
+amf_log=$(docker exec $CP_CTR cat /var/log/open5gs/amf.log 2>/dev/null)
 
 cnode_lines=$(echo "$amf_log" | grep "\[AMF-cnode\]" | head -10)
 if [ -n "$cnode_lines" ]; then
@@ -244,7 +262,7 @@ done
 
 if [ "$ready" -eq 1 ]; then
     # Run client from inside the container, connecting to host
-    client_out=$(docker exec open5gs-cp python3 -c "$CLIENT_SCRIPT" \
+    client_out=$(docker exec $CP_CTR python3 -c "$CLIENT_SCRIPT" \
         "$DOCKER_HOST_IP" "$TEST_PORT" 2>/dev/null)
 
     # Wait for server to finish
@@ -293,14 +311,14 @@ rm -f "$SERVER_OUT_FILE"
 
 # ── Step 4: Real cnode server connectivity (if configured) ────────────────────
 info "Step 4: Checking real cnode server configuration..."
-cnode_ip=$(docker exec open5gs-cp printenv AMF_CNODE_SERVER_IP 2>/dev/null || echo "")
-cnode_port=$(docker exec open5gs-cp printenv AMF_CNODE_SERVER_PORT 2>/dev/null || echo "9090")
+cnode_ip=$(docker exec $CP_CTR printenv AMF_CNODE_SERVER_IP 2>/dev/null || echo "")
+cnode_port=$(docker exec $CP_CTR printenv AMF_CNODE_SERVER_PORT 2>/dev/null || echo "9090")
 
 if [ -n "$cnode_ip" ]; then
     info "AMF_CNODE_SERVER_IP=${cnode_ip}  AMF_CNODE_SERVER_PORT=${cnode_port}"
 
     # Test TCP connectivity from inside container
-    conn_check=$(docker exec open5gs-cp bash -c \
+    conn_check=$(docker exec $CP_CTR bash -c \
         "timeout 3 bash -c \"</dev/tcp/${cnode_ip}/${cnode_port}\" 2>/dev/null && echo ok || echo fail" \
         2>/dev/null)
     if [ "$conn_check" = "ok" ]; then
@@ -310,16 +328,179 @@ if [ -n "$cnode_ip" ]; then
     fi
 
     if check_amf_cnode_registered; then
-        pass "AMF log confirms registration with cnode server at ${cnode_ip}:${cnode_port} ✓"
+        pass "AMF confirms registration with cnode server at ${cnode_ip}:${cnode_port} ✓"
     else
-        warn "No registration confirmation in AMF log yet (may still be connecting)"
+        warn "No registration confirmation from the AMF within 10s (may still be connecting)"
     fi
 else
     info "AMF_CNODE_SERVER_IP not set — real server connectivity test skipped"
     info "Set AMF_CNODE_SERVER_IP in docker-compose.yaml to activate cnode"
 fi
 
-# ── Summary ───────────────────────────────────────────────────────────────────
+# ── Step 5: UDP fast-probe (if enabled) ──────────────────────────────────────
+info "Step 5: Checking AMF UDP fast-probe..."
+udp_enable=$(docker exec $CP_CTR printenv AMF_UDP_ENABLE 2>/dev/null || echo "")
+udp_port=$(docker exec $CP_CTR printenv AMF_UDP_PORT 2>/dev/null || echo "")
+udp_port="${udp_port:-$AMF_HEALTH_DEFAULT_PORT}"
+
+if [ "$udp_enable" = "1" ]; then
+    udp_out=$(python3 "$TESTS_DIR/amf_health_probe.py" --host "$AMF_HEALTH_IP" \
+        --port "$udp_port" --udp --count 200 --window 32 2>&1)
+    if [ $? -eq 0 ]; then
+        pass "UDP fast-probe: 200/200 SERVING with matching nonce ✓"
+    else
+        fail "UDP fast-probe did not answer every probe"
+    fi
+    echo "$udp_out" | while IFS= read -r line; do echo "    $line"; done
+    rtt=$(echo "$udp_out" | sed -n 's/.*rtt p50=\([0-9.]*\)us p99=\([0-9.]*\)us.*/\1 \2/p')
+    perf_record tc09 udp_rtt_p50_us "${rtt% *}" us lower
+    perf_record tc09 udp_rtt_p99_us "${rtt#* }" us lower
+else
+    info "AMF_UDP_ENABLE not set — UDP fast-probe test skipped"
+fi
+
+# ── Step 6: Shared-memory health page ───────────────────────────────────────
+info "Step 6: Reading AMF shared-memory health page..."
+page=$(amf_health_page)
+page_rc=$?
+
+if [ $page_rc -eq 0 ]; then
+    pass "Health page: SERVING and fresh ✓"
+elif [ $page_rc -eq 1 ]; then
+    fail "Health page reports NOT_SERVING or stale"
+else
+    warn "Health page not readable (AMF_HEALTH_SHM_ENABLE=0 or old image?)"
+fi
+if [ -n "$page" ]; then
+    echo "$page" | while IFS= read -r line; do echo "    $line"; done
+    gnbs=$(echo "$page" | awk -F= '$1 == "gnbs" { print $2 }')
+    if [ "${gnbs:-0}" -ge 1 ]; then
+        pass "Health page load counters: ${gnbs} gNB(s) connected"
+    else
+        warn "Health page shows no connected gNB"
+    fi
+fi
+
+# ── Step 7: gRPC health service (if enabled) ─────────────────────────────────
+info "Step 7: Checking grpc.health.v1 service on the health port..."
+grpc_enable=$(docker exec $CP_CTR printenv AMF_GRPC_ENABLE 2>/dev/null || echo "")
+tcp_port=$(docker exec $CP_CTR printenv AMF_TCP_PORT 2>/dev/null || echo "")
+tcp_port="${tcp_port:-$AMF_HEALTH_DEFAULT_PORT}"
+
+if [ "$grpc_enable" = "1" ]; then
+    grpc_out=$(python3 "$TESTS_DIR/amf_health_probe.py" --host "$AMF_HEALTH_IP" \
+        --port "$tcp_port" --grpc --count 20 2>&1)
+    if [ $? -eq 0 ]; then
+        pass "gRPC Check: 20/20 SERVING over h2c ✓"
+    else
+        fail "gRPC Check did not return SERVING"
+    fi
+    echo "$grpc_out" | while IFS= read -r line; do echo "    $line"; done
+
+    watch_out=$(python3 "$TESTS_DIR/amf_health_probe.py" --host "$AMF_HEALTH_IP" \
+        --port "$tcp_port" --grpc --watch 2 2>&1)
+    if echo "$watch_out" | head -1 | grep -q "status=SERVING"; then
+        pass "gRPC Watch: initial SERVING pushed ✓"
+    else
+        fail "gRPC Watch did not push an initial status"
+    fi
+    echo "$watch_out" | while IFS= read -r line; do echo "    $line"; done
+
+    # Raw protocol must be unaffected by the HTTP/2 preface sniffing
+    if python3 "$TESTS_DIR/amf_health_probe.py" --host "$AMF_HEALTH_IP" \
+        --port "$tcp_port" >/dev/null 2>&1; then
+        pass "Raw TCP probe still SERVING on the shared port"
+    else
+        fail "Raw TCP probe broken while gRPC is enabled"
+    fi
+else
+    info "AMF_GRPC_ENABLE not set — gRPC health test skipped"
+fi
+
+# ── Step 8: Watch push latency ───────────────────────────────────────────────
+# The collector subscribes once (watch=true) and the AMF pushes transitions.
+# An injected stall must reach it within stall_ms + monitor tick + slack,
+# with no polling on either side.
+info "Step 8: Checking raw TCP watch push..."
+fault_enable=$(docker exec $CP_CTR printenv AMF_HEALTH_FAULT_INJECT 2>/dev/null || echo "")
+if [ "$fault_enable" != "1" ] && [ "${TC09_FAULT_INJECT:-1}" = "1" ]; then
+    info "Recreating ${CP_CTR} with AMF_HEALTH_FAULT_INJECT=1..."
+    CP_RECREATED=1
+    if cp_recreate AMF_HEALTH_FAULT_INJECT=1; then
+        fault_enable=$(docker exec $CP_CTR printenv AMF_HEALTH_FAULT_INJECT 2>/dev/null || echo "")
+    else
+        warn "${CP_CTR} not healthy after recreate"
+    fi
+fi
+stall_ms=$(amf_health_field stall_ms 2>/dev/null)
+tick_ms=$(amf_health_field tick_ms 2>/dev/null)
+stall_ms="${stall_ms:-2000}"
+tick_ms="${tick_ms:-250}"
+
+if [ "$fault_enable" = "1" ]; then
+    watch_log=$(mktemp)
+    inject_ms=$((stall_ms + 1500))
+    python3 "$TESTS_DIR/amf_health_probe.py" --host "$AMF_HEALTH_IP" \
+        --port "$tcp_port" --watch $(( (inject_ms + 6000) / 1000 )) --json \
+        > "$watch_log" 2>&1 &
+    watch_pid=$!
+    sleep 1
+
+    t_inject=$(date +%s.%N)
+    docker exec $CP_CTR sh -c "echo ${inject_ms} > /dev/shm/open5gs-amf-stall"
+    wait "$watch_pid"
+
+    read -r first not_serving recovered < <(python3 - "$watch_log" "$t_inject" <<'PYEOF'
+import json, sys
+t0 = float(sys.argv[2])
+first = ns = rec = "-"
+for line in open(sys.argv[1]):
+    try:
+        m = json.loads(line)
+    except ValueError:
+        continue
+    if first == "-":
+        first = m["status"]
+    elif ns == "-" and m["status"] == "NOT_SERVING":
+        ns = "%d" % ((m["t"] - t0) * 1000)
+    elif ns != "-" and rec == "-" and m["status"] == "SERVING":
+        rec = "%d" % ((m["t"] - t0) * 1000)
+print(first, ns, rec)
+PYEOF
+)
+    rm -f "$watch_log"
+
+    if [ "$first" = "SERVING" ]; then
+        pass "Watch: initial SERVING on subscribe ✓"
+    else
+        fail "Watch: no initial response (got: ${first})"
+    fi
+
+    budget_ms=$((stall_ms + 2 * tick_ms + 500))
+    if [ "$not_serving" = "-" ]; then
+        fail "Watch: NOT_SERVING never pushed after a ${inject_ms}ms stall"
+    elif [ "$not_serving" -le "$budget_ms" ]; then
+        pass "Watch: stall → NOT_SERVING pushed in ${not_serving}ms (stall_ms ${stall_ms}, budget ${budget_ms}ms) ✓"
+        perf_record tc09 watch_not_serving_ms "$not_serving" ms lower
+    else
+        fail "Watch: NOT_SERVING took ${not_serving}ms (budget ${budget_ms}ms)"
+    fi
+    if [ "$recovered" != "-" ]; then
+        pass "Watch: recovery → SERVING pushed at +${recovered}ms"
+    else
+        fail "Watch: SERVING not pushed after the stall ended"
+    fi
+else
+    watch_out=$(python3 "$TESTS_DIR/amf_health_probe.py" --host "$AMF_HEALTH_IP" \
+        --port "$tcp_port" --watch 2 2>&1)
+    if echo "$watch_out" | head -1 | grep -q "status=SERVING"; then
+        pass "Watch: initial SERVING on subscribe ✓"
+    else
+        fail "Watch: no initial response"
+    fi
+    info "AMF_HEALTH_FAULT_INJECT not on (TC09_FAULT_INJECT=0?) — stall → NOT_SERVING latency skipped"
+fi
+
 echo ""
 log_ok=$([ -n "$cnode_lines" ] && echo "1" || echo "0")
 
@@ -332,6 +513,6 @@ elif [ "$HANDSHAKE_RESULT" = "skip" ]; then
     info "  Env var and log checks completed above"
 else
     echo -e "${RED}${BOLD}TC09 FAILED${NC}: AMF cnode handshake not working as expected"
-    info "  Check: docker exec open5gs-cp printenv AMF_CNODE_ENABLE"
-    info "  Check: docker exec open5gs-cp cat /var/log/open5gs/amf.log | grep cnode"
+    info "  Check: docker exec $CP_CTR printenv AMF_CNODE_ENABLE"
+    info "  Check: docker exec $CP_CTR cat /var/log/open5gs/amf.log | grep cnode"
 fi
@@ -1,14 +1,31 @@
 #!/bin/bash
 # ============================================================
 # TC10: Memory Leak / Long-running Stability
-# Register/deregister UEs in cycles and monitor memory growth
+# Register/deregister UEs in cycles; per-NF growth per cycle
+# ============================================================
+# open5gs-memstat runs in open5gs-cp and open5gs-upf and samples every NF
+# process (smaps_rollup, plus the ogs-memstat page: glibc heap, talloc,
+# ogs_pool in-use counts).  After each cycle, once the UEs are gone, the
+# test records a mark; tests/mem_profile.py then fits each NF's growth per
+# cycle (leaving out TC10_WARMUP cycles) and gives it a verdict:
+#   leak  a pool grows >= 0.5 entries/cycle, or heap / talloc / anon
+#         memory >= TC10_SLOPE_KB per cycle, on a clean linear fit
+#   warn  memory over the slope but noisy, or the NF restarted
+# Pool counts are exact, so one UE per cycle is enough to catch a context
+# that is never freed: tc10_memory_leak.sh 20 1
+#
+# Usage: tc10_memory_leak.sh [cycles] [ues_per_cycle]
+# Env:   TC10_WARMUP     cycles left out of the fit (default: 2)
+#        TC10_SLOPE_KB   memory slope that counts as a leak (default: 8 kB/cycle)
+#        TC10_SAMPLE_MS  sampler period (default: 200)
 # ============================================================
 source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
 
 CYCLES="${1:-10}"
 NUM_UES="${2:-3}"
-LEAK_THRESHOLD=20   # fail if memory grows > 20%
-WARN_THRESHOLD=10   # warn if memory grows > 10%
+TC10_WARMUP="${TC10_WARMUP:-2}"
+TC10_SLOPE_KB="${TC10_SLOPE_KB:-8}"
+TC10_SAMPLE_MS="${TC10_SAMPLE_MS:-200}"
 
 header "TC10: Memory Leak / Stability (${CYCLES} cycles, ${NUM_UES} UEs)"
 
@@ -16,150 +33,117 @@ ensure_core_running
 
 # Step 1: Provision subscribers
 info "Provisioning ${NUM_UES} test subscribers..."
-for (( i=0; i<NUM_UES; i++ )); do
-    supi_num=$(supi_add "$BASE_SUPI" "$i")
-    k=$(hex_add "$BASE_K" "$i")
-    provision_subscriber "$supi_num" "$k" "$OPC"
-done
-pass "Provisioned ${NUM_UES} subscribers"
-
-# Step 2: Capture baseline memory
-info "Capturing baseline memory usage..."
-get_mem() {
-    local container="$1"
-    docker stats "$container" --no-stream --format "{{.MemUsage}}" 2>/dev/null | \
-        awk -F'[/ ]' '{print $1}' | sed 's/MiB//' | sed 's/GiB/*1024/' | \
-        python3 -c "import sys; s=sys.stdin.read().strip(); print(eval(s) if s else 0)" 2>/dev/null || echo 0
-}
-
-MEM_CP_START=$(get_mem open5gs-cp)
-MEM_UPF_START=$(get_mem open5gs-upf)
-MEM_DB_START=$(get_mem open5gs-mongodb)
-MEM_UE_START=$(get_mem open5gs-ueransim)
-
-info "Baseline memory (MiB):"
-printf "    %-25s %s\n" "open5gs-cp:"     "$MEM_CP_START"
-printf "    %-25s %s\n" "open5gs-upf:"    "$MEM_UPF_START"
-printf "    %-25s %s\n" "open5gs-mongodb:" "$MEM_DB_START"
-printf "    %-25s %s\n" "open5gs-ueransim:" "$MEM_UE_START"
-
-# Prepare UE config files
-TMPDIR=$(mktemp -d)
-for (( i=0; i<NUM_UES; i++ )); do
-    supi_num=$(supi_add "$BASE_SUPI" "$i")
-    k=$(hex_add "$BASE_K" "$i")
-    generate_ue_config "$supi_num" "$k" "$OPC" "${TMPDIR}/ue${i}.yaml" "internet"
-    docker cp "${TMPDIR}/ue${i}.yaml" open5gs-ueransim:/ueransim/config/ue_mem${i}.yaml
+if provision_subscribers "$NUM_UES" internet same-key >/dev/null; then
+    pass "Provisioned ${NUM_UES} subscribers"
+else
+    fail "Bulk provisioning of ${NUM_UES} subscribers failed"
+fi
+
+# One UE config; each cycle starts all UEs from one nr-ue process
+workdir_init tc10
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "$WORKDIR/ue_mem.yaml" "internet"
+docker cp "$WORKDIR/ue_mem.yaml" $UERANSIM_CTR:/ueransim/config/ue_mem.yaml
+
+# Step 2: Start the per-NF samplers
+info "Starting per-NF memory samplers (every ${TC10_SAMPLE_MS} ms)..."
+for c in $CP_CTR $UPF_CTR; do
+    if memstat_start "$c" "$TC10_SAMPLE_MS"; then
+        pass "open5gs-memstat running in $c"
+    else
+        fail "Could not start open5gs-memstat in $c (rebuild, or install gcc for a static copy)"
+        exit 1
+    fi
 done
+sleep 1
 
 # Step 3: Run register/deregister cycles
 info "Starting ${CYCLES} register/deregister cycles..."
-REPORT_FILE="$TESTS_DIR/logs/memory_report_$(date '+%Y%m%d_%H%M%S').txt"
-mkdir -p "$TESTS_DIR/logs"
-
-{
-echo "open5GS Memory Leak Test Report"
-echo "Date: $(date)"
-echo "Cycles: ${CYCLES}, UEs per cycle: ${NUM_UES}"
-echo ""
-echo "Baseline: CP=${MEM_CP_START}MiB  UPF=${MEM_UPF_START}MiB  DB=${MEM_DB_START}MiB  UE=${MEM_UE_START}MiB"
-echo ""
-echo "Cycle | CP(MiB) | UPF(MiB) | DB(MiB) | UE(MiB)"
-echo "------|---------|----------|---------|--------"
-} > "$REPORT_FILE"
+REPORT_BASE=$(report_path memory_report)
+REPORT_FILE="${REPORT_BASE}.txt"
+JSON_FILE="${REPORT_BASE}.json"
+: > "$WORKDIR/marks.txt"
 
 for (( cycle=1; cycle<=CYCLES; cycle++ )); do
-    # Register all UEs
-    for (( i=0; i<NUM_UES; i++ )); do
-        docker exec -d open5gs-ueransim ./nr-ue -c ./config/ue_mem${i}.yaml
-    done
-    sleep 12
-
-    # Verify at least some registered
-    reg=0
-    for (( i=0; i<NUM_UES; i++ )); do
-        supi_num=$(supi_add "$BASE_SUPI" "$i")
-        imsi="imsi-${supi_num}"
-        status=$(docker exec open5gs-ueransim ./nr-cli "$imsi" -e "status" 2>/dev/null)
-        echo "$status" | grep -q "RM-REGISTERED" && reg=$((reg + 1))
-    done
+    # Register all UEs, wait for them in the AMF log
+    mark=$(cp_log_mark amf)
+    start_ue_group ./config/ue_mem.yaml "$NUM_UES"
+    reg=$(wait_amf_registrations "$mark" "$NUM_UES" 30)
 
     # Deregister all UEs
     for (( i=0; i<NUM_UES; i++ )); do
         supi_num=$(supi_add "$BASE_SUPI" "$i")
         imsi="imsi-${supi_num}"
-        docker exec open5gs-ueransim ./nr-cli "$imsi" -e "deregister normal" 2>/dev/null &
+        docker exec $UERANSIM_CTR ./nr-cli "$imsi" -e "deregister normal" 2>/dev/null &
     done
     wait
     sleep 8
     kill_all_ues
 
-    # Snapshot memory every 5 cycles
+    # End of cycle: every UE context should be gone again
+    echo "$cycle $(date +%s.%N)" >> "$WORKDIR/marks.txt"
     if [ $((cycle % 5)) -eq 0 ] || [ "$cycle" -eq "$CYCLES" ]; then
-        cp_mem=$(get_mem open5gs-cp)
-        upf_mem=$(get_mem open5gs-upf)
-        db_mem=$(get_mem open5gs-mongodb)
-        ue_mem=$(get_mem open5gs-ueransim)
-        printf "  Cycle %2d: CP=%.1fMiB UPF=%.1fMiB DB=%.1fMiB UE=%.1fMiB (registered: %d/%d)\n" \
-            "$cycle" "$cp_mem" "$upf_mem" "$db_mem" "$ue_mem" "$reg" "$NUM_UES"
-        printf "%5d | %7.1f | %8.1f | %7.1f | %7.1f\n" \
-            "$cycle" "$cp_mem" "$upf_mem" "$db_mem" "$ue_mem" >> "$REPORT_FILE"
+        printf "  Cycle %2d/%d (registered: %d/%d)\n" "$cycle" "$CYCLES" "$reg" "$NUM_UES"
     else
         printf "  Cycle %2d/%d (registered: %d/%d)\r" "$cycle" "$CYCLES" "$reg" "$NUM_UES"
     fi
 done
 echo ""
 
-# Step 4: Capture final memory
-MEM_CP_END=$(get_mem open5gs-cp)
-MEM_UPF_END=$(get_mem open5gs-upf)
-MEM_DB_END=$(get_mem open5gs-mongodb)
-MEM_UE_END=$(get_mem open5gs-ueransim)
-
-# Step 5: Calculate growth and report
-calc_growth() {
-    local start="$1" end="$2"
-    python3 -c "
-s,e = float('${start}' or 0), float('${end}' or 0)
-if s > 0:
-    print(f'{((e-s)/s*100):+.1f}%')
-else:
-    print('N/A')
-" 2>/dev/null || echo "N/A"
-}
-
-cp_growth=$(calc_growth "$MEM_CP_START" "$MEM_CP_END")
-upf_growth=$(calc_growth "$MEM_UPF_START" "$MEM_UPF_END")
-db_growth=$(calc_growth "$MEM_DB_START" "$MEM_DB_END")
+# Step 4: Collect samples, fit per-NF slopes
+memstat_stop $CP_CTR  "$WORKDIR/cp.jsonl"
+memstat_stop $UPF_CTR "$WORKDIR/upf.jsonl"
 
 {
+echo "open5GS Memory Leak Test Report"
+echo "Date: $(date)"
+echo "Cycles: ${CYCLES}, UEs per cycle: ${NUM_UES}, warm-up: ${TC10_WARMUP}, slope limit: ${TC10_SLOPE_KB} kB/cycle"
 echo ""
-echo "Final: CP=${MEM_CP_END}MiB  UPF=${MEM_UPF_END}MiB  DB=${MEM_DB_END}MiB  UE=${MEM_UE_END}MiB"
-echo "Growth: CP=${cp_growth}  UPF=${upf_growth}  DB=${db_growth}"
-} >> "$REPORT_FILE"
-
-echo ""
-info "Memory growth after ${CYCLES} cycles:"
-printf "    %-20s start=%s MiB  end=%s MiB  growth=%s\n" "open5gs-cp:"    "$MEM_CP_START" "$MEM_CP_END"  "$cp_growth"
-printf "    %-20s start=%s MiB  end=%s MiB  growth=%s\n" "open5gs-upf:"   "$MEM_UPF_START" "$MEM_UPF_END" "$upf_growth"
-printf "    %-20s start=%s MiB  end=%s MiB  growth=%s\n" "open5gs-mongodb:" "$MEM_DB_START" "$MEM_DB_END"  "$db_growth"
-
-# Cleanup
-rm -rf "$TMPDIR"
-
-# Evaluate result
-cp_pct=$(python3 -c "
-s,e = float('${MEM_CP_START}' or 1), float('${MEM_CP_END}' or 0)
-print(int((e-s)/s*100) if s>0 else 0)
-" 2>/dev/null || echo 0)
+} > "$REPORT_FILE"
 
-info "Report saved to: $REPORT_FILE"
+info "Per-NF growth per cycle (fit over cycles $(( TC10_WARMUP + 1 ))-${CYCLES}):"
+python3 "$TESTS_DIR/mem_profile.py" --samples "$WORKDIR/cp.jsonl" --samples "$WORKDIR/upf.jsonl" \
+    --marks "$WORKDIR/marks.txt" --ues-per-cycle "$NUM_UES" --warmup "$TC10_WARMUP" \
+    --slope-kb "$TC10_SLOPE_KB" --json "$JSON_FILE" | tee -a "$REPORT_FILE" | sed 's/^/    /'
+
+read -r leaks warns nfs < <(python3 - "$JSON_FILE" <<'PYEOF'
+import json, sys
+try:
+    r = json.load(open(sys.argv[1]))["nfs"]
+except (OSError, ValueError, KeyError):
+    r = {}
+pick = lambda v: ",".join(n for n, x in r.items() if x["verdict"] == v) or "-"
+print(pick("leak"), pick("warn"), len(r))
+PYEOF
+)
+
+# Per-NF growth per registered UE into the perf store: a change that makes
+# a context cost more shows up before it crosses the leak limit
+while read -r nf m v; do
+    perf_record tc10 "${nf}_${m}_per_ue" "$v" kB lower
+done < <(python3 - "$JSON_FILE" <<'PYEOF'
+import json, sys
+try:
+    r = json.load(open(sys.argv[1]))["nfs"]
+except (OSError, ValueError, KeyError):
+    r = {}
+for nf, x in r.items():
+    for m in ("pss_kb", "heap_kb"):
+        if m in x["slopes"]:
+            print(nf, m[:-3], x["slopes"][m]["per_ue"])
+PYEOF
+)
+
+info "Report saved to: $REPORT_FILE (time series: $JSON_FILE)"
 
 echo ""
-if [ "${cp_pct:-0}" -gt "$LEAK_THRESHOLD" ]; then
-    echo -e "${RED}${BOLD}TC10 FAILED${NC}: CP memory grew by ${cp_pct}% (> ${LEAK_THRESHOLD}% threshold)"
-elif [ "${cp_pct:-0}" -gt "$WARN_THRESHOLD" ]; then
-    echo -e "${YELLOW}${BOLD}TC10 WARNING${NC}: CP memory grew by ${cp_pct}% (> ${WARN_THRESHOLD}% — monitor)"
+if [ "${nfs:-0}" -eq 0 ]; then
+    echo -e "${RED}${BOLD}TC10 FAILED${NC}: No memory samples collected"
+    exit 1
+elif [ "$leaks" != "-" ]; then
+    echo -e "${RED}${BOLD}TC10 FAILED${NC}: Memory grows every cycle in: ${leaks}"
+    exit 1
+elif [ "$warns" != "-" ]; then
+    echo -e "${YELLOW}${BOLD}TC10 WARNING${NC}: Noisy growth or restart in: ${warns} — monitor"
 else
-    echo -e "${GREEN}${BOLD}TC10 PASSED${NC}: Memory growth within acceptable limits (CP: ${cp_growth})"
+    echo -e "${GREEN}${BOLD}TC10 PASSED${NC}: No per-cycle growth in ${nfs} NFs"
 fi
@@ -0,0 +1,140 @@
+#!/bin/bash
+# ============================================================
+# TC11: Registration Storm (control-plane capacity)
+# Step up the registration rate until the success rate drops;
+# report latency percentiles per step and the sustained capacity
+# ============================================================
+# Each step offers RATE registrations/s for STEP_SECONDS from one nr-ue
+# (-n RATE*STEP_SECONDS, -t 1000/RATE ms), on a fresh IMSI block and a
+# freshly reset gNB.  A step passes if at least TC11_MIN_SUCCESS % of its
+# UEs logged "Registration complete" in the AMF log within STEP_SECONDS +
+# TC11_SETTLE s.  The capacity is the highest passing rate.
+#
+# Latency per step (tests/ue_latency.py):
+#   registration     AMF: "UE by SUCI" -> "Registration complete"
+#   authentication   UE:  Initial Registration sent -> Security Mode Command
+#   security_mode    UE:  Security Mode Command -> Registration accept
+#
+# Usage: tc11_registration_storm.sh [max_rate] [step_seconds]
+# Env:   TC11_RATES        offered rates, ascending (default: 10 20 50 100 200 500 1000)
+#        TC11_MIN_SUCCESS  % of UEs that must register per step (default: 99)
+#        TC11_SETTLE       extra seconds to wait after a step (default: 30)
+# exclusive: registration capacity
+# ============================================================
+source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
+
+MAX_RATE="${1:-500}"
+STEP_SECONDS="${2:-10}"
+TC11_MIN_SUCCESS="${TC11_MIN_SUCCESS:-99}"
+TC11_SETTLE="${TC11_SETTLE:-30}"
+RATES=()
+for r in ${TC11_RATES:-10 20 50 100 200 500 1000}; do
+    [ "$r" -le "$MAX_RATE" ] && RATES+=("$r")
+done
+
+header "TC11: Registration Storm (up to ${MAX_RATE}/s, ${STEP_SECONDS}s steps)"
+
+if [ ${#RATES[@]} -eq 0 ]; then
+    fail "no rate in '${TC11_RATES:-10 20 50 100 200 500 1000}' is <= ${MAX_RATE}"
+    exit 1
+fi
+
+ensure_core_running
+
+workdir_init tc11
+on_exit kill_all_ues
+REPORT_FILE=$(report_path tc11_storm json)
+
+# Step 1: Provision one IMSI block per step (shared K for nr-ue -n)
+TOTAL=0
+for r in "${RATES[@]}"; do TOTAL=$(( TOTAL + r * STEP_SECONDS )); done
+info "Provisioning ${TOTAL} subscribers for ${#RATES[@]} steps..."
+if provision_subscribers "$TOTAL" internet same-key >/dev/null; then
+    pass "Provisioned ${TOTAL} subscribers"
+else
+    fail "Bulk provisioning of ${TOTAL} subscribers failed"
+    exit 1
+fi
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "$WORKDIR/storm-ue.yaml" "internet"
+
+# Step 2: One step per rate until the success rate drops
+echo ""
+printf "  %7s %6s %6s %8s %9s %8s %8s %8s %8s %8s\n" \
+    "rate/s" "UEs" "reg" "success" "achieved" "p50 ms" "p99 ms" "p999 ms" "auth p99" "smc p99"
+offset=0
+capacity=0
+: > "$WORKDIR/steps.jsonl"
+for rate in "${RATES[@]}"; do
+    count=$(( rate * STEP_SECONDS ))
+    tempo=$(( 1000 / rate )); [ "$tempo" -lt 1 ] && tempo=1
+    first=$(printf "%0${#BASE_SUPI}d" $(( 10#$BASE_SUPI + offset )))
+    offset=$(( offset + count ))
+
+    # Clean RAN state per step; the UE config goes back after the restart
+    reset_ueransim
+    wait_gnb_connected 60
+    docker cp "$WORKDIR/storm-ue.yaml" $UERANSIM_CTR:/ueransim/config/storm-ue.yaml
+
+    mark=$(cp_log_mark amf)
+    start_ue_group ./config/storm-ue.yaml "$count" "$first" "$tempo" /tmp/tc11-ue.log
+    wait_amf_registrations "$mark" "$count" $(( STEP_SECONDS + TC11_SETTLE )) >/dev/null
+
+    cp_log_since amf "$mark" > "$WORKDIR/amf.log"
+    docker exec $UERANSIM_CTR cat /tmp/tc11-ue.log > "$WORKDIR/ue.log" 2>/dev/null
+    kill_all_ues
+    python3 "$TESTS_DIR/ue_latency.py" --amf "$WORKDIR/amf.log" --ue-log "$WORKDIR/ue.log" \
+        --imsi "$first" --expect "$count" --json \
+        --meta "{\"offered_per_sec\":$rate,\"step_seconds\":$STEP_SECONDS}" > "$WORKDIR/step.json"
+    cat "$WORKDIR/step.json" >> "$WORKDIR/steps.jsonl"
+
+    read -r reg ok achieved p50 p99 p999 auth smc < <(python3 - "$WORKDIR/step.json" "$TC11_MIN_SUCCESS" <<'PYEOF'
+import json, sys
+r = json.load(open(sys.argv[1]))
+reg, want = r["registered"], r["expected"]
+ok = want > 0 and reg * 100.0 / want >= float(sys.argv[2])
+d, ph = r["registration_ms"], r.get("phases_ms", {})
+g = lambda x, k: x.get(k) if x.get(k) is not None else "-"
+print(reg, int(ok), r["achieved_per_sec"] or "-", g(d, "p50"), g(d, "p99"), g(d, "p999"),
+      g(ph.get("authentication", {}), "p99"), g(ph.get("security_mode", {}), "p99"))
+PYEOF
+)
+    printf "  %7d %6d %6d %7.1f%% %9s %8s %8s %8s %8s %8s\n" "$rate" "$count" "$reg" \
+        "$(awk -v a="$reg" -v b="$count" 'BEGIN { print a * 100 / b }')" \
+        "$achieved" "$p50" "$p99" "$p999" "$auth" "$smc"
+    [ "$ok" = 1 ] || break
+    capacity=$rate
+done
+echo ""
+
+# Step 3: Machine-readable report
+python3 - "$WORKDIR/steps.jsonl" "$capacity" "$TC11_MIN_SUCCESS" <<'PYEOF' | report_write "$REPORT_FILE"
+import json, sys
+steps = [json.loads(l) for l in open(sys.argv[1]) if l.strip()]
+cap = int(sys.argv[2])
+best = next((s for s in steps if s["offered_per_sec"] == cap), None)
+print(json.dumps({
+    "test": "tc11_registration_storm",
+    "min_success_pct": float(sys.argv[3]),
+    "capacity_per_sec": cap,
+    "capacity_achieved_per_sec": best["achieved_per_sec"] if best else None,
+    "capacity_registration_ms": best["registration_ms"] if best else None,
+    "steps": steps,
+}, indent=2))
+PYEOF
+
+perf_record tc11 capacity_per_sec "$capacity" reg/s higher
+perf_record_report tc11 "$REPORT_FILE" \
+    capacity_achieved_per_sec:achieved_per_sec:reg/s:higher \
+    capacity_registration_ms.p50:registration_p50_ms:ms:lower \
+    capacity_registration_ms.p99:registration_p99_ms:ms:lower
+
+echo ""
+if [ "$capacity" -gt 0 ]; then
+    if [ "$capacity" = "${RATES[-1]}" ]; then
+        warn "Every step passed — capacity is at least ${capacity}/s (raise max_rate)"
+    fi
+    echo -e "${GREEN}${BOLD}TC11 PASSED${NC}: Registration capacity ${capacity}/s at >= ${TC11_MIN_SUCCESS}% success"
+else
+    echo -e "${RED}${BOLD}TC11 FAILED${NC}: Even ${RATES[0]}/s stayed under ${TC11_MIN_SUCCESS}% success"
+    exit 1
+fi
@@ -0,0 +1,208 @@
+#!/bin/bash
+# ============================================================
+# TC12: User-plane Throughput / Latency through uesimtun
+# N UEs with PDU sessions, parallel iperf3 flows per UE to the
+# dn-sink container; aggregate Gbit/s, Mpps, fairness, jitter,
+# UPF CPU per Gbit
+# ============================================================
+# Every flow takes the full path: uesimtun -> nr-ue -> GTP-U (N3) ->
+# UPF -> ogstun -> NAT -> eth0 (N6) -> dn-sink (.50 on open5gs-net, compose
+# profile "bench", one iperf3 server per port).  No external network is
+# involved, so the numbers are comparable across hosts with the same
+# config.  Phases, each TC12_SECONDS long, all flows at once:
+#   tcp-ul   UE -> sink          tcp-dl   sink -> UE (iperf3 -R)
+#   udp-ul   UE -> sink          udp-dl   sink -> UE, TC12_UDP_RATE per flow
+# Around each phase the test reads the UPF's ogstun packet counters and
+# the UPF container's CPU time; tests/userplane_report.py turns flows and
+# counters into the per-phase numbers.  This is the baseline for UPF
+# fast-path changes: the per-phase numbers go to the perf store.
+#
+# Usage: tc12_user_plane.sh [ues] [seconds]
+# Env:   TC12_FLOWS          flows per UE (default: 2; ues x flows <= 64)
+#        TC12_PHASES         default: "tcp-ul tcp-dl udp-ul udp-dl"
+#        TC12_UDP_RATE       iperf3 -b per UDP flow (default: 50M)
+#        TC12_PKT            UDP payload bytes (default: 1200)
+#        TC12_MIN_FAIRNESS   Jain index below which a phase warns (default: 0.8)
+# exclusive: user-plane throughput
+# ============================================================
+source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
+
+NUM_UES="${1:-4}"
+SECONDS_PER_PHASE="${2:-10}"
+TC12_FLOWS="${TC12_FLOWS:-2}"
+TC12_PHASES="${TC12_PHASES:-tcp-ul tcp-dl udp-ul udp-dl}"
+TC12_UDP_RATE="${TC12_UDP_RATE:-50M}"
+TC12_PKT="${TC12_PKT:-1200}"
+TC12_MIN_FAIRNESS="${TC12_MIN_FAIRNESS:-0.8}"
+SINK_IP="${O5GS_SUBNET}.50"
+SINK_PORT=5201
+SINK_PORTS=64
+
+header "TC12: User-plane Throughput (${NUM_UES} UEs x ${TC12_FLOWS} flows, ${SECONDS_PER_PHASE}s phases)"
+
+if [ $(( NUM_UES * TC12_FLOWS )) -gt $SINK_PORTS ]; then
+    fail "${NUM_UES} UEs x ${TC12_FLOWS} flows > ${SINK_PORTS} dn-sink ports"
+    exit 1
+fi
+
+ensure_core_running
+if ! docker exec $UERANSIM_CTR sh -c 'command -v iperf3' >/dev/null 2>&1; then
+    fail "iperf3 not in $UERANSIM_CTR (rebuild: docker compose build ueransim)"
+    exit 1
+fi
+
+workdir_init tc12
+on_exit 'docker rm -f $DN_SINK_CTR >/dev/null 2>&1'
+on_exit kill_all_ues
+REPORT_FILE=$(report_path tc12_userplane json)
+
+# Step 1: Traffic sink on open5gs-net
+info "Starting dn-sink (${SINK_IP}, iperf3 on ports ${SINK_PORT}-$(( SINK_PORT + SINK_PORTS - 1 )))..."
+o5gs_compose --profile bench up -d dn-sink >/dev/null 2>&1
+waited=0
+until docker exec $DN_SINK_CTR sh -c "ss -ltn | grep -q ':$(( SINK_PORT + SINK_PORTS - 1 )) '" 2>/dev/null; do
+    if [ $waited -ge 20 ]; then
+        fail "dn-sink did not come up"
+        exit 1
+    fi
+    sleep 1
+    waited=$((waited + 1))
+done
+pass "dn-sink listening"
+
+# Step 2: Register N UEs with one PDU session each
+kill_all_ues
+info "Provisioning ${NUM_UES} subscribers..."
+if provision_subscribers "$NUM_UES" internet same-key >/dev/null; then
+    pass "Provisioned ${NUM_UES} subscribers"
+else
+    fail "Bulk provisioning of ${NUM_UES} subscribers failed"
+    exit 1
+fi
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "$WORKDIR/up-ue.yaml" "internet"
+docker cp "$WORKDIR/up-ue.yaml" $UERANSIM_CTR:/ueransim/config/up-ue.yaml
+
+mark=$(cp_log_mark amf)
+start_ue_group ./config/up-ue.yaml "$NUM_UES"
+reg=$(wait_amf_registrations "$mark" "$NUM_UES" 60)
+info "Registered: ${reg}/${NUM_UES}"
+
+# uesimtun<n> <ip>, one line per PDU session
+waited=0
+while :; do
+    docker exec $UERANSIM_CTR ip -4 -o addr show 2>/dev/null \
+        | awk '$2 ~ /^uesimtun/ { split($4, a, "/"); print $2, a[1] }' > "$WORKDIR/tuns.txt"
+    [ "$(wc -l < "$WORKDIR/tuns.txt")" -ge "$NUM_UES" ] || [ $waited -ge 30 ] && break
+    sleep 1
+    waited=$((waited + 1))
+done
+ntun=$(wc -l < "$WORKDIR/tuns.txt")
+if [ "$ntun" -lt "$NUM_UES" ]; then
+    fail "Only ${ntun}/${NUM_UES} PDU sessions (uesimtun) came up"
+    echo -e "${RED}${BOLD}TC12 FAILED${NC}: PDU sessions missing"
+    exit 1
+fi
+pass "${ntun} PDU sessions up"
+
+unreachable=0
+while read -r tun ip; do
+    docker exec $UERANSIM_CTR ping -c 1 -W 2 -I "$tun" "$SINK_IP" >/dev/null 2>&1 \
+        || { warn "${tun} (${ip}) cannot reach ${SINK_IP}"; unreachable=$((unreachable + 1)); }
+done < "$WORKDIR/tuns.txt"
+if [ "$unreachable" -gt 0 ]; then
+    echo -e "${RED}${BOLD}TC12 FAILED${NC}: ${unreachable} UE(s) cannot reach the sink through the UPF"
+    exit 1
+fi
+pass "Every UE reaches ${SINK_IP} through the UPF"
+
+# upf_snap — "<ogstun rx> <ogstun tx> <UPF CPU us>"
+upf_snap() {
+    docker exec $UPF_CTR sh -c '
+        s=/sys/class/net/ogstun/statistics
+        cpu=$(awk "/^usage_usec/ { print \$2 }" /sys/fs/cgroup/cpu.stat 2>/dev/null)
+        if [ -z "$cpu" ]; then
+            for d in /proc/[0-9]*; do
+                [ "$(cat $d/comm 2>/dev/null)" = open5gs-upfd ] || continue
+                cpu=$(awk -v hz=$(getconf CLK_TCK) "{ printf \"%d\", (\$14 + \$15) * 1e6 / hz }" $d/stat)
+            done
+        fi
+        echo $(cat $s/rx_packets) $(cat $s/tx_packets) ${cpu:-0}' 2>/dev/null
+}
+
+# Step 3: One phase at a time, all flows in parallel
+: > "$WORKDIR/snaps.txt"
+mkdir -p "$WORKDIR/flows"
+for phase in $TC12_PHASES; do
+    case "$phase" in
+        tcp-ul) opts="" ;;
+        tcp-dl) opts="-R" ;;
+        udp-ul) opts="-u -b $TC12_UDP_RATE -l $TC12_PKT" ;;
+        udp-dl) opts="-u -b $TC12_UDP_RATE -l $TC12_PKT -R" ;;
+        *) warn "unknown phase '${phase}', skipped"; continue ;;
+    esac
+    script="rm -rf /tmp/tc12; mkdir -p /tmp/tc12"
+    ue=0
+    while read -r tun ip; do
+        for (( f=0; f<TC12_FLOWS; f++ )); do
+            port=$(( SINK_PORT + ue * TC12_FLOWS + f ))
+            script+="; iperf3 -c $SINK_IP -B $ip -p $port -t $SECONDS_PER_PHASE $opts -J"
+            script+=" > /tmp/tc12/${phase}.${ue}.${f}.json 2>&1 &"
+        done
+        ue=$((ue + 1))
+    done < "$WORKDIR/tuns.txt"
+    script+="; wait"
+
+    info "${phase}: $(( ntun * TC12_FLOWS )) flows for ${SECONDS_PER_PHASE}s..."
+    before=$(upf_snap)
+    docker exec $UERANSIM_CTR sh -c "$script"
+    after=$(upf_snap)
+    [ -n "$before" ] && [ -n "$after" ] && echo "$phase $before $after" >> "$WORKDIR/snaps.txt"
+    docker cp $UERANSIM_CTR:/tmp/tc12/. "$WORKDIR/flows/" >/dev/null 2>&1
+done
+cp "$WORKDIR/snaps.txt" "$WORKDIR/flows/"
+
+# Step 4: Report
+echo ""
+meta="{\"ues\":${ntun},\"flows_per_ue\":${TC12_FLOWS},\"udp_rate\":\"${TC12_UDP_RATE}\",\"udp_payload\":${TC12_PKT}}"
+python3 "$TESTS_DIR/userplane_report.py" --dir "$WORKDIR/flows" --seconds "$SECONDS_PER_PHASE" \
+    --meta "$meta" --json "$REPORT_FILE" | sed 's/^/  /'
+RC=${PIPESTATUS[0]}
+echo ""
+info "Report saved to: $REPORT_FILE"
+
+# Per-phase numbers into the perf store; the flow count is part of the test
+# name, since 4x2 and 16x4 flows are different baselines
+perf_test="tc12:${ntun}x${TC12_FLOWS}"
+unfair="" lossy=""
+while read -r phase gbps mpps fair cpu jitter loss; do
+    perf_record "$perf_test" "${phase}_gbps" "$gbps" Gbit/s higher
+    perf_record "$perf_test" "${phase}_mpps" "$mpps" Mpps higher
+    perf_record "$perf_test" "${phase}_cpu_s_per_gbit" "$cpu" s lower
+    perf_record "$perf_test" "${phase}_fairness" "$fair" jain higher
+    perf_record "$perf_test" "${phase}_jitter_ms" "$jitter" ms lower
+    [ "$fair" != "-" ] && awk -v f="$fair" -v m="$TC12_MIN_FAIRNESS" 'BEGIN { exit !(f < m) }' \
+        && unfair+="${unfair:+, }${phase} (${fair})"
+    [ "$loss" != "-" ] && awk -v l="$loss" 'BEGIN { exit !(l > 5) }' \
+        && lossy+="${lossy:+, }${phase} (${loss}%)"
+done < <(python3 - "$REPORT_FILE" <<'PYEOF'
+import json, sys
+try:
+    r = json.load(open(sys.argv[1]))["phases"]
+except (OSError, ValueError, KeyError):
+    r = {}
+g = lambda v: "-" if v is None else "%.6g" % v
+for name, p in r.items():
+    print(name, g(p["gbps"]), g(p["mpps"]), g(p["fairness"]), g(p["cpu_s_per_gbit"]),
+          g(p.get("jitter_ms")), g(p.get("lost_pct")))
+PYEOF
+)
+
+echo ""
+if [ "$RC" -ne 0 ]; then
+    echo -e "${RED}${BOLD}TC12 FAILED${NC}: Some flows moved no traffic (see ${REPORT_FILE})"
+    exit 1
+elif [ -n "$unfair" ] || [ -n "$lossy" ]; then
+    echo -e "${YELLOW}${BOLD}TC12 WARNING${NC}: ${unfair:+fairness < ${TC12_MIN_FAIRNESS}: ${unfair}}${unfair:+${lossy:+; }}${lossy:+UDP loss > 5%: ${lossy}}"
+else
+    echo -e "${GREEN}${BOLD}TC12 PASSED${NC}: ${ntun} UEs x ${TC12_FLOWS} flows through the UPF"
+fi
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""
+ue_latency.py — Registration and PDU session latency from open5GS logs.
+
+Reads the part of amf.log (and optionally smf.log) written during a load
+run and pairs, per UE:
+
+  start         AMF  [suci-0-<mcc>-<mnc>-...-<msin>] Unknown|Known UE by SUCI
+  registered    AMF  [imsi-<digits>] Registration complete
+  rejected      AMF  [imsi-...|suci-...] Registration reject
+  session       SMF  UE SUPI[imsi-<digits>] DNN[<dnn>] IPv4[...]
+
+Registration latency is registered minus the last start before it (a UE
+that retries is timed from its last attempt).  Session latency is the
+SMF's session line minus that UE's Registration complete, per DNN.
+
+Both logs come from the same container, so their clocks agree.  Lines
+look like "10/16 12:34:56.789: [gmm] INFO: ..." (no year).
+
+With --ue-log (nr-ue output; multi-UE mode prefixes each line with the
+SUPI, "[<date> <time>] [imsi-<digits>|nas] [debug] ..."), the UE side is
+split into the registration sub-phases:
+
+  authentication   "Sending Initial Registration" -> "Security Mode Command
+                   received": AMF, AUSF and UDM 5G-AKA round trips
+  security_mode    -> "Registration accept received": Security Mode
+                   Complete, then the AMF's UDM/PCF work before the accept
+  ue_total         "Sending Initial Registration" -> "... is successful"
+
+Usage:
+  docker exec open5gs-cp tail -c +<offset> /var/log/open5gs/amf.log > amf.part
+  python3 tests/ue_latency.py --amf amf.part --smf smf.part --expect 1000 --json
+
+  # restrict to the IMSIs a run launched
+  python3 tests/ue_latency.py --amf amf.part --imsi 001010000050641 --expect 1000
+
+Prints a summary (or one JSON object with --json); --csv writes one line
+per UE: imsi,registration_ms,<dnn>_ms,...  --meta '{"k":..}' adds fields
+to the JSON report.
+
+Exit status: 0 if --expect UEs (default: every started UE) registered.
+"""
+
+import argparse
+import datetime
+import json
+import re
+import sys
+
+TS = re.compile(r"^(\d\d)/(\d\d) (\d\d):(\d\d):(\d\d)\.(\d{3}):")
+START = re.compile(r"\[suci-0-(\d{3})-(\d{2,3})-[0-9a-fA-F]+-\d+-\d+-(\d+)\] (?:Unknown|Known) UE by SUCI")
+DONE = re.compile(r"\[imsi-(\d+)\] Registration complete")
+REJECT = re.compile(r"\[(imsi-\d+|suci-[0-9a-fA-F-]+)\] Registration reject")
+SESSION = re.compile(r"UE SUPI\[imsi-(\d+)\] DNN\[([^\]]+)\] IPv4\[")
+UE_LINE = re.compile(r"^\[(\d{4})-(\d\d)-(\d\d) (\d\d):(\d\d):(\d\d)\.(\d{3})\] \[imsi-(\d+)\|")
+UE_EVENTS = (
+    ("sent", re.compile(r"Sending Initial Registration")),
+    ("smc", re.compile(r"Security Mode Command received")),
+    ("accept", re.compile(r"Registration accept received")),
+    ("done", re.compile(r"Initial Registration is successful")),
+)
+
+
+def stamp(line, year):
+    m = TS.match(line)
+    if not m:
+        return None
+    mo, d, h, mi, s, ms = map(int, m.groups())
+    return datetime.datetime(year, mo, d, h, mi, s, ms * 1000).timestamp()
+
+
+def read(path):
+    with open(path, errors="replace") as f:
+        return f.readlines()
+
+
+def pct(values, p):
+    if not values:
+        return None
+    v = sorted(values)
+    i = min(len(v) - 1, max(0, int(len(v) * p / 100.0 + 0.5) - 1))
+    return round(v[i], 1)
+
+
+def dist(values):
+    if not values:
+        return {"n": 0}
+    return {"n": len(values), "p50": pct(values, 50), "p90": pct(values, 90),
+            "p99": pct(values, 99), "p999": pct(values, 99.9), "max": round(max(values), 1),
+            "mean": round(sum(values) / len(values), 1)}
+
+
+def suci_imsi(token):
+    # suci-0-001-01-0000-0-0-0000050641 -> 001010000050641
+    p = token.split("-")
+    return p[2] + p[3] + p[-1] if len(p) >= 8 else token
+
+
+def ue_phases(lines, mine):
+    """Per-UE sub-phase latencies (ms) from nr-ue output."""
+    ev = {}
+    for line in lines:
+        m = UE_LINE.match(line)
+        if not m or not mine(m.group(8)):
+            continue
+        for name, rx in UE_EVENTS:
+            if rx.search(line, m.end()):
+                y, mo, d, h, mi, s, ms = map(int, m.groups()[:7])
+                t = datetime.datetime(y, mo, d, h, mi, s, ms * 1000).timestamp()
+                e = ev.setdefault(m.group(8), {})
+                if name == "sent":
+                    # a retry restarts the clock
+                    e.clear()
+                e.setdefault(name, t)
+                break
+    phases = {"authentication": [], "security_mode": [], "ue_total": []}
+    for e in ev.values():
+        for name, a, b in (("authentication", "sent", "smc"),
+                           ("security_mode", "smc", "accept"),
+                           ("ue_total", "sent", "done")):
+            if a in e and b in e:
+                phases[name].append((e[b] - e[a]) * 1000)
+    return {k: dist(v) for k, v in phases.items()}
+
+
+def analyze(amf_lines, smf_lines=(), imsi=None, expect=None, year=None, ue_lines=None):
+    year = year or datetime.date.today().year
+    lo = int(imsi) if imsi else None
+    hi = lo + expect - 1 if imsi and expect else None
+
+    def mine(digits):
+        if lo is None:
+            return True
+        n = int(digits)
+        return n >= lo and (hi is None or n <= hi) and len(digits) == len(imsi)
+
+    started, registered, rejected = {}, {}, set()
+    first = last = None
+    for line in amf_lines:
+        m = START.search(line)
+        if m:
+            ue = m.group(1) + m.group(2) + m.group(3)
+            t = stamp(line, year)
+            if t is not None and mine(ue) and ue not in registered:
+                started[ue] = t
+                first = t if first is None else min(first, t)
+            continue
+        m = DONE.search(line)
+        if m:
+            ue, t = m.group(1), stamp(line, year)
+            if t is not None and mine(ue) and ue in started and ue not in registered:
+                registered[ue] = t
+                last = t if last is None else max(last, t)
+            continue
+        m = REJECT.search(line)
+        if m:
+            tok = m.group(1)
+            ue = tok[5:] if tok.startswith("imsi-") else suci_imsi(tok)
+            if mine(ue):
+                rejected.add(ue)
+
+    reg_ms = {ue: (registered[ue] - started[ue]) * 1000 for ue in registered}
+
+    sess_ms = {}
+    for line in smf_lines:
+        m = SESSION.search(line)
+        if not m:
+            continue
+        ue, dnn, t = m.group(1), m.group(2), stamp(line, year)
+        if t is None or ue not in registered:
+            continue
+        sess_ms.setdefault(dnn, {}).setdefault(ue, (t - registered[ue]) * 1000)
+
+    span = (last - first) if first is not None and last is not None else 0
+    want = expect or len(started)
+    report = {
+        "expected": want,
+        "started": len(started),
+        "registered": len(registered),
+        "rejected": len(rejected - set(registered)),
+        "span_s": round(span, 3),
+        "achieved_per_sec": round(len(registered) / span, 1) if span > 0 else None,
+        "registration_ms": dist(list(reg_ms.values())),
+        "sessions": {dnn: dist(list(v.values())) for dnn, v in sorted(sess_ms.items())},
+    }
+    if ue_lines is not None:
+        report["phases_ms"] = ue_phases(ue_lines, mine)
+    return report, reg_ms, sess_ms
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--amf", required=True, help="amf.log (slice)")
+    ap.add_argument("--smf", help="smf.log (slice)")
+    ap.add_argument("--ue-log", help="nr-ue output (multi-UE mode) for the sub-phases")
+    ap.add_argument("--imsi", help="first IMSI of the run (digits)")
+    ap.add_argument("--expect", type=int, help="UEs the run launched")
+    ap.add_argument("--json", action="store_true")
+    ap.add_argument("--csv", help="per-UE latencies to this file")
+    ap.add_argument("--meta", help="JSON object merged into the --json report")
+    a = ap.parse_args()
+
+    imsi = a.imsi[5:] if a.imsi and a.imsi.startswith("imsi-") else a.imsi
+    report, reg_ms, sess_ms = analyze(read(a.amf), read(a.smf) if a.smf else (),
+                                      imsi, a.expect,
+                                      ue_lines=read(a.ue_log) if a.ue_log else None)
+
+    if a.csv:
+        dnns = sorted(sess_ms)
+        with open(a.csv, "w") as f:
+            f.write(",".join(["imsi", "registration_ms"] + [d + "_ms" for d in dnns]) + "\n")
+            for ue in sorted(reg_ms):
+                row = ["imsi-" + ue, "%.1f" % reg_ms[ue]]
+                row += ["%.1f" % sess_ms[d][ue] if ue in sess_ms[d] else "" for d in dnns]
+                f.write(",".join(row) + "\n")
+
+    if a.json:
+        print(json.dumps(dict(json.loads(a.meta) if a.meta else {}, **report)))
+    else:
+        r = report["registration_ms"]
+        print("registered %d/%d (started %d, rejected %d) in %.1f s, %s/s"
+              % (report["registered"], report["expected"], report["started"],
+                 report["rejected"], report["span_s"], report["achieved_per_sec"]))
+        if r["n"]:
+            print("registration ms  p50 %s  p90 %s  p99 %s  p99.9 %s  max %s"
+                  % (r["p50"], r["p90"], r["p99"], r["p999"], r["max"]))
+        for dnn, s in report["sessions"].items():
+            print("session %-8s n %d  p50 %s  p90 %s  p99 %s  max %s ms"
+                  % (dnn, s["n"], s["p50"], s["p90"], s["p99"], s["max"]))
+        for name, s in report.get("phases_ms", {}).items():
+            if s["n"]:
+                print("phase %-14s n %d  p50 %s  p99 %s  p99.9 %s ms"
+                      % (name, s["n"], s["p50"], s["p99"], s["p999"]))
+
+    sys.exit(0 if report["registered"] >= report["expected"] else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,174 @@
+#!/bin/bash
+# ============================================================
+# ue_load.sh — UE registration load: arrival rate, ramps, PDU sessions
+# ============================================================
+# Drives UERANSIM's multi-UE mode instead of one nr-ue per UE: one UE
+# config, and one `nr-ue -n <count> -i <first-imsi> -t <ms>` per load
+# step.  The subscribers share one K (provisioned with same-key, through
+# the fixture cache).
+#
+# The arrival profile is a comma-separated list of segments:
+#
+#   R          R registrations/s until all UEs are started
+#   R:S        R/s for S seconds (R=0 is a pause)
+#   A-B:S      linear ramp from A/s to B/s over S seconds (1 s steps)
+#
+# If the profile ends before --ues are started, its last rate continues.
+#
+# Completion is read from the AMF log (no fixed sleeps): the run waits
+# for every UE's "Registration complete", then for its PDU sessions in
+# the SMF log.  tests/ue_latency.py turns both log slices into latency
+# distributions.
+#
+# Usage: tests/ue_load.sh [--ues 1000] [--rate 50 | --profile 10-100:30,100]
+#                         [--dnn internet[,ims]] [--hold S] [--timeout S]
+#                         [--json FILE] [--csv FILE]
+#
+# Writes the JSON report to tests/logs/ue_load_<timestamp>.json (or
+# --json).  Exit status 0 if every UE registered.
+# ============================================================
+
+source "$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/common.sh"
+
+UES=100 PROFILE="" RATE=20 DNNS=internet HOLD=0 TIMEOUT=120
+JSON_OUT=$(report_path ue_load json)
+CSV_OUT=""
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --ues)     UES="$2";      shift ;;
+        --rate)    RATE="$2";     shift ;;
+        --profile) PROFILE="$2";  shift ;;
+        --dnn)     DNNS="$2";     shift ;;
+        --hold)    HOLD="$2";     shift ;;
+        --timeout) TIMEOUT="$2";  shift ;;
+        --json)    JSON_OUT="$2"; shift ;;
+        --csv)     CSV_OUT="$2";  shift ;;
+        *) echo "Usage: $0 [--ues N] [--rate R | --profile SPEC] [--dnn LIST]" \
+                "[--hold S] [--timeout S] [--json FILE] [--csv FILE]" >&2; exit 2 ;;
+    esac
+    shift
+done
+PROFILE="${PROFILE:-$RATE}"
+
+# plan <profile> <ues> — one load step per line: <offset_ms> <count> <tempo_ms>
+plan() {
+    awk -v spec="$1" -v total="$2" '
+    function step(d, r,   n) {
+        cum += r * d
+        n = int(cum + 1e-9) - done
+        if (n > total - done) n = total - done
+        if (n > 0 && r > 0) { printf "%d %d %d\n", t * 1000, n, int(1000 / r + 0.5); done += n }
+        t += d
+    }
+    BEGIN {
+        nseg = split(spec, seg, ",")
+        for (i = 1; i <= nseg && done < total; i++) {
+            s = seg[i]; dur = -1
+            if ((c = index(s, ":"))) { dur = substr(s, c + 1) + 0; s = substr(s, 1, c - 1) }
+            if ((c = index(s, "-"))) { a = substr(s, 1, c - 1) + 0; b = substr(s, c + 1) + 0 }
+            else a = b = s + 0
+            if (dur < 0) { if (b > 0) step((total - done) / b, b); continue }
+            if (a == b) { step(dur, a); continue }
+            for (k = 0; k < dur && done < total; k++)
+                step(1, a + (b - a) * (k + 0.5) / dur)
+        }
+        # profile ran out: keep its last rate
+        if (done < total && b > 0) step((total - done) / b, b)
+    }'
+}
+
+header "UE load: ${UES} UEs, profile ${PROFILE}, DNN ${DNNS}"
+
+if ! [[ "$UES" =~ ^[0-9]+$ ]] || [ "$UES" -lt 1 ]; then
+    fail "--ues must be a positive number"
+    exit 2
+fi
+STEPS=$(plan "$PROFILE" "$UES")
+planned=$(awk '{ n += $2 } END { print n + 0 }' <<< "$STEPS")
+if [ "$planned" -lt "$UES" ]; then
+    fail "profile '${PROFILE}' starts only ${planned}/${UES} UEs (ends at rate 0?)"
+    exit 2
+fi
+
+ensure_core_running
+kill_all_ues
+workdir_init ue_load
+on_exit kill_all_ues
+
+info "Provisioning ${UES} subscribers (same K, DNN ${DNNS})..."
+if summary=$(provision_subscribers "$UES" "$DNNS" same-key); then
+    info "Provisioned: ${summary}"
+else
+    fail "provisioning failed"
+    exit 1
+fi
+generate_ue_config "$BASE_SUPI" "$BASE_K" "$OPC" "$WORKDIR/load-ue.yaml" "$DNNS"
+docker cp "$WORKDIR/load-ue.yaml" $UERANSIM_CTR:/ueransim/config/load-ue.yaml
+
+# ── Launch ───────────────────────────────────────────────────
+AMF_MARK=$(cp_log_mark amf)
+SMF_MARK=$(cp_log_mark smf)
+nsteps=$(wc -l <<< "$STEPS")
+info "Starting ${UES} UEs in ${nsteps} nr-ue process(es)..."
+t0=${EPOCHREALTIME/[.,]/}
+started=0
+while read -r offset count tempo; do
+    wait_us=$(( t0 + offset * 1000 - ${EPOCHREALTIME/[.,]/} ))
+    [ "$wait_us" -gt 0 ] && sleep "$(awk -v u="$wait_us" 'BEGIN { printf "%.3f", u / 1e6 }')"
+    start_ue_group ./config/load-ue.yaml "$count" \
+        "$(printf "%0${#BASE_SUPI}d" $(( 10#$BASE_SUPI + started )))" "$tempo"
+    started=$(( started + count ))
+    printf "  t=%6.1fs  +%-5d UEs  (%d ms apart)  %d/%d\r" \
+        "$(awk -v ms="$offset" 'BEGIN { print ms / 1000 }')" "$count" "$tempo" "$started" "$UES"
+done <<< "$STEPS"
+echo ""
+
+# ── Wait: registrations (AMF), then sessions (SMF) ───────────
+info "Waiting for ${UES} registrations in the AMF log (max ${TIMEOUT}s)..."
+reg=$(wait_amf_registrations "$AMF_MARK" "$UES" "$TIMEOUT")
+info "Registered: ${reg}/${UES}"
+
+ndnn=$(awk -F, '{ print NF }' <<< "$DNNS")
+want=$(( reg * ndnn ))
+waited=0
+while :; do
+    sess=$(cp_log_since smf "$SMF_MARK" | grep -c 'UE SUPI\[imsi-[0-9]*\] DNN\[')
+    [ "$sess" -ge "$want" ] || [ $waited -ge 30 ] && break
+    sleep 1
+    waited=$((waited + 1))
+done
+info "PDU sessions: ${sess}/${want}"
+
+if [ "$HOLD" -gt 0 ]; then
+    info "Holding ${reg} UEs attached for ${HOLD}s (AMF UEs: $(amf_health_field amf_ues))"
+    sleep "$HOLD"
+fi
+
+# ── Report ───────────────────────────────────────────────────
+cp_log_since amf "$AMF_MARK" > "$WORKDIR/amf.log"
+cp_log_since smf "$SMF_MARK" > "$WORKDIR/smf.log"
+meta="{\"profile\":\"${PROFILE}\",\"dnns\":\"${DNNS}\",\"nr_ue_processes\":${nsteps}}"
+csv=()
+[ -n "$CSV_OUT" ] && csv=(--csv "$CSV_OUT")
+
+echo ""
+python3 "$TESTS_DIR/ue_latency.py" --amf "$WORKDIR/amf.log" --smf "$WORKDIR/smf.log" \
+    --imsi "$BASE_SUPI" --expect "$UES" "${csv[@]}" | sed 's/^/  /'
+python3 "$TESTS_DIR/ue_latency.py" --amf "$WORKDIR/amf.log" --smf "$WORKDIR/smf.log" \
+    --imsi "$BASE_SUPI" --expect "$UES" --json --meta "$meta" | report_write "$JSON_OUT"
+RC=${PIPESTATUS[0]}
+echo ""
+
+# Results of one load shape are only comparable to the same shape
+perf_record_report "ue_load:${UES}@${PROFILE}" "$JSON_OUT" \
+    achieved_per_sec:achieved_per_sec:reg/s:higher \
+    registration_ms.p50:registration_p50_ms:ms:lower \
+    registration_ms.p99:registration_p99_ms:ms:lower
+
+if [ $RC -eq 0 ]; then
+    pass "All ${UES} UEs registered"
+else
+    fail "Only ${reg}/${UES} UEs registered"
+fi
+exit $RC
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+userplane_report.py — aggregate the iperf3 flows of one TC12 run.
+
+TC12 runs N UEs x F flows per phase, each an `iperf3 -J` client bound to
+a UE's uesimtun address and talking to the dn-sink container through
+gNB -> N3 -> UPF -> N6.  --dir holds one result per flow,
+
+  <phase>.<ue>.<flow>.json     iperf3 -J output (client side)
+
+and snaps.txt, one line per phase with the UPF counters around it:
+
+  <phase> <rx0> <tx0> <cpu_us0> <rx1> <tx1> <cpu_us1>
+
+rx/tx are ogstun packets (rx: uplink written by the UPF, tx: downlink
+read by it), cpu_us the CPU time of the UPF container (cgroup usage, or
+open5gs-upfd utime+stime without cgroup v2).  Per phase:
+
+  gbps            sum of the flows' received bit rate
+  mpps            ogstun packets / phase seconds (both directions)
+  fairness        Jain's index over the flows' rates (1.0 = equal share)
+  cpu_s_per_gbit  UPF CPU seconds per Gbit moved
+  jitter_ms, lost_pct   UDP phases: mean jitter, total loss
+
+Usage:
+  python3 tests/userplane_report.py --dir DIR --seconds 10 --json report.json
+
+Prints a table.  Exit status: 1 if a flow failed or moved nothing, else 0.
+"""
+
+import argparse
+import glob
+import json
+import os
+import sys
+
+
+def flow_result(path):
+    """-> dict(bps, bytes, retransmits, jitter_ms, lost, packets, error)"""
+    r = {"bps": 0.0, "bytes": 0, "retransmits": None, "jitter_ms": None,
+         "lost": None, "packets": None, "error": None}
+    try:
+        with open(path, errors="replace") as f:
+            d = json.load(f)
+    except (OSError, ValueError):
+        r["error"] = "no iperf3 result"
+        return r
+    if d.get("error"):
+        r["error"] = d["error"]
+    end = d.get("end") or {}
+    udp = ((d.get("start") or {}).get("test_start") or {}).get("protocol") == "UDP"
+    if not udp:
+        s = end.get("sum_received") or {}
+        r["retransmits"] = (end.get("sum_sent") or {}).get("retransmits")
+    else:
+        # iperf3 >= 3.10 splits sum_sent / sum_received; 3.9 has one sum
+        s = end.get("sum_received") or end.get("sum") or {}
+        r["jitter_ms"] = s.get("jitter_ms")
+        r["lost"] = s.get("lost_packets")
+        r["packets"] = s.get("packets")
+    r["bps"] = float(s.get("bits_per_second") or 0)
+    r["bytes"] = int(s.get("bytes") or 0)
+    return r
+
+
+def jain(xs):
+    sq = sum(x * x for x in xs)
+    return (sum(xs) ** 2) / (len(xs) * sq) if xs and sq > 0 else None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--dir", required=True)
+    ap.add_argument("--seconds", type=float, required=True, help="iperf3 -t per flow")
+    ap.add_argument("--meta", default="{}", help="JSON object merged into the report")
+    ap.add_argument("--json", help="write the report here")
+    a = ap.parse_args()
+
+    snaps = {}
+    try:
+        with open(os.path.join(a.dir, "snaps.txt")) as f:
+            for line in f:
+                p = line.split()
+                if len(p) == 7:
+                    snaps[p[0]] = [int(x) for x in p[1:]]
+    except OSError:
+        pass
+
+    phases, bad = {}, 0
+    names = []
+    for path in sorted(glob.glob(os.path.join(a.dir, "*.*.*.json"))):
+        phase, ue, flow = os.path.basename(path)[:-5].rsplit(".", 2)
+        if phase not in names:
+            names.append(phase)
+        f = flow_result(path)
+        f.update(ue=int(ue), flow=int(flow), gbps=f["bps"] / 1e9)
+        phases.setdefault(phase, []).append(f)
+
+    out = {}
+    print("%-8s %5s %9s %8s %9s %12s %10s %8s" % ("PHASE", "FLOWS", "GBIT/S", "MPPS",
+                                                  "FAIRNESS", "CPU S/GBIT", "JITTER MS", "LOSS %"))
+    for phase in names:
+        flows = sorted(phases[phase], key=lambda f: (f["ue"], f["flow"]))
+        gbps = sum(f["gbps"] for f in flows)
+        failed = [f for f in flows if f["error"] or f["bytes"] == 0]
+        bad += len(failed)
+        p = {"flows": len(flows), "failed": len(failed), "gbps": gbps,
+             "fairness": jain([f["gbps"] for f in flows]),
+             "mpps": None, "upf_cpu_s": None, "cpu_s_per_gbit": None,
+             "per_flow": [{k: f[k] for k in ("ue", "flow", "gbps", "retransmits",
+                                             "jitter_ms", "lost", "packets", "error")}
+                          for f in flows]}
+        s = snaps.get(phase)
+        if s:
+            p["mpps"] = ((s[3] - s[0]) + (s[4] - s[1])) / a.seconds / 1e6
+            p["upf_cpu_s"] = (s[5] - s[2]) / 1e6
+            if gbps > 0:
+                p["cpu_s_per_gbit"] = p["upf_cpu_s"] / (gbps * a.seconds)
+        udp = [f for f in flows if f["packets"] is not None]
+        if udp:
+            js = [f["jitter_ms"] for f in udp if f["jitter_ms"] is not None]
+            pk = sum(f["packets"] or 0 for f in udp)
+            p["jitter_ms"] = sum(js) / len(js) if js else None
+            p["lost_pct"] = 100.0 * sum(f["lost"] or 0 for f in udp) / pk if pk else None
+        out[phase] = p
+        g = lambda k, fmt: "-" if p.get(k) is None else fmt % p[k]
+        print("%-8s %5d %9.3f %8s %9s %12s %10s %8s" % (
+            phase, len(flows), gbps, g("mpps", "%.3f"), g("fairness", "%.3f"),
+            g("cpu_s_per_gbit", "%.3f"), g("jitter_ms", "%.3f"), g("lost_pct", "%.2f")))
+        for f in failed:
+            print("  %s ue %d flow %d: %s" % (phase, f["ue"], f["flow"],
+                                           f["error"] or "no data"), file=sys.stderr)
+
+    if a.json:
+        report = json.loads(a.meta)
+        report.update(seconds=a.seconds, phases=out)
+        with open(a.json, "w") as f:
+            json.dump(report, f, indent=2)
+    return 1 if bad or not out else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,101 @@
+#!/bin/bash
+# ============================================================
+# capture.sh — capture the CP container's control plane, then report
+# per-hop latency (cp-capture.c + cp_latency.py)
+# ============================================================
+# Runs cp-capture inside open5gs-cp's network namespace (NGAP and PFCP on
+# eth0, SBI between the NFs on lo) for --seconds, or for as long as the
+# command after "--" runs, then prints the cp_latency.py report.
+#
+# Usage: capture.sh [--seconds N] [--out FILE] [--json FILE] [--waterfall N]
+#                   [--container NAME] [--all] [-- command ...]
+#
+#   sudo tools/capture/capture.sh --seconds 30
+#   sudo tools/capture/capture.sh --json storm.json -- tests/tc11_registration_storm.sh 200
+#
+# Env:   CP_CAPTURE   path to cp-capture (default: build-output or compiled
+#                     from tools/capture with gcc)
+#
+# Needs root (setns + AF_PACKET).  The pcap is kept (default
+# tests/logs/cp_<timestamp>.pcap) and opens in Wireshark as well.
+# Exit status: the command's, else 1 if the capture dropped packets.
+# ============================================================
+
+set -uo pipefail
+
+HERE="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+source "$HERE/../../tests/common.sh"
+
+SECONDS_ARG=0
+OUT=$(report_path cp pcap)
+JSON=""
+WATERFALL=3
+CONTAINER="$CP_CTR"
+EXTRA=()
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --seconds)   SECONDS_ARG="$2"; shift 2 ;;
+        --out)       OUT="$2"; shift 2 ;;
+        --json)      JSON="$2"; shift 2 ;;
+        --waterfall) WATERFALL="$2"; shift 2 ;;
+        --container) CONTAINER="$2"; shift 2 ;;
+        --all)       EXTRA+=(--all); shift ;;
+        --)          shift; break ;;
+        *) echo "Usage: $0 [--seconds N] [--out FILE] [--json FILE] [--waterfall N] [--container NAME] [--all] [-- command ...]" >&2
+           exit 2 ;;
+    esac
+done
+if [ "$SECONDS_ARG" = 0 ] && [ $# -eq 0 ]; then
+    echo "$0: give --seconds N or a command after --" >&2
+    exit 2
+fi
+
+if [ "$(id -u)" != "0" ]; then
+    echo "$0: needs root (joins the container's network namespace)" >&2
+    exit 2
+fi
+
+PID=$(docker inspect -f '{{.State.Pid}}' "$CONTAINER" 2>/dev/null)
+if [ -z "$PID" ] || [ "$PID" = 0 ]; then
+    echo "$0: container $CONTAINER is not running" >&2
+    exit 1
+fi
+
+workdir_init cp-capture
+
+BIN="${CP_CAPTURE:-$PROJECT_DIR/build-output/open5gs/bin/cp-capture}"
+if [ ! -x "$BIN" ]; then
+    BIN="$WORKDIR/cp-capture"
+    echo "Building cp-capture from tools/capture" >&2
+    gcc -O2 -Wall -o "$BIN" "$HERE/cp-capture.c" || exit 1
+fi
+
+mkdir -p "$(dirname "$OUT")"
+STATS="$WORKDIR/stats"
+
+"$BIN" --netns "/proc/$PID/ns/net" --if any -w "$OUT" --seconds "$SECONDS_ARG" \
+    "${EXTRA[@]}" 2> "$STATS" &
+CAP=$!
+sleep 0.5
+if ! kill -0 "$CAP" 2>/dev/null; then
+    cat "$STATS" >&2
+    exit 1
+fi
+
+rc=0
+if [ $# -gt 0 ]; then
+    "$@"
+    rc=$?
+    kill -INT "$CAP" 2>/dev/null
+fi
+wait "$CAP"
+cap_rc=$?
+echo "capture: $(tail -n 1 "$STATS")  ->  $OUT" >&2
+[ "$rc" = 0 ] && rc=$cap_rc
+
+if [ -n "$JSON" ]; then
+    python3 "$HERE/cp_latency.py" "$OUT" --waterfall "$WATERFALL" --json > "$JSON"
+    echo "report: $JSON" >&2
+fi
+python3 "$HERE/cp_latency.py" "$OUT" --waterfall "$WATERFALL"
+exit "$rc"
@@ -0,0 +1,336 @@
+/*
+ * cp-capture — control-plane packet capture on a TPACKET_V3 ring.
+ *
+ * Captures NGAP (SCTP), SBI (HTTP/2 on TCP ports 7777-7799) and PFCP
+ * (UDP 8805) into a pcap file for tools/capture/cp_latency.py.  Built for
+ * capturing under tc11-style load without drops:
+ *
+ *   - the kernel fills a block ring (TPACKET_V3) shared with this process;
+ *     userspace walks a whole block per wakeup, no syscall per packet
+ *   - a classic BPF filter in the socket keeps everything else (GTP-U,
+ *     MongoDB, ...) out of the ring
+ *   - on loopback every packet would be seen twice (outgoing + incoming);
+ *     the filter drops the outgoing copy
+ *   - records are written with a large stdio buffer, nanosecond pcap
+ *
+ * --netns joins another network namespace before opening the socket, so
+ * the capture can run on the host against a container:
+ *
+ *   cp-capture --netns /proc/$(docker inspect -f '{{.State.Pid}}' open5gs-cp)/ns/net \
+ *              --if any -w cp.pcap --seconds 60
+ *
+ * In the CP container's namespace, "any" sees NGAP and PFCP on eth0 and
+ * the SBI traffic between the NFs (and the SCP) on lo.
+ *
+ * Link type is LINUX_SLL (cooked, from a SOCK_DGRAM packet socket), so
+ * Wireshark opens the file as well.
+ *
+ * Usage:
+ *   cp-capture [--if any|IFNAME] [--netns PATH] [-w FILE|-] [--snaplen 1536]
+ *              [--block-kb 1024] [--blocks 64] [--seconds 0] [--all]
+ *
+ * --all disables the port filter (still IPv4 only).  Stops on SIGINT /
+ * SIGTERM or after --seconds; prints one JSON line to stderr:
+ *   {"packets":N,"bytes":B,"kernel_packets":K,"drops":D,"freeze_q":F,"seconds":S}
+ * Exit status: 0, or 1 if the kernel dropped packets.
+ *
+ * Build: gcc -O2 -Wall -o cp-capture tools/capture/cp-capture.c
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#define PCAP_MAGIC_NS   0xa1b23c4d
+#define LINKTYPE_SLL    113
+
+#define SBI_PORT_MIN    7777
+#define SBI_PORT_MAX    7799
+#define PFCP_PORT       8805
+#define IPPROTO_SCTP_   132
+
+struct pcap_hdr {
+    uint32_t magic;
+    uint16_t major, minor;
+    int32_t  thiszone;
+    uint32_t sigfigs, snaplen, linktype;
+};
+
+struct pcap_rec {
+    uint32_t sec, nsec, caplen, len;
+};
+
+struct sll_hdr {
+    uint16_t pkttype, hatype, halen;
+    uint8_t  addr[8];
+    uint16_t protocol;
+};
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static double mono_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Filter over the network header (SOCK_DGRAM).  lo_ifindex is patched in:
+ * outgoing packets on lo are dropped, their incoming copy is kept.
+ */
+static int attach_filter(int fd, int lo_ifindex, int all)
+{
+    struct sock_filter prog[] = {
+        /* 0: drop the outgoing copy on loopback */
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_IFINDEX),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)lo_ifindex, 0, 3),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+        /* 5: IPv4 only */
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0xf0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x40, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+        /* 9: --all stops here */
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 0),   /* patched below */
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_SCTP_, 13, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 4),
+        /* 14: UDP 8805 either way */
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PFCP_PORT, 9, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PFCP_PORT, 7, 8),
+        /* 18: TCP, either port in the SBI range */
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, 0, 7),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 0),
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, SBI_PORT_MIN, 0, 1),
+        BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, SBI_PORT_MAX, 0, 3),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, SBI_PORT_MIN, 0, 2),
+        BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, SBI_PORT_MAX, 1, 0),
+        /* 25: accept */
+        BPF_STMT(BPF_RET | BPF_K, 0x40000),
+        /* 26: drop */
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog fprog = { sizeof(prog) / sizeof(prog[0]), prog };
+
+    /* --all: unconditional jump from 9 to accept */
+    prog[9] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JA, all ? 25 - 10 : 0, 0, 0);
+    if (lo_ifindex <= 0)
+        prog[1].k = 0xffffffff;
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog));
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s [--if any|IFNAME] [--netns PATH] [-w FILE|-] [--snaplen N]\n"
+        "          [--block-kb N] [--blocks N] [--seconds N] [--all]\n"
+        "  --if IFNAME     interface (default: any)\n"
+        "  --netns PATH    join this network namespace first (/proc/PID/ns/net)\n"
+        "  -w FILE         pcap output (default: cp.pcap; - for stdout)\n"
+        "  --snaplen N     bytes kept per packet (default: 1536)\n"
+        "  --block-kb N    ring block size in KB (default: 1024)\n"
+        "  --blocks N      ring blocks (default: 64)\n"
+        "  --seconds N     stop after N seconds (default: 0 = until signal)\n"
+        "  --all           keep all IPv4, not just NGAP/SBI/PFCP\n",
+        prog);
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = "any", *netns = NULL, *out = "cp.pcap";
+    unsigned snaplen = 1536, block_kb = 1024, nblocks = 64;
+    double seconds = 0;
+    int all = 0, i;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--if") && i + 1 < argc)
+            ifname = argv[++i];
+        else if (!strcmp(argv[i], "--netns") && i + 1 < argc)
+            netns = argv[++i];
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+            out = argv[++i];
+        else if (!strcmp(argv[i], "--snaplen") && i + 1 < argc)
+            snaplen = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--block-kb") && i + 1 < argc)
+            block_kb = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--blocks") && i + 1 < argc)
+            nblocks = (unsigned)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--all"))
+            all = 1;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (snaplen < 64 || block_kb < 64 || nblocks < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (netns) {
+        int nfd = open(netns, O_RDONLY | O_CLOEXEC);
+        if (nfd < 0 || setns(nfd, CLONE_NEWNET) < 0) {
+            fprintf(stderr, "cp-capture: netns %s: %s\n", netns, strerror(errno));
+            return 2;
+        }
+        close(nfd);
+    }
+
+    int fd = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_ALL));
+    if (fd < 0) {
+        fprintf(stderr, "cp-capture: packet socket: %s (needs CAP_NET_RAW)\n", strerror(errno));
+        return 2;
+    }
+    if (attach_filter(fd, (int)if_nametoindex("lo"), all) < 0) {
+        fprintf(stderr, "cp-capture: SO_ATTACH_FILTER: %s\n", strerror(errno));
+        return 2;
+    }
+
+    int ver = TPACKET_V3;
+    if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver)) < 0) {
+        fprintf(stderr, "cp-capture: TPACKET_V3: %s\n", strerror(errno));
+        return 2;
+    }
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = block_kb * 1024;
+    req.tp_block_nr = nblocks;
+    req.tp_frame_size = 2048;
+    req.tp_frame_nr = req.tp_block_size / req.tp_frame_size * req.tp_block_nr;
+    req.tp_retire_blk_tov = 50;     /* ms: hand over a partly filled block */
+    if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        fprintf(stderr, "cp-capture: PACKET_RX_RING (%u x %u KB): %s\n",
+                nblocks, block_kb, strerror(errno));
+        return 2;
+    }
+    size_t ring_len = (size_t)req.tp_block_size * req.tp_block_nr;
+    uint8_t *ring = mmap(NULL, ring_len, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_LOCKED, fd, 0);
+    if (ring == MAP_FAILED)
+        ring = mmap(NULL, ring_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        fprintf(stderr, "cp-capture: mmap ring: %s\n", strerror(errno));
+        return 2;
+    }
+
+    struct sockaddr_ll sll;
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    if (strcmp(ifname, "any")) {
+        sll.sll_ifindex = (int)if_nametoindex(ifname);
+        if (!sll.sll_ifindex) {
+            fprintf(stderr, "cp-capture: no interface %s\n", ifname);
+            return 2;
+        }
+    }
+    if (bind(fd, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
+        fprintf(stderr, "cp-capture: bind %s: %s\n", ifname, strerror(errno));
+        return 2;
+    }
+
+    FILE *fp = strcmp(out, "-") ? fopen(out, "wb") : stdout;
+    if (!fp) {
+        fprintf(stderr, "cp-capture: %s: %s\n", out, strerror(errno));
+        return 2;
+    }
+    setvbuf(fp, NULL, _IOFBF, 4 << 20);
+    struct pcap_hdr ph = { PCAP_MAGIC_NS, 2, 4, 0, 0, snaplen, LINKTYPE_SLL };
+    fwrite(&ph, sizeof(ph), 1, fp);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    uint64_t packets = 0, bytes = 0;
+    unsigned blk = 0;
+    double t0 = mono_s();
+    struct pollfd pfd = { fd, POLLIN | POLLERR, 0 };
+
+    while (!stop && !(seconds > 0 && mono_s() - t0 >= seconds)) {
+        struct tpacket_block_desc *bd =
+            (struct tpacket_block_desc *)(ring + (size_t)blk * req.tp_block_size);
+
+        if (!(bd->hdr.bh1.block_status & TP_STATUS_USER)) {
+            poll(&pfd, 1, 100);
+            continue;
+        }
+
+        struct tpacket3_hdr *h =
+            (struct tpacket3_hdr *)((uint8_t *)bd + bd->hdr.bh1.offset_to_first_pkt);
+        uint32_t n;
+        for (n = 0; n < bd->hdr.bh1.num_pkts; n++) {
+            const struct sockaddr_ll *a = (const struct sockaddr_ll *)
+                ((uint8_t *)h + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+            uint32_t caplen = h->tp_snaplen < snaplen ? h->tp_snaplen : snaplen;
+            struct pcap_rec rec = { h->tp_sec, h->tp_nsec,
+                                    caplen + (uint32_t)sizeof(struct sll_hdr),
+                                    h->tp_len + (uint32_t)sizeof(struct sll_hdr) };
+            struct sll_hdr sh;
+            memset(&sh, 0, sizeof(sh));
+            sh.pkttype = htons(a->sll_pkttype);
+            sh.hatype = htons(a->sll_hatype);
+            sh.halen = htons(a->sll_halen > 8 ? 8 : a->sll_halen);
+            memcpy(sh.addr, a->sll_addr, a->sll_halen > 8 ? 8 : a->sll_halen);
+            sh.protocol = a->sll_protocol;
+
+            fwrite(&rec, sizeof(rec), 1, fp);
+            fwrite(&sh, sizeof(sh), 1, fp);
+            fwrite((uint8_t *)h + h->tp_net, caplen, 1, fp);
+            packets++;
+            bytes += h->tp_len;
+            h = (struct tpacket3_hdr *)((uint8_t *)h + h->tp_next_offset);
+        }
+
+        __atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        blk = (blk + 1) % req.tp_block_nr;
+    }
+
+    fflush(fp);
+    if (fp != stdout)
+        fclose(fp);
+
+    struct tpacket_stats_v3 st;
+    socklen_t sl = sizeof(st);
+    memset(&st, 0, sizeof(st));
+    getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &st, &sl);
+    fprintf(stderr,
+        "{\"packets\":%llu,\"bytes\":%llu,\"kernel_packets\":%u,\"drops\":%u,"
+        "\"freeze_q\":%u,\"seconds\":%.3f}\n",
+        (unsigned long long)packets, (unsigned long long)bytes,
+        st.tp_packets, st.tp_drops, st.tp_freeze_q_cnt, mono_s() - t0);
+
+    munmap(ring, ring_len);
+    close(fd);
+    return st.tp_drops ? 1 : 0;
+}
@@ -0,0 +1,635 @@
+#!/usr/bin/env python3
+"""
+cp_latency.py — per-hop control-plane latency from a packet capture.
+
+Reads a pcap (tools/capture/cp-capture.c, or tcpdump: LINUX_SLL, SLL2,
+Ethernet or raw IP) and times the three control-plane interfaces:
+
+  NGAP  SCTP to/from port 38412.  NGAP is decoded far enough for the
+        procedure code, RAN-UE-NGAP-ID and the NAS-PDU; NAS far enough for
+        the 5GMM / 5GSM message type and the SUCI of a Registration
+        request (null scheme, NEA0 — the deployment's defaults).  Messages
+        are grouped per UE (gNB association + RAN-UE-NGAP-ID).
+  SBI   HTTP/2 cleartext on TCP 7777-7799, one TCP stream per direction
+        reassembled; a transaction is a request HEADERS frame and the
+        response HEADERS on the same stream.  The hop is named after the
+        server port (7778 is the SCP, 7784 the AUSF, ...).  HPACK is not
+        decoded beyond :method / :status in the first header field.
+  PFCP  UDP 8805, request and response paired by sequence number.
+
+Per UE it builds the procedures (Registration, PDU session establishment,
+Deregistration) and, per pair of consecutive NGAP messages, the time on
+the core side (uplink -> next downlink: AMF plus whatever it waited for)
+and on the RAN side (downlink -> next uplink: UERANSIM).  An SBI or PFCP
+transaction that starts inside exactly one UE's core-side gap is
+attributed to it in the waterfall; under load, overlapping gaps leave
+transactions unattributed rather than guessed.
+
+Output: per-interface latency histograms (log2 ms buckets) with p50/p99,
+per-procedure totals, and a waterfall for the first --waterfall UEs (or
+the --imsi ones).  --json prints all of it as one JSON object.
+
+Usage:
+  python3 tools/capture/cp_latency.py cp.pcap
+  python3 tools/capture/cp_latency.py cp.pcap --waterfall 5 --json > report.json
+  python3 tools/capture/cp_latency.py cp.pcap --imsi 001010000050641
+"""
+
+import argparse
+import bisect
+import json
+import struct
+import sys
+
+NGAP_PORT = 38412
+NGAP_PPID = 60
+SBI_PORTS = range(7777, 7800)
+PFCP_PORT = 8805
+
+SBI_NF = {7777: "nrf", 7778: "scp", 7779: "sepp", 7780: "amf", 7781: "smf",
+          7782: "pcf", 7783: "nssf", 7784: "ausf", 7785: "udm", 7786: "udr",
+          7787: "bsf"}
+
+NGAP_PROC = {
+    4: "DownlinkNASTransport", 9: "ErrorIndication", 14: "InitialContextSetup",
+    15: "InitialUEMessage", 20: "NGReset", 21: "NGSetup", 24: "Paging",
+    26: "PDUSessionResourceModify", 28: "PDUSessionResourceRelease",
+    29: "PDUSessionResourceSetup", 40: "UEContextModification",
+    41: "UEContextRelease", 42: "UEContextReleaseRequest",
+    44: "UERadioCapabilityInfoIndication", 46: "UplinkNASTransport",
+}
+NGAP_KIND = {0x00: "", 0x20: "Response", 0x40: "Failure"}
+IE_AMF_UE_ID, IE_NAS_PDU, IE_RAN_UE_ID = 10, 38, 85
+
+NAS_5GMM = {
+    0x41: "Registration request", 0x42: "Registration accept",
+    0x43: "Registration complete", 0x44: "Registration reject",
+    0x45: "Deregistration request", 0x46: "Deregistration accept",
+    0x47: "Deregistration request (NW)", 0x48: "Deregistration accept (NW)",
+    0x4c: "Service request", 0x4d: "Service reject", 0x4e: "Service accept",
+    0x54: "Configuration update command", 0x55: "Configuration update complete",
+    0x56: "Authentication request", 0x57: "Authentication response",
+    0x58: "Authentication reject", 0x59: "Authentication failure",
+    0x5a: "Authentication result", 0x5b: "Identity request",
+    0x5c: "Identity response", 0x5d: "Security mode command",
+    0x5e: "Security mode complete", 0x5f: "Security mode reject",
+    0x64: "5GMM status", 0x67: "UL NAS transport", 0x68: "DL NAS transport",
+}
+NAS_5GSM = {
+    0xc1: "PDU session establishment request", 0xc2: "PDU session establishment accept",
+    0xc3: "PDU session establishment reject", 0xd1: "PDU session release request",
+    0xd3: "PDU session release command", 0xd4: "PDU session release complete",
+}
+
+PFCP_MSG = {1: "Heartbeat", 3: "PFD Management", 5: "Association Setup",
+            7: "Association Update", 9: "Association Release", 12: "Node Report",
+            14: "Session Set Deletion", 50: "Session Establishment",
+            52: "Session Modification", 54: "Session Deletion", 56: "Session Report"}
+
+# (name, first message, last message): NAS or NGAP message names
+PROCEDURES = (
+    ("Registration", "Registration request", "Registration complete"),
+    ("PDU session establishment", "PDU session establishment request",
+     "PDUSessionResourceSetupResponse"),
+    ("Deregistration", "Deregistration request", "UEContextReleaseComplete"),
+)
+
+
+# ── pcap ────────────────────────────────────────────────────────────────
+
+def read_pcap(path):
+    """Yield (time_s, ipv4_packet) from a pcap file."""
+    with open(path, "rb") as f:
+        hdr = f.read(24)
+        if len(hdr) < 24:
+            return
+        magic = struct.unpack("<I", hdr[:4])[0]
+        if magic in (0xa1b2c3d4, 0xa1b23c4d):
+            end = "<"
+        elif magic in (0xd4c3b2a1, 0x4d3cb2a1):
+            end = ">"
+            magic = struct.unpack(">I", hdr[:4])[0]
+        else:
+            raise ValueError("%s: not a pcap file (pcapng: convert with editcap -F pcap)" % path)
+        frac = 1e9 if magic == 0xa1b23c4d else 1e6
+        link = struct.unpack(end + "I", hdr[20:24])[0] & 0xffff
+        rec = struct.Struct(end + "IIII")
+        while True:
+            h = f.read(16)
+            if len(h) < 16:
+                return
+            sec, sub, caplen, _ = rec.unpack(h)
+            data = f.read(caplen)
+            if link == 113:                 # LINUX_SLL
+                proto, ip = struct.unpack("!H", data[14:16])[0], data[16:]
+            elif link == 276:               # LINUX_SLL2
+                proto, ip = struct.unpack("!H", data[0:2])[0], data[20:]
+            elif link == 1:                 # Ethernet (one VLAN tag at most)
+                proto, ip = struct.unpack("!H", data[12:14])[0], data[14:]
+                if proto == 0x8100:
+                    proto, ip = struct.unpack("!H", data[16:18])[0], data[18:]
+            elif link in (101, 12, 228):    # raw IPv4
+                proto, ip = 0x0800, data
+            else:
+                raise ValueError("unsupported link type %d" % link)
+            if proto == 0x0800 and len(ip) >= 20 and ip[0] >> 4 == 4:
+                yield sec + sub / frac, ip
+
+
+def ip_str(b):
+    return "%d.%d.%d.%d" % tuple(b)
+
+
+# ── NGAP / NAS ──────────────────────────────────────────────────────────
+
+def aper_len(b, o):
+    if b[o] < 0x80:
+        return b[o], o + 1
+    return ((b[o] & 0x3f) << 8) | b[o + 1], o + 2
+
+
+def aper_uint(v, len_bits):
+    n = (v[0] >> (8 - len_bits)) + 1
+    return int.from_bytes(v[1:1 + n], "big")
+
+
+def ngap_decode(b):
+    """-> (label, ran_ue_id, amf_ue_id, nas_pdu) or None."""
+    try:
+        kind, proc = b[0] & 0xe0, b[1]
+        _, o = aper_len(b, 3)
+        o += 1                                  # extension bit + padding
+        count = struct.unpack("!H", b[o:o + 2])[0]
+        o += 2
+        ran = amf = nas = None
+        for _ in range(count):
+            ie = struct.unpack("!H", b[o:o + 2])[0]
+            n, o = aper_len(b, o + 3)
+            v = b[o:o + n]
+            o += n
+            if ie == IE_RAN_UE_ID:
+                ran = aper_uint(v, 2)
+            elif ie == IE_AMF_UE_ID:
+                amf = aper_uint(v, 3)
+            elif ie == IE_NAS_PDU:
+                ln, p = aper_len(v, 0)
+                nas = v[p:p + ln]
+    except (IndexError, struct.error):
+        return None
+    name = NGAP_PROC.get(proc, "NGAP-%d" % proc)
+    if kind == 0x00 and proc in (14, 26, 28, 29, 40):
+        name += "Request"
+    elif kind == 0x00 and proc == 41:
+        name += "Command"
+    elif kind == 0x20:
+        name += "Complete" if proc == 41 else "Response"
+    elif kind == 0x40:
+        name += "Failure"
+    return name, ran, amf, nas
+
+
+def bcd(b):
+    s = ""
+    for x in b:
+        for d in (x & 0xf, x >> 4):
+            if d <= 9:
+                s += str(d)
+    return s
+
+
+def nas_decode(b):
+    """-> (message name or None, imsi from a SUCI or None)."""
+    if len(b) < 3:
+        return None, None
+    if b[0] == 0x7e and b[1] & 0x0f and len(b) >= 10:
+        b = b[7:]                               # MAC + SQN; NEA0 leaves it readable
+        if b[0] != 0x7e:
+            return "(ciphered NAS)", None
+    if b[0] == 0x2e and len(b) >= 4:
+        return NAS_5GSM.get(b[3], "5GSM 0x%02x" % b[3]), None
+    if b[0] != 0x7e:
+        return None, None
+    t = b[2]
+    if t in (0x67, 0x68) and len(b) >= 10 and b[6] == 0x2e:
+        return nas_decode(b[6:])[0], None       # N1 SM container: the 5GSM message
+    imsi = None
+    if t == 0x41 and len(b) > 8:
+        n = struct.unpack("!H", b[4:6])[0]
+        ident = b[6:6 + n]
+        if len(ident) >= 9 and ident[0] & 0x07 == 1 and (ident[0] >> 4) & 0x07 == 0:
+            mcc = "%d%d%d" % (ident[1] & 0xf, ident[1] >> 4, ident[2] & 0xf)
+            mnc = "%d%d" % (ident[3] & 0xf, ident[3] >> 4)
+            if ident[2] >> 4 != 0xf:
+                mnc += str(ident[2] >> 4)
+            if ident[6] & 0x0f == 0:            # null protection scheme
+                imsi = mcc + mnc + bcd(ident[8:])
+    return NAS_5GMM.get(t, "5GMM 0x%02x" % t), imsi
+
+
+class Ngap:
+    def __init__(self):
+        self.ues = {}           # (assoc, ran_ue_id) -> {"imsi", "msgs": [(t, up, label, short)]}
+        self.seen = set()
+        self.frag = {}
+
+    def sctp(self, t, src, dst, b):
+        if len(b) < 12:
+            return
+        sport, dport = struct.unpack("!HH", b[:4])
+        if NGAP_PORT not in (sport, dport):
+            return
+        up = dport == NGAP_PORT
+        gnb = (src, sport) if up else (dst, dport)
+        o = 12
+        while o + 4 <= len(b):
+            ctype, flags, clen = b[o], b[o + 1], struct.unpack("!H", b[o + 2:o + 4])[0]
+            if clen < 4:
+                break
+            if ctype == 0 and clen >= 16:
+                tsn, sid, _, ppid = struct.unpack("!IHHI", b[o + 4:o + 16])
+                key = (src, sport, tsn)
+                if key not in self.seen:        # skip retransmissions
+                    self.seen.add(key)
+                    data = b[o + 16:o + clen]
+                    fk = (src, sport, sid)
+                    if not flags & 0x02:        # not the first fragment
+                        data = self.frag.pop(fk, b"") + data
+                    if flags & 0x01:
+                        if ppid in (NGAP_PPID, 0):
+                            self.message(t, gnb, up, data)
+                    else:
+                        self.frag[fk] = data
+            o += (clen + 3) & ~3
+
+    def message(self, t, gnb, up, data):
+        d = ngap_decode(data)
+        if not d or d[1] is None:
+            return
+        name, ran, _, nas = d
+        label = short = name
+        imsi = None
+        if nas:
+            msg, imsi = nas_decode(nas)
+            if msg:
+                label, short = "%s / %s" % (name, msg), msg
+        ue = self.ues.setdefault((gnb, ran), {"imsi": None, "msgs": []})
+        if imsi:
+            ue["imsi"] = imsi
+        ue["msgs"].append((t, up, label, short))
+
+
+# ── SBI (HTTP/2 cleartext) ──────────────────────────────────────────────
+
+H2_PREFACE = b"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+HPACK_METHOD = {0x82: "GET", 0x83: "POST"}
+HPACK_STATUS = {0x88: 200, 0x89: 204, 0x8a: 206, 0x8b: 304, 0x8c: 400, 0x8d: 404, 0x8e: 500}
+
+
+def huff_digits(b):
+    """HPACK Huffman for a digits-only string ('0'-'2': 5 bits, '3'-'9': 6)."""
+    bits = "".join("{:08b}".format(x) for x in b)
+    s, i = "", 0
+    while i + 5 <= len(bits):
+        v5 = int(bits[i:i + 5], 2)
+        if v5 <= 2:
+            s, i = s + str(v5), i + 5
+            continue
+        if i + 6 > len(bits):
+            break
+        v6 = int(bits[i:i + 6], 2)
+        if 0x19 <= v6 <= 0x1f:
+            s, i = s + str(v6 - 0x19 + 3), i + 6
+            continue
+        break                                   # EOS padding (all ones)
+    return s
+
+
+def hpack_first(block, name_index):
+    """Value of the first header field if it is :method (2) / :status (8)."""
+    if not block:
+        return None
+    x = block[0]
+    if name_index == 2 and x in HPACK_METHOD:
+        return HPACK_METHOD[x]
+    if name_index == 8 and x in HPACK_STATUS:
+        return HPACK_STATUS[x]
+    # literal with (0x40) / without (0x00) / never (0x10) indexing, indexed name
+    idx = x & 0x3f if x & 0xc0 == 0x40 else x & 0x0f
+    if x & 0x80 or idx != name_index or len(block) < 2:
+        return None
+    n, huff = block[1] & 0x7f, block[1] & 0x80
+    v = block[2:2 + n]
+    if huff:
+        return huff_digits(v) if name_index == 8 else None
+    return v.decode("ascii", "replace")
+
+
+class TcpDir:
+    __slots__ = ("next", "buf", "pending", "synced")
+
+    def __init__(self):
+        self.next = None
+        self.buf = bytearray()
+        self.pending = {}
+        self.synced = False
+
+
+def h2_plausible(b, o):
+    if o + 9 > len(b):
+        return o == len(b)
+    n, typ, sid = int.from_bytes(b[o:o + 3], "big"), b[o + 3], int.from_bytes(b[o + 5:o + 9], "big")
+    if typ > 9 or n > 1 << 20 or sid >> 31:
+        return False
+    return (sid == 0) == (typ in (4, 6, 7))
+
+
+class Sbi:
+    def __init__(self):
+        self.dirs = {}
+        self.open = {}          # (conn, stream) -> (t, method)
+        self.txns = []          # dicts
+
+    def tcp(self, t, src, dst, b):
+        if len(b) < 20:
+            return
+        sport, dport, seq = struct.unpack("!HHI", b[:8])
+        if sport not in SBI_PORTS and dport not in SBI_PORTS:
+            return
+        off, flags = (b[12] >> 4) * 4, b[13]
+        payload = b[off:]
+        to_server = dport in SBI_PORTS and not (sport in SBI_PORTS and sport < dport)
+        server = (dst, dport) if to_server else (src, sport)
+        client = (src, sport) if to_server else (dst, dport)
+        key = (src, sport, dst, dport)
+        d = self.dirs.get(key)
+        if flags & 0x02:                        # SYN: a fresh stream, framing known
+            d = self.dirs[key] = TcpDir()
+            d.next, d.synced = (seq + 1) & 0xffffffff, True
+            return
+        if not payload:
+            return
+        if d is None:
+            d = self.dirs[key] = TcpDir()
+            d.next = seq
+        diff = (seq - d.next) & 0xffffffff
+        if diff == 0:
+            d.buf += payload
+            d.next = (seq + len(payload)) & 0xffffffff
+            while d.next in d.pending:
+                p = d.pending.pop(d.next)
+                d.buf += p
+                d.next = (d.next + len(p)) & 0xffffffff
+        elif diff < 1 << 30:                    # ahead: hold it
+            if len(d.pending) < 256:
+                d.pending[seq] = payload
+            return
+        else:                                   # retransmission / overlap
+            over = (d.next - seq) & 0xffffffff
+            if over >= len(payload):
+                return
+            d.buf += payload[over:]
+            d.next = (seq + len(payload)) & 0xffffffff
+        self.frames(t, d, to_server, (client, server))
+
+    def frames(self, t, d, to_server, conn):
+        b = d.buf
+        if to_server and b.startswith(H2_PREFACE):
+            del b[:len(H2_PREFACE)]
+        if not d.synced:                        # joined mid-connection
+            for i in range(min(len(b), 4096)):
+                if h2_plausible(b, i) and h2_plausible(b, i + 9 + int.from_bytes(b[i:i + 3], "big")):
+                    del b[:i]
+                    d.synced = True
+                    break
+            else:
+                if len(b) > 4096:
+                    del b[:]
+                return
+        o = 0
+        while o + 9 <= len(b):
+            n, typ, fl = int.from_bytes(b[o:o + 3], "big"), b[o + 3], b[o + 4]
+            sid = int.from_bytes(b[o + 5:o + 9], "big") & 0x7fffffff
+            if o + 9 + n > len(b):
+                break
+            if typ == 1:                        # HEADERS
+                p = o + 9
+                pad = 0
+                if fl & 0x08:
+                    pad, p = b[p], p + 1
+                if fl & 0x20:
+                    p += 5
+                block = bytes(b[p:o + 9 + n - pad])
+                self.headers(t, to_server, conn, sid, block)
+            o += 9 + n
+        del b[:o]
+
+    def headers(self, t, to_server, conn, sid, block):
+        k = (conn, sid)
+        if to_server:
+            if k not in self.open:
+                self.open[k] = (t, hpack_first(block, 2))
+            return
+        req = self.open.pop(k, None)
+        if req is None:
+            return                              # trailers, or request before the capture
+        port = conn[1][1]
+        self.txns.append({"t": req[0], "ms": (t - req[0]) * 1000,
+                          "hop": "SBI %s (:%d)" % (SBI_NF.get(port, "?"), port),
+                          "method": req[1], "status": hpack_first(block, 8)})
+
+
+# ── PFCP ────────────────────────────────────────────────────────────────
+
+class Pfcp:
+    def __init__(self):
+        self.open = {}
+        self.txns = []
+
+    def udp(self, t, src, dst, b):
+        if len(b) < 8:
+            return
+        sport, dport = struct.unpack("!HH", b[:4])
+        if PFCP_PORT not in (sport, dport):
+            return
+        p = b[8:]
+        if len(p) < 8 or p[0] >> 5 != 1:
+            return
+        typ = p[1]
+        so = 12 if p[0] & 1 else 4
+        if len(p) < so + 3:
+            return
+        seq = int.from_bytes(p[so:so + 3], "big")
+        if typ in PFCP_MSG:
+            self.open[(src, sport, dst, dport, seq)] = (t, typ)
+            return
+        req = self.open.pop((dst, dport, src, sport, seq), None)
+        if req and typ == req[1] + 1:
+            self.txns.append({"t": req[0], "ms": (t - req[0]) * 1000,
+                              "hop": "PFCP %s" % PFCP_MSG[req[1]], "method": None,
+                              "status": None})
+
+
+# ── Analysis ────────────────────────────────────────────────────────────
+
+BUCKETS = [0.25 * 2 ** i for i in range(16)]       # 0.25 ms .. 8 s
+
+
+def pct(v, p):
+    if not v:
+        return None
+    i = min(len(v) - 1, max(0, int(len(v) * p / 100.0 + 0.5) - 1))
+    return round(v[i], 3)
+
+
+def dist(values):
+    v = sorted(values)
+    hist = [0] * (len(BUCKETS) + 1)
+    for x in v:
+        hist[bisect.bisect_left(BUCKETS, x)] += 1
+    return {"n": len(v), "p50": pct(v, 50), "p90": pct(v, 90), "p99": pct(v, 99),
+            "p999": pct(v, 99.9), "max": round(v[-1], 3) if v else None,
+            "hist": hist}
+
+
+def is_msg(label, name):
+    return label == name or label.endswith(" / " + name)
+
+
+def analyze(path, want_imsi=(), waterfalls=3):
+    ngap, sbi, pfcp = Ngap(), Sbi(), Pfcp()
+    packets = 0
+    for t, ip in read_pcap(path):
+        packets += 1
+        ihl = (ip[0] & 0x0f) * 4
+        if struct.unpack("!H", ip[6:8])[0] & 0x1fff:
+            continue                            # non-first fragment
+        proto, src, dst, l4 = ip[9], ip_str(ip[12:16]), ip_str(ip[16:20]), ip[ihl:]
+        if proto == 132:
+            ngap.sctp(t, src, dst, l4)
+        elif proto == 6:
+            sbi.tcp(t, src, dst, l4)
+        elif proto == 17:
+            pfcp.udp(t, src, dst, l4)
+
+    hops = {}
+
+    def add(hop, ms):
+        hops.setdefault(hop, []).append(ms)
+
+    # NGAP pairs per UE and the core-side gaps
+    gaps = []                                   # (start, end, ue_index, uplink msg index)
+    procs = {}
+    ues = list(ngap.ues.values())
+    for ui, ue in enumerate(ues):
+        msgs = ue["msgs"]
+        msgs.sort(key=lambda m: m[0])
+        for i in range(1, len(msgs)):
+            (t0, up0, _, s0), (t1, up1, _, s1) = msgs[i - 1], msgs[i]
+            ms = (t1 - t0) * 1000
+            if up0 and not up1:
+                add("NGAP core: %s -> %s" % (s0, s1), ms)
+                gaps.append((t0, t1, ui, i - 1))
+            elif not up0 and up1:
+                add("NGAP RAN: %s -> %s" % (s0, s1), ms)
+        for name, first, last in PROCEDURES:
+            start = None
+            for t, _, label, _ in msgs:
+                if is_msg(label, first):
+                    start = t
+                elif start is not None and is_msg(label, last):
+                    procs.setdefault(name, []).append((t - start) * 1000)
+                    start = None
+
+    for x in sbi.txns + pfcp.txns:
+        add(x["hop"], x["ms"])
+
+    # Attribute SBI / PFCP transactions to a UE when exactly one core-side
+    # gap is open at the transaction's start
+    gaps.sort()
+    starts = [g[0] for g in gaps]
+    attributed = {}
+    for x in sorted(sbi.txns + pfcp.txns, key=lambda x: x["t"]):
+        i = bisect.bisect_right(starts, x["t"])
+        hit = [g for g in gaps[max(0, i - 64):i] if g[1] >= x["t"]]
+        if len(hit) == 1:
+            attributed.setdefault((hit[0][2], hit[0][3]), []).append(x)
+
+    picked = [ui for ui, ue in enumerate(ues)
+              if (ue["imsi"] in want_imsi if want_imsi else ue["imsi"])]
+    if not want_imsi:
+        picked = picked[:waterfalls]
+    wf = []
+    for ui in picked:
+        msgs = ues[ui]["msgs"]
+        t0 = msgs[0][0]
+        rows = []
+        for i, (t, up, label, _) in enumerate(msgs):
+            row = {"ms": round((t - t0) * 1000, 3), "dir": "gNB->AMF" if up else "AMF->gNB",
+                   "msg": label}
+            sub = attributed.get((ui, i), [])
+            if sub:
+                row["core"] = [{"at_ms": round((x["t"] - t0) * 1000, 3), "hop": x["hop"],
+                                "ms": round(x["ms"], 3), "method": x["method"],
+                                "status": x["status"]} for x in sub]
+            rows.append(row)
+        wf.append({"imsi": ues[ui]["imsi"], "rows": rows})
+
+    return {
+        "packets": packets,
+        "ues": len(ues),
+        "sbi_transactions": len(sbi.txns),
+        "pfcp_transactions": len(pfcp.txns),
+        "attributed": sum(len(v) for v in attributed.values()),
+        "procedures": {k: dist(v) for k, v in sorted(procs.items())},
+        "hops": {k: dist(v) for k, v in sorted(hops.items())},
+        "waterfalls": wf,
+    }
+
+
+def hist_line(hist):
+    top = max(hist) or 1
+    bars = " ▁▂▃▄▅▆▇█"
+    return "".join(bars[(h * 8 + top - 1) // top] for h in hist)
+
+
+def print_report(r):
+    print("%d packets, %d UEs, %d SBI and %d PFCP transactions (%d attributed to a UE)"
+          % (r["packets"], r["ues"], r["sbi_transactions"], r["pfcp_transactions"],
+             r["attributed"]))
+    print("")
+    print("histogram buckets (ms): <=0.25 0.5 1 2 4 8 16 32 64 128 256 512 1k 2k 4k 8k >8k")
+    for title, group in (("Procedures", r["procedures"]), ("Hops", r["hops"])):
+        print("")
+        print("%-66s %6s %9s %9s %9s  %s" % (title, "n", "p50 ms", "p99 ms", "max ms", "histogram"))
+        for k, d in group.items():
+            print("%-66s %6d %9s %9s %9s  %s" % (k[:66], d["n"], d["p50"], d["p99"], d["max"],
+                                                hist_line(d["hist"])))
+    for w in r["waterfalls"]:
+        print("")
+        print("Waterfall imsi-%s" % w["imsi"])
+        for row in w["rows"]:
+            print("  %+10.3f ms  %-8s  %s" % (row["ms"], row["dir"], row["msg"]))
+            for c in row.get("core", []):
+                extra = " ".join(str(x) for x in (c["method"], c["status"]) if x)
+                print("  %+10.3f ms      |  %-28s %8.3f ms  %s"
+                      % (c["at_ms"], c["hop"], c["ms"], extra))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("pcap")
+    ap.add_argument("--waterfall", type=int, default=3, help="UEs to draw (default: 3)")
+    ap.add_argument("--imsi", action="append", default=[], help="draw this UE (repeatable)")
+    ap.add_argument("--json", action="store_true")
+    a = ap.parse_args()
+
+    imsis = [x[5:] if x.startswith("imsi-") else x for x in a.imsi]
+    r = analyze(a.pcap, imsis, a.waterfall)
+    if a.json:
+        print(json.dumps(r))
+    else:
+        print_report(r)
+
+
+if __name__ == "__main__":
+    main()
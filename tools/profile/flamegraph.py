@@ -0,0 +1,341 @@
+#!/usr/bin/env python3
+"""
+flamegraph.py — per-NF folded stacks and SVG flamegraphs from perf.
+
+Used by tools/profile/profile.sh (./open5gs.sh profile); each step also
+runs on its own.
+
+  symfs   Stage a --symfs tree for `perf script` from `perf buildid-list`.
+          open5GS binaries and libraries come from build-output/ when
+          their build-id matches the one perf recorded.  The other paths
+          are printed on stdout, one per line, for profile.sh to copy out
+          of the container.  On a mismatch (build-output rebuilt since the
+          image) the container's copy is used.
+
+  fold    Split `perf script` output by NF (--nfs: "<host pid> <nf>" per
+          line) and fold it into <out>/<nf>.cpu.folded (samples) and, with
+          --offcpu, <out>/<nf>.offcpu.folded (microseconds blocked).  An
+          SVG is written next to each.  The off-CPU input is sched_switch
+          recorded system-wide: a thread's stack when it switches out, and
+          the time until it switches back in.  The leaf frame says why it
+          was off the CPU: [sleep] (S: poll, locks, timers), [io] (D) or
+          [preempted] (R).
+
+  svg     Render one folded file.
+
+Folded lines are "<thread>;<root frame>;...;<leaf frame> <weight>" as in
+Brendan Gregg's FlameGraph tools, so they load there and in speedscope.
+Kernel frames end in "_[k]".
+
+Usage:
+  flamegraph.py symfs --buildids ids.txt --build-output build-output/open5gs --symfs DIR
+  flamegraph.py fold --nfs nfs.txt --cpu cpu.txt [--offcpu off.txt] --out DIR
+  flamegraph.py svg in.folded out.svg [--title T] [--offcpu]
+"""
+
+import argparse
+import html
+import os
+import re
+import struct
+import sys
+import zlib
+
+HEADER = re.compile(r"^(?P<comm>\S.*?)\s+(?P<pid>\d+)/(?P<tid>\d+)\s+(?:\[\d+\]\s+)?"
+                    r"(?P<time>\d+\.\d+):\s+(?:\d+\s+)?(?P<event>[\w:.-]+):\s*(?P<rest>.*)$")
+FRAME = re.compile(r"^\s+([0-9a-f]+)\s+(.*?)\s+\((.*)\)\s*$")
+SWITCH = re.compile(r"prev_comm=(.*?)\s+prev_pid=(\d+)\s+prev_prio=\d+\s+prev_state=(\S+)\s+"
+                    r"==>\s+next_comm=.*?\s+next_pid=(\d+)")
+STATES = {"S": "[sleep]", "D": "[io]", "R": "[preempted]", "R+": "[preempted]"}
+
+
+# ── build-ids / symfs ────────────────────────────────────────────────────────
+
+def build_id(path):
+    """GNU build-id of an ELF file as hex, or None"""
+    try:
+        with open(path, "rb") as f:
+            data = f.read()
+    except OSError:
+        return None
+    if data[:4] != b"\x7fELF":
+        return None
+    is64, end = data[4] == 2, "<" if data[5] == 1 else ">"
+    if is64:
+        phoff, = struct.unpack_from(end + "Q", data, 0x20)
+        phentsize, phnum = struct.unpack_from(end + "HH", data, 0x36)
+    else:
+        phoff, = struct.unpack_from(end + "I", data, 0x1c)
+        phentsize, phnum = struct.unpack_from(end + "HH", data, 0x2a)
+    for i in range(phnum):
+        o = phoff + i * phentsize
+        if is64:
+            ptype, _, off, _, _, size = struct.unpack_from(end + "IIQQQQ", data, o)
+        else:
+            ptype, off, _, _, size = struct.unpack_from(end + "IIIII", data, o)
+        if ptype != 4:                          # PT_NOTE
+            continue
+        p = off
+        while p + 12 <= off + size:
+            namesz, descsz, ntype = struct.unpack_from(end + "III", data, p)
+            name = data[p + 12:p + 12 + namesz]
+            desc_at = p + 12 + ((namesz + 3) & ~3)
+            if ntype == 3 and name.rstrip(b"\0") == b"GNU":
+                return data[desc_at:desc_at + descsz].hex()
+            p = desc_at + ((descsz + 3) & ~3)
+    return None
+
+
+def local_copy(path, build_output):
+    """Container path -> the same file under build-output/, or None"""
+    name = os.path.basename(path)
+    for sub in ("bin", "lib"):
+        cand = os.path.join(build_output, sub, name)
+        if os.path.isfile(cand):
+            return cand
+    return None
+
+
+def cmd_symfs(a):
+    os.makedirs(a.symfs, exist_ok=True)
+    with open(a.buildids) as f:
+        for line in f:
+            p = line.split(None, 1)
+            if len(p) != 2:
+                continue
+            bid, path = p[0], p[1].strip()
+            if not path.startswith("/") or path.startswith("/proc/"):
+                continue                        # [kernel.kallsyms], [vdso], ...
+            dest = os.path.join(a.symfs, path.lstrip("/"))
+            src = local_copy(path, a.build_output)
+            if src and build_id(src) == bid:
+                os.makedirs(os.path.dirname(dest), exist_ok=True)
+                if os.path.lexists(dest):
+                    os.unlink(dest)
+                os.symlink(os.path.abspath(src), dest)
+                continue
+            if src:
+                print("flamegraph: %s: build-output copy has another build-id "
+                      "(rebuilt since the image?), using the container's" % path,
+                      file=sys.stderr)
+            print(path)
+    return 0
+
+
+# ── perf script -> folded ────────────────────────────────────────────────────
+
+def samples(path):
+    """perf script output -> (comm, pid, tid, time, event, rest, [frames leaf first])"""
+    cur = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not line.strip():
+                if cur:
+                    yield cur
+                cur = None
+                continue
+            m = FRAME.match(line)
+            if m and cur is not None:
+                sym, dso = m.group(2), m.group(3)
+                if sym == "[unknown]":
+                    sym = "[%s]" % os.path.basename(dso) if dso != "[unknown]" else "[unknown]"
+                elif dso.startswith("[kernel"):
+                    sym += "_[k]"
+                cur[6].append(sym.split("+0x")[0])
+                continue
+            m = HEADER.match(line)
+            if m:
+                if cur:
+                    yield cur
+                cur = (m.group("comm"), int(m.group("pid")), int(m.group("tid")),
+                       float(m.group("time")), m.group("event"), m.group("rest"), [])
+    if cur:
+        yield cur
+
+
+def fold_cpu(path, nfs):
+    out = {}
+    for comm, pid, _, _, _, _, frames in samples(path):
+        nf = nfs.get(pid)
+        if nf is None:
+            continue
+        key = ";".join([comm] + frames[::-1])
+        d = out.setdefault(nf, {})
+        d[key] = d.get(key, 0) + 1
+    return out
+
+
+def fold_offcpu(path, nfs):
+    """Blocked time per stack (us), from system-wide sched_switch"""
+    out, pending, tid_nf = {}, {}, {}
+    for comm, pid, tid, t, event, rest, frames in samples(path):
+        m = SWITCH.search(rest)
+        if not m or "sched_switch" not in event:
+            continue
+        prev, state, nxt = int(m.group(2)), m.group(3), int(m.group(4))
+        if prev == tid and pid in nfs:
+            tid_nf[tid] = nfs[pid]
+            leaf = STATES.get(state, "[%s]" % state)
+            pending[prev] = (t, ";".join([m.group(1)] + frames[::-1] + [leaf]))
+        if nxt in pending:
+            t0, key = pending.pop(nxt)
+            us = int(round((t - t0) * 1e6))
+            if us > 0:
+                d = out.setdefault(tid_nf[nxt], {})
+                d[key] = d.get(key, 0) + us
+    return out
+
+
+def write_folded(path, folded):
+    with open(path, "w") as f:
+        for k, v in sorted(folded.items()):
+            f.write("%s %d\n" % (k, v))
+
+
+def read_folded(path):
+    folded = {}
+    with open(path) as f:
+        for line in f:
+            k, _, v = line.rstrip("\n").rpartition(" ")
+            if k and v.isdigit():
+                folded[k] = folded.get(k, 0) + int(v)
+    return folded
+
+
+def top_frames(folded, n=5, user=False):
+    """Leaf frames by self weight; user=True skips kernel frames and the
+    [sleep]/[io] marker, so off-CPU time lands on the caller that blocked"""
+    self_w = {}
+    for k, v in folded.items():
+        fr = k.split(";")
+        leaf = fr[-1]
+        if user:
+            rest = [f for f in fr[1:]
+                    if not f.endswith("_[k]") and f not in STATES.values()]
+            leaf = rest[-1] if rest else fr[-1]
+        self_w[leaf] = self_w.get(leaf, 0) + v
+    return sorted(self_w.items(), key=lambda x: -x[1])[:n]
+
+
+# ── SVG ──────────────────────────────────────────────────────────────────────
+
+def color(name, offcpu):
+    h = zlib.crc32(name.encode())
+    v1, v2 = (h & 0xff) / 255.0, ((h >> 8) & 0xff) / 255.0
+    if offcpu:
+        return "rgb(%d,%d,%d)" % (50 + 60 * v1, 80 + 90 * v2, 200 + 55 * v1)
+    if name.endswith("_[k]"):
+        return "rgb(%d,%d,%d)" % (200 + 55 * v1, 120 + 60 * v2, 60)
+    return "rgb(%d,%d,%d)" % (205 + 50 * v2, 60 + 130 * v1, 40 + 30 * v2)
+
+
+def svg(folded, path, title, unit, offcpu=False):
+    tree = {"c": {}, "w": 0}
+    for k, v in folded.items():
+        node = tree
+        node["w"] += v
+        for fr in k.split(";"):
+            node = node["c"].setdefault(fr, {"c": {}, "w": 0})
+            node["w"] += v
+    total = tree["w"] or 1
+    width, fh, pad = 1200, 16, 10
+    rects = []
+    depth_max = [0]
+
+    def walk(node, x, depth):
+        for name, ch in sorted(node["c"].items()):
+            w = ch["w"] * (width - 2 * pad) / float(total)
+            if w >= 0.3:
+                rects.append((x, depth, w, name, ch["w"]))
+                depth_max[0] = max(depth_max[0], depth)
+                walk(ch, x, depth + 1)
+            x += w
+
+    walk(tree, pad, 0)
+    height = (depth_max[0] + 1) * fh + 60
+    o = ['<?xml version="1.0" standalone="no"?>',
+         '<svg version="1.1" width="%d" height="%d" xmlns="http://www.w3.org/2000/svg" '
+         'font-family="Verdana" font-size="11">' % (width, height),
+         '<rect width="100%" height="100%" fill="#f8f8f8"/>',
+         '<text x="%d" y="24" text-anchor="middle" font-size="17">%s</text>'
+         % (width // 2, html.escape(title)),
+         '<text x="%d" y="%d" fill="#555">total: %d %s</text>' % (pad, height - 8, total, unit)]
+    for x, depth, w, name, weight in rects:
+        y = height - 30 - (depth + 1) * fh
+        tip = "%s (%d %s, %.2f%%)" % (name, weight, unit, weight * 100.0 / total)
+        o.append('<g><title>%s</title><rect x="%.1f" y="%d" width="%.1f" height="%d" '
+                 'fill="%s" rx="2"/>' % (html.escape(tip), x, y, w, fh - 1, color(name, offcpu)))
+        chars = int(w / 7)
+        if chars >= 3:
+            label = name if len(name) <= chars else name[:chars - 2] + ".."
+            o.append('<text x="%.1f" y="%d">%s</text>' % (x + 3, y + fh - 4, html.escape(label)))
+        o.append("</g>")
+    o.append("</svg>")
+    with open(path, "w") as f:
+        f.write("\n".join(o) + "\n")
+
+
+# ── commands ─────────────────────────────────────────────────────────────────
+
+def cmd_fold(a):
+    nfs = {}
+    with open(a.nfs) as f:
+        for line in f:
+            p = line.split()
+            if len(p) == 2 and p[0].isdigit():
+                nfs[int(p[0])] = p[1]
+    os.makedirs(a.out, exist_ok=True)
+    kinds = [("cpu", fold_cpu(a.cpu, nfs), "samples")]
+    if a.offcpu:
+        kinds.append(("offcpu", fold_offcpu(a.offcpu, nfs), "us"))
+    for kind, per_nf, unit in kinds:
+        for nf in sorted(set(nfs.values())):
+            folded = per_nf.get(nf, {})
+            base = os.path.join(a.out, "%s.%s" % (nf, kind))
+            write_folded(base + ".folded", folded)
+            svg(folded, base + ".svg", "%s %s" % (nf, "off-CPU" if kind == "offcpu" else "CPU"),
+                unit, kind == "offcpu")
+            total = sum(folded.values())
+            if kind == "offcpu":
+                print("%-5s %-6s %10.1f ms blocked" % (nf, kind, total / 1000.0))
+            else:
+                print("%-5s %-6s %10d samples" % (nf, kind, total))
+            for name, w in top_frames(folded, user=(kind == "offcpu")):
+                print("        %5.1f%%  %s" % (w * 100.0 / total, name))
+    return 0
+
+
+def cmd_svg(a):
+    svg(read_folded(a.input), a.output, a.title or os.path.basename(a.input),
+        "us" if a.offcpu else "samples", a.offcpu)
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("symfs", help="stage a --symfs tree from build-output")
+    p.add_argument("--buildids", required=True, help="perf buildid-list output")
+    p.add_argument("--build-output", required=True, help="build-output/open5gs")
+    p.add_argument("--symfs", required=True)
+
+    p = sub.add_parser("fold", help="perf script output -> per-NF folded + SVG")
+    p.add_argument("--nfs", required=True, help="'<host pid> <nf>' per line")
+    p.add_argument("--cpu", required=True, help="perf script of the CPU samples")
+    p.add_argument("--offcpu", help="perf script of the sched_switch records")
+    p.add_argument("--out", required=True)
+
+    p = sub.add_parser("svg", help="render one folded file")
+    p.add_argument("input")
+    p.add_argument("output")
+    p.add_argument("--title")
+    p.add_argument("--offcpu", action="store_true", help="weights are microseconds")
+
+    a = ap.parse_args()
+    sys.exit({"symfs": cmd_symfs, "fold": cmd_fold, "svg": cmd_svg}[a.cmd](a))
+
+
+if __name__ == "__main__":
+    main()
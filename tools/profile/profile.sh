@@ -0,0 +1,174 @@
+#!/bin/bash
+# ============================================================
+# profile.sh — sample open5GS daemons with perf, then write per-NF
+# folded stacks and SVG flamegraphs (flamegraph.py)
+# ============================================================
+# Runs perf on the host against the NF processes inside open5gs-cp /
+# open5gs-upf (host PIDs, found through the container's PID namespace),
+# for --seconds or for as long as the command after "--" runs.
+#
+#   CPU      cpu-clock samples at --freq Hz, per NF process
+#   off-CPU  (--offcpu) sched_switch of the NF threads, system-wide with a
+#            tid filter: where each thread blocked and for how long, so
+#            lock, socket and MongoDB waits in AMF/SMF/UDR show up
+#
+# Symbols come from build-output/open5gs (unstripped, with debug info)
+# when the build-id matches what perf recorded, else from the container.
+#
+# Usage: profile.sh [--seconds N] [--freq HZ] [--offcpu] [--unwind dwarf|fp]
+#                   [--out DIR] <nf|all> ... [-- command ...]
+#
+#   sudo tools/profile/profile.sh --seconds 30 amf smf
+#   sudo tools/profile/profile.sh --offcpu all -- tests/tc11_registration_storm.sh 200
+#
+# Output (default tests/logs/profile_<timestamp>/): <nf>.cpu.folded/.svg,
+# <nf>.offcpu.folded/.svg, and the perf.data files for `perf report`.
+# Needs root and perf (linux-tools) on the host.
+# ============================================================
+
+set -uo pipefail
+
+HERE="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+source "$HERE/../../tests/common.sh"
+BUILD_OUTPUT="$PROJECT_DIR/build-output/open5gs"
+CP_NFS="nrf scp amf smf ausf udm udr pcf nssf bsf"
+
+SECS=0
+FREQ=199
+OFFCPU=0
+UNWIND=dwarf
+OUT=$(report_path profile)
+NFS=()
+usage() {
+    echo "Usage: $0 [--seconds N] [--freq HZ] [--offcpu] [--unwind dwarf|fp] [--out DIR] <nf|all> ... [-- command ...]" >&2
+    exit 2
+}
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --seconds) SECS="$2"; shift 2 ;;
+        --freq)    FREQ="$2"; shift 2 ;;
+        --offcpu)  OFFCPU=1; shift ;;
+        --unwind)  UNWIND="$2"; shift 2 ;;
+        --out)     OUT="$2"; shift 2 ;;
+        --)        shift; break ;;
+        all)       NFS+=($CP_NFS upf); shift ;;
+        nrf|scp|amf|smf|ausf|udm|udr|pcf|nssf|bsf|upf) NFS+=("$1"); shift ;;
+        *)         usage ;;
+    esac
+done
+[ ${#NFS[@]} -gt 0 ] || usage
+case "$UNWIND" in dwarf|fp) ;; *) usage ;; esac
+if [ "$SECS" = 0 ] && [ $# -eq 0 ]; then
+    echo "$0: give --seconds N or a command after --" >&2
+    exit 2
+fi
+if [ "$(id -u)" != "0" ]; then
+    echo "$0: needs root (perf on another PID namespace's processes)" >&2
+    exit 2
+fi
+if ! command -v perf >/dev/null; then
+    echo "$0: perf not found (apt install linux-tools-\$(uname -r), or linux-perf)" >&2
+    exit 2
+fi
+
+workdir_init open5gs-profile
+
+# ── NF processes: host PID <-> NF, per container ─────────────
+containers=()
+: > "$WORKDIR/nfs.txt"
+for nf in "${NFS[@]}"; do
+    c=$CP_CTR
+    [ "$nf" = upf ] && c=$UPF_CTR
+    cpid=$(docker inspect -f '{{.State.Pid}}' "$c" 2>/dev/null)
+    if [ -z "$cpid" ] || [ "$cpid" = 0 ]; then
+        echo "$0: $c is not running (needed for $nf)" >&2
+        exit 1
+    fi
+    [[ " ${containers[*]} " == *" $c "* ]] || containers+=("$c")
+    ns=$(readlink "/proc/$cpid/ns/pid")
+    found=0
+    for d in /proc/[0-9]*; do
+        [ "$(cat "$d/comm" 2>/dev/null)" = "open5gs-${nf}d" ] || continue
+        [ "$(readlink "$d/ns/pid" 2>/dev/null)" = "$ns" ] || continue
+        echo "${d#/proc/} $nf" >> "$WORKDIR/nfs.txt"
+        found=1
+    done
+    [ "$found" = 1 ] || echo "$0: no open5gs-${nf}d in $c, skipped" >&2
+done
+[ -s "$WORKDIR/nfs.txt" ] || { echo "$0: no NF process to profile" >&2; exit 1; }
+PIDS=$(awk '{ print $1 }' "$WORKDIR/nfs.txt" | paste -sd, -)
+
+# ── Record ───────────────────────────────────────────────────
+mkdir -p "$OUT"
+if [ "$SECS" = 0 ]; then
+    # Until the command exits: perf stops on SIGINT
+    SLEEP=(sleep 86400)
+else
+    SLEEP=(sleep "$SECS")
+fi
+
+perf record -q -e cpu-clock -F "$FREQ" --call-graph "$UNWIND" -p "$PIDS" \
+    -o "$OUT/cpu.perf.data" -- "${SLEEP[@]}" 2> "$WORKDIR/cpu.err" &
+PERFS=($!)
+
+if [ "$OFFCPU" = 1 ]; then
+    # The tid filter is fixed at start: threads created later are missed
+    filter=""
+    for pid in ${PIDS//,/ }; do
+        for t in /proc/$pid/task/*; do
+            t=${t##*/}
+            filter+="${filter:+ || }prev_pid == $t || next_pid == $t"
+        done
+    done
+    perf record -q -a -e sched:sched_switch --filter "$filter" \
+        --call-graph "$UNWIND" -o "$OUT/offcpu.perf.data" -- "${SLEEP[@]}" \
+        2> "$WORKDIR/offcpu.err" &
+    PERFS+=($!)
+fi
+sleep 1
+for p in "${PERFS[@]}"; do
+    if ! kill -0 "$p" 2>/dev/null; then
+        cat "$WORKDIR"/*.err >&2
+        exit 1
+    fi
+done
+echo "profiling ${NFS[*]} (pids $PIDS)$([ "$OFFCPU" = 1 ] && echo ", off-CPU on")..." >&2
+
+rc=0
+if [ $# -gt 0 ]; then
+    "$@"
+    rc=$?
+    # perf forwards SIGINT to its workload and writes out
+    for p in "${PERFS[@]}"; do kill -INT "$p" 2>/dev/null; done
+fi
+for p in "${PERFS[@]}"; do wait "$p"; done
+
+# ── Symbols: build-output first, container copies for the rest ──
+SYMFS="$WORKDIR/symfs"
+mkdir -p "$SYMFS/proc"
+cat /proc/kallsyms > "$SYMFS/proc/kallsyms"
+for d in "$OUT"/*.perf.data; do
+    perf buildid-list -i "$d" 2>/dev/null
+done | sort -u > "$WORKDIR/buildids.txt"
+python3 "$HERE/flamegraph.py" symfs --buildids "$WORKDIR/buildids.txt" \
+    --build-output "$BUILD_OUTPUT" --symfs "$SYMFS" |
+while IFS= read -r path; do
+    mkdir -p "$SYMFS$(dirname "$path")"
+    for c in "${containers[@]}"; do
+        docker cp -L "$c:$path" "$SYMFS$path" >/dev/null 2>&1 && break
+    done
+done
+
+perf script --symfs "$SYMFS" -i "$OUT/cpu.perf.data" \
+    -F comm,pid,tid,time,event,ip,sym,dso > "$WORKDIR/cpu.txt" 2>/dev/null
+off=()
+if [ "$OFFCPU" = 1 ]; then
+    perf script --symfs "$SYMFS" -i "$OUT/offcpu.perf.data" \
+        -F comm,pid,tid,cpu,time,event,trace,ip,sym,dso > "$WORKDIR/offcpu.txt" 2>/dev/null
+    off=(--offcpu "$WORKDIR/offcpu.txt")
+fi
+
+python3 "$HERE/flamegraph.py" fold --nfs "$WORKDIR/nfs.txt" --cpu "$WORKDIR/cpu.txt" \
+    "${off[@]}" --out "$OUT"
+echo "flamegraphs: $OUT/<nf>.cpu.svg$([ "$OFFCPU" = 1 ] && echo ", <nf>.offcpu.svg")" >&2
+exit "$rc"
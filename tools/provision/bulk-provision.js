@@ -0,0 +1,115 @@
+// ============================================================
+// bulk-provision.js — streaming subscriber provisioning (mongosh)
+// ============================================================
+// Runs inside one mongosh process, so every batch goes over the same
+// connection.  Documents are generated a batch at a time (never the whole
+// set in memory) and written with an unordered insertMany; the IMSI range
+// is cleared first with one deleteMany, which keeps the old "replace if
+// present" behaviour of the per-subscriber deleteOne + insertOne.
+//
+// Parameters come from `const ARGS = {...}` evaluated before this file
+// (tools/provision/bulk-provision.sh builds it):
+//
+//   count    subscribers to write
+//   imsi     first IMSI, digits only (incremented, length preserved)
+//   k, opc   hex; k is incremented per subscriber unless sameKey
+//   sameKey  every subscriber gets k
+//   keyStep  'full': k + i over its whole width (default); 'byte': only
+//            the last byte, + i mod 256 (the old ./open5gs.sh behaviour)
+//   sst, sd  slice
+//   dnns     DNN list; "ims" gets the IMS session profile
+//   batch    documents per insertMany (default 1000)
+//   replace  delete the IMSI range first (default true)
+//
+// Prints progress every ~10% and ends with one JSON summary line:
+//   {"count":N,"seconds":S,"per_sec":R,"deleted":D,"total":T}
+// ============================================================
+
+const A = Object.assign({
+    count: 1, batch: 1000, sameKey: false, keyStep: 'full', replace: true,
+    sst: 3, sd: '198153', dnns: ['internet'], amf: '8000',
+}, typeof ARGS === 'object' ? ARGS : {});
+if (!(A.batch >= 1))        // 0 or NaN would never advance the loop below
+    throw new Error(`bulk-provision.js: batch must be >= 1, got ${A.batch}`);
+
+// Same document as provision_subscriber() / provision_subscriber_multi_apn()
+// in tests/common.sh
+const AMBR = { uplink: { value: 1, unit: 3 }, downlink: { value: 1, unit: 3 } };
+const SESSION = {
+    internet: {
+        ambr: AMBR,
+        qos: { index: 9, arp: { priority_level: 8, pre_emption_capability: 1,
+                                pre_emption_vulnerability: 1 } },
+    },
+    ims: {
+        ambr: { uplink: { value: 500, unit: 2 }, downlink: { value: 500, unit: 2 } },
+        qos: { index: 5, arp: { priority_level: 1, pre_emption_capability: 1,
+                                pre_emption_vulnerability: 1 } },
+    },
+};
+
+const sessions = A.dnns.map(name => Object.assign(
+    { name: name, type: 3, pcc_rule: [] }, SESSION[name] || SESSION.internet));
+
+function addDigits(s, i) {
+    return (BigInt(s) + BigInt(i)).toString().padStart(s.length, '0');
+}
+
+const K_BITS = BigInt(A.k.length * 4);
+const K0 = BigInt('0x' + A.k);
+function addHex(i) {
+    if (A.keyStep === 'byte')
+        return ((K0 & ~0xffn) | ((K0 + BigInt(i)) & 0xffn))
+            .toString(16).padStart(A.k.length, '0');
+    return ((K0 + BigInt(i)) % (1n << K_BITS)).toString(16).padStart(A.k.length, '0');
+}
+
+function subscriber(i) {
+    return {
+        imsi: addDigits(A.imsi, i),
+        subscribed_rau_tau_timer: 12,
+        network_access_mode: 0,
+        subscriber_status: 0,
+        access_restriction_data: 32,
+        slice: [{ sst: A.sst, sd: A.sd, default_indicator: true, session: sessions }],
+        ambr: AMBR,
+        security: {
+            k: (A.sameKey ? A.k : addHex(i)).toUpperCase(),
+            opc: A.opc.toUpperCase(),
+            amf: A.amf,
+            sqn: NumberLong(32),
+        },
+        schema_version: 1,
+        __v: 0,
+    };
+}
+
+const t0 = Date.now();
+let deleted = 0;
+if (A.replace) {
+    const last = addDigits(A.imsi, A.count - 1);
+    deleted = db.subscribers.deleteMany({
+        imsi: { $gte: A.imsi, $lte: last },
+        $expr: { $eq: [{ $strLenCP: '$imsi' }, A.imsi.length] },
+    }).deletedCount;
+}
+
+let done = 0, next = Math.ceil(A.count / 10);
+while (done < A.count) {
+    const n = Math.min(A.batch, A.count - done);
+    const docs = new Array(n);
+    for (let j = 0; j < n; j++) docs[j] = subscriber(done + j);
+    db.subscribers.insertMany(docs, { ordered: false });
+    done += n;
+    if (done >= next && done < A.count) {
+        print(`  ${done}/${A.count} (${Math.round(done * 1000 / (Date.now() - t0))}/s)`);
+        next += Math.ceil(A.count / 10);
+    }
+}
+
+const secs = (Date.now() - t0) / 1000;
+print(JSON.stringify({
+    count: done, seconds: Number(secs.toFixed(3)),
+    per_sec: Math.round(done / Math.max(secs, 0.001)),
+    deleted: deleted, total: db.subscribers.estimatedDocumentCount(),
+}));
@@ -0,0 +1,116 @@
+#!/bin/bash
+# ============================================================
+# bulk-provision.sh — provision N subscribers over one mongosh connection
+# ============================================================
+# Two engines, both one `docker exec` into the MongoDB container per run:
+#
+#   js     tools/provision/bulk-provision.js in mongosh: documents built
+#          per subscriber in JS, unordered insertMany batches (default)
+#   image  tools/provision/sub_template.py on the host stamps documents out
+#          of a compiled BSON template (copy + fixed-width IMSI/K writes);
+#          the stream is piped into mongorestore.  For 10^5..10^6+ sets.
+#
+# Used by `./open5gs.sh bulk-provision` and provision_subscribers() in
+# tests/common.sh.
+#
+# Usage: bulk-provision.sh --count N --imsi 001010000050641 --key <hex> --opc <hex>
+#                          [--same-key | --key-step full|byte] [--sst 3] [--sd 198153]
+#                          [--dnn internet[,ims]] [--batch 1000] [--no-replace]
+#                          [--engine js|image] [--template <json>]
+#
+# --key-step: K of subscriber i is K + i over its full width (full, the
+# default), or K with only its last byte + i mod 256 (byte, what
+# ./open5gs.sh bulk-provision always did: keys repeat after 256).
+# --template defaults to templates/subscriber.json, or
+# templates/subscriber-multi-apn.json for --dnn internet,ims.
+# Env:   MONGO_CONTAINER  (default: open5gs-mongodb)
+#        MONGO_URI        (default: mongodb://localhost:27017/open5gs)
+#
+# Output: progress lines, then one JSON line
+#   {"count":N,"seconds":S,"per_sec":R,"deleted":D,"total":T}
+# ============================================================
+
+set -uo pipefail
+
+HERE="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+JS="$HERE/bulk-provision.js"
+MONGO_CONTAINER="${MONGO_CONTAINER:-open5gs-mongodb}"
+MONGO_URI="${MONGO_URI:-mongodb://localhost:27017/open5gs}"
+
+count=1 imsi="" key="" opc="" same_key=false key_step=full sst=3 sd=198153
+dnn=internet batch=1000 replace=true engine=js template=""
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --count)      count="$2"; shift ;;
+        --imsi)       imsi="${2#imsi-}"; shift ;;
+        --key)        key="$2";   shift ;;
+        --opc)        opc="$2";   shift ;;
+        --same-key)   same_key=true ;;
+        --key-step)   key_step="$2"; shift ;;
+        --sst)        sst="$2";   shift ;;
+        --sd)         sd="$2";    shift ;;
+        --dnn)        dnn="$2";   shift ;;
+        --batch)      batch="$2"; shift ;;
+        --no-replace) replace=false ;;
+        --engine)     engine="$2";   shift ;;
+        --template)   template="$2"; shift ;;
+        *) echo "bulk-provision.sh: unknown option $1" >&2; exit 2 ;;
+    esac
+    shift
+done
+
+if ! [[ "$imsi" =~ ^[0-9]+$ && "$key" =~ ^[0-9a-fA-F]+$ && "$opc" =~ ^[0-9a-fA-F]+$ ]] ||
+   ! [[ "$count" =~ ^[0-9]+$ && "$batch" =~ ^[0-9]+$ ]] || [ "$count" -lt 1 ] ||
+   [ "$batch" -lt 1 ] ||
+   ! [[ "$key_step" =~ ^(full|byte)$ ]]; then
+    echo "bulk-provision.sh: need --count N --imsi <digits> --key <hex> --opc <hex>" \
+         "(--count and --batch >= 1)" >&2
+    exit 2
+fi
+
+# ── image engine: delete the range, then BSON stream → mongorestore ──
+if [ "$engine" = image ]; then
+    if [ -z "$template" ]; then
+        case "$dnn" in
+            internet)     template="$HERE/templates/subscriber.json" ;;
+            internet,ims) template="$HERE/templates/subscriber-multi-apn.json" ;;
+            *) echo "bulk-provision.sh: no template for --dnn $dnn (use --template)" >&2; exit 2 ;;
+        esac
+    fi
+    last=$(printf "%0${#imsi}d" $(( 10#$imsi + count - 1 )))
+    t0=${EPOCHREALTIME/[.,]/}
+    deleted=0
+    if [ "$replace" = true ]; then
+        deleted=$(docker exec "$MONGO_CONTAINER" mongosh "$MONGO_URI" --quiet --eval "
+            db.subscribers.deleteMany({
+                imsi: { \$gte: '$imsi', \$lte: '$last' },
+                \$expr: { \$eq: [{ \$strLenCP: '\$imsi' }, ${#imsi}] },
+            }).deletedCount") || exit 1
+    fi
+    extra=(--key-step "$key_step")
+    [ "$same_key" = true ] && extra+=(--same-key)
+    python3 "$HERE/sub_template.py" generate --template "$template" \
+            --sst "$sst" --sd "$sd" --count "$count" --imsi "$imsi" \
+            --key "$key" --opc "$opc" "${extra[@]}" |
+        docker exec -i "$MONGO_CONTAINER" mongorestore --uri "${MONGO_URI%/*}" --quiet \
+            --db "${MONGO_URI##*/}" --collection subscribers \
+            --numInsertionWorkersPerCollection 4 - || exit 1
+    t1=${EPOCHREALTIME/[.,]/}
+    total=$(docker exec "$MONGO_CONTAINER" mongosh "$MONGO_URI" --quiet \
+        --eval "db.subscribers.estimatedDocumentCount()")
+    awk -v n="$count" -v us=$(( t1 - t0 )) -v d="${deleted:-0}" -v t="${total:-0}" 'BEGIN {
+        s = us / 1e6; if (s < 0.001) s = 0.001
+        printf "{\"count\":%d,\"seconds\":%.3f,\"per_sec\":%d,\"deleted\":%d,\"total\":%d}\n", n, s, n / s, d, t }'
+    exit 0
+fi
+
+# ── js engine ───────────────────────────────────────────────
+dnns="'${dnn//,/\',\'}'"
+args="const ARGS = { count: $count, imsi: '$imsi', k: '$key', opc: '$opc',
+    sameKey: $same_key, keyStep: '$key_step', sst: $sst, sd: '$sd', dnns: [$dnns], batch: $batch,
+    replace: $replace };"
+
+docker exec "$MONGO_CONTAINER" mongosh "$MONGO_URI" --quiet \
+    --eval "$args
+$(cat "$JS")" | awk '{ print; fflush() } /^\{"count"/ { ok = 1 } END { exit !ok }'
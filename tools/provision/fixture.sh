@@ -0,0 +1,114 @@
+#!/bin/bash
+# ============================================================
+# fixture.sh — cached subscriber datasets (mongodump archive per set)
+# ============================================================
+# `provision` takes the bulk-provision.sh options.  The first time a set
+# is asked for, it is provisioned with bulk-provision.sh and its IMSI
+# range is dumped to a gzip mongodump archive.  Later runs restore that
+# archive instead: delete the range, then one mongorestore.  Restoring
+# also resets security.sqn, the same as provisioning fresh.
+#
+# A set is keyed by count, first IMSI, K (or same-key), OPc, DNNs, SST/SD
+# and a hash of the generators (bulk-provision.js, templates/), so a
+# schema change invalidates the cache:
+#
+#   $FIXTURE_DIR/sub-<count>-<imsi>-<dnns>-<hash>.archive.gz
+#
+# Usage: fixture.sh provision --count N --imsi <digits> --key <hex> --opc <hex> [...]
+#        fixture.sh list | clear
+# Env:   FIXTURE_DIR      cache directory (default: tests/.fixtures)
+#        MONGO_CONTAINER  (default: open5gs-mongodb)
+#        MONGO_URI        (default: mongodb://localhost:27017/open5gs)
+#
+# Output: the bulk-provision.sh JSON summary plus "fixture":"hit|saved|none"
+# (none: provisioned, but the dump failed and nothing was cached)
+# ============================================================
+
+set -uo pipefail
+
+HERE="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+FIXTURE_DIR="${FIXTURE_DIR:-$HERE/../../tests/.fixtures}"
+MONGO_CONTAINER="${MONGO_CONTAINER:-open5gs-mongodb}"
+MONGO_URI="${MONGO_URI:-mongodb://localhost:27017/open5gs}"
+
+cmd="${1:-}"
+shift || true
+
+case "$cmd" in
+list)
+    ls -lh "$FIXTURE_DIR"/sub-*.archive.gz 2>/dev/null || echo "no fixtures in $FIXTURE_DIR"
+    exit 0 ;;
+clear)
+    rm -f "$FIXTURE_DIR"/sub-*.archive.gz
+    exit 0 ;;
+provision) ;;
+*)
+    echo "Usage: $0 provision <bulk-provision.sh options> | list | clear" >&2
+    exit 2 ;;
+esac
+
+# Only the options that change the documents go into the key
+count=1 imsi="" key="" opc="" same_key=false key_step=full sst=3 sd=198153 dnn=internet template=""
+args=("$@")
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --count)    count="$2"; shift ;;
+        --imsi)     imsi="${2#imsi-}"; shift ;;
+        --key)      key="${2^^}"; shift ;;
+        --opc)      opc="${2^^}"; shift ;;
+        --same-key) same_key=true ;;
+        --key-step) key_step="$2"; shift ;;
+        --sst)      sst="$2"; shift ;;
+        --sd)       sd="$2"; shift ;;
+        --dnn)      dnn="$2"; shift ;;
+        --template) template="$2"; shift ;;
+        --engine|--batch) shift ;;
+    esac
+    shift
+done
+[[ "$imsi" =~ ^[0-9]+$ && "$count" =~ ^[0-9]+$ ]] ||
+    { echo "fixture.sh: need --count N --imsi <digits>" >&2; exit 2; }
+
+hash=$( { echo "$key $same_key $key_step $opc $sst $sd $dnn"
+          cat "$HERE/bulk-provision.js" "$HERE"/templates/*.json ${template:+"$template"}
+        } | sha1sum | cut -c1-12)
+file="$FIXTURE_DIR/sub-${count}-${imsi}-${dnn//,/+}-${hash}.archive.gz"
+last=$(printf "%0${#imsi}d" $(( 10#$imsi + count - 1 )))
+range="{ \"imsi\": { \"\$gte\": \"$imsi\", \"\$lte\": \"$last\" },
+         \"\$expr\": { \"\$eq\": [{ \"\$strLenCP\": \"\$imsi\" }, ${#imsi}] } }"
+
+# summary <json> <hit|saved|none> — append the fixture state to the JSON line
+summary() { echo "${1%\}},\"fixture\":\"$2\",\"file\":\"$(basename "$file")\"}"; }
+
+if [ -s "$file" ]; then
+    t0=${EPOCHREALTIME/[.,]/}
+    deleted=$(docker exec "$MONGO_CONTAINER" mongosh "$MONGO_URI" --quiet \
+        --eval "db.subscribers.deleteMany($range).deletedCount") || exit 1
+    docker exec -i "$MONGO_CONTAINER" mongorestore --uri "${MONGO_URI%/*}" --quiet \
+        --archive --gzip --nsInclude "${MONGO_URI##*/}.subscribers" \
+        --numInsertionWorkersPerCollection 4 < "$file" || exit 1
+    t1=${EPOCHREALTIME/[.,]/}
+    total=$(docker exec "$MONGO_CONTAINER" mongosh "$MONGO_URI" --quiet \
+        --eval "db.subscribers.estimatedDocumentCount()")
+    summary "$(awk -v n="$count" -v us=$(( t1 - t0 )) -v d="${deleted:-0}" -v t="${total:-0}" 'BEGIN {
+        s = us / 1e6; if (s < 0.001) s = 0.001
+        printf "{\"count\":%d,\"seconds\":%.3f,\"per_sec\":%d,\"deleted\":%d,\"total\":%d}", n, s, n / s, d, t }')" hit
+    exit 0
+fi
+
+out=$("$HERE/bulk-provision.sh" "${args[@]}") || exit 1
+line="${out##*$'\n'}"
+# Parallel run_all.sh workers share the cache: dump to a private file, then
+# rename it into place
+mkdir -p "$FIXTURE_DIR"
+tmp=$(mktemp "$FIXTURE_DIR/.sub.XXXXXX") || exit 1
+if docker exec "$MONGO_CONTAINER" mongodump --uri "$MONGO_URI" --quiet \
+        --collection subscribers --query "$range" --archive --gzip > "$tmp" &&
+   [ -s "$tmp" ]; then
+    mv "$tmp" "$file"
+    summary "$line" saved
+else
+    rm -f "$tmp"
+    echo "fixture.sh: mongodump failed — $count subscribers provisioned, not cached" >&2
+    summary "$line" none
+fi
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""
+sub_template.py — compile a subscriber template into a BSON image and
+stamp out subscriber documents from it.
+
+A template is the subscriber document as JSON (tools/provision/templates/)
+with placeholders:
+
+  "@IMSI@", "@K@", "@OPC@"   patched per document / per dataset
+  "@SST@", "@SD@"            substituted once at compile time (SST as int32)
+  {"$numberLong": "32"}      int64, as mongosh's NumberLong(32)
+
+Compiling encodes the document once to BSON (ints as int32, like mongosh),
+with an "_id" ObjectId in front, and records the byte offset and width of
+every patched field.  Every field keeps its width, so the image never
+changes length: generating a document is a copy of the image plus
+fixed-width writes of the IMSI, K and the ObjectId counter.
+
+The output is a plain BSON stream, as mongorestore reads it:
+
+  mongorestore --db open5gs --collection subscribers - < subscribers.bson
+
+Usage:
+  # compile once (optional: generate compiles on the fly from --template)
+  sub_template.py compile templates/subscriber.json -o sub.img --imsi-digits 15
+
+  # 1M subscribers, K incremented per subscriber, BSON to stdout
+  sub_template.py generate --image sub.img --count 1000000 \\
+      --imsi 001010000050641 --key 0c57... --opc 109e... > subs.bson
+
+  # image layout: offsets and widths
+  sub_template.py show sub.img
+
+tools/provision/bulk-provision.sh --engine image pipes `generate` into
+mongorestore inside the MongoDB container.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+
+MAGIC = b"SUBIMG1\n"
+KEY_HEX = 32        # K and OPc: 128-bit, upper-case hex
+
+
+# ── BSON encoder (the subset a subscriber document uses) ─────────────────
+
+class Image:
+    """Encoder state: patch offsets are recorded while encoding."""
+
+    def __init__(self, widths, subst):
+        self.widths = widths        # placeholder -> fixed width (bytes)
+        self.subst = subst          # compile-time placeholder -> value
+        self.patch = {}             # placeholder -> [offset, width]
+        self.out = bytearray()
+
+    def cstring(self, s):
+        b = s.encode()
+        if b"\0" in b:
+            raise ValueError("NUL in key %r" % s)
+        self.out += b + b"\0"
+
+    def element(self, key, v):
+        if isinstance(v, str) and v in self.subst:
+            v = self.subst[v]
+        o = self.out
+        if isinstance(v, bool):
+            o.append(0x08); self.cstring(key); o.append(1 if v else 0)
+        elif isinstance(v, int):
+            if -2**31 <= v < 2**31:
+                o.append(0x10); self.cstring(key); o += struct.pack("<i", v)
+            else:
+                o.append(0x12); self.cstring(key); o += struct.pack("<q", v)
+        elif isinstance(v, float):
+            o.append(0x01); self.cstring(key); o += struct.pack("<d", v)
+        elif v is None:
+            o.append(0x0A); self.cstring(key)
+        elif isinstance(v, str):
+            o.append(0x02); self.cstring(key)
+            if v in self.widths:
+                w = self.widths[v]
+                o += struct.pack("<i", w + 1)
+                self.patch[v.strip("@").lower()] = [len(o), w]
+                o += b"0" * w + b"\0"
+            else:
+                b = v.encode()
+                o += struct.pack("<i", len(b) + 1) + b + b"\0"
+        elif isinstance(v, dict) and list(v) == ["$numberLong"]:
+            o.append(0x12); self.cstring(key); o += struct.pack("<q", int(v["$numberLong"]))
+        elif isinstance(v, dict) and list(v) == ["$oid"]:
+            o.append(0x07); self.cstring(key)
+            self.patch["_id"] = [len(o), 12]
+            o += bytes(12)
+        elif isinstance(v, dict):
+            o.append(0x03); self.cstring(key); self.document(v)
+        elif isinstance(v, list):
+            o.append(0x04); self.cstring(key)
+            self.document({str(i): x for i, x in enumerate(v)})
+        else:
+            raise TypeError("cannot encode %r" % (v,))
+
+    def document(self, d):
+        start = len(self.out)
+        self.out += b"\0\0\0\0"
+        for k, v in d.items():
+            self.element(k, v)
+        self.out.append(0)
+        struct.pack_into("<i", self.out, start, len(self.out) - start)
+
+
+def compile_template(path, imsi_digits, sst, sd):
+    with open(path) as f:
+        doc = json.load(f)
+    doc.pop("_id", None)
+    img = Image({"@IMSI@": imsi_digits, "@K@": KEY_HEX, "@OPC@": KEY_HEX},
+                {"@SST@": sst, "@SD@": sd})
+    img.document(dict([("_id", {"$oid": "@ID@"})] + list(doc.items())))
+    for need in ("imsi", "k", "opc"):
+        if need not in img.patch:
+            raise ValueError("%s: no @%s@ placeholder" % (path, need.upper()))
+    return bytes(img.out), img.patch
+
+
+def save_image(path, image, patch, meta):
+    hdr = json.dumps(dict(meta, patch=patch, size=len(image)), sort_keys=True)
+    with open(path, "wb") as f:
+        f.write(MAGIC + hdr.encode() + b"\n" + image)
+
+
+def load_image(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(MAGIC):
+        raise ValueError("%s: not a subscriber image" % path)
+    nl = data.index(b"\n", len(MAGIC))
+    hdr = json.loads(data[len(MAGIC):nl])
+    image = data[nl + 1:]
+    if len(image) != hdr["size"]:
+        raise ValueError("%s: truncated image" % path)
+    return image, hdr["patch"], hdr
+
+
+# ── Generator: copy + fixed-width writes ────────────────────────────────
+
+def generate(image, patch, out, count, imsi, key, opc, same_key=False,
+             id_prefix=None, chunk=4096, key_step="full"):
+    io, iw = patch["imsi"]
+    ko, kw = patch["k"]
+    oo, ow = patch["opc"]
+    ido, _ = patch["_id"]
+    if len(imsi) != iw:
+        raise ValueError("IMSI %s is not %d digits (recompile with --imsi-digits %d)"
+                         % (imsi, iw, len(imsi)))
+    if len(key) != KEY_HEX or len(opc) != KEY_HEX:
+        raise ValueError("K and OPc must be %d hex digits" % KEY_HEX)
+
+    buf = bytearray(image)
+    buf[oo:oo + ow] = opc.upper().encode()
+    # ObjectId: 4-byte time + 5 random bytes, then a 3-byte counter is what
+    # the server does; 8 fixed bytes + a 4-byte index keeps them unique
+    # within one dataset and sorted by IMSI
+    buf[ido:ido + 8] = id_prefix or (struct.pack(">I", int(time.time())) + os.urandom(4))
+    if same_key:
+        buf[ko:ko + kw] = key.upper().encode()
+
+    imsi0, k0, mask = int(imsi), int(key, 16), (1 << (4 * KEY_HEX)) - 1
+    if key_step == "byte":      # last byte only, as ./open5gs.sh did
+        k0, mask = k0 & 0xff, 0xff
+    khigh = int(key, 16) & ~mask
+    ifmt, kfmt = b"%%0%dd" % iw, b"%032X"
+    pack_id = struct.Struct(">I").pack_into
+    parts = []
+    for i in range(count):
+        buf[io:io + iw] = ifmt % (imsi0 + i)
+        if not same_key:
+            buf[ko:ko + kw] = kfmt % (khigh | ((k0 + i) & mask))
+        pack_id(buf, ido + 8, i)
+        parts.append(bytes(buf))
+        if len(parts) == chunk:
+            out.write(b"".join(parts))
+            parts = []
+    if parts:
+        out.write(b"".join(parts))
+
+
+# ── CLI ──────────────────────────────────────────────────────────────────
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    def add_compile_args(p):
+        p.add_argument("--imsi-digits", type=int, default=15)
+        p.add_argument("--sst", type=int, default=3)
+        p.add_argument("--sd", default="198153")
+
+    c = sub.add_parser("compile", help="template JSON -> image")
+    c.add_argument("template")
+    c.add_argument("-o", "--output", required=True)
+    add_compile_args(c)
+
+    g = sub.add_parser("generate", help="image -> BSON stream")
+    src = g.add_mutually_exclusive_group(required=True)
+    src.add_argument("--image")
+    src.add_argument("--template")
+    add_compile_args(g)
+    g.add_argument("--count", type=int, required=True)
+    g.add_argument("--imsi", required=True)
+    g.add_argument("--key", required=True)
+    g.add_argument("--opc", required=True)
+    g.add_argument("--same-key", action="store_true")
+    g.add_argument("--key-step", choices=("full", "byte"), default="full")
+    g.add_argument("-o", "--output", default="-")
+
+    s = sub.add_parser("show", help="print an image's layout")
+    s.add_argument("image")
+
+    a = ap.parse_args()
+    if a.cmd == "compile":
+        image, patch = compile_template(a.template, a.imsi_digits, a.sst, a.sd)
+        save_image(a.output, image, patch,
+                   {"template": os.path.basename(a.template), "sst": a.sst, "sd": a.sd})
+        print("%s: %d-byte image, patch %s" % (a.output, len(image), patch), file=sys.stderr)
+    elif a.cmd == "show":
+        image, patch, hdr = load_image(a.image)
+        print(json.dumps(hdr, indent=2, sort_keys=True))
+    else:
+        imsi = a.imsi[5:] if a.imsi.startswith("imsi-") else a.imsi
+        if a.image:
+            image, patch, _ = load_image(a.image)
+        else:
+            image, patch = compile_template(a.template, len(imsi), a.sst, a.sd)
+        out = sys.stdout.buffer if a.output == "-" else open(a.output, "wb")
+        t0 = time.perf_counter()
+        generate(image, patch, out, a.count, imsi, a.key, a.opc, a.same_key,
+                 key_step=a.key_step)
+        out.flush()
+        dt = max(time.perf_counter() - t0, 1e-6)
+        print(json.dumps({"count": a.count, "bytes": a.count * len(image),
+                          "seconds": round(dt, 3), "per_sec": int(a.count / dt)}),
+              file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()